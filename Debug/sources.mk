@@ -15,6 +15,7 @@ C_DEPS :=
 SUBDIRS := \
 . \
 src/argparse \
+src/bmap \
 src/cexpr \
 src/cfgparser \
 src/ctree \
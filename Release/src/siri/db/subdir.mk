@@ -20,15 +20,20 @@ C_SRCS += \
 ../src/siri/db/lookup.c \
 ../src/siri/db/median.c \
 ../src/siri/db/misc.c \
+../src/siri/db/names.c \
 ../src/siri/db/nodes.c \
+../src/siri/db/partial.c \
 ../src/siri/db/pcache.c \
+../src/siri/db/pindex.c \
 ../src/siri/db/points.c \
 ../src/siri/db/pool.c \
 ../src/siri/db/pools.c \
 ../src/siri/db/presuf.c \
+../src/siri/db/profile.c \
 ../src/siri/db/props.c \
 ../src/siri/db/queries.c \
 ../src/siri/db/query.c \
+../src/siri/db/rcache.c \
 ../src/siri/db/re.c \
 ../src/siri/db/reindex.c \
 ../src/siri/db/replicate.c \
@@ -39,6 +44,7 @@ C_SRCS += \
 ../src/siri/db/shards.c \
 ../src/siri/db/tasks.c \
 ../src/siri/db/time.c \
+../src/siri/db/trigram.c \
 ../src/siri/db/user.c \
 ../src/siri/db/users.c \
 ../src/siri/db/variance.c \
@@ -61,15 +67,20 @@ OBJS += \
 ./src/siri/db/lookup.o \
 ./src/siri/db/median.o \
 ./src/siri/db/misc.o \
+./src/siri/db/names.o \
 ./src/siri/db/nodes.o \
+./src/siri/db/partial.o \
 ./src/siri/db/pcache.o \
+./src/siri/db/pindex.o \
 ./src/siri/db/points.o \
 ./src/siri/db/pool.o \
 ./src/siri/db/pools.o \
 ./src/siri/db/presuf.o \
+./src/siri/db/profile.o \
 ./src/siri/db/props.o \
 ./src/siri/db/queries.o \
 ./src/siri/db/query.o \
+./src/siri/db/rcache.o \
 ./src/siri/db/re.o \
 ./src/siri/db/reindex.o \
 ./src/siri/db/replicate.o \
@@ -80,6 +91,7 @@ OBJS += \
 ./src/siri/db/shards.o \
 ./src/siri/db/tasks.o \
 ./src/siri/db/time.o \
+./src/siri/db/trigram.o \
 ./src/siri/db/user.o \
 ./src/siri/db/users.o \
 ./src/siri/db/variance.o \
@@ -102,15 +114,20 @@ C_DEPS += \
 ./src/siri/db/lookup.d \
 ./src/siri/db/median.d \
 ./src/siri/db/misc.d \
+./src/siri/db/names.d \
 ./src/siri/db/nodes.d \
+./src/siri/db/partial.d \
 ./src/siri/db/pcache.d \
+./src/siri/db/pindex.d \
 ./src/siri/db/points.d \
 ./src/siri/db/pool.d \
 ./src/siri/db/pools.d \
 ./src/siri/db/presuf.d \
+./src/siri/db/profile.d \
 ./src/siri/db/props.d \
 ./src/siri/db/queries.d \
 ./src/siri/db/query.d \
+./src/siri/db/rcache.d \
 ./src/siri/db/re.d \
 ./src/siri/db/reindex.d \
 ./src/siri/db/replicate.d \
@@ -121,6 +138,7 @@ C_DEPS += \
 ./src/siri/db/shards.d \
 ./src/siri/db/tasks.d \
 ./src/siri/db/time.d \
+./src/siri/db/trigram.d \
 ./src/siri/db/user.d \
 ./src/siri/db/users.d \
 ./src/siri/db/variance.d \
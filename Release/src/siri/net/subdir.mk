@@ -12,7 +12,8 @@ C_SRCS += \
 ../src/siri/net/protocol.c \
 ../src/siri/net/stream.c \
 ../src/siri/net/tcp.c \
-../src/siri/net/pipe.c
+../src/siri/net/pipe.c \
+../src/siri/net/wqueue.c
 
 OBJS += \
 ./src/siri/net/bserver.o \
@@ -23,7 +24,8 @@ OBJS += \
 ./src/siri/net/protocol.o \
 ./src/siri/net/stream.o \
 ./src/siri/net/tcp.o \
-./src/siri/net/pipe.o
+./src/siri/net/pipe.o \
+./src/siri/net/wqueue.o
 
 C_DEPS += \
 ./src/siri/net/bserver.d \
@@ -34,7 +36,8 @@ C_DEPS += \
 ./src/siri/net/protocol.d \
 ./src/siri/net/stream.d \
 ./src/siri/net/tcp.d \
-./src/siri/net/pipe.d
+./src/siri/net/pipe.d \
+./src/siri/net/wqueue.d
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -11,6 +11,7 @@ C_SRCS += \
 ../src/siri/heartbeat.c \
 ../src/siri/optimize.c \
 ../src/siri/siri.c \
+../src/siri/slowlog.c \
 ../src/siri/version.c
 
 OBJS += \
@@ -21,6 +22,7 @@ OBJS += \
 ./src/siri/heartbeat.o \
 ./src/siri/optimize.o \
 ./src/siri/siri.o \
+./src/siri/slowlog.o \
 ./src/siri/version.o
 
 C_DEPS += \
@@ -31,6 +33,7 @@ C_DEPS += \
 ./src/siri/heartbeat.d \
 ./src/siri/optimize.d \
 ./src/siri/siri.d \
+./src/siri/slowlog.d \
 ./src/siri/version.d
 
 
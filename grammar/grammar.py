@@ -58,6 +58,8 @@ class SiriGrammar(Grammar):
     k_before = Keyword('before')
     k_buffer_size = Keyword('buffer_size')
     k_buffer_path = Keyword('buffer_path')
+    k_cache_hit_ratio = Keyword('cache_hit_ratio')
+    k_cache_size = Keyword('cache_size')
     k_between = Keyword('between')
     k_count = Keyword('count')
     k_create = Keyword('create')
@@ -67,6 +69,7 @@ class SiriGrammar(Grammar):
     k_dbpath = Keyword('dbpath')
     k_debug = Keyword('debug')
     k_derivative = Keyword('derivative')
+    k_desc = Keyword('desc')
     k_difference = Keyword('difference')
     k_drop = Keyword('drop')
     k_drop_threshold = Keyword('drop_threshold')
@@ -125,12 +128,15 @@ class SiriGrammar(Grammar):
     k_online = Keyword('online')
     k_open_files = Keyword('open_files')
     k_or = Keyword('or')
+    k_order = Keyword('order')
+    k_packages_per_write = Keyword('packages_per_write')
     k_password = Keyword('password')
     k_points = Keyword('points')
     k_pool = Keyword('pool')
     k_pools = Keyword('pools')
     k_port = Keyword('port')
     k_prefix = Keyword('prefix')
+    k_profile = Keyword('profile')
     k_pvariance = Keyword('pvariance')
     k_read = Keyword('read')
     k_received_points = Keyword('received_points')
@@ -295,6 +301,7 @@ class SiriGrammar(Grammar):
         k_pool,
         k_servers,
         k_series,
+        k_length,
         most_greedy=False)
     pool_columns = List(pool_props, ',', 1)
 
@@ -427,6 +434,7 @@ class SiriGrammar(Grammar):
         series_sep,
         1)
     limit_expr = Sequence(k_limit, int_expr)
+    order_expr = Sequence(k_order, k_desc, k_limit, int_expr)
 
     before_expr = Sequence(k_before, time_expr)
     after_expr = Sequence(k_after, time_expr)
@@ -435,6 +443,7 @@ class SiriGrammar(Grammar):
 
     prefix_expr = Sequence(k_prefix, string)
     suffix_expr = Sequence(k_suffix, string)
+    series_after = Sequence(k_after, string)
 
     f_all = Choice(Token('*'), k_all, most_greedy=False)
 
@@ -627,7 +636,8 @@ class SiriGrammar(Grammar):
         k_series,
         k_length,
         Optional(series_match),
-        Optional(where_series))
+        Optional(where_series),
+        Optional(series_after))
 
     create_group = Sequence(
         k_group, group_name, k_for, r_regex)
@@ -733,6 +743,7 @@ class SiriGrammar(Grammar):
             between_expr,
             before_expr,
             most_greedy=False)),
+        Optional(order_expr),
         Optional(merge_as))
 
     show_stmt = Sequence(k_show, List(Choice(
@@ -740,6 +751,8 @@ class SiriGrammar(Grammar):
         k_active_tasks,
         k_buffer_path,
         k_buffer_size,
+        k_cache_hit_ratio,
+        k_cache_size,
         k_dbname,
         k_dbpath,
         k_drop_threshold,
@@ -755,6 +768,7 @@ class SiriGrammar(Grammar):
         k_max_open_files,
         k_mem_usage,
         k_open_files,
+        k_packages_per_write,
         k_pool,
         k_received_points,
         k_reindex_progress,
@@ -774,10 +788,12 @@ class SiriGrammar(Grammar):
 
     timeit_stmt = Repeat(k_timeit, 1, 1)
 
+    profile_stmt = Repeat(k_profile, 1, 1)
+
     help_stmt = Ref()
 
     START = Sequence(
-        Optional(timeit_stmt),
+        Optional(Choice(timeit_stmt, profile_stmt, most_greedy=False)),
         Optional(Choice(
             select_stmt,
             list_stmt,
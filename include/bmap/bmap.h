@@ -0,0 +1,48 @@
+/*
+ * bmap.h - Compressed bitmap for uint32_t keys with set operation support.
+ */
+#ifndef BMAP_H_
+#define BMAP_H_
+
+/* containers with more keys are stored as bitmap */
+#define BMAP_ARRAY_MAX 4096
+
+typedef struct bmap_container_s bmap_container_t;
+typedef struct bmap_s bmap_t;
+
+#include <inttypes.h>
+#include <stddef.h>
+
+typedef int (*bmap_cb)(uint32_t id, void * args);
+typedef int (*bmap_update_cb)(bmap_t * dest, bmap_t * bmap);
+
+bmap_t * bmap_new(void);
+void bmap_free(bmap_t * bmap);
+int bmap_add(bmap_t * bmap, uint32_t id);
+int bmap_pop(bmap_t * bmap, uint32_t id);
+int bmap_has(bmap_t * bmap, uint32_t id);
+void bmap_clear(bmap_t * bmap);
+int bmap_walk(bmap_t * bmap, bmap_cb cb, void * args);
+int bmap_union(bmap_t * dest, bmap_t * bmap);
+int bmap_intersection(bmap_t * dest, bmap_t * bmap);
+int bmap_difference(bmap_t * dest, bmap_t * bmap);
+int bmap_symmetric_difference(bmap_t * dest, bmap_t * bmap);
+
+struct bmap_container_s
+{
+    uint16_t key;       /* high 16 bits of the ids in this container    */
+    uint32_t len;       /* number of ids in this container              */
+    uint32_t size;      /* allocated size for array                     */
+    uint16_t * array;   /* sorted low 16 bits, NULL when bits are used  */
+    uint64_t * bits;    /* 65536 bits, NULL when array is used          */
+};
+
+struct bmap_s
+{
+    size_t len;                     /* number of ids                    */
+    uint32_t n;                     /* number of containers             */
+    uint32_t size;                  /* allocated size for containers    */
+    bmap_container_t * containers;  /* sorted by key                    */
+};
+
+#endif  /* BMAP_H_ */
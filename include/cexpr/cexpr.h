@@ -31,6 +31,7 @@ typedef struct cexpr_list_s cexpr_list_t;
 
 typedef int (*cexpr_cb_t)(void * obj, cexpr_condition_t * cond);
 typedef int (*cexpr_cb_prop_t)(uint32_t prop);
+typedef int (*cexpr_cb_cond_t)(cexpr_condition_t * cond, void * args);
 
 cexpr_t * cexpr_from_node(cleri_node_t * node);
 int cexpr_int_cmp(
@@ -51,6 +52,7 @@ int cexpr_bool_cmp(
         const int64_t b);
 int cexpr_run(cexpr_t * cexpr, cexpr_cb_t cb, void * obj);
 int cexpr_contains(cexpr_t * cexpr, cexpr_cb_prop_t cb);
+int cexpr_required(cexpr_t * cexpr, cexpr_cb_cond_t cb, void * args);
 void cexpr_free(cexpr_t * cexpr);
 cexpr_operator_t cexpr_operator_fn(cleri_node_t * node);
 
@@ -36,7 +36,20 @@ void * ct_getn(ct_t * ct, const char * key, size_t n);
 void * ct_pop(ct_t * ct, const char * key);
 int ct_items(ct_t * ct, ct_item_cb cb, void * args);
 int ct_values(ct_t * ct, ct_val_cb cb, void * args);
+int ct_values_prefix(
+        ct_t * ct,
+        const char * prefix,
+        size_t n,
+        ct_val_cb cb,
+        void * args);
+int ct_prefixes(ct_t * ct, const char * key, ct_val_cb cb, void * args);
 void ct_valuesn(ct_t * ct, size_t * n, ct_val_cb cb, void * args);
+void ct_valuesn_after(
+        ct_t * ct,
+        const char * key,
+        size_t * n,
+        ct_val_cb cb,
+        void * args);
 
 struct ct_node_s
 {
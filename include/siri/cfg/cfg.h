@@ -32,6 +32,12 @@ struct siri_cfg_s
     uint8_t pipe_support;
     char pipe_client_name[XPATH_MAX];
     uint32_t buffer_sync_interval;
+    uint32_t slow_query_threshold;
+    uint32_t slow_query_sample_rate;
+    uint8_t trigram_index;
+    uint8_t property_index;
+    uint8_t hedge_percentile;
+    uint8_t replicate_window;
 };
 
 #endif  /* SIRI_CFG_H_ */
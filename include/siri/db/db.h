@@ -35,6 +35,10 @@ typedef struct siridb_s siridb_t;
 #include <siri/db/tasks.h>
 #include <siri/db/time.h>
 #include <siri/db/buffer.h>
+#include <siri/db/rcache.h>
+#include <siri/db/trigram.h>
+#include <siri/db/names.h>
+#include <siri/db/pindex.h>
 
 int32_t siridb_get_uptime(siridb_t * siridb);
 int8_t siridb_get_idle_percentage(siridb_t * siridb);
@@ -58,6 +62,7 @@ struct siridb_s
     uint8_t pad0;
     uint32_t max_series_id;
     uint16_t insert_tasks;
+    uint16_t insert_decodes;        /* inserts decoded in a work thread     */
     uint16_t shard_mask_num;
     uint16_t shard_mask_log;
     uint32_t select_points_limit;
@@ -72,6 +77,7 @@ struct siridb_s
     double drop_threshold;
     size_t received_points;
     size_t selected_points;
+    uint64_t series_length;         /* total length of all local series     */
 
     siridb_time_t * time;
     siridb_server_t * server;
@@ -79,7 +85,7 @@ struct siridb_s
     llist_t * users;
     llist_t * servers;
     siridb_pools_t * pools;
-    ct_t * series;
+    siridb_names_t * series;
     imap_t * series_map;
     uv_mutex_t series_mutex;
     uv_mutex_t shards_mutex;
@@ -91,6 +97,9 @@ struct siridb_s
     siridb_reindex_t * reindex;
     siridb_groups_t * groups;
     siridb_buffer_t * buffer;
+    siridb_rcache_t * rcache;
+    siridb_trigram_t * trigrams;    /* NULL when the index is disabled  */
+    siridb_pindex_t * pindex;       /* NULL when the index is disabled  */
     siridb_tasks_t tasks;
 };
 
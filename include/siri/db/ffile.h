@@ -11,6 +11,12 @@ typedef enum
     FFILE_SUCCESS
 } siridb_ffile_result_t;
 
+/*
+ * Records are stored as a package, a checksum and the size of the package
+ * with this bit set. Records without this bit have no checksum.
+ */
+#define FFILE_CHECKSUM 0x80000000
+
 typedef struct siridb_ffile_s siridb_ffile_t;
 
 #include <siri/net/pkg.h>
@@ -22,8 +28,11 @@ siridb_ffile_t * siridb_ffile_new(
         sirinet_pkg_t * pkg);
 int siridb_ffile_check_fn(const char * fn);
 void siridb_ffile_free(siridb_ffile_t * ffile);
+int siridb_ffile_close(siridb_ffile_t * ffile);
 void siridb_ffile_unlink(siridb_ffile_t * ffile);
 sirinet_pkg_t * siridb_ffile_pop(siridb_ffile_t * ffile);
+void siridb_ffile_unpop(siridb_ffile_t * ffile, sirinet_pkg_t * pkg);
+void siridb_ffile_pop_rewind(siridb_ffile_t * ffile);
 int siridb_ffile_pop_commit(siridb_ffile_t * ffile);
 siridb_ffile_result_t siridb_ffile_append(
         siridb_ffile_t * ffile,
@@ -35,9 +44,25 @@ struct siridb_ffile_s
     char * fn;
     uint32_t free_space;
     uint32_t next_size;  /* must be uint32_t (4 bytes)  */
+    uint32_t pop_size;   /* size of the package at pop_pos, 0 if none   */
+    uint32_t last_pop;   /* size of the last popped package             */
     FILE * fp;
     int fd;
     long int size;
+    long int pop_pos;    /* end of the next package to pop              */
+    long int fsize;      /* size on disk, larger when truncating failed */
+    long int map_size;   /* 0 when not mapped, -1 if mapping failed     */
+    char * map;          /* read-only mapping of a full fifo file       */
 };
 
+/*
+ * Returns the package size for a size as stored in the fifo file.
+ */
+#define siridb_ffile_pkg_size(sz) ((sz) & ~FFILE_CHECKSUM)
+
+/*
+ * Returns 1 (true) when no package is popped without being committed.
+ */
+#define siridb_ffile_pop_at_head(ffile) ((ffile)->pop_pos == (ffile)->size)
+
 #endif  /* SIRIDB_FFILE_H_ */
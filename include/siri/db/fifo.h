@@ -17,6 +17,8 @@ void siridb_fifo_free(siridb_fifo_t * fifo);
 size_t siridb_fifo_size(siridb_fifo_t * fifo);
 int siridb_fifo_append(siridb_fifo_t * fifo, sirinet_pkg_t * pkg);
 sirinet_pkg_t * siridb_fifo_pop(siridb_fifo_t * fifo);
+void siridb_fifo_unpop(siridb_fifo_t * fifo, sirinet_pkg_t * pkg);
+void siridb_fifo_rewind(siridb_fifo_t * fifo);
 int siridb_fifo_commit(siridb_fifo_t * fifo);
 int siridb_fifo_commit_err(siridb_fifo_t * fifo);
 int siridb_fifo_close(siridb_fifo_t * fifo);
@@ -28,6 +30,13 @@ int siridb_fifo_open(siridb_fifo_t * fifo);
  */
 #define siridb_fifo_has_data(fifo) fifo->out->next_size
 
+/*
+ * Value is greater than 0 when the fifo has a package which is not popped.
+ * Packages can be popped before the previous ones are committed, but only
+ * within the current 'out' fifo file.
+ */
+#define siridb_fifo_has_next(fifo) fifo->out->pop_size
+
 
 /*
  * Returns 1 if the fifo buffer is open or 0 if closed.
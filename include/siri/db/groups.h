@@ -16,6 +16,8 @@
  *
  *  Group thread:
  *      group->series :     read (no lock)      write (lock)
+ *      groups->prefixes :  read (lock)         write (lock)
+ *      groups->unanchored: read (lock)         write (lock)
  *
  *  Note:   One exception to 'not allowed' are the free functions
  *          since they only run when no other references to the object exist.
@@ -33,6 +35,7 @@ typedef enum
 typedef struct siridb_groups_s siridb_groups_t;
 
 #define GROUPS_FLAG_DROPPED_SERIES 1
+#define GROUPS_FLAG_REBUILD 2  /* group expressions have changed */
 
 #include <ctree/ctree.h>
 #include <vec/vec.h>
@@ -71,7 +74,10 @@ struct siridb_groups_s
     ct_t * groups;
     vec_t * nseries;  /* list of series we need to assign to groups */
     vec_t * ngroups;  /* list of groups which need initialization */
+    ct_t * prefixes;  /* literal prefix -> list of groups */
+    vec_t * unanchored;  /* groups without a literal prefix */
     uv_mutex_t mutex;
+    uv_cond_t cond;  /* signaled when new series are added */
     uv_work_t work;
 };
 #endif  /* SIRIDB_GROUPS_H_ */
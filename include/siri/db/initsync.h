@@ -26,6 +26,7 @@ struct siridb_initsync_s
     int fd;
     long int size;
     uint32_t * next_series_id;
+    uint32_t nseries;       /* number of series ids handled by pkg  */
     sirinet_pkg_t * pkg;
 };
 
@@ -50,6 +50,7 @@ siridb_insert_t * siridb_insert_new(
         sirinet_stream_t * client);
 void siridb_insert_free(siridb_insert_t * insert);
 int siridb_insert_points_to_pools(siridb_insert_t * insert, size_t npoints);
+int siridb_insert_assign(siridb_insert_t * insert, sirinet_pkg_t * pkg);
 int insert_init_backend_local(
         siridb_t * siridb,
         sirinet_stream_t * client,
@@ -0,0 +1,54 @@
+/*
+ * names.h - Dictionary with series names.
+ */
+#ifndef SIRIDB_NAMES_H_
+#define SIRIDB_NAMES_H_
+
+typedef struct siridb_names_s siridb_names_t;
+
+#include <ctree/ctree.h>
+#include <inttypes.h>
+#include <siri/db/series.h>
+#include <stddef.h>
+
+siridb_names_t * siridb_names_new(void);
+void siridb_names_free(siridb_names_t * names, ct_free_cb cb);
+int siridb_names_add(siridb_names_t * names, siridb_series_t * series);
+int siridb_names_append(siridb_names_t * names, siridb_series_t * series);
+int siridb_names_rebuild(siridb_names_t * names);
+siridb_series_t * siridb_names_get(siridb_names_t * names, const char * name);
+siridb_series_t * siridb_names_getn(
+        siridb_names_t * names,
+        const char * name,
+        size_t n);
+siridb_series_t * siridb_names_pop(siridb_names_t * names, const char * name);
+int siridb_names_values_prefix(
+        siridb_names_t * names,
+        const char * prefix,
+        size_t n,
+        ct_val_cb cb,
+        void * args);
+void siridb_names_valuesn(
+        siridb_names_t * names,
+        size_t * n,
+        ct_val_cb cb,
+        void * args);
+void siridb_names_valuesn_after(
+        siridb_names_t * names,
+        const char * name,
+        size_t * n,
+        ct_val_cb cb,
+        void * args);
+
+struct siridb_names_s
+{
+    size_t len;                 /* number of series in the dictionary */
+    size_t size;                /* number of entries in sorted */
+    size_t ndropped;            /* dropped entries in sorted */
+    size_t mask;                /* number of hash slots - 1 */
+    uintptr_t * sorted;         /* series (or dropped names) by name */
+    siridb_series_t ** slots;   /* open addressing hash table */
+    ct_t * delta;               /* series added after the last rebuild */
+};
+
+#endif  /* SIRIDB_NAMES_H_ */
@@ -0,0 +1,23 @@
+/*
+ * partial.h - Partial aggregation for merged select queries.
+ */
+#ifndef SIRIDB_PARTIAL_H_
+#define SIRIDB_PARTIAL_H_
+
+#include <siri/db/aggregate.h>
+#include <siri/db/points.h>
+#include <vec/vec.h>
+
+size_t siridb_partial_size(siridb_aggr_t * aggr);
+int siridb_partial_append(
+        vec_t ** partials,
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+siridb_points_t * siridb_partial_combine(
+        vec_t * partials,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+void siridb_partial_free(vec_t * partials);
+
+#endif  /* SIRIDB_PARTIAL_H_ */
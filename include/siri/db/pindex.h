@@ -0,0 +1,45 @@
+/*
+ * pindex.h - Index on series properties used by where expressions.
+ */
+#ifndef SIRIDB_PINDEX_H_
+#define SIRIDB_PINDEX_H_
+
+typedef enum
+{
+    SIRIDB_PINDEX_START,
+    SIRIDB_PINDEX_END,
+    SIRIDB_PINDEX_LENGTH,
+    SIRIDB_PINDEX_TYPE,
+    SIRIDB_PINDEX_PROPS         /* number of properties, must be last */
+} siridb_pindex_prop_t;
+
+typedef struct siridb_pindex_s siridb_pindex_t;
+
+#include <cexpr/cexpr.h>
+#include <imap/imap.h>
+#include <inttypes.h>
+#include <siri/db/series.h>
+#include <vec/vec.h>
+
+siridb_pindex_t * siridb_pindex_new(uint64_t day);
+void siridb_pindex_free(siridb_pindex_t * pindex);
+int siridb_pindex_add(siridb_pindex_t * pindex, siridb_series_t * series);
+void siridb_pindex_pop(siridb_pindex_t * pindex, siridb_series_t * series);
+int siridb_pindex_update(
+        siridb_pindex_t * pindex,
+        siridb_series_t * series,
+        uint64_t start,
+        uint64_t end,
+        uint32_t length);
+vec_t * siridb_pindex_match(
+        siridb_pindex_t * pindex,
+        cexpr_t * cexpr,
+        uint16_t pool);
+
+struct siridb_pindex_s
+{
+    uint64_t day;                           /* one day in db precision  */
+    imap_t * props[SIRIDB_PINDEX_PROPS];    /* key -> bucket            */
+};
+
+#endif  /* SIRIDB_PINDEX_H_ */
@@ -33,6 +33,8 @@ siridb_points_t * siridb_points_copy(siridb_points_t * points);
 int siridb_points_pack(siridb_points_t * points, qp_packer_t * packer);
 void siridb_points_ts_correction(siridb_points_t * points, double factor);
 int siridb_points_raw_pack(siridb_points_t * points, qp_packer_t * packer);
+int siridb_points_zip_pack(siridb_points_t * points, qp_packer_t * packer);
+siridb_points_t * siridb_points_unpack(qp_unpacker_t * unpacker);
 siridb_points_t * siridb_points_merge(vec_t * plist, char * err_msg);
 unsigned char * siridb_points_zip_double(
         siridb_points_t * points,
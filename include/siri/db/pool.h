@@ -40,6 +40,7 @@ struct siridb_pool_walker_s
     uint_fast16_t pool;
     uint_fast8_t servers;
     size_t series;
+    uint64_t length;
 };
 
 #endif  /* SIRIDB_POOL_H_ */
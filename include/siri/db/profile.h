@@ -0,0 +1,119 @@
+/*
+ * profile.h - Per stage query profiling.
+ */
+#ifndef SIRIDB_PROFILE_H_
+#define SIRIDB_PROFILE_H_
+
+typedef enum
+{
+    SIRIDB_PROFILE_PARSE,       /* parsing the query (cleri and walker)     */
+    SIRIDB_PROFILE_MATCH,       /* series matching (names, regex, where)    */
+    SIRIDB_PROFILE_LOCK,        /* waiting for the series mutex             */
+    SIRIDB_PROFILE_READ,        /* reading shard files                      */
+    SIRIDB_PROFILE_DECODE,      /* decompress and decode points             */
+    SIRIDB_PROFILE_AGGREGATE,   /* aggregation per series                   */
+    SIRIDB_PROFILE_MERGE,       /* merge and combine results on the master  */
+    SIRIDB_PROFILE_PACK,        /* packing results using qpack              */
+    SIRIDB_PROFILE_NETWORK,     /* waiting for other servers                */
+    SIRIDB_PROFILE_STAGES       /* number of stages, must be last           */
+} siridb_profile_stage_t;
+
+typedef struct siridb_profile_s siridb_profile_t;
+
+#include <inttypes.h>
+#include <qpack/qpack.h>
+#include <timeit/timeit.h>
+#include <uv.h>
+#include <vec/vec.h>
+
+siridb_profile_t * siridb_profile_new(void);
+void siridb_profile_free(siridb_profile_t * profile);
+void siridb_profile_lock(siridb_profile_t * profile, uv_mutex_t * mutex);
+void siridb_profile_unlock(uv_mutex_t * mutex);
+int siridb_profile_pack(siridb_profile_t * profile, qp_packer_t * packer);
+void siridb_profile_promises(siridb_profile_t * profile, vec_t * promises);
+const char * siridb_profile_strstage(siridb_profile_stage_t stage);
+
+/*
+ * Profile which is used while reading points from shards. This profile is
+ * set by siridb_profile_lock() and only while the series mutex is locked.
+ * Each thread has its own pointer so shards which are read by other threads,
+ * for example the optimize task or a query on another database, are never
+ * counted using this profile.
+ */
+extern __thread siridb_profile_t * siridb_profile_io;
+
+struct siridb_profile_s
+{
+    double stages[SIRIDB_PROFILE_STAGES];   /* time in seconds          */
+    uint64_t chunks;                        /* chunks read from shards  */
+    uint64_t bytes;                         /* bytes read from shards   */
+    uint64_t points;                        /* points decoded           */
+    uint64_t series;                        /* series matched           */
+    uint64_t start_ts;                      /* selected time range, set */
+    uint64_t end_ts;                        /*  by select queries       */
+    struct timespec network;                /* start waiting for others */
+    uint16_t npools;                        /* length of pools          */
+    float * pools;                          /* latency for each pool    */
+};
+
+/*
+ * The functions below do nothing when profile is NULL so they can be used
+ * without checking if profiling is enabled for a query.
+ */
+static inline void siridb_profile_start(
+        siridb_profile_t * profile,
+        struct timespec * start)
+{
+    if (profile != NULL)
+    {
+        timeit_start(start);
+    }
+}
+
+static inline void siridb_profile_stop(
+        siridb_profile_t * profile,
+        siridb_profile_stage_t stage,
+        struct timespec * start)
+{
+    if (profile != NULL)
+    {
+        profile->stages[stage] += timeit_get(start);
+    }
+}
+
+static inline void siridb_profile_read(
+        siridb_profile_t * profile,
+        size_t size,
+        struct timespec * start)
+{
+    if (profile != NULL)
+    {
+        profile->stages[SIRIDB_PROFILE_READ] += timeit_get(start);
+        profile->chunks++;
+        profile->bytes += size;
+        timeit_start(start);
+    }
+}
+
+static inline void siridb_profile_decode(
+        siridb_profile_t * profile,
+        size_t n,
+        struct timespec * start)
+{
+    if (profile != NULL)
+    {
+        profile->stages[SIRIDB_PROFILE_DECODE] += timeit_get(start);
+        profile->points += n;
+    }
+}
+
+static inline void siridb_profile_network_start(siridb_profile_t * profile)
+{
+    if (profile != NULL)
+    {
+        timeit_start(&profile->network);
+    }
+}
+
+#endif  /* SIRIDB_PROFILE_H_ */
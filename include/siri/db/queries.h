@@ -6,6 +6,7 @@
 
 #include <uv.h>
 #include <inttypes.h>
+#include <bmap/bmap.h>
 #include <imap/imap.h>
 #include <vec/vec.h>
 #include <cexpr/cexpr.h>
@@ -43,11 +44,12 @@ typedef enum
 uint8_t tp;                     \
 uint8_t flags;                  \
 imap_t * series_map;            \
-imap_t * series_tmp;            \
+bmap_t * series_bits;           \
+bmap_t * series_tmp;            \
 imap_t * pmap;                  \
 vec_t * vec;                \
 size_t vec_index;             \
-imap_update_cb update_cb;       \
+bmap_update_cb update_cb;       \
 cexpr_t * where_expr;           \
 pcre2_code * regex;             \
 pcre2_match_data * match_data;
@@ -117,6 +119,8 @@ struct query_list_s
     QUERY_DEF
     vec_t * props;  /* will be freed      */
     size_t limit;
+    char * after;   /* will be freed, list series after this name   */
+    ct_t * rows;    /* will be freed, rows by name to merge pools   */
 };
 
 struct query_select_s
@@ -126,12 +130,15 @@ struct query_select_s
     size_t nselects;
     uint64_t * start_ts;    /* will NOT be freed        */
     uint64_t * end_ts;      /* will NOT be freed        */
+    size_t tail;            /* newest points per series, 0 for all points   */
     siridb_presuf_t * presuf;
     char * merge_as;
     ct_t * result;
     imap_t * points_map;    /* points_map for caching                       */
     vec_t * alist;        /* aggregation list (can be used multiple times)*/
+    char * rcache_key;      /* result cache key for the aggregation list    */
     vec_t * mlist;        /* merge aggregation list                       */
+    ct_t * partial;         /* partial merge results received from pools    */
 };
 
 #endif  /* SIRIDB_QUERIES_H_ */
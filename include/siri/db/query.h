@@ -8,6 +8,9 @@
 #define SIRIDB_QUERY_FLAG_REBUILD 2
 #define SIRIDB_QUERY_FLAG_UPDATE_REPLICA 4
 #define SIRIDB_QUERY_FLAG_ERR 8
+#define SIRIDB_QUERY_FLAG_PARTIAL 16   /* master accepts partial results */
+#define SIRIDB_QUERY_FLAG_STREAM 32    /* client accepts result chunks */
+#define SIRIDB_QUERY_FLAG_ZIP 64       /* master accepts zipped points */
 
 /*
  * Note(*) : servers must be 'accessible' unless FLAG_ONLY_CHECK_ONLINE is used
@@ -41,6 +44,7 @@ typedef struct siridb_query_s siridb_query_t;
 #include <qpack/qpack.h>
 #include <siri/db/time.h>
 #include <siri/db/nodes.h>
+#include <siri/db/profile.h>
 #include <siri/db/series.h>
 #include <siri/db/db.h>
 #include <siri/net/protocol.h>
@@ -54,6 +58,7 @@ void siridb_query_run(
         int flags);
 void siridb_query_free(uv_handle_t * handle);
 void siridb_send_query_result(uv_async_t * handle);
+int siridb_query_send_chunk(siridb_query_t * query);
 void siridb_query_send_error(
         uv_async_t * handle,
         cproto_server_t err);
@@ -80,6 +85,7 @@ struct siridb_query_s
     char err_msg[SIRIDB_MAX_SIZE_ERR_MSG];
     qp_packer_t * packer;
     qp_packer_t * timeit;
+    siridb_profile_t * profile;     /* NULL unless profiling is enabled */
     cleri_parse_t * pr;
     siridb_nodes_t * nodes;
     struct timespec start;
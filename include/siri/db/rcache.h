@@ -0,0 +1,84 @@
+/*
+ * rcache.h - Result cache for select queries.
+ */
+#ifndef SIRIDB_RCACHE_H_
+#define SIRIDB_RCACHE_H_
+
+#define SIRIDB_RCACHE_MAX_SIZE 67108864     /* 64 MB                        */
+
+typedef struct siridb_rcache_s siridb_rcache_t;
+typedef struct siridb_rcache_entry_s siridb_rcache_entry_t;
+typedef struct siridb_rcache_hit_s siridb_rcache_hit_t;
+
+#include <imap/imap.h>
+#include <inttypes.h>
+#include <siri/db/points.h>
+#include <vec/vec.h>
+
+siridb_rcache_t * siridb_rcache_new(size_t max_size);
+void siridb_rcache_free(siridb_rcache_t * rcache);
+char * siridb_rcache_key(const char * str, size_t len);
+uint64_t siridb_rcache_group_by(vec_t * alist);
+int siridb_rcache_get(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        const char * key,
+        uint64_t group_by,
+        uint64_t start_ts,
+        uint64_t end_ts,
+        siridb_rcache_hit_t * hit);
+void siridb_rcache_set(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        const char * key,
+        uint64_t group_by,
+        uint64_t start_ts,
+        uint64_t end_ts,
+        siridb_points_t * points);
+void siridb_rcache_invalidate(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        uint64_t ts);
+void siridb_rcache_clear(siridb_rcache_t * rcache);
+siridb_points_t * siridb_rcache_concat(
+        siridb_points_t * head,
+        siridb_points_t * points,
+        siridb_points_t * tail);
+double siridb_rcache_hit_ratio(siridb_rcache_t * rcache);
+
+struct siridb_rcache_hit_s
+{
+    siridb_points_t * points;   /* copy of the re-usable cached points      */
+    uint64_t head_end;          /* points in [start, head_end) are missing  */
+    uint64_t tail_start;        /* points in [tail_start, end) are missing  */
+};
+
+struct siridb_rcache_entry_s
+{
+    uint32_t series_id;
+    uint64_t group_by;          /* 0 when the result cannot be re-used
+                                   for another time range */
+    uint64_t start_ts;
+    uint64_t end_ts;
+    uint64_t valid_ts;          /* result is valid for [start_ts, valid_ts) */
+    size_t size;
+    char * key;
+    siridb_points_t * points;
+    siridb_rcache_entry_t * next;       /* next entry for the same series   */
+    siridb_rcache_entry_t * lru_prev;   /* more recently used               */
+    siridb_rcache_entry_t * lru_next;   /* less recently used               */
+};
+
+struct siridb_rcache_s
+{
+    size_t size;                /* memory used by the cache in bytes        */
+    size_t max_size;
+    uint64_t hits;
+    uint64_t partial_hits;
+    uint64_t misses;
+    imap_t * series;            /* series id -> first cache entry           */
+    siridb_rcache_entry_t * lru_head;
+    siridb_rcache_entry_t * lru_tail;
+};
+
+#endif  /* SIRIDB_RCACHE_H_ */
@@ -15,6 +15,9 @@ int siridb_re_compile(
         const char * source,
         size_t len,
         char * err_msg);
-
+void siridb_re_free(pcre2_code * regex, pcre2_match_data * match_data);
+void siridb_re_destroy(void);
+size_t siridb_re_prefix(const char * source, size_t len, char * prefix);
+size_t siridb_re_literals(const char * source, size_t len, char * literals);
 
 #endif  /* SIRIDB_RE_H_ */
@@ -19,8 +19,18 @@
 #define SIRIDB_REINDEX_H_
 
 #define REINDEX_FN ".reindex"
+#define REINDEX_WINDOW 4            /* max batches in flight            */
+
+typedef enum
+{
+    REINDEX_BATCH_READING,      /* points are read in a work thread     */
+    REINDEX_BATCH_READY,        /* package is ready to be send          */
+    REINDEX_BATCH_SENT,         /* waiting for the new pool             */
+    REINDEX_BATCH_DONE          /* series are moved or skipped          */
+} siridb_reindex_batch_status_t;
 
 typedef struct siridb_reindex_s siridb_reindex_t;
+typedef struct siridb_reindex_batch_s siridb_reindex_batch_t;
 
 #include <inttypes.h>
 #include <uv.h>
@@ -35,17 +45,31 @@ void siridb_reindex_close(siridb_reindex_t * reindex);
 void siridb_reindex_start(uv_timer_t * timer);
 const char * siridb_reindex_progress(siridb_t * siridb);
 
+struct siridb_reindex_batch_s
+{
+    siridb_t * siridb;
+    siridb_reindex_batch_status_t status;
+    uint32_t nids;              /* series ids taken from the file       */
+    uint32_t nseries;           /* series which are moved               */
+    siridb_series_t ** series;
+    sirinet_pkg_t * pkg;
+    uv_work_t work;
+};
+
 struct siridb_reindex_s
 {
     FILE * fp;
     char * fn;
     int fd;
     long int size;
-    uint32_t * next_series_id;
-    sirinet_pkg_t * pkg;
-    siridb_series_t * series;
+    long int head;              /* bytes at the end taken by batches    */
+    uint8_t tail;               /* position of the oldest batch         */
+    uint8_t nbatches;
+    size_t moved;               /* series moved since start             */
+    uint64_t start;             /* start time in milliseconds           */
     siridb_server_t * server;
     uv_timer_t * timer;
+    siridb_reindex_batch_t * batches[REINDEX_WINDOW];
 };
 
 #endif  /* SIRIDB_REINDEX_H_ */
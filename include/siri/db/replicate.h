@@ -14,6 +14,7 @@ typedef enum
 } siridb_replicate_status_t;
 
 typedef struct siridb_replicate_s siridb_replicate_t;
+typedef struct siridb_replicate_slot_s siridb_replicate_slot_t;
 
 #include <uv.h>
 #include <siri/db/db.h>
@@ -36,11 +37,24 @@ sirinet_pkg_t * siridb_replicate_pkg_filter(
 
 #define siridb_replicate_is_idle(replicate) (replicate->status == REPLICATE_IDLE)
 
+struct siridb_replicate_slot_s
+{
+    siridb_t * siridb;
+    uint16_t npkgs;         /* number of fifo packages in this slot     */
+    uint8_t status;
+};
+
 struct siridb_replicate_s
 {
     siridb_replicate_status_t status;
+    uint16_t window;        /* maximum number of slots in flight        */
+    uint16_t head;          /* oldest slot in flight                    */
+    uint16_t inflight;
+    uint8_t barrier;        /* a non-insert package is in flight        */
+    uint8_t rewind;         /* packages must be sent again              */
     uv_timer_t * timer;
     siridb_initsync_t * initsync;
+    siridb_replicate_slot_t * slots;
 };
 
 #endif  /* SIRIDB_REPLICATE_H_ */
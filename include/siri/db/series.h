@@ -49,6 +49,7 @@ typedef points_tp series_tp;
 #include <siri/db/buffer.h>
 #include <qpack/qpack.h>
 #include <cexpr/cexpr.h>
+#include <bmap/bmap.h>
 
 /* order here matters since shard.h is using a full series definition */
 struct siridb_series_s
@@ -98,6 +99,11 @@ siridb_points_t * siridb_series_get_points(
         siridb_series_t *__restrict series,
         uint64_t *__restrict start_ts,
         uint64_t *__restrict end_ts);
+siridb_points_t * siridb_series_get_tail(
+        siridb_series_t *__restrict series,
+        uint64_t *__restrict start_ts,
+        uint64_t *__restrict end_ts,
+        size_t limit);
 void siridb_series_remove_shard(
         siridb_t *__restrict siridb,
         siridb_series_t *__restrict series,
@@ -123,6 +129,8 @@ siridb_points_t * siridb_series_get_last(
         siridb_series_t * series, int * required_shard);
 siridb_points_t * siridb_series_get_count(siridb_series_t * series);
 void siridb_series_ensure_type(siridb_series_t * series, qp_obj_t * qp_obj);
+imap_t * siridb_series_bmap_imap(siridb_t * siridb, bmap_t * bmap);
+vec_t * siridb_series_bmap_vec(siridb_t * siridb, bmap_t * bmap);
 /*
  * Increment the series reference counter.
  */
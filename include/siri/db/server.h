@@ -6,6 +6,7 @@
 
 #define FLAG_KEEP_PKG 1
 #define FLAG_ONLY_CHECK_ONLINE 2
+#define FLAG_HEDGE 4
 
 #define SERVER_FLAG_RUNNING 1
 #define SERVER_FLAG_SYNCHRONIZING 2
@@ -158,6 +159,8 @@ struct siridb_server_s
     uint8_t ip_support;
     uint8_t pad0;
     uint32_t startup_time;
+    float latency; /* moving average of response times in seconds */
+    float latency_pct; /* estimated response time percentile, seconds */
     char * libuv;
     char * version;
     char * dbpath;
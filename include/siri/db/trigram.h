@@ -0,0 +1,29 @@
+/*
+ * trigram.h - Trigram index on series names.
+ */
+#ifndef SIRIDB_TRIGRAM_H_
+#define SIRIDB_TRIGRAM_H_
+
+typedef struct siridb_trigram_s siridb_trigram_t;
+
+#include <imap/imap.h>
+#include <inttypes.h>
+#include <siri/db/series.h>
+#include <stddef.h>
+#include <vec/vec.h>
+
+siridb_trigram_t * siridb_trigram_new(void);
+void siridb_trigram_free(siridb_trigram_t * trigram);
+int siridb_trigram_add(siridb_trigram_t * trigram, siridb_series_t * series);
+void siridb_trigram_pop(siridb_trigram_t * trigram, siridb_series_t * series);
+vec_t * siridb_trigram_match(
+        siridb_trigram_t * trigram,
+        const char * literals,
+        size_t len);
+
+struct siridb_trigram_s
+{
+    imap_t * grams;     /* trigram -> imap with series id -> series */
+};
+
+#endif  /* SIRIDB_TRIGRAM_H_ */
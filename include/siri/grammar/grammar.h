@@ -108,6 +108,7 @@ enum cleri_grammar_ids {
     CLERI_GID_HELP_LIST_SHARDS,
     CLERI_GID_HELP_LIST_USERS,
     CLERI_GID_HELP_NOACCESS,
+    CLERI_GID_HELP_PROFILE,
     CLERI_GID_HELP_REVOKE,
     CLERI_GID_HELP_SELECT,
     CLERI_GID_HELP_SHOW,
@@ -130,6 +131,8 @@ enum cleri_grammar_ids {
     CLERI_GID_K_BETWEEN,
     CLERI_GID_K_BUFFER_PATH,
     CLERI_GID_K_BUFFER_SIZE,
+    CLERI_GID_K_CACHE_HIT_RATIO,
+    CLERI_GID_K_CACHE_SIZE,
     CLERI_GID_K_COUNT,
     CLERI_GID_K_CREATE,
     CLERI_GID_K_CRITICAL,
@@ -138,6 +141,7 @@ enum cleri_grammar_ids {
     CLERI_GID_K_DBPATH,
     CLERI_GID_K_DEBUG,
     CLERI_GID_K_DERIVATIVE,
+    CLERI_GID_K_DESC,
     CLERI_GID_K_DIFFERENCE,
     CLERI_GID_K_DROP,
     CLERI_GID_K_DROP_THRESHOLD,
@@ -193,12 +197,15 @@ enum cleri_grammar_ids {
     CLERI_GID_K_ONLINE,
     CLERI_GID_K_OPEN_FILES,
     CLERI_GID_K_OR,
+    CLERI_GID_K_ORDER,
+    CLERI_GID_K_PACKAGES_PER_WRITE,
     CLERI_GID_K_PASSWORD,
     CLERI_GID_K_POINTS,
     CLERI_GID_K_POOL,
     CLERI_GID_K_POOLS,
     CLERI_GID_K_PORT,
     CLERI_GID_K_PREFIX,
+    CLERI_GID_K_PROFILE,
     CLERI_GID_K_PVARIANCE,
     CLERI_GID_K_READ,
     CLERI_GID_K_RECEIVED_POINTS,
@@ -252,9 +259,11 @@ enum cleri_grammar_ids {
     CLERI_GID_LIST_USERS,
     CLERI_GID_LOG_KEYWORDS,
     CLERI_GID_MERGE_AS,
+    CLERI_GID_ORDER_EXPR,
     CLERI_GID_POOL_COLUMNS,
     CLERI_GID_POOL_PROPS,
     CLERI_GID_PREFIX_EXPR,
+    CLERI_GID_PROFILE_STMT,
     CLERI_GID_REVOKE_STMT,
     CLERI_GID_REVOKE_USER,
     CLERI_GID_R_COMMENT,
@@ -270,6 +279,7 @@ enum cleri_grammar_ids {
     CLERI_GID_SELECT_AGGREGATE,
     CLERI_GID_SELECT_AGGREGATES,
     CLERI_GID_SELECT_STMT,
+    CLERI_GID_SERIES_AFTER,
     CLERI_GID_SERIES_ALL,
     CLERI_GID_SERIES_COLUMNS,
     CLERI_GID_SERIES_MATCH,
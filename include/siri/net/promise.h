@@ -22,6 +22,7 @@ typedef void (* sirinet_promise_cb)(
         int status);
 
 #include <uv.h>
+#include <time.h>
 #include <siri/net/stream.h>
 #include <siri/db/server.h>
 #include <siri/net/pkg.h>
@@ -43,6 +44,8 @@ struct sirinet_promise_s
     siridb_server_t * server;
     sirinet_pkg_t * pkg;
     void * data;
+    struct timespec start;  /* time when the package is sent */
+    float latency;          /* seconds, set by sirinet_promises_on_response */
 };
 
 #endif  /* SIRINET_PROMISE_H_ */
@@ -7,7 +7,7 @@
 typedef enum
 {
     /* Public requests */
-    CPROTO_REQ_QUERY=0,                 /* (query, time_precision)          */
+    CPROTO_REQ_QUERY=0,                 /* (query, time_precision[, flags]) */
     CPROTO_REQ_INSERT=1,                /* series with points map/array     */
     CPROTO_REQ_AUTH=2,                  /* (user, password, dbname)         */
     CPROTO_REQ_PING=3,                  /* empty                            */
@@ -31,6 +31,7 @@ typedef enum
     CPROTO_RES_AUTH_SUCCESS=2,          /* empty                            */
     CPROTO_RES_ACK=3,                   /* empty                            */
     CPROTO_RES_FILE=5,                  /* file content                     */
+    CPROTO_RES_QUERY_CHUNK=6,           /* {series: points, ...}            */
 
     /* Service API success */
     CPROTO_ACK_SERVICE=32,                /* empty                          */
@@ -127,6 +128,14 @@ typedef enum
 
 } bproto_server_t;
 
+/*
+ * Optional flags for CPROTO_REQ_QUERY. When CPROTO_QUERY_FLAG_STREAM is set,
+ * a select query response may be preceded by zero or more
+ * CPROTO_RES_QUERY_CHUNK packages. The final CPROTO_RES_QUERY package
+ * contains the remaining series.
+ */
+#define CPROTO_QUERY_FLAG_STREAM 1
+
 #define sirinet_protocol_is_error(tp) (tp >= 64 && tp < 192)
 #define sirinet_protocol_is_error_msg(tp) (tp >= 64 && tp < 70)
 
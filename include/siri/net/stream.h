@@ -34,6 +34,7 @@ void sirinet_stream_on_data(
         ssize_t nread,
         const uv_buf_t * buf);
 void sirinet__stream_free(uv_stream_t * uvclient);
+void sirinet_stream_pool_destroy(void);
 
 #define sirinet_stream_incref(client) \
     (client)->ref++
@@ -54,9 +55,11 @@ struct sirinet_stream_s
     siridb_t * siridb;
     void * origin;  /* can be a user, server or NULL */
     char * buf;
-    size_t len;
+    size_t len;     /* received bytes in buf                */
+    size_t pos;     /* start of the first unhandled package */
     size_t size;
     uv_stream_t * stream;
+    struct sirinet_wqueue_s * wqueue;  /* created on the first write */
 };
 
 #endif  /* SIRINET_STREAM_H_ */
@@ -0,0 +1,60 @@
+/*
+ * wqueue.h - Write queue for coalescing packages on a stream.
+ */
+#ifndef SIRINET_WQUEUE_H_
+#define SIRINET_WQUEUE_H_
+
+typedef struct sirinet_wqueue_s sirinet_wqueue_t;
+typedef struct sirinet_witem_s sirinet_witem_t;
+typedef struct sirinet_witems_s sirinet_witems_t;
+
+#include <inttypes.h>
+#include <siri/net/pkg.h>
+#include <siri/net/stream.h>
+#include <uv.h>
+
+/*
+ * When a call-back is used, the call-back is responsible for the package,
+ * otherwise the package will be destroyed when it is written.
+ */
+typedef void (* sirinet_wqueue_cb)(void * data, int status);
+
+sirinet_wqueue_t * sirinet_wqueue_new(sirinet_stream_t * client);
+void sirinet_wqueue_free(sirinet_wqueue_t * wqueue);
+int sirinet_wqueue_write(
+        sirinet_stream_t * client,
+        sirinet_pkg_t * pkg,
+        sirinet_wqueue_cb cb,
+        void * data);
+size_t sirinet_wqueue_pending_size(sirinet_stream_t * client);
+double sirinet_wqueue_packages_per_write(void);
+
+struct sirinet_witem_s
+{
+    /* copy of the header since a package can be sent to more streams */
+    unsigned char header[sizeof(sirinet_pkg_t)];
+    sirinet_pkg_t * pkg;
+    sirinet_wqueue_cb cb;
+    void * data;
+};
+
+struct sirinet_witems_s
+{
+    size_t len;
+    size_t size;
+    sirinet_witem_t * items;
+};
+
+struct sirinet_wqueue_s
+{
+    uv_write_t req;                 /* re-used for each write           */
+    sirinet_stream_t * client;
+    sirinet_witems_t * writing;     /* items in the current write       */
+    sirinet_witems_t * pending;     /* items waiting for the next write */
+    uv_buf_t * bufs;                /* two buffers for each item        */
+    size_t nbufs;
+    size_t pending_size;            /* bytes in the pending items       */
+    int err;                        /* status of a write which failed   */
+};
+
+#endif  /* SIRINET_WQUEUE_H_ */
@@ -39,6 +39,7 @@ extern siri_t siri;
 #include <siri/optimize.h>
 #include <siri/backup.h>
 #include <siri/heartbeat.h>
+#include <siri/slowlog.h>
 #include <siri/cfg/cfg.h>
 #include <siri/args/args.h>
 #include <llist/llist.h>
@@ -58,6 +59,7 @@ struct siri_s
     uv_timer_t * backup;
     uv_timer_t * heartbeat;
     uv_timer_t * buffersync;
+    siri_slowlog_t * slowlog;
     siri_cfg_t * cfg;
     siri_args_t * args;
     uv_mutex_t siridb_mutex;
@@ -0,0 +1,25 @@
+/*
+ * slowlog.h - Log queries which exceed the slow query threshold.
+ */
+#ifndef SIRI_SLOWLOG_H_
+#define SIRI_SLOWLOG_H_
+
+typedef struct siri_slowlog_s siri_slowlog_t;
+
+#include <inttypes.h>
+#include <siri/siri.h>
+#include <siri/db/query.h>
+
+void siri_slowlog_init(siri_t * siri);
+void siri_slowlog_destroy(siri_t * siri);
+int siri_slowlog_sample(siri_t * siri);
+void siri_slowlog_query(siridb_query_t * query);
+
+struct siri_slowlog_s
+{
+    int fd;
+    uint32_t threshold;     /* in milliseconds */
+    uint32_t sample_rate;   /* percentage of queries which are profiled */
+};
+
+#endif  /* SIRI_SLOWLOG_H_ */
@@ -0,0 +1,866 @@
+/*
+ * bmap.c - Compressed bitmap for uint32_t keys with set operation support.
+ *
+ * Keys are divided over containers using the high 16 bits. A container
+ * stores the low 16 bits in a sorted array as long as it holds at most
+ * BMAP_ARRAY_MAX keys and switches to a bitmap of 65536 bits (8KB) when it
+ * holds more. Set operations work per container using merges or bitwise
+ * operations and never touch the objects the keys are referring to.
+ */
+#include <bmap/bmap.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BMAP_WORDS 1024     /* 64 bit words in a bitmap container */
+
+#define BMAP_BIT(low) (1ULL << ((low) & 63))
+#define BMAP_WORD(bits, low) (bits)[(low) >> 6]
+
+static bmap_container_t * BMAP_find(
+        bmap_t * bmap,
+        uint16_t key,
+        uint32_t * pos);
+static bmap_container_t * BMAP_insert(
+        bmap_t * bmap,
+        uint16_t key,
+        uint32_t pos);
+static void BMAP_remove(bmap_t * bmap, uint32_t pos);
+static void BMAP_update_len(bmap_t * bmap);
+static uint32_t BMAP_search(bmap_container_t * c, uint16_t low);
+static int BMAP_has(bmap_container_t * c, uint16_t low);
+static int BMAP_add(bmap_container_t * c, uint16_t low);
+static int BMAP_pop(bmap_container_t * c, uint16_t low);
+static int BMAP_copy(bmap_container_t * dest, bmap_container_t * c);
+static int BMAP_to_bits(bmap_container_t * c);
+static void BMAP_to_array(bmap_container_t * c);
+static void BMAP_count(bmap_container_t * c);
+static void BMAP_container_free(bmap_container_t * c);
+static int BMAP_union(bmap_container_t * dest, bmap_container_t * c);
+static int BMAP_intersection(bmap_container_t * dest, bmap_container_t * c);
+static void BMAP_difference(bmap_container_t * dest, bmap_container_t * c);
+static int BMAP_symmetric_difference(
+        bmap_container_t * dest,
+        bmap_container_t * c);
+
+/*
+ * Returns NULL in case an error has occurred.
+ */
+bmap_t * bmap_new(void)
+{
+    return (bmap_t *) calloc(1, sizeof(bmap_t));
+}
+
+/*
+ * Destroy bmap. (parsing NULL is not allowed)
+ */
+void bmap_free(bmap_t * bmap)
+{
+    bmap_clear(bmap);
+    free(bmap->containers);
+    free(bmap);
+}
+
+/*
+ * Remove all keys from the bmap.
+ */
+void bmap_clear(bmap_t * bmap)
+{
+    uint32_t i;
+
+    for (i = 0; i < bmap->n; i++)
+    {
+        BMAP_container_free(bmap->containers + i);
+    }
+
+    bmap->n = 0;
+    bmap->len = 0;
+}
+
+/*
+ * Returns 1 when the id is added, 0 when the id already exists or -1 in case
+ * of an allocation error.
+ */
+int bmap_add(bmap_t * bmap, uint32_t id)
+{
+    uint32_t pos;
+    bmap_container_t * c = BMAP_find(bmap, id >> 16, &pos);
+    int rc;
+
+    if (c == NULL && (c = BMAP_insert(bmap, id >> 16, pos)) == NULL)
+    {
+        return -1;
+    }
+
+    rc = BMAP_add(c, (uint16_t) id);
+
+    if (rc == 1)
+    {
+        bmap->len++;
+    }
+    else if (rc == -1 && !c->len)
+    {
+        BMAP_remove(bmap, pos);
+    }
+
+    return rc;
+}
+
+/*
+ * Returns 1 when the id is removed or 0 if the id was not found.
+ */
+int bmap_pop(bmap_t * bmap, uint32_t id)
+{
+    uint32_t pos;
+    bmap_container_t * c = BMAP_find(bmap, id >> 16, &pos);
+
+    if (c == NULL || !BMAP_pop(c, (uint16_t) id))
+    {
+        return 0;
+    }
+
+    bmap->len--;
+
+    if (!c->len)
+    {
+        BMAP_remove(bmap, pos);
+    }
+
+    return 1;
+}
+
+/*
+ * Returns 1 when the id exists or 0 if not.
+ */
+int bmap_has(bmap_t * bmap, uint32_t id)
+{
+    uint32_t pos;
+    bmap_container_t * c = BMAP_find(bmap, id >> 16, &pos);
+
+    return c != NULL && BMAP_has(c, (uint16_t) id);
+}
+
+/*
+ * Call 'cb' for each id in ascending order. Walking stops when the call-back
+ * returns a non-zero value which is then returned.
+ */
+int bmap_walk(bmap_t * bmap, bmap_cb cb, void * args)
+{
+    bmap_container_t * c;
+    uint64_t word;
+    uint32_t base, i;
+    int rc;
+
+    for (c = bmap->containers; c < bmap->containers + bmap->n; c++)
+    {
+        base = (uint32_t) c->key << 16;
+
+        if (c->bits == NULL)
+        {
+            for (i = 0; i < c->len; i++)
+            {
+                if ((rc = (*cb)(base | c->array[i], args)))
+                {
+                    return rc;
+                }
+            }
+            continue;
+        }
+
+        for (i = 0; i < BMAP_WORDS; i++)
+        {
+            for (word = c->bits[i]; word; word &= word - 1)
+            {
+                if ((rc = (*cb)(
+                        base | (i << 6) | __builtin_ctzll(word),
+                        args)))
+                {
+                    return rc;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Add all ids from 'bmap' to 'dest'.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error in which
+ * case 'dest' might contain only a part of the ids.
+ */
+int bmap_union(bmap_t * dest, bmap_t * bmap)
+{
+    bmap_container_t * c, * d;
+    uint32_t i, pos;
+    int rc = 0;
+
+    for (i = 0; !rc && i < bmap->n; i++)
+    {
+        c = bmap->containers + i;
+        d = BMAP_find(dest, c->key, &pos);
+
+        if (d != NULL)
+        {
+            rc = BMAP_union(d, c);
+        }
+        else if ((d = BMAP_insert(dest, c->key, pos)) == NULL)
+        {
+            rc = -1;
+        }
+        else if ((rc = BMAP_copy(d, c)))
+        {
+            BMAP_remove(dest, pos);
+        }
+    }
+
+    BMAP_update_len(dest);
+    return rc;
+}
+
+/*
+ * Keep only the ids in 'dest' which also exist in 'bmap'.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error in which
+ * case 'dest' might be only partially updated.
+ */
+int bmap_intersection(bmap_t * dest, bmap_t * bmap)
+{
+    bmap_container_t * c, * d;
+    uint32_t i, pos;
+    int rc = 0;
+
+    for (i = dest->n; i--;)
+    {
+        d = dest->containers + i;
+        c = BMAP_find(bmap, d->key, &pos);
+
+        if (c != NULL && BMAP_intersection(d, c))
+        {
+            rc = -1;
+        }
+
+        if (c == NULL || !d->len)
+        {
+            BMAP_remove(dest, i);
+        }
+    }
+
+    BMAP_update_len(dest);
+    return rc;
+}
+
+/*
+ * Remove all ids in 'bmap' from 'dest'. Always returns 0 since no memory
+ * needs to be allocated but the signature is compatible with bmap_update_cb.
+ */
+int bmap_difference(bmap_t * dest, bmap_t * bmap)
+{
+    bmap_container_t * c, * d;
+    uint32_t i, pos;
+
+    for (i = dest->n; i--;)
+    {
+        d = dest->containers + i;
+        c = BMAP_find(bmap, d->key, &pos);
+
+        if (c != NULL)
+        {
+            BMAP_difference(d, c);
+            if (!d->len)
+            {
+                BMAP_remove(dest, i);
+            }
+        }
+    }
+
+    BMAP_update_len(dest);
+    return 0;
+}
+
+/*
+ * Keep the ids which exist in either 'dest' or 'bmap' but not in both.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error in which
+ * case 'dest' might be only partially updated.
+ */
+int bmap_symmetric_difference(bmap_t * dest, bmap_t * bmap)
+{
+    bmap_container_t * c, * d;
+    uint32_t i, pos;
+    int rc = 0;
+
+    for (i = 0; !rc && i < bmap->n; i++)
+    {
+        c = bmap->containers + i;
+        d = BMAP_find(dest, c->key, &pos);
+
+        if (d != NULL)
+        {
+            rc = BMAP_symmetric_difference(d, c);
+            if (!d->len)
+            {
+                BMAP_remove(dest, pos);
+            }
+        }
+        else if ((d = BMAP_insert(dest, c->key, pos)) == NULL)
+        {
+            rc = -1;
+        }
+        else if ((rc = BMAP_copy(d, c)))
+        {
+            BMAP_remove(dest, pos);
+        }
+    }
+
+    BMAP_update_len(dest);
+    return rc;
+}
+
+/*
+ * Returns the container for 'key' or NULL if not found. The position of the
+ * container, or where the container should be inserted, is set to 'pos'.
+ */
+static bmap_container_t * BMAP_find(
+        bmap_t * bmap,
+        uint16_t key,
+        uint32_t * pos)
+{
+    uint32_t lo = 0, hi = bmap->n, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (bmap->containers[mid].key < key)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    *pos = lo;
+
+    return (lo < bmap->n && bmap->containers[lo].key == key) ?
+            bmap->containers + lo : NULL;
+}
+
+/*
+ * Returns a new and empty container at position 'pos' or NULL in case of
+ * an allocation error. Pointers to other containers are invalid after
+ * calling this function.
+ */
+static bmap_container_t * BMAP_insert(
+        bmap_t * bmap,
+        uint16_t key,
+        uint32_t pos)
+{
+    bmap_container_t * c;
+
+    if (bmap->n == bmap->size)
+    {
+        uint32_t size = bmap->size ? bmap->size * 2 : 4;
+
+        c = (bmap_container_t *) realloc(
+                bmap->containers,
+                size * sizeof(bmap_container_t));
+
+        if (c == NULL)
+        {
+            return NULL;
+        }
+
+        bmap->containers = c;
+        bmap->size = size;
+    }
+
+    c = bmap->containers + pos;
+    memmove(c + 1, c, (bmap->n - pos) * sizeof(bmap_container_t));
+    bmap->n++;
+
+    c->key = key;
+    c->len = 0;
+    c->size = 0;
+    c->array = NULL;
+    c->bits = NULL;
+
+    return c;
+}
+
+static void BMAP_remove(bmap_t * bmap, uint32_t pos)
+{
+    bmap_container_t * c = bmap->containers + pos;
+
+    BMAP_container_free(c);
+    bmap->n--;
+    memmove(c, c + 1, (bmap->n - pos) * sizeof(bmap_container_t));
+}
+
+static void BMAP_update_len(bmap_t * bmap)
+{
+    uint32_t i;
+
+    for (bmap->len = 0, i = 0; i < bmap->n; i++)
+    {
+        bmap->len += bmap->containers[i].len;
+    }
+}
+
+/*
+ * Returns the position in the array where 'low' is or should be inserted.
+ */
+static uint32_t BMAP_search(bmap_container_t * c, uint16_t low)
+{
+    uint32_t lo = 0, hi = c->len, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (c->array[mid] < low)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static int BMAP_has(bmap_container_t * c, uint16_t low)
+{
+    uint32_t i;
+
+    if (c->bits != NULL)
+    {
+        return (BMAP_WORD(c->bits, low) & BMAP_BIT(low)) != 0;
+    }
+
+    i = BMAP_search(c, low);
+    return i < c->len && c->array[i] == low;
+}
+
+/*
+ * Returns 1 when added, 0 when the key already exists or -1 in case of an
+ * allocation error.
+ */
+static int BMAP_add(bmap_container_t * c, uint16_t low)
+{
+    uint32_t i;
+
+    if (c->bits != NULL)
+    {
+        if (BMAP_WORD(c->bits, low) & BMAP_BIT(low))
+        {
+            return 0;
+        }
+        BMAP_WORD(c->bits, low) |= BMAP_BIT(low);
+        c->len++;
+        return 1;
+    }
+
+    i = BMAP_search(c, low);
+
+    if (i < c->len && c->array[i] == low)
+    {
+        return 0;
+    }
+
+    if (c->len == BMAP_ARRAY_MAX)
+    {
+        return BMAP_to_bits(c) ? -1 : BMAP_add(c, low);
+    }
+
+    if (c->len == c->size)
+    {
+        uint32_t size = c->size ? c->size * 2 : 4;
+        uint16_t * tmp = (uint16_t *) realloc(
+                c->array,
+                size * sizeof(uint16_t));
+
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+
+        c->array = tmp;
+        c->size = size;
+    }
+
+    memmove(c->array + i + 1, c->array + i, (c->len - i) * sizeof(uint16_t));
+    c->array[i] = low;
+    c->len++;
+
+    return 1;
+}
+
+/*
+ * Returns 1 when removed or 0 if the key was not found.
+ */
+static int BMAP_pop(bmap_container_t * c, uint16_t low)
+{
+    uint32_t i;
+
+    if (c->bits != NULL)
+    {
+        if (!(BMAP_WORD(c->bits, low) & BMAP_BIT(low)))
+        {
+            return 0;
+        }
+        BMAP_WORD(c->bits, low) &= ~BMAP_BIT(low);
+        c->len--;
+
+        /* use half the maximum so we do not switch on each add/pop */
+        if (c->len <= BMAP_ARRAY_MAX / 2)
+        {
+            BMAP_to_array(c);
+        }
+        return 1;
+    }
+
+    i = BMAP_search(c, low);
+
+    if (i == c->len || c->array[i] != low)
+    {
+        return 0;
+    }
+
+    c->len--;
+    memmove(c->array + i, c->array + i + 1, (c->len - i) * sizeof(uint16_t));
+
+    return 1;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int BMAP_copy(bmap_container_t * dest, bmap_container_t * c)
+{
+    if (c->bits != NULL)
+    {
+        dest->bits = (uint64_t *) malloc(BMAP_WORDS * sizeof(uint64_t));
+        if (dest->bits == NULL)
+        {
+            return -1;
+        }
+        memcpy(dest->bits, c->bits, BMAP_WORDS * sizeof(uint64_t));
+    }
+    else
+    {
+        dest->array = (uint16_t *) malloc(c->len * sizeof(uint16_t));
+        if (dest->array == NULL)
+        {
+            return -1;
+        }
+        memcpy(dest->array, c->array, c->len * sizeof(uint16_t));
+        dest->size = c->len;
+    }
+
+    dest->len = c->len;
+    return 0;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int BMAP_to_bits(bmap_container_t * c)
+{
+    uint64_t * bits = (uint64_t *) calloc(BMAP_WORDS, sizeof(uint64_t));
+    uint32_t i;
+
+    if (bits == NULL)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < c->len; i++)
+    {
+        BMAP_WORD(bits, c->array[i]) |= BMAP_BIT(c->array[i]);
+    }
+
+    free(c->array);
+    c->array = NULL;
+    c->size = 0;
+    c->bits = bits;
+
+    return 0;
+}
+
+/*
+ * Convert a bitmap container to an array. This is not critical so in case
+ * of an allocation error we simply keep the bitmap.
+ */
+static void BMAP_to_array(bmap_container_t * c)
+{
+    uint16_t * array = (uint16_t *) malloc(c->len * sizeof(uint16_t));
+    uint64_t word;
+    uint32_t i, n = 0;
+
+    if (array == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < BMAP_WORDS; i++)
+    {
+        for (word = c->bits[i]; word; word &= word - 1)
+        {
+            array[n++] = (uint16_t) ((i << 6) | __builtin_ctzll(word));
+        }
+    }
+
+    free(c->bits);
+    c->bits = NULL;
+    c->array = array;
+    c->size = c->len;
+}
+
+/*
+ * Update the length of a bitmap container and convert to an array when
+ * possible.
+ */
+static void BMAP_count(bmap_container_t * c)
+{
+    uint32_t i;
+
+    for (c->len = 0, i = 0; i < BMAP_WORDS; i++)
+    {
+        c->len += __builtin_popcountll(c->bits[i]);
+    }
+
+    if (c->len && c->len <= BMAP_ARRAY_MAX)
+    {
+        BMAP_to_array(c);
+    }
+}
+
+static void BMAP_container_free(bmap_container_t * c)
+{
+    free(c->array);
+    free(c->bits);
+}
+
+static int BMAP_union(bmap_container_t * dest, bmap_container_t * c)
+{
+    uint32_t i, j, n;
+
+    if (    dest->bits == NULL &&
+            c->bits == NULL &&
+            dest->len + c->len <= BMAP_ARRAY_MAX)
+    {
+        uint16_t * array = (uint16_t *) malloc(
+                (dest->len + c->len) * sizeof(uint16_t));
+
+        if (array == NULL)
+        {
+            return -1;
+        }
+
+        for (i = j = n = 0; i < dest->len || j < c->len;)
+        {
+            if (j == c->len || (i < dest->len && dest->array[i] < c->array[j]))
+            {
+                array[n++] = dest->array[i++];
+            }
+            else if (i == dest->len || c->array[j] < dest->array[i])
+            {
+                array[n++] = c->array[j++];
+            }
+            else
+            {
+                array[n++] = dest->array[i++];
+                j++;
+            }
+        }
+
+        free(dest->array);
+        dest->array = array;
+        dest->size = dest->len + c->len;
+        dest->len = n;
+
+        return 0;
+    }
+
+    if (dest->bits == NULL && BMAP_to_bits(dest))
+    {
+        return -1;
+    }
+
+    if (c->bits != NULL)
+    {
+        for (i = 0; i < BMAP_WORDS; i++)
+        {
+            dest->bits[i] |= c->bits[i];
+        }
+    }
+    else
+    {
+        for (i = 0; i < c->len; i++)
+        {
+            BMAP_WORD(dest->bits, c->array[i]) |= BMAP_BIT(c->array[i]);
+        }
+    }
+
+    BMAP_count(dest);
+    return 0;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error in which case
+ * the length of 'dest' is set to zero.
+ */
+static int BMAP_intersection(bmap_container_t * dest, bmap_container_t * c)
+{
+    uint32_t i, n = 0;
+
+    if (dest->bits == NULL)
+    {
+        for (i = 0; i < dest->len; i++)
+        {
+            if (BMAP_has(c, dest->array[i]))
+            {
+                dest->array[n++] = dest->array[i];
+            }
+        }
+        dest->len = n;
+        return 0;
+    }
+
+    if (c->bits == NULL)
+    {
+        uint16_t * array = (uint16_t *) malloc(c->len * sizeof(uint16_t));
+
+        if (array == NULL)
+        {
+            dest->len = 0;
+            return -1;
+        }
+
+        for (i = 0; i < c->len; i++)
+        {
+            if (BMAP_WORD(dest->bits, c->array[i]) & BMAP_BIT(c->array[i]))
+            {
+                array[n++] = c->array[i];
+            }
+        }
+
+        free(dest->bits);
+        dest->bits = NULL;
+        dest->array = array;
+        dest->size = c->len;
+        dest->len = n;
+        return 0;
+    }
+
+    for (i = 0; i < BMAP_WORDS; i++)
+    {
+        dest->bits[i] &= c->bits[i];
+    }
+
+    BMAP_count(dest);
+    return 0;
+}
+
+static void BMAP_difference(bmap_container_t * dest, bmap_container_t * c)
+{
+    uint32_t i, n = 0;
+
+    if (dest->bits == NULL)
+    {
+        for (i = 0; i < dest->len; i++)
+        {
+            if (!BMAP_has(c, dest->array[i]))
+            {
+                dest->array[n++] = dest->array[i];
+            }
+        }
+        dest->len = n;
+        return;
+    }
+
+    if (c->bits != NULL)
+    {
+        for (i = 0; i < BMAP_WORDS; i++)
+        {
+            dest->bits[i] &= ~c->bits[i];
+        }
+    }
+    else
+    {
+        for (i = 0; i < c->len; i++)
+        {
+            BMAP_WORD(dest->bits, c->array[i]) &= ~BMAP_BIT(c->array[i]);
+        }
+    }
+
+    BMAP_count(dest);
+}
+
+static int BMAP_symmetric_difference(
+        bmap_container_t * dest,
+        bmap_container_t * c)
+{
+    uint32_t i, j, n;
+
+    if (dest->bits == NULL && c->bits == NULL)
+    {
+        uint16_t * array = (uint16_t *) malloc(
+                (dest->len + c->len) * sizeof(uint16_t));
+
+        if (array == NULL)
+        {
+            return -1;
+        }
+
+        for (i = j = n = 0; i < dest->len || j < c->len;)
+        {
+            if (j == c->len || (i < dest->len && dest->array[i] < c->array[j]))
+            {
+                array[n++] = dest->array[i++];
+            }
+            else if (i == dest->len || c->array[j] < dest->array[i])
+            {
+                array[n++] = c->array[j++];
+            }
+            else
+            {
+                i++;
+                j++;
+            }
+        }
+
+        free(dest->array);
+        dest->array = array;
+        dest->size = dest->len + c->len;
+        dest->len = n;
+
+        return (n > BMAP_ARRAY_MAX) ? BMAP_to_bits(dest) : 0;
+    }
+
+    if (dest->bits == NULL && BMAP_to_bits(dest))
+    {
+        return -1;
+    }
+
+    if (c->bits != NULL)
+    {
+        for (i = 0; i < BMAP_WORDS; i++)
+        {
+            dest->bits[i] ^= c->bits[i];
+        }
+    }
+    else
+    {
+        for (i = 0; i < c->len; i++)
+        {
+            BMAP_WORD(dest->bits, c->array[i]) ^= BMAP_BIT(c->array[i]);
+        }
+    }
+
+    BMAP_count(dest);
+    return 0;
+}
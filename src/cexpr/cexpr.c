@@ -276,6 +276,42 @@ int cexpr_contains(cexpr_t * cexpr, cexpr_cb_prop_t cb)
     return 0;
 }
 
+/*
+ * Call 'cb' for each condition which must be true for the expression to be
+ * true, which are the conditions only joined by AND. Conditions within an OR
+ * are skipped.
+ *
+ * Returns 0 or the first non-zero value returned by the call-back.
+ */
+int cexpr_required(cexpr_t * cexpr, cexpr_cb_cond_t cb, void * args)
+{
+    int rc = 0;
+
+    if (cexpr->operator != CEXPR_AND)
+    {
+        return 0;
+    }
+
+    switch (cexpr->tp_a)
+    {
+    case VIA_CEXPR: rc = cexpr_required(cexpr->via_a.cexpr, cb, args); break;
+    case VIA_COND: rc = cb(cexpr->via_a.cond, args); break;
+    }
+
+    if (rc)
+    {
+        return rc;
+    }
+
+    switch (cexpr->tp_b)
+    {
+    case VIA_CEXPR: rc = cexpr_required(cexpr->via_b.cexpr, cb, args); break;
+    case VIA_COND: rc = cb(cexpr->via_b.cond, args); break;
+    }
+
+    return rc;
+}
+
 void cexpr_free(cexpr_t * cexpr)
 {
     switch (cexpr->tp_a)
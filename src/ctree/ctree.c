@@ -39,6 +39,20 @@ static void CT_valuesn(
         size_t * n,
         ct_val_cb cb,
         void * args);
+static void CT_valuesn_after(
+        ct_node_t * node,
+        const char * key,
+        size_t * n,
+        ct_val_cb cb,
+        void * args);
+static void CT_valuesn_after_nodes(
+        ct_nodes_t * nodes,
+        uint8_t offset,
+        uint8_t sz,
+        const char * key,
+        size_t * n,
+        ct_val_cb cb,
+        void * args);
 static void CT_free(ct_node_t * node, ct_free_cb cb);
 
 /*
@@ -316,6 +330,119 @@ int ct_values(ct_t * ct, ct_val_cb cb, void * args)
     return rc;
 }
 
+/*
+ * Loop over all values with a key starting with 'prefix' and perform the
+ * call-back on each value. Only the sub-tree matching the prefix is
+ * visited. The prefix has length 'n' and is not required to be terminated.
+ *
+ * Returns the sum of all the call-backs.
+ */
+int ct_values_prefix(
+        ct_t * ct,
+        const char * prefix,
+        size_t n,
+        ct_val_cb cb,
+        void * args)
+{
+    ct_node_t * nd;
+    uint8_t k, pos;
+
+    if (!n)
+    {
+        return ct_values(ct, cb, args);
+    }
+
+    k = (uint8_t) *prefix;
+    pos = k / BLOCKSZ;
+
+    if (pos < ct->offset || pos >= ct->offset + ct->n)
+    {
+        return 0;
+    }
+
+    nd = (*ct->nodes)[k - ct->offset * BLOCKSZ];
+    prefix++;
+    n--;
+
+    while (nd)
+    {
+        if (n <= nd->len)
+        {
+            /* the prefix ends within this node */
+            return (strncmp(nd->key, prefix, n)) ?
+                    0 : CT_values(nd, cb, args);
+        }
+
+        if (strncmp(nd->key, prefix, nd->len) || !nd->nodes)
+        {
+            return 0;
+        }
+
+        prefix += nd->len;
+        n -= nd->len;
+
+        k = (uint8_t) *prefix;
+        pos = k / BLOCKSZ;
+
+        if (pos < nd->offset || pos >= nd->offset + nd->n)
+        {
+            return 0;
+        }
+
+        nd = (*nd->nodes)[k - nd->offset * BLOCKSZ];
+        prefix++;
+        n--;
+    }
+
+    return 0;
+}
+
+/*
+ * Perform the call-back on each value with a key which is a prefix of 'key',
+ * including the value for 'key' itself. Only the path to 'key' is visited
+ * and call-backs are performed with the shortest key first.
+ *
+ * Returns the sum of all the call-backs.
+ */
+int ct_prefixes(ct_t * ct, const char * key, ct_val_cb cb, void * args)
+{
+    ct_node_t * nd;
+    uint8_t k = (uint8_t) *key;
+    uint8_t pos = k / BLOCKSZ;
+    int rc = 0;
+
+    if (!*key || pos < ct->offset || pos >= ct->offset + ct->n)
+    {
+        return 0;
+    }
+
+    nd = (*ct->nodes)[k - ct->offset * BLOCKSZ];
+
+    while (nd && !strncmp(nd->key, ++key, nd->len))
+    {
+        key += nd->len;
+
+        if (nd->data != NULL)
+        {
+            rc += (*cb)(nd->data, args);
+        }
+
+        if (!*key || !nd->nodes) break;
+
+        k = (uint8_t) *key;
+        pos = k / BLOCKSZ;
+
+        if (pos < nd->offset || pos >= nd->offset + nd->n)
+        {
+            break;
+        }
+
+        nd = (*nd->nodes)[k - nd->offset * BLOCKSZ];
+    }
+
+    return rc;
+}
+
 /*
  * Walking stops either when the call-back is called on each value or
  * when 'n' is zero. 'n' will be decremented by the result of each call-back.
@@ -335,6 +462,21 @@ void ct_valuesn(ct_t * ct, size_t * n, ct_val_cb cb, void * args)
     }
 }
 
+/*
+ * Like ct_valuesn() but only values with a key greater than 'key' are
+ * visited. Values are visited in key order so this can be used to continue
+ * a previous walk which has ended at 'key'.
+ */
+void ct_valuesn_after(
+        ct_t * ct,
+        const char * key,
+        size_t * n,
+        ct_val_cb cb,
+        void * args)
+{
+    CT_valuesn_after_nodes(ct->nodes, ct->offset, ct->n, key, n, cb, args);
+}
+
 /*
  * Loop over all items in the tree and perform the call-back on each item.
  * Walking stops either when the call-back is called on each item or
@@ -460,6 +602,82 @@ static void CT_valuesn(
     }
 }
 
+/*
+ * Walk the values in 'node' with a key greater than 'key'. The first
+ * character of 'key' is already consumed by the parent.
+ */
+static void CT_valuesn_after(
+        ct_node_t * node,
+        const char * key,
+        size_t * n,
+        ct_val_cb cb,
+        void * args)
+{
+    uint32_t i;
+
+    for (i = 0; i < node->len; i++, key++)
+    {
+        if (node->key[i] != *key)
+        {
+            /* when 'key' ends here, the node key is greater as well */
+            if ((uint8_t) node->key[i] > (uint8_t) *key)
+            {
+                CT_valuesn(node, n, cb, args);
+            }
+            return;
+        }
+    }
+
+    /* the node key is equal to, or a prefix of 'key' so skip the value */
+    if (node->nodes != NULL)
+    {
+        CT_valuesn_after_nodes(
+                node->nodes,
+                node->offset,
+                node->n,
+                key,
+                n,
+                cb,
+                args);
+    }
+}
+
+/*
+ * Walk the children with a key greater than 'key'.
+ */
+static void CT_valuesn_after_nodes(
+        ct_nodes_t * nodes,
+        uint8_t offset,
+        uint8_t sz,
+        const char * key,
+        size_t * n,
+        ct_val_cb cb,
+        void * args)
+{
+    ct_node_t * nd;
+    uint_fast16_t i, c, end;
+    uint_fast16_t k = (uint8_t) *key;
+
+    for (i = 0, end = sz * BLOCKSZ; *n && i < end; i++)
+    {
+        if ((nd = (*nodes)[i]) == NULL)
+        {
+            continue;
+        }
+
+        c = i + offset * BLOCKSZ;
+
+        if (c > k)
+        {
+            CT_valuesn(nd, n, cb, args);
+        }
+        else if (c == k)
+        {
+            CT_valuesn_after(nd, key + 1, n, cb, args);
+        }
+    }
+}
+
 /*
  * Returns CT_OK when the item is added, CT_EXISTS if the item already exists,
  * or CT_ERR in case or an error.
@@ -36,6 +36,12 @@ static siri_cfg_t siri_cfg = {
         .pipe_support=0,
         .pipe_client_name="siridb_client.sock",
         .buffer_sync_interval=0,
+        .slow_query_threshold=0,
+        .slow_query_sample_rate=100,
+        .trigram_index=0,
+        .property_index=0,
+        .hedge_percentile=0,
+        .replicate_window=8,
 };
 
 static void SIRI_CFG_read_uint(
@@ -143,6 +149,59 @@ void siri_cfg_init(siri_t * siri)
             &tmp);
     siri_cfg.buffer_sync_interval = (uint32_t) tmp;
 
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "slow_query_threshold",
+            0,
+            3600000,  /* 1 hour */
+            &siri_cfg.slow_query_threshold);
+
+    if (siri_cfg.slow_query_threshold)
+    {
+        SIRI_CFG_read_uint(
+                cfgparser,
+                "slow_query_sample_rate",
+                1,
+                100,
+                &siri_cfg.slow_query_sample_rate);
+    }
+
+    tmp = siri_cfg.trigram_index;
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "enable_trigram_index",
+            0,
+            1,
+            &tmp);
+    siri_cfg.trigram_index = (uint8_t) tmp;
+
+    tmp = siri_cfg.property_index;
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "enable_property_index",
+            0,
+            1,
+            &tmp);
+    siri_cfg.property_index = (uint8_t) tmp;
+
+    tmp = siri_cfg.hedge_percentile;
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "hedge_percentile",
+            0,
+            99,
+            &tmp);
+    siri_cfg.hedge_percentile = (uint8_t) tmp;
+
+    tmp = siri_cfg.replicate_window;
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "replicate_window",
+            1,
+            64,
+            &tmp);
+    siri_cfg.replicate_window = (uint8_t) tmp;
+
     cfgparser_free(cfgparser);
 }
 
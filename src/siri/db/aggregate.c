@@ -544,8 +544,7 @@ static void AGGREGATE_free(siridb_aggr_t * aggr)
     if (aggr->filter_tp == TP_STRING)
     {
         free(aggr->filter_via.raw);
-        pcre2_code_free(aggr->regex);
-        pcre2_match_data_free(aggr->match_data);
+        siridb_re_free(aggr->regex, aggr->match_data);
     }
     free(aggr);
 }
@@ -13,6 +13,7 @@
 #include <procinfo/procinfo.h>
 #include <siri/db/db.h>
 #include <siri/db/misc.h>
+#include <siri/db/rcache.h>
 #include <siri/db/series.h>
 #include <siri/db/servers.h>
 #include <siri/db/shard.h>
@@ -48,6 +49,15 @@ static int siridb__from_unpacker(
 static siridb_t * siridb__from_dat(const char * dbpath);
 static int siridb__read_conf(siridb_t * siridb);
 static int siridb__lock(const char * dbpath, int lock_flags);
+static int siridb__build_trigrams(siridb_t * siridb);
+static int siridb__add_trigrams(
+        siridb_series_t * series,
+        siridb_trigram_t * trigrams);
+static int siridb__build_pindex(siridb_t * siridb);
+static int siridb__sum_length(siridb_series_t * series, uint64_t * length);
+static int siridb__add_pindex(
+        siridb_series_t * series,
+        siridb_pindex_t * pindex);
 
 #define READ_DB_EXIT_WITH_ERROR(ERROR_MSG)  \
     strcpy(err_msg, ERROR_MSG);             \
@@ -216,6 +226,24 @@ siridb_t * siridb_new(const char * dbpath, int lock_flags)
         return NULL;
     }
 
+    /* create the result cache for select queries */
+    if ((siridb->rcache = siridb_rcache_new(SIRIDB_RCACHE_MAX_SIZE)) == NULL)
+    {
+        log_error("Cannot create result cache for database '%s'",
+                siridb->dbname);
+        siridb_decref(siridb);
+        return NULL;
+    }
+
+    /* build the trigram index on series names when enabled */
+    if (siri.cfg->trigram_index && siridb__build_trigrams(siridb))
+    {
+        log_error("Cannot create trigram index for database '%s'",
+                siridb->dbname);
+        siridb_decref(siridb);
+        return NULL;
+    }
+
     /* update series props */
     log_info("Updating series properties");
 
@@ -237,6 +265,23 @@ siridb_t * siridb_new(const char * dbpath, int lock_flags)
 
     vec_free(vec);
 
+    /* from now on the total length is updated when series are changed */
+    siridb->series_length = 0;
+    imap_walk(
+            siridb->series_map,
+            (imap_cb) siridb__sum_length,
+            &siridb->series_length);
+
+    /* build the index on series properties when enabled, the properties
+     * must be updated before the index can be created */
+    if (siri.cfg->property_index && siridb__build_pindex(siridb))
+    {
+        log_error("Cannot create property index for database '%s'",
+                siridb->dbname);
+        siridb_decref(siridb);
+        return NULL;
+    }
+
     /* generate pools, this can raise a signal */
     log_info("Initialize pools");
     siridb_pools_init(siridb);
@@ -628,10 +673,12 @@ void siridb__free(siridb_t * siridb)
         imap_free(siridb->series_map, NULL);
     }
 
-    /* free c-tree lookup and series */
+    /* free name lookup and series */
     if (siridb->series != NULL)
     {
-        ct_free(siridb->series, (ct_free_cb) &siridb__series_decref);
+        siridb_names_free(
+                siridb->series,
+                (ct_free_cb) &siridb__series_decref);
     }
 
     /* free shards using imap walk an free the imap */
@@ -645,6 +692,21 @@ void siridb__free(siridb_t * siridb)
         siridb_groups_decref(siridb->groups);
     }
 
+    if (siridb->rcache != NULL)
+    {
+        siridb_rcache_free(siridb->rcache);
+    }
+
+    if (siridb->trigrams != NULL)
+    {
+        siridb_trigram_free(siridb->trigrams);
+    }
+
+    if (siridb->pindex != NULL)
+    {
+        siridb_pindex_free(siridb->pindex);
+    }
+
     /* unlock the database in case no siri_err occurred */
     if (!siri_err)
     {
@@ -677,7 +739,7 @@ static siridb_t * siridb__new(void)
     }
     else
     {
-        siridb->series = ct_new();
+        siridb->series = siridb_names_new();
         if (siridb->series == NULL)
         {
             ERR_ALLOC
@@ -689,7 +751,7 @@ static siridb_t * siridb__new(void)
             siridb->series_map = imap_new();
             if (siridb->series_map == NULL)
             {
-                ct_free(siridb->series, NULL);
+                siridb_names_free(siridb->series, NULL);
                 free(siridb);
                 siridb = NULL;
                 ERR_ALLOC
@@ -700,7 +762,7 @@ static siridb_t * siridb__new(void)
                 if (siridb->shards == NULL)
                 {
                     imap_free(siridb->series_map, NULL);
-                    ct_free(siridb->series, NULL);
+                    siridb_names_free(siridb->series, NULL);
                     free(siridb);
                     siridb = NULL;
                     ERR_ALLOC
@@ -714,7 +776,7 @@ static siridb_t * siridb__new(void)
                     {
                         imap_free(siridb->shards, NULL);
                         imap_free(siridb->series_map, NULL);
-                        ct_free(siridb->series, NULL);
+                        siridb_names_free(siridb->series, NULL);
                         free(siridb);
                         siridb = NULL;
                         ERR_ALLOC
@@ -725,6 +787,7 @@ static siridb_t * siridb__new(void)
                         siridb->dbpath = NULL;
                         siridb->ref = 1;
                         siridb->insert_tasks = 0;
+                        siridb->insert_decodes = 0;
                         siridb->flags = 0;
                         siridb->time = NULL;
                         siridb->users = NULL;
@@ -733,6 +796,7 @@ static siridb_t * siridb__new(void)
                         siridb->max_series_id = 0;
                         siridb->received_points = 0;
                         siridb->selected_points = 0;
+                        siridb->series_length = 0;
                         siridb->drop_threshold = DEF_DROP_THRESHOLD;
                         siridb->select_points_limit = DEF_SELECT_POINTS_LIMIT;
                         siridb->list_limit = DEF_LIST_LIMIT;
@@ -743,6 +807,9 @@ static siridb_t * siridb__new(void)
                         siridb->replicate = NULL;
                         siridb->reindex = NULL;
                         siridb->groups = NULL;
+                        siridb->rcache = NULL;
+                        siridb->trigrams = NULL;
+                        siridb->pindex = NULL;
 
                         /* make file pointers are NULL when file is closed */
                         siridb->dropped_fp = NULL;
@@ -901,5 +968,53 @@ static int siridb__lock(const char * dbpath, int lock_flags)
     return 0;
 }
 
+/*
+ * Returns 0 if successful or -1 in case of an error.
+ */
+static int siridb__build_trigrams(siridb_t * siridb)
+{
+    log_info("Building trigram index for %zu series", siridb->series_map->len);
 
+    siridb->trigrams = siridb_trigram_new();
 
+    return (siridb->trigrams == NULL || imap_walk(
+            siridb->series_map,
+            (imap_cb) siridb__add_trigrams,
+            siridb->trigrams)) ? -1 : 0;
+}
+
+static int siridb__add_trigrams(
+        siridb_series_t * series,
+        siridb_trigram_t * trigrams)
+{
+    return siridb_trigram_add(trigrams, series) ? 1 : 0;
+}
+
+static int siridb__sum_length(siridb_series_t * series, uint64_t * length)
+{
+    *length += series->length;
+    return 0;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an error.
+ */
+static int siridb__build_pindex(siridb_t * siridb)
+{
+    log_info("Building property index for %zu series",
+            siridb->series_map->len);
+
+    siridb->pindex = siridb_pindex_new(86400 * siridb->time->factor);
+
+    return (siridb->pindex == NULL || imap_walk(
+            siridb->series_map,
+            (imap_cb) siridb__add_pindex,
+            siridb->pindex)) ? -1 : 0;
+}
+
+static int siridb__add_pindex(
+        siridb_series_t * series,
+        siridb_pindex_t * pindex)
+{
+    return siridb_pindex_add(pindex, series) ? 1 : 0;
+}
@@ -11,11 +11,26 @@
 #include <siri/err.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #define FFILE_DEFAULT_SIZE 104857600  /* 100 MB  */
 #define FFILE_NUMBERS 9  /* how much numbers are used to generate the file.  */
 
+/* bytes stored before the size of a record */
+#define FFILE_REC_SIZE(sz)                      \
+    (siridb_ffile_pkg_size(sz) +                \
+        (((sz) & FFILE_CHECKSUM) ? sizeof(uint32_t) : 0))
+
+static uint32_t FFILE_checksum(const unsigned char * data, size_t n);
+static void FFILE_map(siridb_ffile_t * ffile);
+static int FFILE_read(
+        siridb_ffile_t * ffile,
+        long int pos,
+        void * buf,
+        size_t n);
+static int FFILE_truncate(siridb_ffile_t * ffile);
+
 /*
  * Open the fifo file. (set both the file pointer and file descriptor
  * In case of and error, fifo->fp is set to NULL
@@ -64,6 +79,10 @@ siridb_ffile_t * siridb_ffile_new(
 
     ffile->id = id;
     ffile->next_size = 0;
+    ffile->pop_size = 0;
+    ffile->last_pop = 0;
+    ffile->map_size = 0;
+    ffile->map = NULL;
 
     siridb_ffile_open(ffile, "r+");
 
@@ -82,15 +101,17 @@ siridb_ffile_t * siridb_ffile_new(
         if (pkg == NULL)
         {
             ffile->size = ffile->free_space = FFILE_DEFAULT_SIZE;
+            ffile->pop_pos = ffile->fsize = ffile->size;
         }
         else
         {
             /* we need 4 extra zeros (uint32_t) at the start of a fifo file */
-            size_t size = pkg->len + sizeof(sirinet_pkg_t) + 2 * sizeof(uint32_t);
+            size_t size = pkg->len + sizeof(sirinet_pkg_t) + 3 * sizeof(uint32_t);
 
             /* set free space to a value is will always fit */
             ffile->size = ffile->free_space = (size > FFILE_DEFAULT_SIZE) ?
                     size : FFILE_DEFAULT_SIZE;
+            ffile->pop_pos = ffile->fsize = ffile->size;
 
             /* because we has enough free space, this should always work */
             if (siridb_ffile_append(ffile, pkg) != FFILE_SUCCESS)
@@ -129,6 +150,9 @@ siridb_ffile_t * siridb_ffile_new(
             ffile->fp = NULL;
         }
 
+        ffile->pop_pos = ffile->fsize = ffile->size;
+        ffile->pop_size = ffile->next_size;
+
         if (!ffile->next_size)
         {
             log_debug("Empty fifo found, removing: '%s'", ffile->fn);
@@ -155,8 +179,11 @@ siridb_ffile_result_t siridb_ffile_append(
     assert (ffile->fp != NULL);
 
     uint32_t size = pkg->len + sizeof(sirinet_pkg_t);
+    uint32_t rec_size = size + sizeof(uint32_t);
+    uint32_t stored_size = size | FFILE_CHECKSUM;
+    uint32_t checksum;
 
-    if (ffile->free_space < size + 2 * sizeof(uint32_t))
+    if (ffile->free_space < rec_size + 2 * sizeof(uint32_t))
     {
         ffile->free_space = 0;
         return FFILE_NO_FREE_SPACE;
@@ -164,13 +191,24 @@ siridb_ffile_result_t siridb_ffile_append(
 
     if (!ffile->next_size)
     {
-        ffile->next_size = size;
+        ffile->next_size = stored_size;
     }
-    ffile->free_space -= size + sizeof(uint32_t);
+    ffile->free_space -= rec_size + sizeof(uint32_t);
+
+    if (    !ffile->pop_size &&
+            ffile->pop_pos ==
+                (long int) (ffile->free_space + rec_size + sizeof(uint32_t)))
+    {
+        /* all packages are popped, the new package is next */
+        ffile->pop_size = stored_size;
+    }
+
+    checksum = FFILE_checksum((const unsigned char *) pkg, size);
 
     if (    fseeko(ffile->fp, (off_t) ffile->free_space, SEEK_SET) ||
             fwrite((unsigned char *) pkg, size, 1, ffile->fp) != 1 ||
-            fwrite(&size, sizeof(uint32_t), 1, ffile->fp) != 1 ||
+            fwrite(&checksum, sizeof(uint32_t), 1, ffile->fp) != 1 ||
+            fwrite(&stored_size, sizeof(uint32_t), 1, ffile->fp) != 1 ||
             fflush(ffile->fp))
     {
         return FFILE_ERROR;
@@ -196,21 +234,35 @@ int siridb_ffile_check_fn(const char * fn)
 /*
  * returns a package object or NULL in case of an error.
  *
- * warning: be sure to check 'next_size' before calling this function.
+ * Packages are popped from 'pop_pos' so more packages can be popped before
+ * the first one is committed. Commits are always in the order of popping.
+ * A fifo file which is full is read using a memory map.
+ *
+ * warning: be sure to check 'pop_size' before calling this function.
  */
 sirinet_pkg_t * siridb_ffile_pop(siridb_ffile_t * ffile)
 {
-    assert (ffile->next_size);
+    assert (ffile->pop_size);
     assert (ffile->fp != NULL);
-    if (fseeko(
-            ffile->fp,
-            -(long int) (ffile->next_size + sizeof(uint32_t)),
-            SEEK_END))
+
+    uint32_t size = siridb_ffile_pkg_size(ffile->pop_size);
+    uint32_t checksum;
+    long int pos = ffile->pop_pos -
+            FFILE_REC_SIZE(ffile->pop_size) - sizeof(uint32_t);
+
+    if (!ffile->map_size)
     {
-        log_critical("Seek error in '%s'", ffile->fn);
+        FFILE_map(ffile);
+    }
+
+    if (size < sizeof(sirinet_pkg_t) || pos < 0)
+    {
+        log_critical(
+                "Corrupt package in fifo: '%s' ", ffile->fn);
         return NULL;
     }
-    sirinet_pkg_t * pkg = (sirinet_pkg_t *) malloc(ffile->next_size);
+
+    sirinet_pkg_t * pkg = (sirinet_pkg_t *) malloc(size);
 
     if (pkg == NULL)
     {
@@ -218,18 +270,26 @@ sirinet_pkg_t * siridb_ffile_pop(siridb_ffile_t * ffile)
         return NULL;
     }
 
-    if (fread(pkg, ffile->next_size, 1, ffile->fp) != 1)
+    if (FFILE_read(ffile, pos, pkg, size))
     {
         log_critical(
                 "Error while reading %" PRIu32 " bytes from '%s'",
-                ffile->next_size,
+                size,
                 ffile->fn);
         free(pkg);
         return NULL;
     }
 
-    if (    ffile->next_size < sizeof(sirinet_pkg_t) ||
-            pkg->len != ffile->next_size - sizeof(sirinet_pkg_t))
+    if (    pkg->len != size - sizeof(sirinet_pkg_t) ||
+            (   (ffile->pop_size & FFILE_CHECKSUM) &&
+                (   FFILE_read(
+                            ffile,
+                            pos + size,
+                            &checksum,
+                            sizeof(uint32_t)) ||
+                    checksum != FFILE_checksum(
+                            (const unsigned char *) pkg,
+                            size))))
     {
         log_critical(
                 "Corrupt package in fifo: '%s' ", ffile->fn);
@@ -237,9 +297,46 @@ sirinet_pkg_t * siridb_ffile_pop(siridb_ffile_t * ffile)
         return NULL;
     }
 
+    /* the size of the next package is stored before this package */
+    ffile->last_pop = ffile->pop_size;
+    ffile->pop_pos = pos;
+    ffile->pop_size = 0;
+    if (    pos > (long int) (ffile->free_space + sizeof(uint32_t)) &&
+            FFILE_read(
+                    ffile,
+                    pos - sizeof(uint32_t),
+                    &ffile->pop_size,
+                    sizeof(uint32_t)))
+    {
+        log_critical("Error while reading next size from '%s'", ffile->fn);
+        ffile->pop_size = 0;
+    }
+
     return pkg;
 }
 
+/*
+ * Undo the last pop. (pkg must be the package returned by the last pop)
+ */
+void siridb_ffile_unpop(
+        siridb_ffile_t * ffile,
+        sirinet_pkg_t * pkg __attribute__((unused)))
+{
+    assert (siridb_ffile_pkg_size(ffile->last_pop) ==
+            pkg->len + sizeof(sirinet_pkg_t));
+    ffile->pop_size = ffile->last_pop;
+    ffile->pop_pos += FFILE_REC_SIZE(ffile->pop_size) + sizeof(uint32_t);
+}
+
+/*
+ * Popped but not committed packages will be popped again.
+ */
+void siridb_ffile_pop_rewind(siridb_ffile_t * ffile)
+{
+    ffile->pop_pos = ffile->size;
+    ffile->pop_size = ffile->next_size;
+}
+
 /*
  * returns 0 if successful, -1 in case of an error
  *
@@ -249,15 +346,28 @@ int siridb_ffile_pop_commit(siridb_ffile_t * ffile)
 {
     assert (ffile->next_size && ffile->fp != NULL);
 
-    ffile->size -= ffile->next_size + sizeof(uint32_t);
+    ffile->size -= FFILE_REC_SIZE(ffile->next_size) + sizeof(uint32_t);
 
-    return (fseeko(
-                ffile->fp,
+    /*
+     * The file is truncated on each commit since a re-opened fifo file
+     * starts at the end of the file. (committed packages are not sent again
+     * after a restart)
+     */
+    int rc = (FFILE_read(
+                ffile,
                 ffile->size - sizeof(uint32_t),
-                SEEK_SET) ||
-            fread(&ffile->next_size, sizeof(uint32_t), 1, ffile->fp) != 1 ||
-            ftruncate(ffile->fd, ffile->size)) ?
+                &ffile->next_size,
+                sizeof(uint32_t)) ||
+            FFILE_truncate(ffile)) ?
                     -1 : 0;
+
+    if (ffile->pop_pos >= ffile->size)
+    {
+        /* all popped packages are committed */
+        siridb_ffile_pop_rewind(ffile);
+    }
+
+    return rc;
 }
 
 
@@ -266,6 +376,10 @@ int siridb_ffile_pop_commit(siridb_ffile_t * ffile)
  */
 void siridb_ffile_unlink(siridb_ffile_t * ffile)
 {
+    if (ffile->map != NULL)
+    {
+        munmap(ffile->map, ffile->map_size);
+    }
     if (ffile->fp != NULL && fclose(ffile->fp))
     {
         ERR_FILE
@@ -284,10 +398,104 @@ void siridb_ffile_unlink(siridb_ffile_t * ffile)
  */
 void siridb_ffile_free(siridb_ffile_t * ffile)
 {
-    if (ffile->fp != NULL && fclose(ffile->fp))
+    if (ffile->map != NULL)
+    {
+        munmap(ffile->map, ffile->map_size);
+    }
+    if (ffile->fp != NULL && siridb_ffile_close(ffile))
     {
         ERR_FILE
     }
     free(ffile->fn);
     free(ffile);
 }
+
+/*
+ * Truncate committed packages and close the file.
+ *
+ * Returns 0 if successful or another value in case of an error.
+ */
+int siridb_ffile_close(siridb_ffile_t * ffile)
+{
+    assert (ffile->fp != NULL);
+    int rc = (ffile->fsize > ffile->size) ? FFILE_truncate(ffile) : 0;
+
+    rc += fclose(ffile->fp);
+    ffile->fp = NULL;
+
+    return rc;
+}
+
+/*
+ * FNV-1a hash, used as checksum for packages in the fifo.
+ */
+static uint32_t FFILE_checksum(const unsigned char * data, size_t n)
+{
+    uint32_t h = 2166136261u;
+    while (n--)
+    {
+        h ^= *data++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*
+ * A fifo file which is full does not change except for truncating, so the
+ * file can be mapped. When mapping fails, the file is read with stdio.
+ */
+static void FFILE_map(siridb_ffile_t * ffile)
+{
+    void * map;
+
+    if (ffile->free_space)
+    {
+        return;  /* packages can still be appended */
+    }
+
+    map = mmap(NULL, ffile->size, PROT_READ, MAP_SHARED, ffile->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        log_warning("Cannot map fifo file: '%s'", ffile->fn);
+        ffile->map_size = -1;
+        return;
+    }
+
+    ffile->map = (char *) map;
+    ffile->map_size = ffile->size;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an error.
+ */
+static int FFILE_read(
+        siridb_ffile_t * ffile,
+        long int pos,
+        void * buf,
+        size_t n)
+{
+    if (ffile->map != NULL)
+    {
+        if (pos < 0 || pos + (long int) n > ffile->map_size)
+        {
+            return -1;
+        }
+        memcpy(buf, ffile->map + pos, n);
+        return 0;
+    }
+    return (fseeko(ffile->fp, pos, SEEK_SET) ||
+            fread(buf, n, 1, ffile->fp) != 1) ? -1 : 0;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an error.
+ */
+static int FFILE_truncate(siridb_ffile_t * ffile)
+{
+    if (ftruncate(ffile->fd, ffile->size))
+    {
+        return -1;
+    }
+    ffile->fsize = ffile->size;
+    return 0;
+}
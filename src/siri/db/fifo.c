@@ -109,13 +109,9 @@ int siridb_fifo_append(siridb_fifo_t * fifo, sirinet_pkg_t * pkg)
     switch(siridb_ffile_append(fifo->in, pkg))
     {
     case FFILE_NO_FREE_SPACE:
-        if (fifo->in != fifo->out)
+        if (fifo->in != fifo->out && siridb_ffile_close(fifo->in))
         {
-            if (fclose(fifo->in->fp))
-            {
-                ERR_FILE
-            }
-            fifo->in->fp = NULL;
+            ERR_FILE
         }
 
         fifo->in = siridb_ffile_new(++fifo->max_id, fifo->path, pkg);
@@ -146,8 +142,11 @@ int siridb_fifo_append(siridb_fifo_t * fifo, sirinet_pkg_t * pkg)
  * returns a package created with malloc or NULL when an error has occurred.
  * (signal is set in case of a malloc error, not in case of a file error)
  *
+ * Each popped package must be committed, in the order of popping, or the
+ * fifo must be rewound once all popped packages are handled.
+ *
  * warning:
- *      be sure to check the fifo using siridb_fifo_has_data() and
+ *      be sure to check the fifo using siridb_fifo_has_next() and
  *      siridb_fifo_is_open() before calling this function.
  */
 sirinet_pkg_t * siridb_fifo_pop(siridb_fifo_t * fifo)
@@ -155,15 +154,44 @@ sirinet_pkg_t * siridb_fifo_pop(siridb_fifo_t * fifo)
     sirinet_pkg_t * pkg = siridb_ffile_pop(fifo->out);
     if (pkg == NULL && !siri_err)
     {
-        /*
-         * In case siri_err is not set, we can try to recover by commiting an
-         * error. We should not do this in case of malloc errors.
-         */
-        siridb_fifo_commit_err(fifo);
+        if (siridb_ffile_pop_at_head(fifo->out))
+        {
+            /*
+             * In case siri_err is not set, we can try to recover by
+             * commiting an error. We should not do this in case of malloc
+             * errors.
+             */
+            siridb_fifo_commit_err(fifo);
+        }
+        else
+        {
+            /*
+             * Packages before this one are not committed yet. Stop popping
+             * until they are, this package will then be the first.
+             */
+            fifo->out->pop_size = 0;
+        }
     }
     return pkg;
 }
 
+/*
+ * Undo the last pop so the package will be returned by the next pop.
+ */
+void siridb_fifo_unpop(siridb_fifo_t * fifo, sirinet_pkg_t * pkg)
+{
+    siridb_ffile_unpop(fifo->out, pkg);
+}
+
+/*
+ * Pop again from the first package which is not committed. Only use this
+ * function when no popped package is waiting to be committed.
+ */
+void siridb_fifo_rewind(siridb_fifo_t * fifo)
+{
+    siridb_ffile_pop_rewind(fifo->out);
+}
+
 /*
  * returns 0 if successful or another value in case of errors.
  * (signal can be set when result is not 0)
@@ -233,14 +261,12 @@ int siridb_fifo_close(siridb_fifo_t * fifo)
     int rc = 0;
 
     /* close the 'in' fifo */
-    rc += fclose(fifo->in->fp);
-    fifo->in->fp = NULL;
+    rc += siridb_ffile_close(fifo->in);
 
     /* if 'out' is not the same as 'in', we also need to close 'out' */
     if (fifo->out->fp != NULL)
     {
-        rc += fclose(fifo->out->fp);
-        fifo->out->fp = NULL;
+        rc += siridb_ffile_close(fifo->out);
     }
 
     /* return 0 if successful or a negative value in case of errors */
@@ -258,13 +258,15 @@ int siridb_group_update_expression(
 
     /* replace group expression */
     free(group->source);
-    pcre2_code_free(group->regex);
-    pcre2_match_data_free(group->match_data);
+    siridb_re_free(group->regex, group->match_data);
 
     group->source = new_source;
     group->regex = new_regex;
     group->match_data = new_regex_match_data;
 
+    /* the group must move in the matcher for new series */
+    groups->flags |= GROUPS_FLAG_REBUILD;
+
     for (i = 0; i < group->series->len; i++)
     {
         series = (siridb_series_t *) group->series->data[i];
@@ -365,7 +367,6 @@ void siridb__group_free(siridb_group_t * group)
         vec_free(group->series);
     }
 
-    pcre2_code_free(group->regex);
-    pcre2_match_data_free(group->match_data);
+    siridb_re_free(group->regex, group->match_data);
     free(group);
 }
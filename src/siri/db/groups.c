@@ -16,6 +16,8 @@
  *
  *  Group thread:
  *      group->series :     read (no lock)      write (lock)
+ *      groups->prefixes :  read (lock)         write (lock)
+ *      groups->unanchored: read (lock)         write (lock)
  *
  *  Note:   One exception to 'not allowed' are the free functions
  *          since they only run when no other references to the object exist.
@@ -29,6 +31,7 @@
 #include <siri/db/group.h>
 #include <siri/db/groups.h>
 #include <siri/db/misc.h>
+#include <siri/db/re.h>
 #include <siri/db/series.h>
 #include <siri/err.h>
 #include <siri/net/protocol.h>
@@ -43,7 +46,7 @@
 #define GROUPS_LOOP_SLEEP 2  /* 2 seconds  */
 #define GROUPS_LOOP_DEEP 15  /* x times -> 30 seconds. used when re-indexing */
 #define GROUPS_RE_BATCH_SZ 1000
-#define CALC_BATCH_SIZE(sz) GROUPS_RE_BATCH_SZ /((sz / 5 ) + 1) + 1;
+#define CALC_BATCH_SIZE(sz) (GROUPS_RE_BATCH_SZ / (((sz) / 5) + 1) + 1)
 
 static int GROUPS_load(siridb_groups_t * groups);
 static void GROUPS_free(siridb_groups_t * groups);
@@ -56,6 +59,15 @@ static void GROUPS_init_groups(siridb_t * siridb);
 static void GROUPS_init_series(siridb_t * siridb);
 static int GROUPS_2vec(siridb_group_t * group, vec_t * groups_list);
 static void GROUPS_cleanup(siridb_groups_t * groups);
+static void GROUPS_wait(siridb_groups_t * groups);
+static int GROUPS_batch_size(siridb_groups_t * groups);
+static void GROUPS_free_matcher(siridb_groups_t * groups);
+static void GROUPS_build_matcher(siridb_groups_t * groups);
+static int GROUPS_matcher_add(
+        siridb_group_t * group,
+        siridb_groups_t * groups);
+static int GROUPS_match_series(vec_t * groups_list, siridb_series_t * series);
+static void GROUPS_free_prefix(vec_t * groups_list);
 /*
  * In case of an error the return value is NULL and a SIGNAL is raised.
  */
@@ -76,7 +88,10 @@ siridb_groups_t * siridb_groups_new(siridb_t * siridb)
         groups->groups = ct_new();
         groups->nseries = vec_new(VEC_DEFAULT_SIZE);
         groups->ngroups = vec_new(VEC_DEFAULT_SIZE);
+        groups->prefixes = NULL;
+        groups->unanchored = NULL;
         uv_mutex_init(&groups->mutex);
+        uv_cond_init(&groups->cond);
         groups->work.data = (siridb_t *) siridb;
 
         if (!groups->groups || !groups->nseries || !groups->ngroups)
@@ -98,8 +113,7 @@ siridb_groups_t * siridb_groups_new(siridb_t * siridb)
         else
         {
             groups->status = GROUPS_RUNNING;
-            groups->flags = 0;
-
+            groups->flags = GROUPS_FLAG_REBUILD;
         }
     }
 
@@ -132,6 +146,9 @@ int siridb_groups_add_series(
     if (vec_append_safe(&groups->nseries, series) == 0)
     {
         siridb_series_incref(series);
+
+        /* wake the group thread so the series is assigned right away */
+        uv_cond_signal(&groups->cond);
     }
     else
     {
@@ -194,6 +211,7 @@ int siridb_groups_add_group(
         break;
 
     case CT_OK:
+        groups->flags |= GROUPS_FLAG_REBUILD;
         if (vec_append_safe(&groups->ngroups, group))
         {
             siridb_group_decref(group);
@@ -218,7 +236,12 @@ int siridb_groups_add_group(
 
 void siridb_groups_destroy(siridb_groups_t * groups)
 {
+    uv_mutex_lock(&groups->mutex);
+
     groups->status = GROUPS_STOPPING;
+    uv_cond_signal(&groups->cond);
+
+    uv_mutex_unlock(&groups->mutex);
 }
 
 /*
@@ -314,6 +337,11 @@ int siridb_groups_drop_group(
 
     siridb_group_t * group = (siridb_group_t *) ct_pop(groups->groups, name);
 
+    if (group != NULL)
+    {
+        groups->flags |= GROUPS_FLAG_REBUILD;
+    }
+
     uv_mutex_unlock(&groups->mutex);
 
     if (group == NULL)
@@ -399,7 +427,10 @@ static void GROUPS_free(siridb_groups_t * groups)
         vec_free(groups->ngroups);
     }
 
+    GROUPS_free_matcher(groups);
+
     uv_mutex_destroy(&groups->mutex);
+    uv_cond_destroy(&groups->cond);
 
     free(groups);
 }
@@ -427,11 +458,18 @@ static void GROUPS_loop(uv_work_t * work)
 
     while (groups->status != GROUPS_STOPPING)
     {
-        sleep(GROUPS_LOOP_SLEEP);
+        if (siridb_is_reindexing(siridb))
+        {
+            sleep(GROUPS_LOOP_SLEEP);
 
-        if (siridb_is_reindexing(siridb) && (++mod_test % GROUPS_LOOP_DEEP))
+            if (++mod_test % GROUPS_LOOP_DEEP)
+            {
+                continue;
+            }
+        }
+        else
         {
-            continue;
+            GROUPS_wait(groups);
         }
 
         switch((siridb_groups_status_t) groups->status)
@@ -549,8 +587,13 @@ static void GROUPS_init_series(siridb_t * siridb)
 
     uv_mutex_lock(&groups->mutex);
 
+    if (groups->flags & GROUPS_FLAG_REBUILD)
+    {
+        GROUPS_build_matcher(groups);
+    }
+
     /* calculate modulo size  [1..1001] */
-    int m = CALC_BATCH_SIZE(groups->groups->len);
+    int m = GROUPS_batch_size(groups);
 
     while (groups->nseries->len)
     {
@@ -558,10 +601,22 @@ static void GROUPS_init_series(siridb_t * siridb)
 
         if (~series->flags & SIRIDB_SERIES_IS_DROPPED)
         {
-            ct_values(
-                    groups->groups,
-                    (ct_val_cb) siridb_group_test_series,
-                    series);
+            if (groups->unanchored == NULL)
+            {
+                ct_values(
+                        groups->groups,
+                        (ct_val_cb) siridb_group_test_series,
+                        series);
+            }
+            else
+            {
+                ct_prefixes(
+                        groups->prefixes,
+                        series->name,
+                        (ct_val_cb) GROUPS_match_series,
+                        series);
+                GROUPS_match_series(groups->unanchored, series);
+            }
         }
 
         siridb_series_decref(series);
@@ -574,8 +629,13 @@ static void GROUPS_init_series(siridb_t * siridb)
 
             uv_mutex_lock(&groups->mutex);
 
+            if (groups->flags & GROUPS_FLAG_REBUILD)
+            {
+                GROUPS_build_matcher(groups);
+            }
+
             /* re-calculate modulo size [1..1001] */
-            m = CALC_BATCH_SIZE(groups->groups->len);
+            m = GROUPS_batch_size(groups);
         }
     }
 
@@ -707,3 +767,177 @@ static void GROUPS_cleanup(siridb_groups_t * groups)
 
     vec_free(groups_list);
 }
+
+/*
+ * Group thread.
+ *
+ * Wait until new series are added but not longer than GROUPS_LOOP_SLEEP
+ * seconds, so new series are assigned to groups without delay.
+ */
+static void GROUPS_wait(siridb_groups_t * groups)
+{
+    uv_mutex_lock(&groups->mutex);
+
+    if (!groups->nseries->len && groups->status == GROUPS_RUNNING)
+    {
+        (void) uv_cond_timedwait(
+                &groups->cond,
+                &groups->mutex,
+                GROUPS_LOOP_SLEEP * 1000000000ULL);
+    }
+
+    uv_mutex_unlock(&groups->mutex);
+}
+
+/*
+ * Group thread. (groups->mutex must be locked)
+ *
+ * Only groups without a literal prefix are tested for each series, unless
+ * the matcher is not available in which case all groups are tested.
+ */
+static int GROUPS_batch_size(siridb_groups_t * groups)
+{
+    size_t sz = (groups->unanchored == NULL) ?
+            groups->groups->len : groups->unanchored->len;
+    return CALC_BATCH_SIZE(sz);
+}
+
+/*
+ * Group thread. (groups->mutex must be locked)
+ *
+ * Multi-pattern matcher for new series. Groups with a literal prefix are
+ * stored in a tree by this prefix so for a series only the groups with a
+ * prefix of the series name need to be tested. The other groups are tested
+ * for each series.
+ *
+ * When building the matcher fails, the matcher is not used and all groups
+ * are tested for each series.
+ */
+static void GROUPS_build_matcher(siridb_groups_t * groups)
+{
+    GROUPS_free_matcher(groups);
+
+    groups->flags &= ~GROUPS_FLAG_REBUILD;
+    groups->prefixes = ct_new();
+    groups->unanchored = vec_new(VEC_DEFAULT_SIZE);
+
+    if (    groups->prefixes == NULL ||
+            groups->unanchored == NULL ||
+            ct_values(
+                groups->groups,
+                (ct_val_cb) GROUPS_matcher_add,
+                groups))
+    {
+        log_critical("Cannot build the matcher for groups, "
+                "all groups will be tested for new series.");
+        GROUPS_free_matcher(groups);
+    }
+}
+
+/*
+ * Group thread. (groups->mutex must be locked)
+ */
+static void GROUPS_free_matcher(siridb_groups_t * groups)
+{
+    if (groups->prefixes != NULL)
+    {
+        ct_free(groups->prefixes, (ct_free_cb) GROUPS_free_prefix);
+        groups->prefixes = NULL;
+    }
+
+    if (groups->unanchored != NULL)
+    {
+        GROUPS_free_prefix(groups->unanchored);
+        groups->unanchored = NULL;
+    }
+}
+
+/*
+ * Group thread. (groups->mutex must be locked)
+ *
+ * Returns 0 if successful or 1 in case of an allocation error.
+ */
+static int GROUPS_matcher_add(
+        siridb_group_t * group,
+        siridb_groups_t * groups)
+{
+    size_t len = strlen(group->source);
+    char prefix[len + 1];
+    vec_t ** groups_list;
+    size_t n = siridb_re_prefix(group->source, len, prefix);
+
+    if (!n)
+    {
+        if (vec_append_safe(&groups->unanchored, group))
+        {
+            return 1;
+        }
+        siridb_group_incref(group);
+        return 0;
+    }
+
+    prefix[n] = '\0';
+
+    groups_list = (vec_t **) ct_getaddr(groups->prefixes, prefix);
+
+    if (groups_list == NULL || *groups_list == NULL)
+    {
+        vec_t * nlist = vec_new(1);
+        if (nlist == NULL)
+        {
+            return 1;
+        }
+        vec_append(nlist, group);
+
+        if (groups_list != NULL)
+        {
+            *groups_list = nlist;
+        }
+        else if (ct_add(groups->prefixes, prefix, nlist) != CT_OK)
+        {
+            vec_free(nlist);
+            return 1;
+        }
+    }
+    else if (vec_append_safe(groups_list, group))
+    {
+        return 1;
+    }
+
+    siridb_group_incref(group);
+    return 0;
+}
+
+/*
+ * Group thread. (groups->mutex must be locked)
+ *
+ * Test a series against a list of groups. Always returns 0 so the function
+ * can be used as a call-back.
+ */
+static int GROUPS_match_series(vec_t * groups_list, siridb_series_t * series)
+{
+    size_t i;
+
+    for (i = 0; i < groups_list->len; i++)
+    {
+        siridb_group_test_series(
+                (siridb_group_t *) groups_list->data[i],
+                series);
+    }
+
+    return 0;
+}
+
+static void GROUPS_free_prefix(vec_t * groups_list)
+{
+    siridb_group_t * group;
+    size_t i;
+
+    for (i = 0; i < groups_list->len; i++)
+    {
+        group = (siridb_group_t *) groups_list->data[i];
+        siridb_group_decref(group);
+    }
+
+    vec_free(groups_list);
+}
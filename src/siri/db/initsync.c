@@ -20,6 +20,8 @@
 #define INITSYNC_SLEEP 100          /* 100 milliseconds * active tasks  */
 #define INITSYNC_TIMEOUT 120000     /* 2 minutes                        */
 #define INITSYNC_RETRY 30000        /* 30 seconds                       */
+#define INITSYNC_MAX_SERIES 1024    /* max series in one package        */
+#define INITSYNC_PKG_SIZE 1048576   /* stop adding series at 1 MB       */
 #define INITSYC_FN ".initsync"
 
 void siridb_initsync_fopen(siridb_initsync_t * initsync, const char * opentype);
@@ -30,12 +32,12 @@ static int INITSYNC_unlink(siridb_initsync_t * initsync);
 static inline int INITSYNC_fn(siridb_t * siridb, siridb_initsync_t * initsync);
 static void INITSYNC_pause(siridb_replicate_t * replicate);
 static void INITSYNC_send(uv_timer_t * timer);
+static void INITSYNC_retry(siridb_t * siridb);
 static void INITSYNC_on_insert_response(
         sirinet_promise_t * promise,
         sirinet_pkg_t * pkg,
         int status);
 
-static const long int SIZE2 = 2 * sizeof(uint32_t);
 static char sync_progress[30];
 
 
@@ -58,6 +60,7 @@ siridb_initsync_t * siridb_initsync_open(siridb_t * siridb, int create_new)
         initsync->fn = NULL;
         initsync->fp = NULL;
         initsync->next_series_id = NULL;
+        initsync->nseries = 0;
         initsync->pkg = NULL;
 
         if (INITSYNC_fn(siridb, initsync) < 0)
@@ -225,7 +228,7 @@ void siridb_initsync_fopen(siridb_initsync_t * initsync, const char * opentype)
 
 /*
  * Read the next series id and truncate the synchronization file to remove
- * the last synchronization id.
+ * the series ids which are handled by the last package.
  *
  * This function might destroy 'replicate->initsync' when initial
  * synchronization is finished.
@@ -242,10 +245,15 @@ static void INITSYNC_next_series_id(siridb_t * siridb)
     free(initsync->pkg);
     initsync->pkg = NULL;
 
-    if (initsync->size >= SIZE2)
+    long int done = initsync->nseries * sizeof(uint32_t);
+
+    if (initsync->size - done >= (long int) sizeof(uint32_t))
     {
-        initsync->size -= sizeof(uint32_t);
-        if (fseeko(initsync->fp, -SIZE2, SEEK_END) ||
+        initsync->size -= done;
+        if (fseeko(
+                initsync->fp,
+                initsync->size - sizeof(uint32_t),
+                SEEK_SET) ||
             fread(  initsync->next_series_id,
                     sizeof(uint32_t),
                     1,
@@ -356,63 +364,116 @@ static void INITSYNC_work(uv_timer_t * timer)
 
     siridb_initsync_t * initsync = siridb->replicate->initsync;
     siridb_series_t * series;
+    siridb_points_t * points;
+    qp_packer_t * packer;
+    uint32_t ids[INITSYNC_MAX_SERIES];
+    size_t n = initsync->size / sizeof(uint32_t);
+    size_t packed = 0;
 
-    series = imap_get(siridb->series_map, *initsync->next_series_id);
+    if (n > INITSYNC_MAX_SERIES)
+    {
+        n = INITSYNC_MAX_SERIES;
+    }
 
-    if (series != NULL)
+    /* the last series id in the file is the next series id */
+    if (fseeko(
+            initsync->fp,
+            initsync->size - n * sizeof(uint32_t),
+            SEEK_SET) ||
+        fread(ids, sizeof(uint32_t), n, initsync->fp) != n)
     {
-        uv_mutex_lock(&siridb->series_mutex);
+        ERR_FILE
+        log_critical("Reading series ids has failed: '%s'", initsync->fn);
+        INITSYNC_retry(siridb);
+        return;
+    }
 
-        siridb_points_t * points = siridb_series_get_points(
-                series,
-                NULL,
-                NULL);
+    packer = sirinet_packer_new(QP_SUGGESTED_SIZE);
+    if (packer == NULL)
+    {
+        INITSYNC_retry(siridb);
+        return;  /* signal is raised */
+    }
 
-        uv_mutex_unlock(&siridb->series_mutex);
+    qp_add_type(packer, QP_MAP_OPEN);
 
-        if (points != NULL)
+    for (   initsync->nseries = 0;
+            initsync->nseries < n && packer->len < INITSYNC_PKG_SIZE;
+            initsync->nseries++)
+    {
+        series = imap_get(siridb->series_map, ids[n - 1 - initsync->nseries]);
+        if (series == NULL)
         {
-            qp_packer_t * packer = sirinet_packer_new(QP_SUGGESTED_SIZE);
-            if (packer != NULL)
-            {
-                qp_add_type(packer, QP_MAP1);
+            continue;  /* the series is dropped */
+        }
 
-                /* add name including string terminator */
-                qp_add_raw(
-                        packer,
-                        (const unsigned char *) series->name,
-                        series->name_len + 1);
+        uv_mutex_lock(&siridb->series_mutex);
 
-                if (siridb_points_pack(points, packer) == 0)
-                {
-                    series->flags &= ~SIRIDB_SERIES_INIT_REPL;
+        points = siridb_series_get_points(series, NULL, NULL);
 
-                    initsync->pkg = sirinet_packer2pkg(
-                            packer,
-                            0,
-                            BPROTO_INSERT_SERVER);
+        uv_mutex_unlock(&siridb->series_mutex);
 
-                    uv_timer_start(
-                            siridb->replicate->timer,
-                            INITSYNC_send,
-                            0,
-                            0);
+        if (points == NULL)
+        {
+            qp_packer_free(packer);
+            INITSYNC_retry(siridb);
+            return;  /* signal is raised */
+        }
 
-                }
-                else
-                {
-                    qp_packer_free(packer);  /* signal is raised */
-                }
-            }
+        /* add name including string terminator */
+        if (qp_add_raw(
+                    packer,
+                    (const unsigned char *) series->name,
+                    series->name_len + 1) ||
+            siridb_points_pack(points, packer))
+        {
             siridb_points_free(points);
+            qp_packer_free(packer);
+            INITSYNC_retry(siridb);
+            return;  /* signal is raised */
         }
+
+        siridb_points_free(points);
+        series->flags &= ~SIRIDB_SERIES_INIT_REPL;
+        packed++;
+    }
+
+    if (packed)
+    {
+        initsync->pkg = sirinet_packer2pkg(
+                packer,
+                0,
+                BPROTO_INSERT_SERVER);
+
+        uv_timer_start(
+                siridb->replicate->timer,
+                INITSYNC_send,
+                0,
+                0);
     }
     else
     {
+        qp_packer_free(packer);
         INITSYNC_next_series_id(siridb);
     }
 }
 
+/*
+ * Start the work again after INITSYNC_RETRY so initial synchronization does
+ * not stop when a package cannot be created.
+ */
+static void INITSYNC_retry(siridb_t * siridb)
+{
+    log_error("Cannot create initial replica package "
+            "(try again in %d seconds)",
+            INITSYNC_RETRY / 1000);
+    uv_timer_start(
+            siridb->replicate->timer,
+            INITSYNC_work,
+            INITSYNC_RETRY,
+            0);
+}
+
 /*
  * Call-back function: sirinet_promise_cb
  */
@@ -8,7 +8,9 @@
 #include <siri/db/buffer.h>
 #include <siri/db/forward.h>
 #include <siri/db/insert.h>
+#include <siri/db/lookup.h>
 #include <siri/db/points.h>
+#include <siri/db/reindex.h>
 #include <siri/db/replicate.h>
 #include <siri/db/series.h>
 #include <siri/db/servers.h>
@@ -22,6 +24,13 @@
 #include <siri/db/tasks.h>
 
 #define MAX_INSERT_MSG 236
+
+/*
+ * Insert packages with at least this size are decoded in a work thread so
+ * the main loop can continue handling other clients while the points are
+ * assigned to pools.
+ */
+#define INSERT_DECODE_WORK_SIZE 65536
 #define INSERT_TIMEOUT 300000  /* 5 minutes                                 */
 #define INSERT_AT_ONCE 3000    /* one point counts as 1, a series as 100    */
 #define WEIGHT_SERIES 50
@@ -37,10 +46,37 @@ if (*ts > series->end)              \
     series->end = *ts;              \
 }
 
+typedef struct
+{
+    siridb_t * siridb;
+    siridb_lookup_t * lookup;   /* NULL while re-indexing               */
+    int old_servers;            /* servers without string support       */
+} insert_assign_t;
+
+typedef struct
+{
+    uv_work_t work;
+    insert_assign_t assign;
+    siridb_insert_t * insert;
+    sirinet_pkg_t * pkg;
+    ssize_t rc;
+    size_t pos;
+} insert_decode_t;
+
 static void INSERT_free(uv_handle_t * handle);
 static void INSERT_points_to_pools(uv_async_t * handle);
 static void INSERT_on_response(vec_t * promises, uv_async_t * handle);
-static uint16_t INSERT_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name);
+static uint16_t INSERT_get_pool(
+        insert_assign_t * assign,
+        qp_obj_t * qp_series_name);
+static void INSERT_assign_init(insert_assign_t * assign, siridb_t * siridb);
+static ssize_t INSERT_assign(
+        insert_assign_t * assign,
+        qp_unpacker_t * unpacker,
+        qp_packer_t * packer[]);
+static int INSERT_assigned(siridb_insert_t * insert, ssize_t rc, size_t pos);
+static void INSERT_decode_work(uv_work_t * work);
+static void INSERT_decode_work_finish(uv_work_t * work, int status);
 
 static void INSERT_local_free_cb(uv_async_t * handle);
 static int8_t INSERT_local_work(
@@ -70,18 +106,18 @@ static int INSERT_init_local(
         uint8_t flags);
 
 static ssize_t INSERT_assign_by_map(
-        siridb_t * siridb,
+        insert_assign_t * assign,
         qp_unpacker_t * unpacker,
         qp_packer_t * packer[]);
 
 static ssize_t INSERT_assign_by_array(
-        siridb_t * siridb,
+        insert_assign_t * assign,
         qp_unpacker_t * unpacker,
         qp_packer_t * packer[],
         qp_packer_t * tmp_packer);
 
 static int INSERT_read_points(
-        siridb_t * siridb,
+        insert_assign_t * assign,
         qp_packer_t * packer,
         qp_unpacker_t * unpacker,
         qp_obj_t * qp_obj,
@@ -157,6 +193,86 @@ ssize_t siridb_insert_assign_pools(
         siridb_t * siridb,
         qp_unpacker_t * unpacker,
         qp_packer_t * packer[])
+{
+    insert_assign_t assign;
+    INSERT_assign_init(&assign, siridb);
+    return INSERT_assign(&assign, unpacker, packer);
+}
+
+/*
+ * Assign the points in the package to the pools and start the insert. Large
+ * packages are decoded in a work thread. Errors in the package are reported
+ * to the client and the insert is destroyed.
+ *
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ * In case of an error the insert should be destroyed by the caller.
+ */
+int siridb_insert_assign(siridb_insert_t * insert, sirinet_pkg_t * pkg)
+{
+    siridb_t * siridb = insert->client->siridb;
+    insert_decode_t * decode;
+
+    if (pkg->len < INSERT_DECODE_WORK_SIZE || siridb_is_reindexing(siridb))
+    {
+        ssize_t rc;
+        qp_unpacker_t unpacker;
+        qp_unpacker_init(&unpacker, pkg->data, pkg->len);
+
+        rc = siridb_insert_assign_pools(siridb, &unpacker, insert->packer);
+        return INSERT_assigned(insert, rc, unpacker.pt - pkg->data);
+    }
+
+    decode = (insert_decode_t *) malloc(sizeof(insert_decode_t));
+    if (decode == NULL)
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
+    /* the package is part of the stream buffer so we need a copy */
+    decode->pkg = sirinet_pkg_dup(pkg);
+    if (decode->pkg == NULL)
+    {
+        free(decode);
+        return -1;  /* a signal is raised */
+    }
+
+    /*
+     * The lookup is not freed while work is pending since re-indexing
+     * cannot finish until siridb->insert_decodes is zero.
+     */
+    INSERT_assign_init(&decode->assign, siridb);
+    decode->insert = insert;
+    decode->work.data = decode;
+
+    siridb_incref(siridb);
+    sirinet_stream_incref(insert->client);
+    siridb->insert_decodes++;
+
+    uv_queue_work(
+            siri.loop,
+            &decode->work,
+            INSERT_decode_work,
+            INSERT_decode_work_finish);
+    return 0;
+}
+
+/*
+ * Snapshot of everything required to assign points to pools. When not
+ * re-indexing, this can be used from a work thread.
+ */
+static void INSERT_assign_init(insert_assign_t * assign, siridb_t * siridb)
+{
+    assign->siridb = siridb;
+    assign->lookup = siridb_is_reindexing(siridb) ?
+            NULL : siridb->pools->lookup;
+    assign->old_servers = siridb_servers_check_version(siridb, "2.0.27");
+}
+
+static ssize_t INSERT_assign(
+        insert_assign_t * assign,
+        qp_unpacker_t * unpacker,
+        qp_packer_t * packer[])
 {
     ssize_t rc = 0;
     qp_types_t tp;
@@ -164,7 +280,7 @@ ssize_t siridb_insert_assign_pools(
 
     if (qp_is_map(tp))
     {
-        rc = INSERT_assign_by_map(siridb, unpacker, packer);
+        rc = INSERT_assign_by_map(assign, unpacker, packer);
     }
     else if (qp_is_array(tp))
     {
@@ -176,7 +292,7 @@ ssize_t siridb_insert_assign_pools(
         else
         {
             rc = INSERT_assign_by_array(
-                    siridb,
+                    assign,
                     unpacker,
                     packer,
                     tmp_packer);
@@ -191,6 +307,124 @@ ssize_t siridb_insert_assign_pools(
     return (siri_err) ? ERR_MEM_ALLOC : rc;
 }
 
+/*
+ * Start the insert when the points are assigned, or report the error to the
+ * client and destroy the insert.
+ *
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ */
+static int INSERT_assigned(siridb_insert_t * insert, ssize_t rc, size_t pos)
+{
+    switch ((siridb_insert_err_t) rc)
+    {
+    case ERR_EXPECTING_ARRAY:
+    case ERR_EXPECTING_SERIES_NAME:
+    case ERR_EXPECTING_MAP_OR_ARRAY:
+    case ERR_EXPECTING_INTEGER_TS:
+    case ERR_TIMESTAMP_OUT_OF_RANGE:
+    case ERR_UNSUPPORTED_VALUE:
+    case ERR_EXPECTING_AT_LEAST_ONE_POINT:
+    case ERR_EXPECTING_NAME_AND_POINTS:
+    case ERR_INCOMPATIBLE_SERVER_VERSION:
+    case ERR_MEM_ALLOC:
+        {
+            /* something went wrong, get correct err message */
+            const char * err_msg = siridb_insert_err_msg(rc);
+
+            log_error("Insert error: '%s' at position %lu", err_msg, pos);
+
+            /* create and send package */
+            sirinet_pkg_t * package = sirinet_pkg_err(
+                    insert->pid,
+                    strlen(err_msg),
+                    CPROTO_ERR_INSERT,
+                    err_msg);
+
+            if (package != NULL)
+            {
+                /* ignore result code, signal can be raised */
+                sirinet_pkg_send(insert->client, package);
+            }
+        }
+
+        /* error, free insert */
+        siridb_insert_free(insert);
+        return 0;
+
+    default:
+        return siridb_insert_points_to_pools(insert, (size_t) rc);
+    }
+}
+
+/*
+ * Work thread, only uses the snapshot in decode->assign.
+ */
+static void INSERT_decode_work(uv_work_t * work)
+{
+    insert_decode_t * decode = (insert_decode_t *) work->data;
+    qp_unpacker_t unpacker;
+    qp_unpacker_init(&unpacker, decode->pkg->data, decode->pkg->len);
+
+    decode->rc = INSERT_assign(
+            &decode->assign,
+            &unpacker,
+            decode->insert->packer);
+    decode->pos = unpacker.pt - decode->pkg->data;
+}
+
+static void INSERT_decode_work_finish(uv_work_t * work, int status)
+{
+    insert_decode_t * decode = (insert_decode_t *) work->data;
+    siridb_t * siridb = decode->assign.siridb;
+    sirinet_stream_t * client = decode->insert->client;
+
+    if (status)
+    {
+        log_error("Insert decode work has failed (error: %s)",
+                uv_strerror(status));
+        siridb_insert_free(decode->insert);
+    }
+    else if ((decode->assign.lookup == NULL) !=
+             (siridb_is_reindexing(siridb) != 0))
+    {
+        /*
+         * Re-indexing has started (or finished) while decoding so the points
+         * are assigned using a lookup which is no longer valid. The points
+         * are assigned again using a new insert since the number of pools
+         * might have changed as well.
+         */
+        siridb_insert_t * insert = siridb_insert_new(
+                siridb,
+                decode->insert->pid,
+                client);
+
+        siridb_insert_free(decode->insert);
+
+        if (insert != NULL && siridb_insert_assign(insert, decode->pkg))
+        {
+            siridb_insert_free(insert);  /* signal is raised */
+        }
+    }
+    else if (INSERT_assigned(decode->insert, decode->rc, decode->pos))
+    {
+        siridb_insert_free(decode->insert);  /* signal is raised */
+    }
+
+    sirinet_stream_decref(client);
+    free(decode->pkg);
+    free(decode);
+
+    /* re-indexing might be waiting for this decode to finish */
+    if (    !--siridb->insert_decodes &&
+            siridb_is_reindexing(siridb) &&
+            (~siridb->server->flags & SERVER_FLAG_REINDEXING))
+    {
+        siridb_reindex_status_update(siridb);
+    }
+
+    siridb_decref(siridb);
+}
+
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  */
@@ -499,6 +733,8 @@ static int8_t INSERT_local_work(
     qp_via_t forstr;
     qp_via_t * val;
     uint64_t * ts;
+    uint64_t prev_start, prev_end;
+    uint32_t prev_length;
     int n = INSERT_AT_ONCE;
 
     /*
@@ -511,7 +747,7 @@ static int8_t INSERT_local_work(
             qp_series_name->via.raw[0] != '\0' &&
             (n -= WEIGHT_SERIES) > 0)
     {
-        series = (siridb_series_t *) ct_get(
+        series = siridb_names_get(
             siridb->series,
             (const char *) qp_series_name->via.raw);
 
@@ -538,6 +774,10 @@ static int8_t INSERT_local_work(
             n -= WEIGHT_NEW_SERIES;
         }
 
+        prev_start = series->start;
+        prev_end = series->end;
+        prev_length = series->length;
+
         ts = (uint64_t *) &qp_series_ts.via.int64;
         SERIES_UPDATE_TS(series)
 
@@ -635,6 +875,18 @@ static int8_t INSERT_local_work(
             }
         }
 
+        if (    siridb->pindex != NULL &&
+                siridb_pindex_update(
+                        siridb->pindex,
+                        series,
+                        prev_start,
+                        prev_end,
+                        prev_length))
+        {
+            ERR_ALLOC
+            return INSERT_LOCAL_ERROR;
+        }
+
         if (tp == QP_ARRAY_CLOSE)
         {
             qp_next(unpacker, qp_series_name);
@@ -664,6 +916,8 @@ static int INSERT_local_work_test(
     qp_obj_t qp_series_val;
     qp_via_t forstr;
     qp_via_t * val;
+    uint64_t prev_start, prev_end;
+    uint32_t prev_length;
     int n = INSERT_AT_ONCE;
 
     /*
@@ -676,7 +930,7 @@ static int INSERT_local_work_test(
             (n -= WEIGHT_SERIES) > 0)
     {
         series_name = (char *) qp_series_name->via.raw;
-        series = (siridb_series_t *) ct_get(siridb->series, series_name);
+        series = siridb_names_get(siridb->series, series_name);
         if (series == NULL)
         {
             /* the series does not exist so check what to do... */
@@ -754,6 +1008,10 @@ static int INSERT_local_work_test(
         qp_next(unpacker, &qp_series_ts); /* first ts       */
         qp_next(unpacker, &qp_series_val); /* first val     */
 
+        prev_start = series->start;
+        prev_end = series->end;
+        prev_length = series->length;
+
         ts = (uint64_t *) &qp_series_ts.via.int64;
         SERIES_UPDATE_TS(series)
 
@@ -851,6 +1109,18 @@ static int INSERT_local_work_test(
             }
         }
 
+        if (    siridb->pindex != NULL &&
+                siridb_pindex_update(
+                        siridb->pindex,
+                        series,
+                        prev_start,
+                        prev_end,
+                        prev_length))
+        {
+            ERR_ALLOC
+            return INSERT_LOCAL_ERROR;
+        }
+
         if (tp == QP_ARRAY_CLOSE)
         {
             qp_next(unpacker, qp_series_name);
@@ -1181,21 +1451,24 @@ static void INSERT_points_to_pools(uv_async_t * handle)
 /*
  * Returns the correct pool.
  */
-static uint16_t INSERT_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name)
+static uint16_t INSERT_get_pool(
+        insert_assign_t * assign,
+        qp_obj_t * qp_series_name)
 {
+    siridb_t * siridb = assign->siridb;
     uint16_t pool;
 
-    if (~siridb->flags & SIRIDB_FLAG_REINDEXING)
+    if (assign->lookup != NULL)
     {
         /* when not re-indexing, select the correct pool */
         pool = siridb_lookup_sn_raw(
-                siridb->pools->lookup,
+                assign->lookup,
                 (const char *) qp_series_name->via.raw,
                 qp_series_name->len);
     }
     else
     {
-        if (ct_getn(
+        if (siridb_names_getn(
                 siridb->series,
                 (const char *) qp_series_name->via.raw,
                 qp_series_name->len) != NULL)
@@ -1241,7 +1514,7 @@ static uint16_t INSERT_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name)
  * allocated for the points and should be checked with 'siri_err'.
  */
 static ssize_t INSERT_assign_by_map(
-        siridb_t * siridb,
+        insert_assign_t * assign,
         qp_unpacker_t * unpacker,
         qp_packer_t * packer[])
 {
@@ -1256,14 +1529,14 @@ static ssize_t INSERT_assign_by_map(
             qp_obj.len &&
             qp_obj.len < SIRIDB_SERIES_NAME_LEN_MAX)
     {
-        pool = INSERT_get_pool(siridb, &qp_obj);
+        pool = INSERT_get_pool(assign, &qp_obj);
 
         qp_add_raw_term(packer[pool],
                 qp_obj.via.raw,
                 qp_obj.len);
 
         if ((tp = INSERT_read_points(
-                siridb,
+                assign,
                 packer[pool],
                 unpacker,
                 &qp_obj,
@@ -1289,7 +1562,7 @@ static ssize_t INSERT_assign_by_map(
  * allocated for the points and should be checked with 'siri_err'.
  */
 static ssize_t INSERT_assign_by_array(
-        siridb_t * siridb,
+        insert_assign_t * assign,
         qp_unpacker_t * unpacker,
         qp_packer_t * packer[],
         qp_packer_t * tmp_packer)
@@ -1310,7 +1583,7 @@ static ssize_t INSERT_assign_by_array(
         if (strncmp((const char *) qp_obj.via.raw, "points", qp_obj.len) == 0)
         {
             if ((tp = INSERT_read_points(
-                    siridb,
+                    assign,
                     tmp_packer,
                     unpacker,
                     &qp_obj,
@@ -1329,7 +1602,7 @@ static ssize_t INSERT_assign_by_array(
                 return ERR_EXPECTING_NAME_AND_POINTS;
             }
 
-            pool = INSERT_get_pool(siridb, &qp_obj);
+            pool = INSERT_get_pool(assign, &qp_obj);
 
             qp_add_raw_term(packer[pool],
                     qp_obj.via.raw,
@@ -1356,7 +1629,7 @@ static ssize_t INSERT_assign_by_array(
             }
 
             if ((tp = INSERT_read_points(
-                    siridb,
+                    assign,
                     packer[pool],
                     unpacker,
                     &qp_obj,
@@ -1383,7 +1656,7 @@ static ssize_t INSERT_assign_by_array(
  * allocated for the points.
  */
 static int INSERT_read_points(
-        siridb_t * siridb,
+        insert_assign_t * assign,
         qp_packer_t * packer,
         qp_unpacker_t * unpacker,
         qp_obj_t * qp_obj,
@@ -1412,7 +1685,7 @@ static int INSERT_read_points(
             return ERR_EXPECTING_INTEGER_TS;
         }
 
-        if (!siridb_int64_valid_ts(siridb->time, qp_obj->via.int64))
+        if (!siridb_int64_valid_ts(assign->siridb->time, qp_obj->via.int64))
         {
             return ERR_TIMESTAMP_OUT_OF_RANGE;
         }
@@ -1422,7 +1695,7 @@ static int INSERT_read_points(
         switch (qp_next(unpacker, qp_obj))
         {
         case QP_RAW:
-            if (siridb_servers_check_version(siridb, "2.0.27") > 0)
+            if (assign->old_servers > 0)
             {
                 return ERR_INCOMPATIBLE_SERVER_VERSION;
             }
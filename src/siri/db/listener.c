@@ -11,10 +11,13 @@
 #include <siri/db/group.h>
 #include <siri/db/groups.h>
 #include <siri/db/nodes.h>
+#include <siri/db/partial.h>
 #include <siri/db/presuf.h>
+#include <siri/db/profile.h>
 #include <siri/db/props.h>
 #include <siri/db/props.h>
 #include <siri/db/query.h>
+#include <siri/db/rcache.h>
 #include <siri/db/re.h>
 #include <siri/db/series.h>
 #include <siri/db/server.h>
@@ -29,6 +32,7 @@
 #include <siri/help/help.h>
 #include <siri/net/promises.h>
 #include <siri/net/protocol.h>
+#include <siri/net/wqueue.h>
 #include <siri/net/clserver.h>
 #include <siri/siri.h>
 #include <xstr/xstr.h>
@@ -43,6 +47,20 @@
 #define DEFAULT_ALLOC_COLUMNS 6
 #define IS_MASTER (query->flags & SIRIDB_QUERY_FLAG_MASTER)
 
+#define SELECT_STREAM_CHUNK_SIZE 1048576      /* 1 MB                 */
+#define SELECT_STREAM_MAX_PENDING 4194304     /* 4 MB                 */
+#define SELECT_STREAM_WAIT 10                 /* 10 milliseconds      */
+
+/* merged points cannot be streamed since they need all points */
+#define IS_STREAM(q_select) \
+    ((query->flags & SIRIDB_QUERY_FLAG_STREAM) && (q_select)->merge_as == NULL)
+
+typedef struct
+{
+    siridb_query_t * query;
+    vec_t * names;          /* series which are packed in this step */
+} select_stream_t;
+
 #define MASTER_CHECK_ONLINE(siridb)                                         \
 if (IS_MASTER && !siridb_server_self_online(siridb->server))                \
 {                                                                           \
@@ -116,7 +134,10 @@ if (IS_MASTER && siridb_is_reindexing(siridb))                              \
     {                                                           \
         sirinet_promises_llist_free(promises);                  \
         return;  /* signal is raised when handle is NULL */     \
-    }
+    }                                                           \
+    siridb_profile_promises(                                    \
+            ((siridb_query_t *) handle->data)->profile,         \
+            promises);
 
 #define MEM_ERR_RET                                             \
         sprintf(query->err_msg, "Memory allocation error.");    \
@@ -188,12 +209,15 @@ static void enter_help(uv_async_t * handle);
 static void enter_limit_expr(uv_async_t * handle);
 static void enter_list_stmt(uv_async_t * handle);
 static void enter_merge_as(uv_async_t * handle);
+static void enter_order_expr(uv_async_t * handle);
+static void enter_profile_stmt(uv_async_t * handle);
 static void enter_revoke_user(uv_async_t * handle);
 static void enter_select_stmt(uv_async_t * handle);
 static void enter_set_expression(uv_async_t * handle);
 static void enter_set_ignore_threshold(uv_async_t * handle);
 static void enter_set_name(uv_async_t * handle);
 static void enter_set_password(uv_async_t * handle);
+static void enter_series_after(uv_async_t * handle);
 static void enter_series_all(uv_async_t * handle);
 static void enter_series_name(uv_async_t * handle);
 static void enter_series_match(uv_async_t * handle);
@@ -234,6 +258,7 @@ static void exit_list_series(uv_async_t * handle);
 static void exit_list_servers(uv_async_t * handle);
 static void exit_list_shards(uv_async_t * handle);
 static void exit_list_users(uv_async_t * handle);
+static void exit_profile_stmt(uv_async_t * handle);
 static void exit_revoke_user(uv_async_t * handle);
 static void exit_select_aggregate(uv_async_t * handle);
 static void exit_select_stmt(uv_async_t * handle);
@@ -258,6 +283,7 @@ static void async_filter_series(uv_async_t * handle);
 static void async_list_series(uv_async_t * handle);
 static void async_no_points_aggregate(uv_async_t * handle);
 static void async_select_aggregate(uv_async_t * handle);
+static void async_select_stream(uv_async_t * handle);
 static void async_series_re(uv_async_t * handle);
 
 /* on response functions */
@@ -277,6 +303,29 @@ static void on_update_xxx_response(vec_t * promises, uv_async_t * handle);
 /* helper functions */
 static void master_select_work(uv_work_t * handle);
 static void master_select_work_finish(uv_work_t * work, int status);
+static void other_select_partial_work(uv_work_t * work);
+static void master_select_stream(uv_async_t * handle);
+static int select_stream_pack(
+        siridb_query_t * query,
+        const char * name,
+        size_t len,
+        siridb_points_t * points);
+static siridb_points_t * select_rcache_get(
+        siridb_query_t * query,
+        siridb_series_t * series);
+static siridb_points_t * select_rcache_points(
+        siridb_query_t * query,
+        siridb_series_t * series,
+        uint64_t * start_ts,
+        uint64_t * end_ts);
+static void select_rcache_set(
+        siridb_query_t * query,
+        siridb_series_t * series,
+        siridb_points_t * points);
+static void select_stream_next(uv_async_t * handle);
+static void timeit_pack_server(siridb_query_t * query);
+static void timeit_finish(uv_async_t * handle);
+static void on_select_stream_timer(uv_timer_t * timer);
 static int items_select_master(
         const char * name,
         size_t len,
@@ -297,25 +346,41 @@ static int items_select_other_merge(
         size_t len,
         vec_t * plist,
         uv_async_t * handle);
+static int items_select_other_partial(
+        const char * name,
+        size_t len,
+        vec_t * plist,
+        uv_async_t * handle);
+static int items_select_stream(
+        const char * name,
+        size_t len,
+        siridb_points_t * points,
+        select_stream_t * stream);
 static void on_select_unpack_points(
         qp_unpacker_t * unpacker,
         query_select_t * q_select,
         qp_obj_t * qp_name,
-        qp_obj_t * qp_tp,
-        qp_obj_t * qp_len,
-        qp_obj_t * qp_points,
         uint32_t select_points_limit);
 static void on_select_unpack_merged_points(
         qp_unpacker_t * unpacker,
         query_select_t * q_select,
+        ct_t * dest,
         qp_obj_t * qp_name,
-        qp_obj_t * qp_tp,
-        qp_obj_t * qp_len,
-        qp_obj_t * qp_points,
         uint32_t select_points_limit);
+static int pack_select_points(
+        siridb_points_t * points,
+        siridb_query_t * query);
 
 static int values_list_groups(siridb_group_t * group, uv_async_t * handle);
 static int values_count_groups(siridb_group_t * group, uv_async_t * handle);
+static int values_series_re(siridb_series_t * series, vec_t ** vec);
+static int add_series_bits(siridb_series_t * series, bmap_t * bmap);
+static int values_list_series(siridb_series_t * series, vec_t * vec);
+static int values_list_rows(qp_packer_t * row, qp_packer_t * packer);
+static int list_rows_add(ct_t * rows, qp_unpacker_t * unpacker);
+static vec_t * list_series_after(siridb_t * siridb, query_list_t * q_list);
+static int cmp_series_name(const void * a, const void * b);
+static int update_series_bits(query_wrapper_t * q_wrapper);
 static void finish_list_groups(uv_async_t * handle);
 static void finish_count_groups(uv_async_t * handle);
 
@@ -411,7 +476,9 @@ void siridb_init_listener(void)
     siridb_listen_enter[CLERI_GID_LIMIT_EXPR] = enter_limit_expr;
     siridb_listen_enter[CLERI_GID_LIST_STMT] = enter_list_stmt;
     siridb_listen_enter[CLERI_GID_MERGE_AS] = enter_merge_as;
+    siridb_listen_enter[CLERI_GID_ORDER_EXPR] = enter_order_expr;
     siridb_listen_enter[CLERI_GID_POOL_COLUMNS] = enter_xxx_columns;
+    siridb_listen_enter[CLERI_GID_PROFILE_STMT] = enter_profile_stmt;
     siridb_listen_enter[CLERI_GID_REVOKE_USER] = enter_revoke_user;
     siridb_listen_enter[CLERI_GID_SELECT_STMT] = enter_select_stmt;
     siridb_listen_enter[CLERI_GID_SET_EXPRESSION] = enter_set_expression;
@@ -420,6 +487,7 @@ void siridb_init_listener(void)
     siridb_listen_enter[CLERI_GID_SET_PASSWORD] = enter_set_password;
     siridb_listen_enter[CLERI_GID_SERIES_COLUMNS] = enter_xxx_columns;
     siridb_listen_enter[CLERI_GID_SERVER_COLUMNS] = enter_xxx_columns;
+    siridb_listen_enter[CLERI_GID_SERIES_AFTER] = enter_series_after;
     siridb_listen_enter[CLERI_GID_SERIES_ALL] = enter_series_all;
     siridb_listen_enter[CLERI_GID_SERIES_NAME] = enter_series_name;
     siridb_listen_enter[CLERI_GID_SERIES_MATCH] = enter_series_match;
@@ -466,6 +534,7 @@ void siridb_init_listener(void)
     siridb_listen_exit[CLERI_GID_LIST_SERVERS] = exit_list_servers;
     siridb_listen_exit[CLERI_GID_LIST_SHARDS] = exit_list_shards;
     siridb_listen_exit[CLERI_GID_LIST_USERS] = exit_list_users;
+    siridb_listen_exit[CLERI_GID_PROFILE_STMT] = exit_profile_stmt;
     siridb_listen_exit[CLERI_GID_REVOKE_USER] = exit_revoke_user;
     siridb_listen_exit[CLERI_GID_SELECT_AGGREGATE] = exit_select_aggregate;
     siridb_listen_exit[CLERI_GID_SELECT_STMT] = exit_select_stmt;
@@ -798,7 +867,7 @@ static void enter_group_match(uv_async_t * handle)
         size_t i;
 
         q_wrapper->series_tmp = (q_wrapper->update_cb == NULL) ?
-                q_wrapper->series_map : imap_new();
+                q_wrapper->series_bits : bmap_new();
 
         if (q_wrapper->series_tmp == NULL)
         {
@@ -810,26 +879,19 @@ static void enter_group_match(uv_async_t * handle)
         for (i = 0; i < group->series->len; i++)
         {
             series = (siridb_series_t *) group->series->data[i];
-            siridb_series_incref(series);
-            if (imap_add(q_wrapper->series_tmp, series->id, series))
+            if (bmap_add(q_wrapper->series_tmp, series->id) == -1)
             {
                 log_critical("Cannot add series to temporary map.");
-                siridb_series_decref(series);
             }
         }
 
         uv_mutex_unlock(&siridb->groups->mutex);
 
-        if (q_wrapper->update_cb != NULL)
+        if (update_series_bits(q_wrapper))
         {
-            (*q_wrapper->update_cb)(
-                    q_wrapper->series_map,
-                    q_wrapper->series_tmp,
-                    (imap_free_cb) &siridb__series_decref);
+            MEM_ERR_RET
         }
 
-        q_wrapper->series_tmp = NULL;
-
         SIRIPARSER_ASYNC_NEXT_NODE
     }
 }
@@ -925,7 +987,12 @@ static void enter_merge_as(uv_async_t * handle)
 
     xstr_extract_string(q_select->merge_as, node->str, node->len);
 
-    if (IS_MASTER && query->nodes->node->children->next->next->next != NULL)
+    /*
+     * Other pools only need the merge aggregation list when the master
+     * accepts partial results.
+     */
+    if ((IS_MASTER || (query->flags & SIRIDB_QUERY_FLAG_PARTIAL)) &&
+        query->nodes->node->children->next->next->next != NULL)
     {
         q_select->mlist = siridb_aggregate_list(
                 query->nodes->node->children->next->next->next->node->
@@ -937,11 +1004,63 @@ static void enter_merge_as(uv_async_t * handle)
             siridb_query_send_error(handle, CPROTO_ERR_QUERY);
             return;
         }
+
+        if (IS_MASTER &&
+            q_select->mlist->len &&
+            siridb_partial_size(q_select->mlist->data[0]) &&
+            (q_select->partial = ct_new()) == NULL)
+        {
+            MEM_ERR_RET
+        }
     }
 
     SIRIPARSER_ASYNC_NEXT_NODE
 }
 
+static void enter_order_expr(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    siridb_t * siridb = query->client->siridb;
+    query_select_t * q_select = (query_select_t *) query->data;
+    int64_t limit =
+            query->nodes->node->children->next->next->next->node->result;
+
+    if (limit <= 0 || limit > siridb->select_points_limit)
+    {
+        snprintf(query->err_msg, SIRIDB_MAX_SIZE_ERR_MSG,
+                "Limit must be a value between 0 and %" PRIu32
+                " but received: %" PRId64
+                " (optionally the limit can be changed, "
+                "see 'help alter database')",
+                siridb->select_points_limit,
+                limit);
+        siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+    }
+    else
+    {
+        /* only the newest points of each series are read */
+        q_select->tail = limit;
+        SIRIPARSER_NEXT_NODE
+    }
+}
+
+static void enter_profile_stmt(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    query->timeit = qp_packer_new(1024);
+
+    if (query->timeit == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    /* profile results are collected like timeit results */
+    qp_add_raw(query->timeit, (const unsigned char *) "__profile__", 11);
+    qp_add_type(query->timeit, QP_ARRAY_OPEN);
+
+    SIRIPARSER_NEXT_NODE
+}
+
 static void enter_revoke_user(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
@@ -1146,6 +1265,24 @@ static void enter_set_password(uv_async_t * handle)
     }
 }
 
+static void enter_series_after(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    query_list_t * q_list = (query_list_t *) query->data;
+    cleri_node_t * name_node = query->nodes->node->children->next->node;
+
+    q_list->after = (char *) malloc(name_node->len - 1);
+
+    if (q_list->after == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    xstr_extract_string(q_list->after, name_node->str, name_node->len);
+
+    SIRIPARSER_NEXT_NODE
+}
+
 static void enter_series_name(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
@@ -1161,7 +1298,7 @@ static void enter_series_name(uv_async_t * handle)
 
     if (siridb_is_reindexing(siridb))
     {
-        series = (siridb_series_t *) ct_get(siridb->series, series_name);
+        series = siridb_names_get(siridb->series, series_name);
     }
     else
     {
@@ -1171,7 +1308,7 @@ static void enter_series_name(uv_async_t * handle)
         /* check if this series belongs to 'this' pool and if so get the series */
         if (pool == siridb->server->pool)
         {
-            series = (siridb_series_t *) ct_get(siridb->series, series_name);
+            series = siridb_names_get(siridb->series, series_name);
             if (series == NULL)
             {
                 /* the series does not exist */
@@ -1194,100 +1331,47 @@ static void enter_series_name(uv_async_t * handle)
 
     if (series == NULL)
     {
-        if (q_wrapper->update_cb == &imap_intersection_ref)
+        if (q_wrapper->update_cb == &bmap_intersection)
         {
-            imap_free(
-                    q_wrapper->series_map,
-                    (imap_free_cb) &siridb__series_decref);
-
-            q_wrapper->series_map = imap_new();
-
-            if (q_wrapper->series_map == NULL)
-            {
-                MEM_ERR_RET
-            }
+            bmap_clear(q_wrapper->series_bits);
         }
     }
-    else
+    else if (   q_wrapper->update_cb == NULL ||
+                q_wrapper->update_cb == &bmap_union)
     {
-        if (    q_wrapper->update_cb == NULL ||
-                q_wrapper->update_cb == &imap_union_ref)
-        {
-            if (imap_set(q_wrapper->series_map, series->id, series) == 1)
-            {
-                siridb_series_incref(series);
-            }
-        }
-        else if (q_wrapper->update_cb == &imap_difference_ref)
+        if (bmap_add(q_wrapper->series_bits, series->id) == -1)
         {
-            series = (siridb_series_t *) imap_pop(
-                    q_wrapper->series_map,
-                    series->id);
-            if (series != NULL)
-            {
-                siridb_series_decref(series);
-            }
+            MEM_ERR_RET
         }
-        else if (q_wrapper->update_cb == &imap_intersection_ref)
-        {
-            series = (siridb_series_t *) imap_get(
-                    q_wrapper->series_map,
-                    series->id);
-
-            if (series != NULL)
-            {
-                siridb_series_incref(series);
-            }
-
-            imap_free(
-                    q_wrapper->series_map,
-                    (imap_free_cb) &siridb__series_decref);
-
-            q_wrapper->series_map = imap_new();
+    }
+    else if (q_wrapper->update_cb == &bmap_difference)
+    {
+        bmap_pop(q_wrapper->series_bits, series->id);
+    }
+    else if (q_wrapper->update_cb == &bmap_intersection)
+    {
+        int found = bmap_has(q_wrapper->series_bits, series->id);
 
-            if (q_wrapper->series_map == NULL)
-            {
-                if (series != NULL)
-                {
-                    siridb_series_decref(series);
-                }
-                MEM_ERR_RET
-            }
+        bmap_clear(q_wrapper->series_bits);
 
-            if (series != NULL)
-            {
-                if (imap_set(q_wrapper->series_map, series->id, series) != 1)
-                {
-                    siridb_series_decref(series);
-                    MEM_ERR_RET
-                }
-            }
-        }
-        else if (q_wrapper->update_cb == &imap_symmetric_difference_ref)
+        if (found && bmap_add(q_wrapper->series_bits, series->id) == -1)
         {
-            switch (imap_set(q_wrapper->series_map, series->id, series))
-            {
-            case 0:
-                series = (siridb_series_t *) imap_pop(
-                        q_wrapper->series_map,
-                        series->id);
-                siridb_series_decref(series);
-                break;
-
-            case 1:
-                siridb_series_incref(series);
-                break;
-
-            default:
-                MEM_ERR_RET
-            }
+            MEM_ERR_RET
         }
-        else
+    }
+    else if (q_wrapper->update_cb == &bmap_symmetric_difference)
+    {
+        if (    !bmap_pop(q_wrapper->series_bits, series->id) &&
+                bmap_add(q_wrapper->series_bits, series->id) == -1)
         {
-            /* we should not get here */
-            assert (0);
+            MEM_ERR_RET
         }
     }
+    else
+    {
+        /* we should not get here */
+        assert (0);
+    }
 
     SIRIPARSER_ASYNC_NEXT_NODE
 }
@@ -1296,7 +1380,7 @@ static void enter_series_match(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
 
-    if ((((query_wrapper_t *) query->data)->series_map = imap_new()) == NULL)
+    if ((((query_wrapper_t *) query->data)->series_bits = bmap_new()) == NULL)
     {
         MEM_ERR_RET
     }
@@ -1308,8 +1392,8 @@ static void enter_series_all(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
     siridb_t * siridb = query->client->siridb;
-    siridb_series_t * series;
     query_wrapper_t * q_wrapper = (query_wrapper_t *) query->data;
+    int rc;
 
     /* we must send this query to all pools */
     if (q_wrapper->pmap != NULL)
@@ -1318,48 +1402,36 @@ static void enter_series_all(uv_async_t * handle)
         q_wrapper->pmap = NULL;
     }
 
-    uv_mutex_lock(&siridb->series_mutex);
-
-    q_wrapper->vec = imap_2vec_ref(
-            (   q_wrapper->update_cb == NULL ||
-                q_wrapper->update_cb == &imap_union_ref ||
-                q_wrapper->update_cb == &imap_symmetric_difference_ref) ?
-                    siridb->series_map : q_wrapper->series_map);
-
-    uv_mutex_unlock(&siridb->series_mutex);
-
-    q_wrapper->series_tmp = (q_wrapper->update_cb == NULL) ?
-            q_wrapper->series_map : imap_new();
-
-    if (q_wrapper->vec == NULL || q_wrapper->series_tmp == NULL)
+    if (q_wrapper->update_cb == &bmap_difference)
     {
-        MEM_ERR_RET
+        bmap_clear(q_wrapper->series_bits);
     }
-
-    for (q_wrapper->vec_index = 0;
-         q_wrapper->vec_index < q_wrapper->vec->len;
-         ++q_wrapper->vec_index)
+    else if (q_wrapper->update_cb != &bmap_intersection)
     {
-        series = q_wrapper->vec->data[q_wrapper->vec_index];
-        if (imap_add(q_wrapper->series_tmp, series->id, series))
+        q_wrapper->series_tmp = (q_wrapper->update_cb == NULL) ?
+                q_wrapper->series_bits : bmap_new();
+
+        if (q_wrapper->series_tmp == NULL)
         {
             MEM_ERR_RET
         }
-    }
 
-    vec_free(q_wrapper->vec);
-    q_wrapper->vec = NULL;
-    q_wrapper->vec_index = 0;
+        uv_mutex_lock(&siridb->series_mutex);
 
-    if (q_wrapper->update_cb != NULL)
-    {
-        (*q_wrapper->update_cb)(
-                q_wrapper->series_map,
-                q_wrapper->series_tmp,
-                (imap_free_cb) &siridb__series_decref);
+        rc = imap_walk(
+                siridb->series_map,
+                (imap_cb) add_series_bits,
+                q_wrapper->series_tmp);
+
+        uv_mutex_unlock(&siridb->series_mutex);
+
+        if (rc || update_series_bits(q_wrapper))
+        {
+            MEM_ERR_RET
+        }
     }
+    /* an intersection with all series does not change the selection */
 
-    q_wrapper->series_tmp = NULL;
     SIRIPARSER_ASYNC_NEXT_NODE
 }
 
@@ -1389,18 +1461,58 @@ static void enter_series_re(uv_async_t * handle)
     }
     else
     {
+        char prefix[node->len];  /* also used for the literals */
+        size_t n;
+
         uv_mutex_lock(&siridb->series_mutex);
 
-        q_wrapper->vec = imap_2vec_ref(
-                (   q_wrapper->update_cb == NULL ||
-                    q_wrapper->update_cb == &imap_union_ref ||
-                    q_wrapper->update_cb == &imap_symmetric_difference_ref) ?
-                        siridb->series_map : q_wrapper->series_map);
+        if (    q_wrapper->update_cb != NULL &&
+                q_wrapper->update_cb != &bmap_union &&
+                q_wrapper->update_cb != &bmap_symmetric_difference)
+        {
+            /* only the series we already have can match */
+            q_wrapper->vec = siridb_series_bmap_vec(
+                    siridb,
+                    q_wrapper->series_bits);
+        }
+        else if ((n = siridb_re_prefix(node->str, node->len, prefix)))
+        {
+            /*
+             * Only series starting with the literal prefix can match so we
+             * walk the sub-tree instead of testing each series.
+             */
+            q_wrapper->vec = vec_new(VEC_DEFAULT_SIZE);
+            if (q_wrapper->vec != NULL && siridb_names_values_prefix(
+                    siridb->series,
+                    prefix,
+                    n,
+                    (ct_val_cb) values_series_re,
+                    &q_wrapper->vec))
+            {
+                while (q_wrapper->vec->len)
+                {
+                    siridb__series_decref(
+                            (siridb_series_t *) vec_pop(q_wrapper->vec));
+                }
+                vec_free(q_wrapper->vec);
+                q_wrapper->vec = NULL;
+            }
+        }
+        else if (   siridb->trigrams == NULL ||
+                    !(n = siridb_re_literals(node->str, node->len, prefix)) ||
+                    (q_wrapper->vec = siridb_trigram_match(
+                            siridb->trigrams,
+                            prefix,
+                            n)) == NULL)
+        {
+            /* no literals can be used, we must test all series */
+            q_wrapper->vec = imap_2vec_ref(siridb->series_map);
+        }
 
         uv_mutex_unlock(&siridb->series_mutex);
 
         q_wrapper->series_tmp = (q_wrapper->update_cb == NULL) ?
-                q_wrapper->series_map : imap_new();
+                q_wrapper->series_bits : bmap_new();
 
         if (q_wrapper->vec == NULL || q_wrapper->series_tmp == NULL)
         {
@@ -1437,16 +1549,16 @@ static void enter_series_sep(uv_async_t * handle)
     switch (query->nodes->node->children->node->cl_obj->gid)
     {
     case CLERI_GID_K_UNION:
-        q_wrapper->update_cb = &imap_union_ref;
+        q_wrapper->update_cb = &bmap_union;
         break;
     case CLERI_GID_K_INTERSECTION:
-        q_wrapper->update_cb = &imap_intersection_ref;
+        q_wrapper->update_cb = &bmap_intersection;
         break;
     case CLERI_GID_C_DIFFERENCE:
-        q_wrapper->update_cb = &imap_difference_ref;
+        q_wrapper->update_cb = &bmap_difference;
         break;
     case CLERI_GID_K_SYMMETRIC_DIFFERENCE:
-        q_wrapper->update_cb = &imap_symmetric_difference_ref;
+        q_wrapper->update_cb = &bmap_symmetric_difference;
         break;
     default:
         assert (0);
@@ -1709,6 +1821,7 @@ static void exit_count_pools(uv_async_t * handle)
     siridb_pool_walker_t wpool = {
             .servers=pool->len,
             .series=siridb->series->len,
+            .length=siridb->series_length,
             .pool=siridb->server->pool
     };
 
@@ -1778,9 +1891,17 @@ static void exit_count_series(uv_async_t * handle)
     {
         uv_mutex_lock(&siridb->series_mutex);
 
-        q_count->vec = imap_2vec_ref(
-                (q_count->series_map == NULL) ?
-                        siridb->series_map : q_count->series_map);
+        if (    q_count->series_map != NULL ||
+                siridb->pindex == NULL ||
+                (q_count->vec = siridb_pindex_match(
+                        siridb->pindex,
+                        q_count->where_expr,
+                        siridb->server->pool)) == NULL)
+        {
+            q_count->vec = imap_2vec_ref(
+                    (q_count->series_map == NULL) ?
+                            siridb->series_map : q_count->series_map);
+        }
 
         uv_mutex_unlock(&siridb->series_mutex);
 
@@ -1820,29 +1941,36 @@ static void exit_count_series_length(uv_async_t * handle)
 
     if (q_count->where_expr == NULL)
     {
-        size_t i;
-        vec_t * vec;
-        siridb_series_t * series;
+        if (q_count->series_map == NULL)
+        {
+            /* the total length of all series is kept up-to-date */
+            q_count->n = siridb->series_length;
+        }
+        else
+        {
+            size_t i;
+            vec_t * vec;
+            siridb_series_t * series;
 
-        uv_mutex_lock(&siridb->series_mutex);
+            uv_mutex_lock(&siridb->series_mutex);
 
-        vec = imap_2vec((q_count->series_map == NULL) ?
-                siridb->series_map : q_count->series_map);
+            vec = imap_2vec(q_count->series_map);
 
-        uv_mutex_unlock(&siridb->series_mutex);
+            uv_mutex_unlock(&siridb->series_mutex);
 
-        if (vec == NULL)
-        {
-            MEM_ERR_RET
-        }
+            if (vec == NULL)
+            {
+                MEM_ERR_RET
+            }
 
-        for (i = 0; i < vec->len; i++)
-        {
-            series = (siridb_series_t *) vec->data[i];
-            q_count->n += series->length;
-        }
+            for (i = 0; i < vec->len; i++)
+            {
+                series = (siridb_series_t *) vec->data[i];
+                q_count->n += series->length;
+            }
 
-        vec_free(vec);
+            vec_free(vec);
+        }
 
         if (IS_MASTER)
         {
@@ -1865,9 +1993,17 @@ static void exit_count_series_length(uv_async_t * handle)
 
         uv_mutex_lock(&siridb->series_mutex);
 
-        q_count->vec = imap_2vec_ref(
-                (q_count->series_map == NULL) ?
-                        siridb->series_map : q_count->series_map);
+        if (    q_count->series_map != NULL ||
+                siridb->pindex == NULL ||
+                (q_count->vec = siridb_pindex_match(
+                        siridb->pindex,
+                        q_count->where_expr,
+                        siridb->server->pool)) == NULL)
+        {
+            q_count->vec = imap_2vec_ref(
+                    (q_count->series_map == NULL) ?
+                            siridb->series_map : q_count->series_map);
+        }
 
         uv_mutex_unlock(&siridb->series_mutex);
 
@@ -2357,9 +2493,19 @@ static void exit_drop_series(uv_async_t * handle)
      */
     uv_mutex_lock(&siridb->series_mutex);
 
-    q_drop->vec = (q_drop->series_map == NULL) ?
-        imap_2vec_ref(siridb->series_map) :
-        imap_vec_pop(q_drop->series_map);
+    if (q_drop->series_map != NULL)
+    {
+        q_drop->vec = imap_vec_pop(q_drop->series_map);
+    }
+    else if (   q_drop->where_expr == NULL ||
+                siridb->pindex == NULL ||
+                (q_drop->vec = siridb_pindex_match(
+                        siridb->pindex,
+                        q_drop->where_expr,
+                        siridb->server->pool)) == NULL)
+    {
+        q_drop->vec = imap_2vec_ref(siridb->series_map);
+    }
 
     uv_mutex_unlock(&siridb->series_mutex);
 
@@ -2809,6 +2955,7 @@ static void exit_list_pools(uv_async_t * handle)
     siridb_pool_walker_t wpool = {
             .servers=pool->len,
             .series=siridb->series->len,
+            .length=siridb->series_length,
             .pool=siridb->server->pool
     };
     uint_fast16_t prop;
@@ -2857,6 +3004,9 @@ static void exit_list_pools(uv_async_t * handle)
             case CLERI_GID_K_SERIES:
                 qp_add_int64(query->packer, wpool.series);
                 break;
+            case CLERI_GID_K_LENGTH:
+                qp_add_int64(query->packer, wpool.length);
+                break;
             }
         }
 
@@ -2900,6 +3050,23 @@ static void exit_list_series(uv_async_t * handle)
         qp_add_raw(query->packer, (const unsigned char *) "name", 4);
     }
 
+    if (q_list->after != NULL)
+    {
+        /* the master merges the pool results using the name column */
+        if (*((uint32_t *) q_list->props->data[0]) != CLERI_GID_K_NAME)
+        {
+            sprintf(query->err_msg,
+                    "The first column must be 'name' when using 'after'.");
+            siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+            return;
+        }
+
+        if (IS_MASTER && (q_list->rows = ct_new()) == NULL)
+        {
+            MEM_ERR_RET
+        }
+    }
+
     qp_add_type(query->packer, QP_ARRAY_CLOSE);
 
     qp_add_raw(query->packer, (const unsigned char *) "series", 6);
@@ -2907,8 +3074,47 @@ static void exit_list_series(uv_async_t * handle)
 
     uv_mutex_lock(&siridb->series_mutex);
 
-    q_list->vec = imap_2vec_ref((q_list->series_map == NULL) ?
-                    siridb->series_map : q_list->series_map);
+    if (q_list->after != NULL)
+    {
+        q_list->vec = list_series_after(siridb, q_list);
+    }
+    else if (q_list->where_expr == NULL)
+    {
+        /* without a filter, only the series up to the limit are listed */
+        size_t n = q_list->limit;
+
+        q_list->vec = vec_new(n);
+
+        if (q_list->vec != NULL)
+        {
+            if (q_list->series_map == NULL)
+            {
+                siridb_names_valuesn(
+                        siridb->series,
+                        &n,
+                        (ct_val_cb) values_list_series,
+                        q_list->vec);
+            }
+            else
+            {
+                imap_walkn(
+                        q_list->series_map,
+                        &n,
+                        (imap_cb) values_list_series,
+                        q_list->vec);
+            }
+        }
+    }
+    else if (   q_list->series_map != NULL ||
+                siridb->pindex == NULL ||
+                (q_list->vec = siridb_pindex_match(
+                        siridb->pindex,
+                        q_list->where_expr,
+                        siridb->server->pool)) == NULL)
+    {
+        q_list->vec = imap_2vec_ref((q_list->series_map == NULL) ?
+                        siridb->series_map : q_list->series_map);
+    }
 
     uv_mutex_unlock(&siridb->series_mutex);
 
@@ -3215,6 +3421,18 @@ static void exit_list_users(uv_async_t * handle)
     SIRIPARSER_ASYNC_NEXT_NODE
 }
 
+static void exit_profile_stmt(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+
+    qp_add_type(query->timeit, QP_MAP_OPEN);
+    timeit_pack_server(query);
+    siridb_profile_pack(query->profile, query->timeit);
+    qp_add_type(query->timeit, QP_MAP_CLOSE);
+
+    timeit_finish(handle);
+}
+
 static void exit_revoke_user(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
@@ -3262,12 +3480,51 @@ static void exit_series_match(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
     query_wrapper_t * q_wrapper = (query_wrapper_t *) query->data;
+    siridb_t * siridb = query->client->siridb;
+
+    /* the selected series are only converted to series at this point */
+    uv_mutex_lock(&siridb->series_mutex);
+
+    q_wrapper->series_map = siridb_series_bmap_imap(
+            siridb,
+            q_wrapper->series_bits);
+
+    uv_mutex_unlock(&siridb->series_mutex);
+
+    bmap_free(q_wrapper->series_bits);
+    q_wrapper->series_bits = NULL;
+
+    if (q_wrapper->series_map == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    if (query->profile != NULL)
+    {
+        query->profile->series = q_wrapper->series_map->len;
+    }
 
     if (q_wrapper->tp == QUERIES_SELECT)
     {
         query_select_t * q_select = (query_select_t *) q_wrapper;
-        if ((q_select->flags & QUERIES_SKIP_GET_POINTS) &&
-                (q_select->start_ts != NULL || q_select->end_ts != NULL))
+
+        if (query->profile != NULL)
+        {
+            /* the time range is used by the slow query log */
+            if (q_select->start_ts != NULL)
+            {
+                query->profile->start_ts = *q_select->start_ts;
+            }
+            if (q_select->end_ts != NULL)
+            {
+                query->profile->end_ts = *q_select->end_ts;
+            }
+        }
+
+        if ((q_select->flags & QUERIES_SKIP_GET_POINTS) && (
+                q_select->start_ts != NULL ||
+                q_select->end_ts != NULL ||
+                q_select->tail))
         {
             q_select->flags &= ~QUERIES_SKIP_GET_POINTS;
         }
@@ -3349,15 +3606,13 @@ static void exit_select_aggregate(uv_async_t * handle)
         {
             if (q_select->merge_as != NULL)
             {
+                const char * name = siridb_presuf_name(
+                        q_select->presuf,
+                        q_select->merge_as,
+                        strlen(q_select->merge_as));
                 vec_t * plist = vec_new(VEC_DEFAULT_SIZE);
 
-                if (plist == NULL || ct_add(
-                        q_select->result,
-                        siridb_presuf_name(
-                                q_select->presuf,
-                                q_select->merge_as,
-                                strlen(q_select->merge_as)),
-                        plist))
+                if (plist == NULL || ct_add(q_select->result, name, plist))
                 {
                     sprintf(query->err_msg,
                             "Error while merging points. Make sure the "
@@ -3366,10 +3621,22 @@ static void exit_select_aggregate(uv_async_t * handle)
                     siridb_query_send_error(handle, CPROTO_ERR_QUERY);
                     return;
                 }
-            }
 
-            if (q_select->series_map->len)
-            {
+                if (q_select->partial != NULL)
+                {
+                    plist = vec_new(VEC_DEFAULT_SIZE);
+
+                    if (plist == NULL ||
+                        ct_add(q_select->partial, name, plist))
+                    {
+                        vec_free(plist);
+                        MEM_ERR_RET
+                    }
+                }
+            }
+
+            if (q_select->series_map->len)
+            {
                 q_select->alist = siridb_aggregate_list(
                         query->nodes->node->children->node->children,
                         query->err_msg);
@@ -3378,6 +3645,21 @@ static void exit_select_aggregate(uv_async_t * handle)
                     siridb_query_send_error(handle, CPROTO_ERR_QUERY);
                     return;
                 }
+
+                /*
+                 * Aggregated results can be stored in the result cache.
+                 * This is not critical so the cache is simply not used when
+                 * creating the key fails.
+                 */
+                if (q_select->alist->len &&
+                    !q_select->tail &&
+                    (~q_select->flags & QUERIES_SKIP_GET_POINTS))
+                {
+                    cleri_node_t * node = query->nodes->node->children->node;
+                    q_select->rcache_key =
+                            siridb_rcache_key(node->str, node->len);
+                }
+
                 q_select->vec = imap_2vec_ref(q_select->series_map);
 
                 if (q_select->vec == NULL)
@@ -3430,7 +3712,11 @@ static void exit_select_stmt(uv_async_t * handle)
                             SIRIDB_QUERY_FWD_POOLS :
                             SIRIDB_QUERY_FWD_SOME_POOLS,
                     (sirinet_promises_cb) on_select_response,
-                    0);
+                    FLAG_HEDGE);
+        }
+        else if (IS_STREAM(q_select))
+        {
+            master_select_stream(handle);
         }
         else
         {
@@ -3469,6 +3755,49 @@ static void exit_select_stmt(uv_async_t * handle)
                         &master_select_work_finish);
         }
     }
+    else if (   (query->flags & SIRIDB_QUERY_FLAG_PARTIAL) &&
+                q_select->mlist != NULL &&
+                q_select->mlist->len &&
+                siridb_partial_size(q_select->mlist->data[0]))
+    {
+        /*
+         * The master accepts partial results so we pre-merge and aggregate
+         * the points in a work thread and send only the partial states.
+         */
+        uv_work_t * work = (uv_work_t *) malloc(sizeof(uv_work_t));
+        if (work == NULL)
+        {
+            MEM_ERR_RET
+        }
+
+        uv_async_t * next = (uv_async_t *) malloc(sizeof(uv_async_t));
+        if (next == NULL)
+        {
+            free(work);
+            MEM_ERR_RET
+        }
+
+        uv_close((uv_handle_t *) handle, (uv_close_cb) free);
+
+        handle = next;
+        handle->data = query;
+        siridb_nodes_next(&query->nodes);
+
+        uv_async_init(
+                siri.loop,
+                handle,
+                (query->nodes == NULL) ?
+                        (uv_async_cb) siridb_send_query_result :
+                        (uv_async_cb) query->nodes->cb);
+
+        siri_async_incref(handle);
+        work->data = handle;
+        uv_queue_work(
+                    siri.loop,
+                    work,
+                    &other_select_partial_work,
+                    &master_select_work_finish);
+    }
     else
     {
         if (qp_add_raw(query->packer, (const unsigned char *) "select", 6) ||
@@ -4151,41 +4480,11 @@ static void exit_show_stmt(uv_async_t * handle)
 static void exit_timeit_stmt(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
-    siridb_t * siridb = query->client->siridb;
-
-    struct timespec end;
-    char * name = siridb->server->name;
-    clock_gettime(CLOCK_REALTIME, &end);
 
     qp_add_type(query->timeit, QP_MAP2);
-    qp_add_raw(query->timeit, (const unsigned char *) "server", 6);
-    qp_add_string(query->timeit, name);
-    qp_add_raw(query->timeit, (const unsigned char *) "time", 4);
-    qp_add_double(query->timeit,
-            (double) (end.tv_sec - query->start.tv_sec) +
-            (double) (end.tv_nsec - query->start.tv_nsec) / 1000000000.0f);
-
-    if (query->packer == NULL)
-    {
-        /* lets give the new packer the exact size so we do not
-         * need a realloc */
-        query->packer = sirinet_packer_new(
-                query->timeit->len +
-                1 +
-                sizeof(sirinet_pkg_t));
-
-        if (query->packer == NULL)
-        {
-            MEM_ERR_RET
-        }
-
-        qp_add_type(query->packer, QP_MAP_OPEN);
-    }
+    timeit_pack_server(query);
 
-    /* extend packer with timeit information */
-    qp_packer_extend(query->packer, query->timeit);
-
-    SIRIPARSER_ASYNC_NEXT_NODE
+    timeit_finish(handle);
 }
 
 /******************************************************************************
@@ -4393,6 +4692,7 @@ static void async_filter_series(uv_async_t * handle)
     cexpr_t * where_expr = q_wrapper->where_expr;
     uint8_t async_more = 0;
     siridb_series_t * series;
+    struct timespec start;
     size_t index_end = q_wrapper->vec_index + MAX_ITERATE_COUNT;
 
     if (index_end >= q_wrapper->vec->len)
@@ -4404,6 +4704,8 @@ static void async_filter_series(uv_async_t * handle)
         async_more = 1;
     }
 
+    siridb_profile_start(query->profile, &start);
+
     for (; q_wrapper->vec_index < index_end; q_wrapper->vec_index++)
     {
         series = (siridb_series_t *)
@@ -4426,6 +4728,8 @@ static void async_filter_series(uv_async_t * handle)
         }
     }
 
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_MATCH, &start);
+
     if (async_more)
     {
         uv_async_send(handle);
@@ -4466,6 +4770,7 @@ static void async_list_series(uv_async_t * handle)
     cexpr_t * where_expr = q_list->where_expr;
     uint8_t async_more = 0;
     siridb_series_t * series;
+    qp_packer_t * packer = query->packer;
     size_t i;
     size_t index_end = q_list->vec_index + MAX_ITERATE_COUNT;
 
@@ -4493,7 +4798,14 @@ static void async_list_series(uv_async_t * handle)
                 async_more = 0;
             }
 
-            qp_add_type(query->packer, QP_ARRAY_OPEN);
+            /* rows are kept by name when pools need to be merged */
+            if (    q_list->rows != NULL &&
+                    (packer = qp_packer_new(series->name_len + 64)) == NULL)
+            {
+                MEM_ERR_RET
+            }
+
+            qp_add_type(packer, QP_ARRAY_OPEN);
 
             for (i = 0; i < props->len; i++)
             {
@@ -4501,29 +4813,36 @@ static void async_list_series(uv_async_t * handle)
                 {
                 case CLERI_GID_K_NAME:
                     qp_add_raw(
-                            query->packer,
+                            packer,
                             (const unsigned char *) series->name,
                             series->name_len);
                     break;
                 case CLERI_GID_K_LENGTH:
-                    qp_add_int32(query->packer, series->length);
+                    qp_add_int32(packer, series->length);
                     break;
                 case CLERI_GID_K_TYPE:
-                    qp_add_string(query->packer, series_type_map[series->tp]);
+                    qp_add_string(packer, series_type_map[series->tp]);
                     break;
                 case CLERI_GID_K_POOL:
-                    qp_add_int16(query->packer, series->pool);
+                    qp_add_int16(packer, series->pool);
                     break;
                 case CLERI_GID_K_START:
-                    qp_add_int64(query->packer, series->start);
+                    qp_add_int64(packer, series->start);
                     break;
                 case CLERI_GID_K_END:
-                    qp_add_int64(query->packer, series->end);
+                    qp_add_int64(packer, series->end);
                     break;
                 }
             }
 
-            qp_add_type(query->packer, QP_ARRAY_CLOSE);
+            qp_add_type(packer, QP_ARRAY_CLOSE);
+
+            if (    packer != query->packer &&
+                    ct_add(q_list->rows, series->name, packer) != CT_OK)
+            {
+                qp_packer_free(packer);
+                MEM_ERR_RET
+            }
         }
 
         siridb_series_decref(series);
@@ -4533,9 +4852,12 @@ static void async_list_series(uv_async_t * handle)
     {
         uv_async_send(handle);
     }
-    else if (IS_MASTER && q_list->limit)
+    else if (IS_MASTER && (q_list->limit || q_list->rows != NULL))
     {
-        /* we have not reached the limit, send the query to other pools */
+        /*
+         * We have not reached the limit, or other pools might have series
+         * which should be listed before ours, send the query to other pools.
+         */
         siridb_query_forward(
                 handle,
                 SIRIDB_QUERY_FWD_POOLS,
@@ -4560,6 +4882,7 @@ static void async_no_points_aggregate(uv_async_t * handle)
     siridb_points_t * points;
     siridb_points_t * aggr_points;
     int required_shard = 0;
+    struct timespec start;
 
     for (;  q_select->vec_index < q_select->vec->len;
             ++q_select->vec_index)
@@ -4583,7 +4906,7 @@ static void async_no_points_aggregate(uv_async_t * handle)
 
         siridb_aggr_t * aggr = q_select->alist->data[0];
 
-        uv_mutex_lock(&siridb->series_mutex);
+        siridb_profile_lock(query->profile, &siridb->series_mutex);
 
         switch (aggr->gid)
         {
@@ -4601,13 +4924,15 @@ static void async_no_points_aggregate(uv_async_t * handle)
             points = NULL;
         }
 
-        uv_mutex_unlock(&siridb->series_mutex);
+        siridb_profile_unlock(&siridb->series_mutex);
 
         if (points != NULL)
         {
             const char * name;
             size_t i;
 
+            siridb_profile_start(query->profile, &start);
+
             for (i = 1; points->len && i < q_select->alist->len; i++)
             {
                 aggr_points = siridb_aggregate_run(
@@ -4629,6 +4954,11 @@ static void async_no_points_aggregate(uv_async_t * handle)
                 points = aggr_points;
             }
 
+            siridb_profile_stop(
+                    query->profile,
+                    SIRIDB_PROFILE_AGGREGATE,
+                    &start);
+
             q_select->n += points->len;
 
             if (q_select->merge_as == NULL)
@@ -4698,6 +5028,9 @@ static void async_select_aggregate(uv_async_t * handle)
     siridb_series_t * series;
     siridb_points_t * points;
     siridb_points_t * aggr_points;
+    int is_cached;
+    int is_read = 0;
+    struct timespec start;
 
     if (q_select->n > siridb->select_points_limit)
     {
@@ -4728,27 +5061,47 @@ static void async_select_aggregate(uv_async_t * handle)
         async_more = 1;
     }
 
+    /* The result cache contains aggregated points from previous queries. */
+    points = (  q_select->rcache_key == NULL ||
+                (series->flags & SIRIDB_SERIES_IS_DROPPED)) ?
+            NULL : select_rcache_get(query, series);
+
+    is_cached = (points != NULL);
+
     /* We try to read the points from the cache in case a cache is created.
      * If there are more select functions left we create a copy of the cache.
      * When this is the last select function we pop from the cache since the
      * points are no longer required.
      */
-    points = (q_select->points_map == NULL) ?
-            NULL :
-            q_select->nselects ?
-                siridb_points_copy(imap_get(q_select->points_map, series->id)):
-                imap_pop(q_select->points_map, series->id);
+    if (points == NULL)
+    {
+        points = (q_select->points_map == NULL) ?
+                NULL :
+                q_select->nselects ?
+                    siridb_points_copy(
+                            imap_get(q_select->points_map, series->id)):
+                    imap_pop(q_select->points_map, series->id);
+    }
 
     if (points == NULL)
     {
-        uv_mutex_lock(&siridb->series_mutex);
+        siridb_profile_lock(query->profile, &siridb->series_mutex);
 
         points = (series->flags & SIRIDB_SERIES_IS_DROPPED) ?
-                NULL : siridb_series_get_points(
+                NULL : q_select->tail ?
+                siridb_series_get_tail(
+                        series,
+                        q_select->start_ts,
+                        q_select->end_ts,
+                        q_select->tail) :
+                siridb_series_get_points(
                         series,
                         q_select->start_ts,
                         q_select->end_ts);
-        uv_mutex_unlock(&siridb->series_mutex);
+
+        siridb_profile_unlock(&siridb->series_mutex);
+
+        is_read = 1;
 
         /* when having a cache and points, add a copy of points to the cache */
         if (q_select->points_map != NULL && points != NULL)
@@ -4767,7 +5120,9 @@ static void async_select_aggregate(uv_async_t * handle)
         const char * name;
         size_t i;
 
-        for (i = 0; points->len && i < q_select->alist->len; i++)
+        siridb_profile_start(query->profile, &start);
+
+        for (i = 0; !is_cached && points->len && i < q_select->alist->len; i++)
         {
             aggr_points = siridb_aggregate_run(
                     points,
@@ -4788,10 +5143,48 @@ static void async_select_aggregate(uv_async_t * handle)
             points = aggr_points;
         }
 
-        q_select->n += points->len;
+        siridb_profile_stop(query->profile, SIRIDB_PROFILE_AGGREGATE, &start);
+
+        /*
+         * Only store results which are read in this step since points might
+         * be added to the series after filling 'points_map'.
+         */
+        if (q_select->rcache_key != NULL && is_read)
+        {
+            select_rcache_set(query, series, points);
+        }
+
+        if (IS_STREAM(q_select))
+        {
+            /*
+             * Streamed points are packed and send to the client right away
+             * so they do not count for the selected points limit.
+             */
+            siridb->selected_points += points->len;
+
+            name = siridb_presuf_name(
+                    q_select->presuf,
+                    series->name,
+                    series->name_len);
+
+            if (name == NULL || select_stream_pack(
+                    query,
+                    name,
+                    strlen(name),
+                    points) == -1)
+            {
+                sprintf(query->err_msg, "Memory allocation error.");
+                siridb_points_free(points);
+                siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+                return;
+            }
 
-        if (q_select->merge_as == NULL)
+            siridb_points_free(points);
+        }
+        else if (q_select->merge_as == NULL)
         {
+            q_select->n += points->len;
+
             name = siridb_presuf_name(
                     q_select->presuf,
                     series->name,
@@ -4810,6 +5203,8 @@ static void async_select_aggregate(uv_async_t * handle)
         {
             vec_t ** plist;
 
+            q_select->n += points->len;
+
             name = siridb_presuf_name(
                     q_select->presuf,
                     q_select->merge_as,
@@ -4832,13 +5227,23 @@ static void async_select_aggregate(uv_async_t * handle)
 
     if (async_more)
     {
-        uv_async_send(handle);
+        if (IS_STREAM(q_select))
+        {
+            select_stream_next(handle);
+        }
+        else
+        {
+            uv_async_send(handle);
+        }
     }
     else
     {
         siridb_aggregate_list_free(q_select->alist);
         q_select->alist = NULL;
 
+        free(q_select->rcache_key);
+        q_select->rcache_key = NULL;
+
         vec_free(q_select->vec);
         q_select->vec = NULL;
         q_select->vec_index = 0;
@@ -4847,12 +5252,64 @@ static void async_select_aggregate(uv_async_t * handle)
     }
 }
 
+/*
+ * Pack the (remaining) selected series to the client in chunks. The series
+ * which are packed are removed from the result so memory is released while
+ * streaming.
+ */
+static void async_select_stream(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    query_select_t * q_select = (query_select_t *) query->data;
+    select_stream_t stream;
+    char * name;
+    int rc;
+
+    stream.query = query;
+    stream.names = vec_new(VEC_DEFAULT_SIZE);
+
+    if (stream.names == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    rc = ct_items(
+            q_select->result,
+            (ct_item_cb) &items_select_stream,
+            &stream);
+
+    while (stream.names->len)
+    {
+        name = (char *) vec_pop(stream.names);
+        siridb_points_free(ct_pop(q_select->result, name));
+        free(name);
+    }
+
+    vec_free(stream.names);
+
+    if (rc == -1 || (query->flags & SIRIDB_QUERY_FLAG_ERR))
+    {
+        MEM_ERR_RET
+    }
+
+    if (rc)
+    {
+        /* the walk is stopped, continue with the remaining series */
+        select_stream_next(handle);
+    }
+    else
+    {
+        SIRIPARSER_ASYNC_NEXT_NODE
+    }
+}
+
 static void async_series_re(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
     query_wrapper_t * q_wrapper = (query_wrapper_t *) query->data;
     uint8_t async_more = 0;
     siridb_series_t * series;
+    struct timespec start;
     size_t index_end = q_wrapper->vec_index + MAX_ITERATE_COUNT;
 
     if (index_end >= q_wrapper->vec->len)
@@ -4866,6 +5323,8 @@ static void async_series_re(uv_async_t * handle)
 
     int pcre_exec_ret;
 
+    siridb_profile_start(query->profile, &start);
+
     for (; q_wrapper->vec_index < index_end; q_wrapper->vec_index++)
     {
         series = (siridb_series_t *)
@@ -4879,13 +5338,17 @@ static void async_series_re(uv_async_t * handle)
                 0,                     /* OPTIONS                       */
                 q_wrapper->match_data,
                 0);                    /* length of sub_str_vec         */
-        if (    pcre_exec_ret < 0 ||
-                imap_add(q_wrapper->series_tmp, series->id, series))
+        if (    pcre_exec_ret >= 0 &&
+                bmap_add(q_wrapper->series_tmp, series->id) == -1)
         {
-            siridb_series_decref(series);
+            log_critical("Cannot add series to temporary map.");
         }
+
+        siridb_series_decref(series);
     }
 
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_MATCH, &start);
+
     if (async_more)
     {
         uv_async_send(handle);
@@ -4895,8 +5358,7 @@ static void async_series_re(uv_async_t * handle)
         /* free the s-list object and reset index */
         vec_free(q_wrapper->vec);
 
-        pcre2_code_free(q_wrapper->regex);
-        pcre2_match_data_free(q_wrapper->match_data);
+        siridb_re_free(q_wrapper->regex, q_wrapper->match_data);
 
         q_wrapper->regex = NULL;
         q_wrapper->match_data = NULL;
@@ -4904,14 +5366,10 @@ static void async_series_re(uv_async_t * handle)
         q_wrapper->vec = NULL;
         q_wrapper->vec_index = 0;
 
-        if (q_wrapper->update_cb != NULL)
+        if (update_series_bits(q_wrapper))
         {
-            (*q_wrapper->update_cb)(
-                    q_wrapper->series_map,
-                    q_wrapper->series_tmp,
-                    (imap_free_cb) &siridb__series_decref);
+            MEM_ERR_RET
         }
-        q_wrapper->series_tmp = NULL;
 
         SIRIPARSER_ASYNC_NEXT_NODE
     }
@@ -5308,6 +5766,9 @@ static void on_list_xxx_response(vec_t * promises, uv_async_t * handle)
     query_list_t * q_list = (query_list_t *) query->data;
     size_t i;
 
+    /* the limit before local rows were added, used when merging rows */
+    size_t n = (q_list->rows == NULL) ? 0 : q_list->limit + q_list->rows->len;
+
     for (i = 0; i < promises->len; i++)
     {
         promise = promises->data[i];
@@ -5331,7 +5792,17 @@ static void on_list_xxx_response(vec_t * promises, uv_async_t * handle)
             {
                 while (qp_is_array(qp_current(&unpacker)))
                 {
-                    if (q_list->limit)
+                    if (q_list->rows != NULL)
+                    {
+                        if (list_rows_add(q_list->rows, &unpacker) &&
+                            !error_tp)
+                        {
+                            sprintf(query->err_msg,
+                                    "Memory allocation error.");
+                            error_tp = CPROTO_ERR_QUERY;
+                        }
+                    }
+                    else if (q_list->limit)
                     {
                         qp_packer_extend_fu(query->packer, &unpacker);
                         q_list->limit--;
@@ -5368,6 +5839,16 @@ static void on_list_xxx_response(vec_t * promises, uv_async_t * handle)
     }
     else
     {
+        if (q_list->rows != NULL)
+        {
+            /* rows from all pools, in name order and up to the limit */
+            ct_valuesn(
+                    q_list->rows,
+                    &n,
+                    (ct_val_cb) values_list_rows,
+                    query->packer);
+        }
+
         qp_add_type(query->packer, QP_ARRAY_CLOSE);
         SIRIPARSER_ASYNC_NEXT_NODE
     }
@@ -5389,10 +5870,8 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
     siridb_t * siridb = query->client->siridb;
     size_t err_count = 0;
     query_select_t * q_select = (query_select_t *) query->data;
+    qp_obj_t qp_key;
     qp_obj_t qp_name;
-    qp_obj_t qp_tp;
-    qp_obj_t qp_len;
-    qp_obj_t qp_points;
     qp_obj_t qp_err_msg;
     size_t i;
 
@@ -5453,18 +5932,27 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
                 qp_unpacker_init(&unpacker, pkg->data, pkg->len);
 
                 if (    qp_is_map(qp_next(&unpacker, NULL)) &&
-                        qp_is_raw(qp_next(&unpacker, NULL)) && /* select */
+                        qp_is_raw(qp_next(&unpacker, &qp_key)) &&
                         qp_is_map(qp_next(&unpacker, NULL)))
                 {
-                    if (q_select->merge_as == NULL)
+                    /* the key is either 'select' or 'partial' */
+                    if (q_select->partial != NULL &&
+                        qp_key.len == 7 &&
+                        memcmp(qp_key.via.raw, "partial", 7) == 0)
+                    {
+                        on_select_unpack_merged_points(
+                                &unpacker,
+                                q_select,
+                                q_select->partial,
+                                &qp_name,
+                                siridb->select_points_limit);
+                    }
+                    else if (q_select->merge_as == NULL)
                     {
                         on_select_unpack_points(
                                 &unpacker,
                                 q_select,
                                 &qp_name,
-                                &qp_tp,
-                                &qp_len,
-                                &qp_points,
                                 siridb->select_points_limit);
                     }
                     else
@@ -5472,10 +5960,8 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
                         on_select_unpack_merged_points(
                                 &unpacker,
                                 q_select,
+                                q_select->result,
                                 &qp_name,
-                                &qp_tp,
-                                &qp_len,
-                                &qp_points,
                                 siridb->select_points_limit);
                     }
 
@@ -5509,6 +5995,10 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
     {
         siridb_query_send_error(handle, CPROTO_ERR_QUERY);
     }
+    else if (IS_STREAM(q_select))
+    {
+        master_select_stream(handle);
+    }
     else
     {
         uv_async_t * next;
@@ -5671,68 +6161,415 @@ static void master_select_work_finish(uv_work_t * work, int status)
     free(work);
 }
 
-static int items_select_master(
-        const char * name,
-        size_t len,
-        siridb_points_t * points,
-        uv_async_t * handle)
+static void other_select_partial_work(uv_work_t * work)
 {
+    uv_async_t * handle = (uv_async_t *) work->data;
     siridb_query_t * query = (siridb_query_t *) handle->data;
+    query_select_t * q_select = (query_select_t *) query->data;
 
-    if (query->factor)
+    if (qp_add_raw(query->packer, (const unsigned char *) "partial", 7) ||
+        qp_add_type(query->packer, QP_MAP_OPEN))
     {
-        siridb_points_ts_correction(points, (double) query->factor);
+        sprintf(query->err_msg, "Memory allocation error.");
+        query->flags |= SIRIDB_QUERY_FLAG_ERR;
     }
-
-    if (    qp_add_raw(query->packer, (const unsigned char *) name, len) ||
-            siridb_points_pack(points, query->packer))
+    else if (ct_items(
+            q_select->result,
+            (ct_item_cb) &items_select_other_partial,
+            handle))
+    {
+        /* the error message is set by items_select_other_partial() */
+        query->flags |= SIRIDB_QUERY_FLAG_ERR;
+    }
+    else if (qp_add_type(query->packer, QP_MAP_CLOSE))
     {
         sprintf(query->err_msg, "Memory allocation error.");
-        return -1;
+        query->flags |= SIRIDB_QUERY_FLAG_ERR;
     }
-
-    return 0;
 }
 
-static int items_select_master_merge(
-        const char * name,
-        size_t len,
-        vec_t * plist,
-        uv_async_t * handle)
+/*
+ * Start streaming the selected series to the client. (the master does not
+ * need a work thread for this since each step packs at most one chunk)
+ */
+static void master_select_stream(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
     query_select_t * q_select = (query_select_t *) query->data;
-    siridb_points_t * points;
+    siridb_t * siridb = query->client->siridb;
+    uv_async_t * next = (uv_async_t *) malloc(sizeof(uv_async_t));
 
-    if (qp_add_raw(query->packer, (const unsigned char *) name, len))
+    if (next == NULL)
     {
-        sprintf(query->err_msg, "Memory allocation error.");
-        return -1;
+        MEM_ERR_RET
     }
 
-    switch (plist->len)
-    {
-    case 0:
-        points = siridb_points_new(0, TP_INT);
-        if (points == NULL)
-        {
-            sprintf(query->err_msg, "Memory allocation error.");
-        }
-        break;
-    case 1:
-        points = vec_pop(plist);
-        break;
-    default:
-        points = siridb_points_merge(plist, query->err_msg);
-        break;
-    }
+    siridb->selected_points += q_select->n;
 
-    if (q_select->mlist != NULL && points != NULL)
-    {
-        siridb_points_t * aggr_points;
-        size_t i;
+    uv_close((uv_handle_t *) handle, (uv_close_cb) free);
+
+    next->data = query;
+    uv_async_init(siri.loop, next, (uv_async_cb) async_select_stream);
+    uv_async_send(next);
+}
+
+/*
+ * Pack points for a series to the query packer and send a chunk to the
+ * client when the packer has reached SELECT_STREAM_CHUNK_SIZE.
+ *
+ * Returns 0 if successful, 1 when a chunk is send or -1 in case of an error.
+ * (a SIGNAL might be raised in case of an error)
+ */
+static int select_stream_pack(
+        siridb_query_t * query,
+        const char * name,
+        size_t len,
+        siridb_points_t * points)
+{
+    struct timespec start;
+    int rc;
+
+    if (query->factor)
+    {
+        siridb_points_ts_correction(points, (double) query->factor);
+    }
+
+    siridb_profile_start(query->profile, &start);
+
+    rc = qp_add_raw(query->packer, (const unsigned char *) name, len) ||
+            siridb_points_pack(points, query->packer);
+
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &start);
+
+    if (rc)
+    {
+        return -1;
+    }
+
+    if (query->packer->len < SELECT_STREAM_CHUNK_SIZE)
+    {
+        return 0;
+    }
+
+    return siridb_query_send_chunk(query) ? -1 : 1;
+}
 
-        for (i = 0; points->len && i < q_select->mlist->len; i++)
+/*
+ * Returns the aggregated points for a series using the result cache, or NULL
+ * when the result is not found. When only a part of the result is cached,
+ * the missing groups are calculated and the cache is updated.
+ */
+static siridb_points_t * select_rcache_get(
+        siridb_query_t * query,
+        siridb_series_t * series)
+{
+    query_select_t * q_select = (query_select_t *) query->data;
+    siridb_rcache_t * rcache = query->client->siridb->rcache;
+    siridb_points_t * head = NULL;
+    siridb_points_t * tail = NULL;
+    siridb_points_t * points;
+    siridb_rcache_hit_t hit;
+    uint64_t start_ts = (q_select->start_ts == NULL) ?
+            0 : *q_select->start_ts;
+    uint64_t end_ts = (q_select->end_ts == NULL) ?
+            UINT64_MAX : *q_select->end_ts;
+
+    if (!siridb_rcache_get(
+            rcache,
+            series->id,
+            q_select->rcache_key,
+            siridb_rcache_group_by(q_select->alist),
+            start_ts,
+            end_ts,
+            &hit))
+    {
+        return NULL;
+    }
+
+    if (hit.head_end == start_ts && hit.tail_start == end_ts)
+    {
+        return hit.points;
+    }
+
+    if (    (   hit.head_end > start_ts &&
+                (head = select_rcache_points(
+                        query,
+                        series,
+                        q_select->start_ts,
+                        &hit.head_end)) == NULL) ||
+            (   hit.tail_start < end_ts &&
+                (tail = select_rcache_points(
+                        query,
+                        series,
+                        &hit.tail_start,
+                        q_select->end_ts)) == NULL))
+    {
+        /* the result will be calculated without using the cache */
+        if (head != NULL)
+        {
+            siridb_points_free(head);
+        }
+        siridb_points_free(hit.points);
+        return NULL;
+    }
+
+    points = siridb_rcache_concat(head, hit.points, tail);
+
+    if (points != NULL)
+    {
+        select_rcache_set(query, series, points);
+    }
+
+    return points;
+}
+
+/*
+ * Returns aggregated points for a part of the selected time range or NULL
+ * in case of an error.
+ */
+static siridb_points_t * select_rcache_points(
+        siridb_query_t * query,
+        siridb_series_t * series,
+        uint64_t * start_ts,
+        uint64_t * end_ts)
+{
+    query_select_t * q_select = (query_select_t *) query->data;
+    siridb_t * siridb = query->client->siridb;
+    siridb_points_t * points;
+    siridb_points_t * aggr_points;
+    struct timespec start;
+
+    siridb_profile_lock(query->profile, &siridb->series_mutex);
+    points = siridb_series_get_points(series, start_ts, end_ts);
+    siridb_profile_unlock(&siridb->series_mutex);
+
+    if (points == NULL || !points->len)
+    {
+        return points;
+    }
+
+    /* partial results are only used for a single aggregate function */
+    siridb_profile_start(query->profile, &start);
+
+    aggr_points = siridb_aggregate_run(
+            points,
+            (siridb_aggr_t *) q_select->alist->data[0],
+            query->err_msg);
+
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_AGGREGATE, &start);
+
+    if (aggr_points != points)
+    {
+        siridb_points_free(points);
+    }
+
+    return aggr_points;
+}
+
+static void select_rcache_set(
+        siridb_query_t * query,
+        siridb_series_t * series,
+        siridb_points_t * points)
+{
+    query_select_t * q_select = (query_select_t *) query->data;
+
+    siridb_rcache_set(
+            query->client->siridb->rcache,
+            series->id,
+            q_select->rcache_key,
+            siridb_rcache_group_by(q_select->alist),
+            (q_select->start_ts == NULL) ? 0 : *q_select->start_ts,
+            (q_select->end_ts == NULL) ? UINT64_MAX : *q_select->end_ts,
+            points);
+}
+
+/*
+ * Continue with the next step of a streaming select. When too much data is
+ * waiting to be written to the client we wait a little before continuing so
+ * the result is not buffered in memory when a client reads slowly.
+ */
+static void select_stream_next(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    uv_timer_t * timer;
+
+    if (sirinet_wqueue_pending_size(query->client) <
+                SELECT_STREAM_MAX_PENDING ||
+        (timer = (uv_timer_t *) malloc(sizeof(uv_timer_t))) == NULL)
+    {
+        uv_async_send(handle);
+        return;
+    }
+
+    siri_async_incref(handle);
+    timer->data = handle;
+
+    uv_timer_init(siri.loop, timer);
+    uv_timer_start(timer, on_select_stream_timer, SELECT_STREAM_WAIT, 0);
+}
+
+static void on_select_stream_timer(uv_timer_t * timer)
+{
+    uv_async_t * handle = (uv_async_t *) timer->data;
+
+    uv_close((uv_handle_t *) timer, (uv_close_cb) free);
+
+    if (!siri_err && !uv_is_closing((uv_handle_t *) handle))
+    {
+        select_stream_next(handle);
+    }
+
+    siri_async_decref(&handle);
+}
+
+/*
+ * Add the server name and query time to the timeit packer.
+ */
+static void timeit_pack_server(siridb_query_t * query)
+{
+    siridb_t * siridb = query->client->siridb;
+
+    struct timespec end;
+    char * name = siridb->server->name;
+    clock_gettime(CLOCK_REALTIME, &end);
+
+    qp_add_raw(query->timeit, (const unsigned char *) "server", 6);
+    qp_add_string(query->timeit, name);
+    qp_add_raw(query->timeit, (const unsigned char *) "time", 4);
+    qp_add_double(query->timeit,
+            (double) (end.tv_sec - query->start.tv_sec) +
+            (double) (end.tv_nsec - query->start.tv_nsec) / 1000000000.0f);
+}
+
+/*
+ * Extend the query packer with the timeit (or profile) information and
+ * continue with the next node.
+ */
+static void timeit_finish(uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+
+    if (query->packer == NULL)
+    {
+        /* lets give the new packer the exact size so we do not
+         * need a realloc */
+        query->packer = sirinet_packer_new(
+                query->timeit->len +
+                1 +
+                sizeof(sirinet_pkg_t));
+
+        if (query->packer == NULL)
+        {
+            MEM_ERR_RET
+        }
+
+        qp_add_type(query->packer, QP_MAP_OPEN);
+    }
+
+    /* extend packer with timeit information */
+    qp_packer_extend(query->packer, query->timeit);
+
+    SIRIPARSER_ASYNC_NEXT_NODE
+}
+
+static int items_select_master(
+        const char * name,
+        size_t len,
+        siridb_points_t * points,
+        uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    struct timespec start;
+    int rc;
+
+    if (query->factor)
+    {
+        siridb_points_ts_correction(points, (double) query->factor);
+    }
+
+    siridb_profile_start(query->profile, &start);
+
+    rc = qp_add_raw(query->packer, (const unsigned char *) name, len) ||
+            siridb_points_pack(points, query->packer);
+
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &start);
+
+    if (rc)
+    {
+        sprintf(query->err_msg, "Memory allocation error.");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int items_select_master_merge(
+        const char * name,
+        size_t len,
+        vec_t * plist,
+        uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    query_select_t * q_select = (query_select_t *) query->data;
+    siridb_points_t * points;
+    vec_t ** partials;
+    size_t i = 0;
+    struct timespec start;
+    int rc;
+
+    if (qp_add_raw(query->packer, (const unsigned char *) name, len))
+    {
+        sprintf(query->err_msg, "Memory allocation error.");
+        return -1;
+    }
+
+    siridb_profile_start(query->profile, &start);
+
+    switch (plist->len)
+    {
+    case 0:
+        points = siridb_points_new(0, TP_INT);
+        if (points == NULL)
+        {
+            sprintf(query->err_msg, "Memory allocation error.");
+        }
+        break;
+    case 1:
+        points = vec_pop(plist);
+        break;
+    default:
+        points = siridb_points_merge(plist, query->err_msg);
+        break;
+    }
+
+    if (q_select->partial != NULL &&
+        points != NULL &&
+        (partials = (vec_t **) ct_getaddr(q_select->partial, name)) != NULL &&
+        (*partials)->len)
+    {
+        /*
+         * At least one pool has sent partial results. Add a partial state
+         * for the local points and combine them to the final result for the
+         * first merge aggregate function.
+         */
+        siridb_aggr_t * aggr = (siridb_aggr_t *) q_select->mlist->data[0];
+
+        if (siridb_partial_append(partials, points, aggr, query->err_msg))
+        {
+            siridb_points_free(points);
+            return -1;  /* (error message is set)  */
+        }
+
+        siridb_points_free(points);
+        points = siridb_partial_combine(*partials, aggr, query->err_msg);
+        i = 1;
+    }
+
+    if (q_select->mlist != NULL && points != NULL)
+    {
+        siridb_points_t * aggr_points;
+
+        for (; points->len && i < q_select->mlist->len; i++)
         {
             aggr_points = siridb_aggregate_run(
                     points,
@@ -5753,6 +6590,8 @@ static int items_select_master_merge(
         }
     }
 
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_MERGE, &start);
+
     if (points == NULL)
     {
         /*
@@ -5767,18 +6606,70 @@ static int items_select_master_merge(
         siridb_points_ts_correction(points, (double) query->factor);
     }
 
-    if (siridb_points_pack(points, query->packer))
+    siridb_profile_start(query->profile, &start);
+    rc = siridb_points_pack(points, query->packer);
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &start);
+
+    siridb_points_free(points);
+
+    if (rc)
     {
         sprintf(query->err_msg, "Memory allocation error.");
-        siridb_points_free(points);
         return -1;
     }
 
-    siridb_points_free(points);
-
     return 0;
 }
 
+/*
+ * Returns 0 to continue, 1 when the chunk is full or the maximum number of
+ * series for one step is reached.
+ */
+static int items_select_stream(
+        const char * name,
+        size_t len,
+        siridb_points_t * points,
+        select_stream_t * stream)
+{
+    siridb_query_t * query = stream->query;
+    char * cpy = strndup(name, len);
+
+    if (cpy == NULL || vec_append_safe(&stream->names, cpy))
+    {
+        free(cpy);
+        query->flags |= SIRIDB_QUERY_FLAG_ERR;
+        return 1;
+    }
+
+    switch (select_stream_pack(query, name, len, points))
+    {
+    case -1:
+        query->flags |= SIRIDB_QUERY_FLAG_ERR;
+        /* FALLTHRU */
+        /* no break */
+    case 1:
+        /* stop after each chunk so we can check the client write queue */
+        return 1;
+    }
+
+    return stream->names->len >= MAX_ITERATE_COUNT;
+}
+
+/*
+ * Pack points for the master server. The points are zipped when the master
+ * has told us it can read zipped points.
+ *
+ * Returns 0 when successful and -1 in case of an error.
+ */
+static int pack_select_points(
+        siridb_points_t * points,
+        siridb_query_t * query)
+{
+    return (query->flags & SIRIDB_QUERY_FLAG_ZIP) ?
+            siridb_points_zip_pack(points, query->packer) :
+            siridb_points_raw_pack(points, query->packer);
+}
+
 /*
  * Returns 0 when successful and -1 in case of an error.
  * (a SIGNAL is raised in case of an error)
@@ -5790,10 +6681,18 @@ static int items_select_other(
         uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
+    struct timespec start;
+    int rc;
 
-    return -(qp_add_raw_term(
+    siridb_profile_start(query->profile, &start);
+
+    rc = qp_add_raw_term(
                 query->packer, (const unsigned char *) name, len) ||
-            siridb_points_raw_pack(points, query->packer));
+            pack_select_points(points, query);
+
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &start);
+
+    return -rc;
 }
 
 /*
@@ -5808,27 +6707,122 @@ static int items_select_other_merge(
 {
     size_t i;
     siridb_query_t * query = (siridb_query_t *) handle->data;
-    int rc = qp_add_raw_term(
+    struct timespec start;
+    int rc;
+
+    siridb_profile_start(query->profile, &start);
+
+    rc = qp_add_raw_term(
                 query->packer, (const unsigned char *) name, len) ||
             qp_add_type(query->packer, QP_ARRAY_OPEN);
 
     for (i = 0; !rc && i < plist->len; i++)
     {
-        rc = siridb_points_raw_pack(
+        rc = pack_select_points(
                 (siridb_points_t * ) plist->data[i],
-                query->packer);
+                query);
     }
 
-    return -(rc || qp_add_type(query->packer, QP_ARRAY_CLOSE));
+    rc = rc || qp_add_type(query->packer, QP_ARRAY_CLOSE);
+
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &start);
+
+    return -rc;
+}
+
+/*
+ * Returns 0 when successful and -1 in case of an error.
+ * (error message is set and a SIGNAL might be raised)
+ */
+static int items_select_other_partial(
+        const char * name,
+        size_t len,
+        vec_t * plist,
+        uv_async_t * handle)
+{
+    siridb_query_t * query = (siridb_query_t *) handle->data;
+    query_select_t * q_select = (query_select_t *) query->data;
+    siridb_points_t * points;
+    vec_t * partials;
+    size_t i;
+    int rc;
+    struct timespec start;
+
+    siridb_profile_start(query->profile, &start);
+
+    switch (plist->len)
+    {
+    case 0:
+        points = siridb_points_new(0, TP_INT);
+        if (points == NULL)
+        {
+            sprintf(query->err_msg, "Memory allocation error.");
+        }
+        break;
+    case 1:
+        points = vec_pop(plist);
+        break;
+    default:
+        points = siridb_points_merge(plist, query->err_msg);
+        break;
+    }
+
+    if (points == NULL)
+    {
+        return -1;  /* (error message is set)  */
+    }
+
+    partials = vec_new(VEC_DEFAULT_SIZE);
+    if (partials == NULL)
+    {
+        siridb_points_free(points);
+        sprintf(query->err_msg, "Memory allocation error.");
+        return -1;
+    }
+
+    rc = siridb_partial_append(
+            &partials,
+            points,
+            (siridb_aggr_t *) q_select->mlist->data[0],
+            query->err_msg);
+
+    siridb_points_free(points);
+
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_MERGE, &start);
+
+    if (rc == 0)
+    {
+        siridb_profile_start(query->profile, &start);
+
+        rc = qp_add_raw_term(
+                query->packer, (const unsigned char *) name, len) ||
+            qp_add_type(query->packer, QP_ARRAY_OPEN);
+
+        for (i = 0; !rc && i < partials->len; i++)
+        {
+            rc = pack_select_points(
+                    (siridb_points_t * ) partials->data[i],
+                    query);
+        }
+
+        if (rc || qp_add_type(query->packer, QP_ARRAY_CLOSE))
+        {
+            sprintf(query->err_msg, "Memory allocation error.");
+            rc = -1;
+        }
+
+        siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &start);
+    }
+
+    siridb_partial_free(partials);
+
+    return rc;
 }
 
 static void on_select_unpack_points(
         qp_unpacker_t * unpacker,
         query_select_t * q_select,
         qp_obj_t * qp_name,
-        qp_obj_t * qp_tp,
-        qp_obj_t * qp_len,
-        qp_obj_t * qp_points,
         uint32_t select_points_limit)
 {
     siridb_points_t * points;
@@ -5837,58 +6831,28 @@ static void on_select_unpack_points(
             qp_is_raw(qp_next(unpacker, qp_name)) &&
             qp_is_raw_term(qp_name) &&
             qp_is_array(qp_next(unpacker, NULL)) &&
-            qp_is_int(qp_next(unpacker, qp_tp)) &&
-            qp_is_int(qp_next(unpacker, qp_len)) &&
-            qp_is_raw(qp_next(unpacker, qp_points)))
+            (points = siridb_points_unpack(unpacker)) != NULL)
     {
-        points = siridb_points_new(qp_len->via.int64, qp_tp->via.int64);
-        if (points != NULL)
+        if (ct_add(q_select->result, (char *) qp_name->via.raw, points))
         {
-            if (points->tp == TP_STRING)
-            {
-                if (qp_len->via.int64 < POINTS_ZIP_THRESHOLD)
-                {
-                    siridb_points_unzip_string_raw(
-                            points,
-                            qp_points->via.raw,
-                            qp_len->via.int64);
-                }
-                else
-                {
-                    siridb_points_unzip_string(
-                            points,
-                            qp_points->via.raw,
-                            qp_len->via.int64,
-                            NULL, NULL, 0);
-                }
-            }
-            else
-            {
-                points->len = qp_len->via.int64;
-                memcpy(points->data, qp_points->via.raw, qp_points->len);
-            }
-
-            if (ct_add(q_select->result, (char *) qp_name->via.raw, points))
-            {
-                siridb_points_free(points);
-            }
-            else
-            {
-                q_select->n += points->len;
-            }
+            siridb_points_free(points);
+        }
+        else
+        {
+            q_select->n += points->len;
         }
-
-        qp_next(unpacker, NULL);  /* QP_ARRAY_CLOSE     */
     }
 }
 
+/*
+ * Unpack merged points to 'dest'. This function is used for both the 'normal'
+ * merged points and partial results.
+ */
 static void on_select_unpack_merged_points(
         qp_unpacker_t * unpacker,
         query_select_t * q_select,
+        ct_t * dest,
         qp_obj_t * qp_name,
-        qp_obj_t * qp_tp,
-        qp_obj_t * qp_len,
-        qp_obj_t * qp_points,
         uint32_t select_points_limit)
 {
     siridb_points_t * points;
@@ -5898,55 +6862,21 @@ static void on_select_unpack_merged_points(
             qp_is_array(qp_next(unpacker, NULL)))
     {
         vec_t ** plist = (vec_t **) ct_getaddr(
-                q_select->result,
+                dest,
                 (const char *) qp_name->via.raw);
 
         while ( q_select->n <= select_points_limit &&
                 qp_is_array(qp_next(unpacker, NULL)) &&
-                qp_is_int(qp_next(unpacker, qp_tp)) &&
-                qp_is_int(qp_next(unpacker, qp_len)) &&
-                qp_is_raw(qp_next(unpacker, qp_points)))
+                (points = siridb_points_unpack(unpacker)) != NULL)
         {
-
-            points = siridb_points_new(qp_len->via.int64, qp_tp->via.int64);
-
-            if (points != NULL)
+            if (vec_append_safe(plist, points))
             {
-                if (points->tp == TP_STRING)
-                {
-                    if (qp_len->via.int64 < POINTS_ZIP_THRESHOLD)
-                    {
-                        siridb_points_unzip_string_raw(
-                                points,
-                                qp_points->via.raw,
-                                qp_len->via.int64);
-                    }
-                    else
-                    {
-                        siridb_points_unzip_string(
-                                points,
-                                qp_points->via.raw,
-                                qp_len->via.int64,
-                                NULL, NULL, 0);
-                    }
-                }
-                else
-                {
-                    points->len = qp_len->via.int64;
-                    memcpy(points->data, qp_points->via.raw, qp_points->len);
-                }
-
-                if (vec_append_safe(plist, points))
-                {
-                    siridb_points_free(points);
-                }
-                else
-                {
-                    q_select->n += points->len;
-                }
+                siridb_points_free(points);
+            }
+            else
+            {
+                q_select->n += points->len;
             }
-
-            qp_next(unpacker, NULL);  /* QP_ARRAY_CLOSE     */
         }
     }
 }
@@ -5989,6 +6919,187 @@ static int values_count_groups(siridb_group_t * group, uv_async_t * handle)
             group);
 }
 
+/*
+ * Add a series with a new reference to the vector. Returns 0 if successful
+ * or 1 in case of an allocation error.
+ */
+static int values_series_re(siridb_series_t * series, vec_t ** vec)
+{
+    if (vec_append_safe(vec, series))
+    {
+        return 1;
+    }
+    siridb_series_incref(series);
+    return 0;
+}
+
+static int add_series_bits(siridb_series_t * series, bmap_t * bmap)
+{
+    return bmap_add(bmap, series->id) == -1;
+}
+
+/*
+ * The vector must have room for all series, the walk is limited to the size
+ * of the vector.
+ */
+static int values_list_series(siridb_series_t * series, vec_t * vec)
+{
+    siridb_series_incref(series);
+    vec_append(vec, series);
+    return 1;
+}
+
+/*
+ * Append a row which is stored by list_rows_add() to the packer.
+ */
+static int values_list_rows(qp_packer_t * row, qp_packer_t * packer)
+{
+    qp_packer_extend(packer, row);
+    return 1;
+}
+
+/*
+ * Store a copy of the row at the current position of the unpacker, using
+ * the series name in the first column as key. The unpacker is moved to the
+ * next row. A series found in more than one pool, which can happen while
+ * re-indexing, is only stored once.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int list_rows_add(ct_t * rows, qp_unpacker_t * unpacker)
+{
+    qp_obj_t qp_name;
+    qp_packer_t * row;
+    unsigned char * start = unpacker->pt;
+    int is_row = qp_is_array(qp_next(unpacker, NULL)) &&
+            qp_is_raw(qp_next(unpacker, &qp_name));
+    size_t size;
+
+    unpacker->pt = start;
+    qp_skip_next(unpacker);
+
+    if (!is_row)
+    {
+        return 0;
+    }
+
+    char name[qp_name.len + 1];
+    memcpy(name, qp_name.via.raw, qp_name.len);
+    name[qp_name.len] = '\0';
+
+    size = unpacker->pt - start;
+    row = qp_packer_new(size);
+
+    if (row == NULL)
+    {
+        return -1;
+    }
+
+    memcpy(row->buffer, start, size);
+    row->len = size;
+
+    switch (ct_add(rows, name, row))
+    {
+    case CT_OK:
+        return 0;
+    case CT_EXISTS:
+        qp_packer_free(row);
+        return 0;
+    }
+
+    qp_packer_free(row);
+    return -1;
+}
+
+/*
+ * Returns the series with a name greater than the 'after' name in name
+ * order. Without a where expression only the series up to the limit are
+ * returned. (the series mutex must be locked)
+ *
+ * Returns NULL in case of an allocation error.
+ */
+static vec_t * list_series_after(siridb_t * siridb, query_list_t * q_list)
+{
+    siridb_series_t * series;
+    vec_t * vec;
+    size_t i, n;
+
+    if (q_list->series_map == NULL)
+    {
+        n = (q_list->where_expr == NULL) ?
+                q_list->limit : siridb->series->len;
+
+        vec = vec_new(n);
+
+        if (vec != NULL)
+        {
+            siridb_names_valuesn_after(
+                    siridb->series,
+                    q_list->after,
+                    &n,
+                    (ct_val_cb) values_list_series,
+                    vec);
+        }
+        return vec;
+    }
+
+    vec = imap_2vec_ref(q_list->series_map);
+
+    if (vec == NULL)
+    {
+        return NULL;
+    }
+
+    for (i = n = 0; i < vec->len; i++)
+    {
+        series = (siridb_series_t *) vec->data[i];
+
+        if (strcmp(series->name, q_list->after) > 0)
+        {
+            vec->data[n++] = series;
+        }
+        else
+        {
+            siridb_series_decref(series);
+        }
+    }
+
+    vec->len = n;
+
+    qsort(vec->data, vec->len, sizeof(void *), &cmp_series_name);
+
+    return vec;
+}
+
+static int cmp_series_name(const void * a, const void * b)
+{
+    return strcmp(
+            (*((siridb_series_t **) a))->name,
+            (*((siridb_series_t **) b))->name);
+}
+
+/*
+ * Update the selected series with the temporary series using the set
+ * operation of the query. Returns 0 if successful or -1 in case of an
+ * allocation error.
+ */
+static int update_series_bits(query_wrapper_t * q_wrapper)
+{
+    int rc = 0;
+
+    if (q_wrapper->update_cb != NULL)
+    {
+        rc = (*q_wrapper->update_cb)(
+                q_wrapper->series_bits,
+                q_wrapper->series_tmp);
+        bmap_free(q_wrapper->series_tmp);
+    }
+
+    q_wrapper->series_tmp = NULL;
+
+    return rc;
+}
+
 static void finish_list_groups(uv_async_t * handle)
 {
     siridb_query_t * query = (siridb_query_t *) handle->data;
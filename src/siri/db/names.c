@@ -0,0 +1,639 @@
+/*
+ * names.c - Dictionary with series names.
+ *
+ * Most series are stored in a sorted array with one pointer per series and
+ * an open addressing hash table for exact lookups. Both point to the series
+ * itself and use the name which is stored in the series allocation, so the
+ * dictionary does not store names of its own.
+ *
+ * Series added after the last rebuild are kept in a small compact tree, the
+ * delta. A dropped series is replaced in the sorted array by a copy of its
+ * name (a tagged pointer) so binary search keeps working. A rebuild merges
+ * the delta into the sorted array and removes the dropped entries. This
+ * happens when the delta or the number of dropped entries becomes large
+ * compared to the sorted array.
+ *
+ * Walking over the series in order merges the sorted array with the delta,
+ * which gives the same order as a compact tree with all series.
+ */
+#include <logger/logger.h>
+#include <siri/db/names.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vec/vec.h>
+
+#define NAMES_MIN_SLOTS 1024
+#define NAMES_REBUILD_MIN 4096
+#define NAMES_REBUILD_RATIO 16
+
+#define NAMES_DROPPED(entry) ((entry) & 1)
+#define NAMES_NAME(entry) (NAMES_DROPPED(entry) ? \
+        (const char *) ((entry) & ~(uintptr_t) 1) : \
+        ((siridb_series_t *) (entry))->name)
+
+static size_t NAMES_hash(const char * name, size_t n);
+static size_t NAMES_slot(
+        siridb_names_t * names,
+        const char * name,
+        size_t n);
+static int NAMES_grow(siridb_names_t * names);
+static void NAMES_unslot(siridb_names_t * names, size_t i);
+static size_t NAMES_bound(
+        siridb_names_t * names,
+        const char * name,
+        size_t n,
+        int upper);
+static void NAMES_unsort(siridb_names_t * names, const char * name);
+static void NAMES_walk(
+        siridb_names_t * names,
+        size_t lo,
+        size_t hi,
+        vec_t * delta,
+        size_t * n,
+        int * rc,
+        ct_val_cb cb,
+        void * args);
+static int NAMES_append(siridb_series_t * series, vec_t * vec);
+
+/*
+ * Returns NULL in case of an allocation error.
+ */
+siridb_names_t * siridb_names_new(void)
+{
+    siridb_names_t * names =
+            (siridb_names_t *) malloc(sizeof(siridb_names_t));
+
+    if (names == NULL)
+    {
+        return NULL;
+    }
+
+    names->len = 0;
+    names->size = 0;
+    names->ndropped = 0;
+    names->mask = NAMES_MIN_SLOTS - 1;
+    names->sorted = NULL;
+    names->slots = (siridb_series_t **) calloc(
+            NAMES_MIN_SLOTS,
+            sizeof(siridb_series_t *));
+    names->delta = ct_new();
+
+    if (names->slots == NULL || names->delta == NULL)
+    {
+        siridb_names_free(names, NULL);
+        return NULL;
+    }
+
+    return names;
+}
+
+/*
+ * Destroy the dictionary and call 'cb' (when not NULL) for each series.
+ * (parsing NULL is not allowed)
+ */
+void siridb_names_free(siridb_names_t * names, ct_free_cb cb)
+{
+    size_t i;
+
+    if (names->slots != NULL && cb != NULL)
+    {
+        for (i = 0; i <= names->mask; i++)
+        {
+            if (names->slots[i] != NULL)
+            {
+                (*cb)(names->slots[i]);
+            }
+        }
+    }
+
+    for (i = 0; i < names->size; i++)
+    {
+        if (NAMES_DROPPED(names->sorted[i]))
+        {
+            free((char *) NAMES_NAME(names->sorted[i]));
+        }
+    }
+
+    if (names->delta != NULL)
+    {
+        ct_free(names->delta, NULL);
+    }
+
+    free(names->sorted);
+    free(names->slots);
+    free(names);
+}
+
+/*
+ * Add a series to the dictionary and rebuild the dictionary when the delta
+ * has become too large.
+ *
+ * Returns CT_OK if successful, CT_EXISTS if a series with the same name
+ * exists or CT_ERR in case of an allocation error.
+ */
+int siridb_names_add(siridb_names_t * names, siridb_series_t * series)
+{
+    int rc = siridb_names_append(names, series);
+
+    if (rc == CT_OK &&
+        names->delta->len >= NAMES_REBUILD_MIN &&
+        names->delta->len * NAMES_REBUILD_RATIO >= names->size &&
+        siridb_names_rebuild(names))
+    {
+        /* the dictionary is still valid, the rebuild will be retried */
+        log_error("Cannot rebuild the series name dictionary");
+    }
+
+    return rc;
+}
+
+/*
+ * Add a series to the dictionary without rebuilding the dictionary. This
+ * is used when loading series, siridb_names_rebuild() should be called
+ * once all series are added.
+ *
+ * Returns CT_OK if successful, CT_EXISTS if a series with the same name
+ * exists or CT_ERR in case of an allocation error.
+ */
+int siridb_names_append(siridb_names_t * names, siridb_series_t * series)
+{
+    size_t i = NAMES_slot(names, series->name, series->name_len);
+
+    if (names->slots[i] != NULL)
+    {
+        return CT_EXISTS;
+    }
+
+    if ((names->len + 1) * 2 > names->mask + 1)
+    {
+        if (NAMES_grow(names))
+        {
+            return CT_ERR;
+        }
+        i = NAMES_slot(names, series->name, series->name_len);
+    }
+
+    if (ct_add(names->delta, series->name, series) != CT_OK)
+    {
+        return CT_ERR;
+    }
+
+    names->slots[i] = series;
+    names->len++;
+
+    return CT_OK;
+}
+
+/*
+ * Merge the delta into the sorted array and remove dropped entries.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error. The
+ * dictionary is unchanged in case of an error.
+ */
+int siridb_names_rebuild(siridb_names_t * names)
+{
+    uintptr_t * sorted = NULL;
+    size_t size = names->len;
+    size_t i, j;
+    uintptr_t entry;
+    siridb_series_t * series;
+    vec_t * delta = vec_new(names->delta->len);
+    ct_t * ct = ct_new();
+
+    if (size)
+    {
+        sorted = (uintptr_t *) malloc(size * sizeof(uintptr_t));
+    }
+
+    if (delta == NULL || ct == NULL || (size && sorted == NULL))
+    {
+        free(delta);
+        free(sorted);
+        if (ct != NULL)
+        {
+            ct_free(ct, NULL);
+        }
+        return -1;
+    }
+
+    ct_values(names->delta, (ct_val_cb) NAMES_append, delta);
+
+    for (i = 0, j = 0, size = 0; i < names->size || j < delta->len;)
+    {
+        if (i < names->size)
+        {
+            entry = names->sorted[i];
+            if (NAMES_DROPPED(entry))
+            {
+                free((char *) NAMES_NAME(entry));
+                i++;
+                continue;
+            }
+            series = (siridb_series_t *) entry;
+            if (j == delta->len || strcmp(
+                    series->name,
+                    ((siridb_series_t *) delta->data[j])->name) < 0)
+            {
+                sorted[size++] = entry;
+                i++;
+                continue;
+            }
+        }
+        sorted[size++] = (uintptr_t) delta->data[j++];
+    }
+
+    free(names->sorted);
+    ct_free(names->delta, NULL);
+    vec_free(delta);
+
+    names->sorted = sorted;
+    names->size = size;
+    names->ndropped = 0;
+    names->delta = ct;
+
+    return 0;
+}
+
+/*
+ * Returns a series by name or NULL when not found.
+ */
+siridb_series_t * siridb_names_get(siridb_names_t * names, const char * name)
+{
+    return names->slots[NAMES_slot(names, name, strlen(name))];
+}
+
+/*
+ * Returns a series by the first 'n' characters of 'name' or NULL when not
+ * found. The name does not need to be terminated.
+ */
+siridb_series_t * siridb_names_getn(
+        siridb_names_t * names,
+        const char * name,
+        size_t n)
+{
+    return names->slots[NAMES_slot(names, name, n)];
+}
+
+/*
+ * Remove a series from the dictionary.
+ *
+ * Returns the removed series or NULL when not found.
+ */
+siridb_series_t * siridb_names_pop(siridb_names_t * names, const char * name)
+{
+    size_t i = NAMES_slot(names, name, strlen(name));
+    siridb_series_t * series = names->slots[i];
+
+    if (series == NULL)
+    {
+        return NULL;
+    }
+
+    NAMES_unslot(names, i);
+    names->len--;
+
+    if (ct_pop(names->delta, name) == NULL)
+    {
+        NAMES_unsort(names, name);
+    }
+
+    return series;
+}
+
+/*
+ * Call 'cb' for each series starting with the first 'n' characters of
+ * 'prefix', in order.
+ *
+ * Returns the sum of all callback results.
+ */
+int siridb_names_values_prefix(
+        siridb_names_t * names,
+        const char * prefix,
+        size_t n,
+        ct_val_cb cb,
+        void * args)
+{
+    int rc = 0;
+    size_t limit = SIZE_MAX;
+    vec_t * delta = vec_new(names->delta->len);
+
+    if (delta == NULL)
+    {
+        return -1;
+    }
+
+    ct_values_prefix(
+            names->delta,
+            prefix,
+            n,
+            (ct_val_cb) NAMES_append,
+            delta);
+
+    NAMES_walk(
+            names,
+            NAMES_bound(names, prefix, n, 0),
+            NAMES_bound(names, prefix, n, 1),
+            delta,
+            &limit,
+            &rc,
+            cb,
+            args);
+
+    vec_free(delta);
+    return rc;
+}
+
+/*
+ * Call 'cb' for series in order. Each positive callback result is
+ * subtracted from 'n' and the walk stops when 'n' reaches zero.
+ */
+void siridb_names_valuesn(
+        siridb_names_t * names,
+        size_t * n,
+        ct_val_cb cb,
+        void * args)
+{
+    int rc = 0;
+    vec_t * delta = vec_new(names->delta->len);
+
+    if (delta == NULL)
+    {
+        return;
+    }
+
+    /* callbacks may skip series so the whole delta is required */
+    ct_values(names->delta, (ct_val_cb) NAMES_append, delta);
+    NAMES_walk(names, 0, names->size, delta, n, &rc, cb, args);
+    vec_free(delta);
+}
+
+/*
+ * Like siridb_names_valuesn() but starts at the first series with a name
+ * greater than 'name'.
+ */
+void siridb_names_valuesn_after(
+        siridb_names_t * names,
+        const char * name,
+        size_t * n,
+        ct_val_cb cb,
+        void * args)
+{
+    int rc = 0;
+    size_t m = SIZE_MAX;
+    vec_t * delta = vec_new(names->delta->len);
+
+    if (delta == NULL)
+    {
+        return;
+    }
+
+    ct_valuesn_after(names->delta, name, &m, (ct_val_cb) NAMES_append, delta);
+    NAMES_walk(
+            names,
+            NAMES_bound(names, name, strlen(name) + 1, 1),
+            names->size,
+            delta,
+            n,
+            &rc,
+            cb,
+            args);
+    vec_free(delta);
+}
+
+/*
+ * FNV-1a hash on the first 'n' characters of 'name'.
+ */
+static size_t NAMES_hash(const char * name, size_t n)
+{
+    uint32_t hash = 2166136261u;
+
+    for (; n--; name++)
+    {
+        hash ^= (uint8_t) *name;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+ * Returns the slot with the series for 'name' or the empty slot where the
+ * series should be stored.
+ */
+static size_t NAMES_slot(
+        siridb_names_t * names,
+        const char * name,
+        size_t n)
+{
+    size_t i = NAMES_hash(name, n) & names->mask;
+    siridb_series_t * series;
+
+    for (; (series = names->slots[i]) != NULL; i = (i + 1) & names->mask)
+    {
+        if (series->name_len == n && memcmp(series->name, name, n) == 0)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*
+ * Double the number of hash slots.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int NAMES_grow(siridb_names_t * names)
+{
+    size_t i, mask = names->mask;
+    siridb_series_t ** slots = names->slots;
+    siridb_series_t * series;
+
+    names->slots = (siridb_series_t **) calloc(
+            (mask + 1) * 2,
+            sizeof(siridb_series_t *));
+
+    if (names->slots == NULL)
+    {
+        names->slots = slots;
+        return -1;
+    }
+
+    names->mask = mask * 2 + 1;
+
+    for (i = 0; i <= mask; i++)
+    {
+        series = slots[i];
+        if (series != NULL)
+        {
+            names->slots[NAMES_slot(
+                    names,
+                    series->name,
+                    series->name_len)] = series;
+        }
+    }
+
+    free(slots);
+    return 0;
+}
+
+/*
+ * Empty slot 'i' and move succeeding series back so no tombstones are
+ * required for linear probing.
+ */
+static void NAMES_unslot(siridb_names_t * names, size_t i)
+{
+    size_t j = i, k;
+    siridb_series_t * series;
+
+    names->slots[i] = NULL;
+
+    while (1)
+    {
+        j = (j + 1) & names->mask;
+        series = names->slots[j];
+
+        if (series == NULL)
+        {
+            return;
+        }
+
+        k = NAMES_hash(series->name, series->name_len) & names->mask;
+
+        /* move the series when its home slot 'k' is not in (i, j] */
+        if ((i < j) ? (k <= i || k > j) : (k <= i && k > j))
+        {
+            names->slots[i] = series;
+            names->slots[j] = NULL;
+            i = j;
+        }
+    }
+}
+
+/*
+ * Returns the first position in the sorted array with a name where the
+ * first 'n' characters compare greater than (upper) or not less than
+ * (lower) 'name'.
+ */
+static size_t NAMES_bound(
+        siridb_names_t * names,
+        const char * name,
+        size_t n,
+        int upper)
+{
+    size_t lo = 0, hi = names->size, mid;
+    int rc;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        rc = strncmp(NAMES_NAME(names->sorted[mid]), name, n);
+        if (upper ? rc <= 0 : rc < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*
+ * Replace a series in the sorted array with a copy of its name. When the
+ * copy cannot be allocated, the entry is removed from the array instead.
+ */
+static void NAMES_unsort(siridb_names_t * names, const char * name)
+{
+    size_t i = NAMES_bound(names, name, strlen(name) + 1, 0);
+    char * dropped;
+
+    if (i == names->size ||
+        NAMES_DROPPED(names->sorted[i]) ||
+        strcmp(NAMES_NAME(names->sorted[i]), name))
+    {
+        return;
+    }
+
+    dropped = strdup(name);
+
+    if (dropped == NULL)
+    {
+        names->size--;
+        memmove(
+                names->sorted + i,
+                names->sorted + i + 1,
+                (names->size - i) * sizeof(uintptr_t));
+        return;
+    }
+
+    names->sorted[i] = (uintptr_t) dropped | 1;
+    names->ndropped++;
+
+    if (names->ndropped >= NAMES_REBUILD_MIN &&
+        names->ndropped * NAMES_REBUILD_RATIO >= names->size &&
+        siridb_names_rebuild(names))
+    {
+        /* the dictionary is still valid, the rebuild will be retried */
+        log_error("Cannot rebuild the series name dictionary");
+    }
+}
+
+/*
+ * Merge sorted[lo:hi] with the ordered 'delta' series and call 'cb' for each
+ * series until 'n' reaches zero.
+ */
+static void NAMES_walk(
+        siridb_names_t * names,
+        size_t lo,
+        size_t hi,
+        vec_t * delta,
+        size_t * n,
+        int * rc,
+        ct_val_cb cb,
+        void * args)
+{
+    size_t j = 0;
+    int res;
+    siridb_series_t * series;
+
+    while (*n && (lo < hi || j < delta->len))
+    {
+        if (lo < hi)
+        {
+            if (NAMES_DROPPED(names->sorted[lo]))
+            {
+                lo++;
+                continue;
+            }
+            series = (siridb_series_t *) names->sorted[lo];
+            if (j == delta->len || strcmp(
+                    series->name,
+                    ((siridb_series_t *) delta->data[j])->name) < 0)
+            {
+                lo++;
+            }
+            else
+            {
+                series = (siridb_series_t *) delta->data[j++];
+            }
+        }
+        else
+        {
+            series = (siridb_series_t *) delta->data[j++];
+        }
+
+        res = (*cb)(series, args);
+        *rc += res;
+        *n -= res;
+    }
+}
+
+static int NAMES_append(siridb_series_t * series, vec_t * vec)
+{
+    vec_append(vec, series);
+    return 1;
+}
@@ -0,0 +1,442 @@
+/*
+ * partial.c - Partial aggregation for merged select queries.
+ *
+ * A merged select normally sends all points of all selected series to the
+ * master server which then merges and aggregates the points. For aggregate
+ * functions which can be decomposed (sum, count, min, max, mean and the
+ * variance functions) each pool can calculate a partial state instead. The
+ * master only needs to combine one partial state per pool.
+ *
+ * A partial state is a list with one or more points objects (components)
+ * which are all aggregated using the same group_by and therefore share the
+ * same time-stamps:
+ *
+ *  sum, min, max, count:               [<aggregate>]
+ *  mean:                               [count, mean]
+ *  variance, pvariance, stddev:        [count, mean, pvariance]
+ */
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <siri/db/partial.h>
+#include <siri/grammar/grammar.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PARTIAL_MAX_COMPONENTS 3
+
+typedef struct
+{
+    size_t n;           /* number of combined partial states    */
+    int64_t count;
+    double mean;
+    double m2;          /* sum of squares of differences        */
+    qp_via_t val;
+} partial_state_t;
+
+static size_t PARTIAL_components(uint32_t gid, uint32_t * gids);
+static int PARTIAL_fold(
+        partial_state_t * state,
+        siridb_points_t ** components,
+        size_t pos,
+        uint32_t gid,
+        points_tp tp,
+        char * err_msg);
+static void PARTIAL_set_value(
+        siridb_point_t * point,
+        partial_state_t * state,
+        uint32_t gid);
+
+/*
+ * Returns the number of components for a partial state or 0 in case the
+ * aggregate cannot be calculated using partial states.
+ */
+size_t siridb_partial_size(siridb_aggr_t * aggr)
+{
+    uint32_t gids[PARTIAL_MAX_COMPONENTS];
+
+    /* the group_by size for limit() depends on the number of points */
+    return (aggr->limit) ? 0 : PARTIAL_components(aggr->gid, gids);
+}
+
+/*
+ * Calculate a partial state for the given points and append the components
+ * to partials. Nothing is added when points is empty.
+ *
+ * Returns 0 if successful or -1 in case of an error. (err_msg is set and a
+ * SIGNAL might be raised)
+ */
+int siridb_partial_append(
+        vec_t ** partials,
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    uint32_t gids[PARTIAL_MAX_COMPONENTS];
+    siridb_points_t * component;
+    siridb_aggr_t tmp;
+    size_t i, n = PARTIAL_components(aggr->gid, gids);
+
+    assert (n && !aggr->limit);
+
+    if (!points->len)
+    {
+        return 0;
+    }
+
+    if (points->tp == TP_STRING && aggr->gid != CLERI_GID_F_COUNT)
+    {
+        /* run the real aggregate so the correct error message is set */
+        component = siridb_aggregate_run(points, aggr, err_msg);
+        if (component != NULL && component != points)
+        {
+            siridb_points_free(component);
+        }
+        return -1;
+    }
+
+    tmp = *aggr;
+
+    for (i = 0; i < n; i++)
+    {
+        tmp.gid = gids[i];
+
+        component = siridb_aggregate_run(points, &tmp, err_msg);
+
+        if (component == NULL)
+        {
+            return -1;  /* error message is set */
+        }
+
+        if (vec_append_safe(partials, component))
+        {
+            sprintf(err_msg, "Memory allocation error.");
+            siridb_points_free(component);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Combine all partial states to the final aggregated points. The partials
+ * are not destroyed by this function.
+ *
+ * Returns NULL in case of an error. (err_msg is set and a SIGNAL might be
+ * raised)
+ */
+siridb_points_t * siridb_partial_combine(
+        vec_t * partials,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    uint32_t gids[PARTIAL_MAX_COMPONENTS];
+    size_t k = PARTIAL_components(aggr->gid, gids);
+    size_t npartials = partials->len / k;
+    size_t i, max_sz = 0;
+    size_t * pos;
+    uint64_t ts = 0;
+    int found;
+    points_tp tp;
+    siridb_points_t * first;
+    siridb_points_t * points;
+    siridb_point_t * point;
+    partial_state_t state;
+
+    assert (k && partials->len % k == 0);
+
+    switch (aggr->gid)
+    {
+    case CLERI_GID_F_COUNT:
+        tp = TP_INT;
+        break;
+    case CLERI_GID_F_SUM:
+    case CLERI_GID_F_MIN:
+    case CLERI_GID_F_MAX:
+        tp = TP_INT;
+        for (i = 0; i < partials->len; i += k)
+        {
+            if (((siridb_points_t *) partials->data[i])->tp == TP_DOUBLE)
+            {
+                tp = TP_DOUBLE;
+                break;
+            }
+        }
+        break;
+    default:
+        tp = TP_DOUBLE;
+    }
+
+    for (i = 0; i < partials->len; i += k)
+    {
+        max_sz += ((siridb_points_t *) partials->data[i])->len;
+    }
+
+    if (!aggr->group_by && max_sz > 1)
+    {
+        max_sz = 1;
+    }
+
+    points = siridb_points_new(max_sz, tp);
+    pos = (size_t *) calloc(npartials, sizeof(size_t));
+
+    if (points == NULL || pos == NULL)
+    {
+        sprintf(err_msg, "Memory allocation error.");
+        if (points != NULL)
+        {
+            siridb_points_free(points);
+        }
+        free(pos);
+        return NULL;
+    }
+
+    while (1)
+    {
+        /*
+         * Find the time-stamp for the next point. When using group_by this
+         * is the lowest time-stamp, otherwise each partial state contains
+         * at most one point and the last time-stamp should be used.
+         */
+        found = 0;
+        for (i = 0; i < npartials; i++)
+        {
+            first = partials->data[i * k];
+            if (pos[i] < first->len && (!found || ((aggr->group_by) ?
+                    first->data[pos[i]].ts < ts :
+                    first->data[pos[i]].ts > ts)))
+            {
+                ts = first->data[pos[i]].ts;
+                found = 1;
+            }
+        }
+
+        if (!found)
+        {
+            break;
+        }
+
+        state.n = 0;
+        state.val.int64 = 0;  /* set from the first value when combined */
+        state.count = 0;
+        state.mean = 0.0;
+        state.m2 = 0.0;
+
+        for (i = 0; i < npartials; i++)
+        {
+            first = partials->data[i * k];
+            if (pos[i] < first->len &&
+                (!aggr->group_by || first->data[pos[i]].ts == ts))
+            {
+                if (PARTIAL_fold(
+                        &state,
+                        (siridb_points_t **) partials->data + i * k,
+                        pos[i],
+                        aggr->gid,
+                        tp,
+                        err_msg))
+                {
+                    siridb_points_free(points);
+                    free(pos);
+                    return NULL;  /* error message is set */
+                }
+                pos[i]++;
+            }
+        }
+
+        assert (points->len < max_sz);
+
+        point = points->data + points->len;
+        point->ts = ts;
+        PARTIAL_set_value(point, &state, aggr->gid);
+        points->len++;
+    }
+
+    free(pos);
+
+    return points;
+}
+
+/*
+ * Destroy partial states. (parsing NULL is not allowed)
+ */
+void siridb_partial_free(vec_t * partials)
+{
+    size_t i;
+    for (i = 0; i < partials->len; i++)
+    {
+        siridb_points_free(partials->data[i]);
+    }
+    vec_free(partials);
+}
+
+static size_t PARTIAL_components(uint32_t gid, uint32_t * gids)
+{
+    switch (gid)
+    {
+    case CLERI_GID_F_SUM:
+    case CLERI_GID_F_MIN:
+    case CLERI_GID_F_MAX:
+    case CLERI_GID_F_COUNT:
+        gids[0] = gid;
+        return 1;
+
+    case CLERI_GID_F_MEAN:
+        gids[0] = CLERI_GID_F_COUNT;
+        gids[1] = CLERI_GID_F_MEAN;
+        return 2;
+
+    case CLERI_GID_F_VARIANCE:
+    case CLERI_GID_F_PVARIANCE:
+    case CLERI_GID_F_STDDEV:
+        gids[0] = CLERI_GID_F_COUNT;
+        gids[1] = CLERI_GID_F_MEAN;
+        gids[2] = CLERI_GID_F_PVARIANCE;
+        return 3;
+    }
+
+    return 0;
+}
+
+/*
+ * Combine the partial state at position 'pos' with the given state.
+ * The variance is combined using the parallel algorithm of Chan et al.
+ *
+ * Returns 0 if successful or -1 when an overflow is detected.
+ */
+static int PARTIAL_fold(
+        partial_state_t * state,
+        siridb_points_t ** components,
+        size_t pos,
+        uint32_t gid,
+        points_tp tp,
+        char * err_msg)
+{
+    siridb_point_t * point = components[0]->data + pos;
+    qp_via_t val;
+
+    switch (gid)
+    {
+    case CLERI_GID_F_COUNT:
+        state->count += point->val.int64;
+        break;
+
+    case CLERI_GID_F_SUM:
+    case CLERI_GID_F_MIN:
+    case CLERI_GID_F_MAX:
+        if (tp == TP_DOUBLE && components[0]->tp == TP_INT)
+        {
+            val.real = (double) point->val.int64;
+        }
+        else
+        {
+            val = point->val;
+        }
+
+        if (!state->n)
+        {
+            state->val = val;
+        }
+        else if (tp == TP_INT)
+        {
+            int64_t * cur = &state->val.int64;
+            switch (gid)
+            {
+            case CLERI_GID_F_SUM:
+                if ((val.int64 > 0 && *cur > LLONG_MAX - val.int64) ||
+                    (val.int64 < 0 && *cur < LLONG_MIN - val.int64))
+                {
+                    sprintf(err_msg, "Overflow detected while using sum().");
+                    return -1;
+                }
+                *cur += val.int64;
+                break;
+            case CLERI_GID_F_MIN:
+                if (val.int64 < *cur)
+                {
+                    *cur = val.int64;
+                }
+                break;
+            case CLERI_GID_F_MAX:
+                if (val.int64 > *cur)
+                {
+                    *cur = val.int64;
+                }
+                break;
+            }
+        }
+        else
+        {
+            double * cur = &state->val.real;
+            switch (gid)
+            {
+            case CLERI_GID_F_SUM:
+                *cur += val.real;
+                break;
+            case CLERI_GID_F_MIN:
+                if (val.real < *cur)
+                {
+                    *cur = val.real;
+                }
+                break;
+            case CLERI_GID_F_MAX:
+                if (val.real > *cur)
+                {
+                    *cur = val.real;
+                }
+                break;
+            }
+        }
+        break;
+
+    default:
+        {
+            int64_t nb = point->val.int64;
+            int64_t n = state->count + nb;
+            double mb = components[1]->data[pos].val.real;
+            double delta = mb - state->mean;
+
+            if (gid != CLERI_GID_F_MEAN)
+            {
+                state->m2 +=
+                        components[2]->data[pos].val.real * nb +
+                        delta * delta * state->count * nb / n;
+            }
+            state->mean += delta * nb / n;
+            state->count = n;
+        }
+    }
+
+    state->n++;
+    return 0;
+}
+
+static void PARTIAL_set_value(
+        siridb_point_t * point,
+        partial_state_t * state,
+        uint32_t gid)
+{
+    switch (gid)
+    {
+    case CLERI_GID_F_COUNT:
+        point->val.int64 = state->count;
+        break;
+    case CLERI_GID_F_MEAN:
+        point->val.real = state->mean;
+        break;
+    case CLERI_GID_F_VARIANCE:
+        point->val.real = (state->count > 1) ?
+                state->m2 / (state->count - 1) : 0.0;
+        break;
+    case CLERI_GID_F_PVARIANCE:
+        point->val.real = state->m2 / state->count;
+        break;
+    case CLERI_GID_F_STDDEV:
+        point->val.real = (state->count > 1) ?
+                sqrt(state->m2 / (state->count - 1)) : 0.0;
+        break;
+    default:
+        point->val = state->val;
+    }
+}
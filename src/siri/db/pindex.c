@@ -0,0 +1,514 @@
+/*
+ * pindex.c - Index on series properties used by where expressions.
+ *
+ * For the properties start, end, length and type, series are grouped in
+ * buckets. Time stamps are grouped per day, the length per power of two and
+ * the type by value. A where expression with conditions on these properties
+ * only needs to test the series in the buckets which can match, instead of
+ * all series.
+ *
+ * Since end and length change with almost every insert, fine grained sorted
+ * indexes would be expensive to maintain. With buckets, a series only moves
+ * when a property crosses a bucket boundary which happens rarely.
+ *
+ * The pool property is not indexed since all local series are in the same
+ * pool, a condition on pool is tested once against the local pool.
+ *
+ * The index does not hold references to the series, series must be removed
+ * from the index before they are destroyed.
+ */
+#include <siri/db/pindex.h>
+#include <siri/grammar/grammar.h>
+#include <stdlib.h>
+
+typedef struct
+{
+    uint64_t key;
+    imap_t * set;       /* series id -> series */
+} pindex_bucket_t;
+
+typedef struct
+{
+    int64_t lo;
+    int64_t hi;
+} pindex_range_t;
+
+typedef struct
+{
+    siridb_pindex_t * pindex;
+    pindex_range_t ranges[SIRIDB_PINDEX_PROPS];
+    pindex_range_t pool;
+    uint64_t key_lo;
+    uint64_t key_hi;
+    size_t n;
+    vec_t * vec;
+} pindex_match_t;
+
+static uint64_t PINDEX_key(
+        siridb_pindex_t * pindex,
+        siridb_pindex_prop_t prop,
+        int64_t value);
+static int64_t PINDEX_value(
+        siridb_series_t * series,
+        siridb_pindex_prop_t prop);
+static int PINDEX_add(
+        imap_t * buckets,
+        uint64_t key,
+        siridb_series_t * series);
+static void PINDEX_pop(
+        imap_t * buckets,
+        uint64_t key,
+        siridb_series_t * series);
+static int PINDEX_move(
+        siridb_pindex_t * pindex,
+        siridb_pindex_prop_t prop,
+        siridb_series_t * series,
+        int64_t prev);
+static int PINDEX_free_bucket(pindex_bucket_t * bucket);
+static int PINDEX_condition(cexpr_condition_t * cond, pindex_match_t * match);
+static int PINDEX_count(pindex_bucket_t * bucket, pindex_match_t * match);
+static int PINDEX_collect(pindex_bucket_t * bucket, pindex_match_t * match);
+static int PINDEX_check(siridb_series_t * series, pindex_match_t * match);
+
+/*
+ * Returns NULL in case of an error. Argument 'day' is one day in the time
+ * precision of the database and is used to group time stamps.
+ */
+siridb_pindex_t * siridb_pindex_new(uint64_t day)
+{
+    siridb_pindex_t * pindex =
+            (siridb_pindex_t *) malloc(sizeof(siridb_pindex_t));
+    size_t i;
+
+    if (pindex == NULL)
+    {
+        return NULL;
+    }
+
+    pindex->day = day;
+
+    for (i = 0; i < SIRIDB_PINDEX_PROPS; i++)
+    {
+        pindex->props[i] = imap_new();
+        if (pindex->props[i] == NULL)
+        {
+            while (i--)
+            {
+                imap_free(pindex->props[i], NULL);
+            }
+            free(pindex);
+            return NULL;
+        }
+    }
+
+    return pindex;
+}
+
+/*
+ * Destroy the property index. (parsing NULL is not allowed)
+ */
+void siridb_pindex_free(siridb_pindex_t * pindex)
+{
+    size_t i;
+
+    for (i = 0; i < SIRIDB_PINDEX_PROPS; i++)
+    {
+        imap_free(pindex->props[i], (imap_free_cb) PINDEX_free_bucket);
+    }
+    free(pindex);
+}
+
+/*
+ * Add a series to the index.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error. In case of
+ * an error the series might be partially indexed and should be removed
+ * using siridb_pindex_pop().
+ */
+int siridb_pindex_add(siridb_pindex_t * pindex, siridb_series_t * series)
+{
+    siridb_pindex_prop_t prop;
+
+    for (prop = 0; prop < SIRIDB_PINDEX_PROPS; prop++)
+    {
+        if (PINDEX_add(
+                pindex->props[prop],
+                PINDEX_key(pindex, prop, PINDEX_value(series, prop)),
+                series))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Remove a series from the index.
+ */
+void siridb_pindex_pop(siridb_pindex_t * pindex, siridb_series_t * series)
+{
+    siridb_pindex_prop_t prop;
+
+    for (prop = 0; prop < SIRIDB_PINDEX_PROPS; prop++)
+    {
+        PINDEX_pop(
+                pindex->props[prop],
+                PINDEX_key(pindex, prop, PINDEX_value(series, prop)),
+                series);
+    }
+}
+
+/*
+ * Must be called after series->start, series->end or series->length are
+ * changed. The arguments 'start', 'end' and 'length' are the values of the
+ * series at the time the series was added or updated for the last time.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_pindex_update(
+        siridb_pindex_t * pindex,
+        siridb_series_t * series,
+        uint64_t start,
+        uint64_t end,
+        uint32_t length)
+{
+    return -(
+        PINDEX_move(pindex, SIRIDB_PINDEX_START, series, (int64_t) start) ||
+        PINDEX_move(pindex, SIRIDB_PINDEX_END, series, (int64_t) end) ||
+        PINDEX_move(pindex, SIRIDB_PINDEX_LENGTH, series, length));
+}
+
+/*
+ * Returns a vector with the series which might match the where expression.
+ * Only conditions on start, end, length, type and pool which are joined by
+ * AND are used. The series in the vector still must be tested against the
+ * expression.
+ *
+ * Each series in the vector has a new reference.
+ *
+ * NULL is returned in case of an allocation error or when the expression has
+ * no conditions which can be used, in which case all series must be tested.
+ */
+vec_t * siridb_pindex_match(
+        siridb_pindex_t * pindex,
+        cexpr_t * cexpr,
+        uint16_t pool)
+{
+    pindex_match_t match;
+    siridb_pindex_prop_t prop;
+    size_t n = 0;
+    int best = -1;
+
+    match.pindex = pindex;
+    match.pool.lo = match.ranges[0].lo = INT64_MIN;
+    match.pool.hi = match.ranges[0].hi = INT64_MAX;
+    for (prop = 1; prop < SIRIDB_PINDEX_PROPS; prop++)
+    {
+        match.ranges[prop] = match.ranges[0];
+    }
+
+    cexpr_required(cexpr, (cexpr_cb_cond_t) PINDEX_condition, &match);
+
+    if (match.pool.lo > pool || match.pool.hi < pool)
+    {
+        return vec_new(0);
+    }
+
+    for (prop = 0; prop < SIRIDB_PINDEX_PROPS; prop++)
+    {
+        if (match.ranges[prop].lo > match.ranges[prop].hi)
+        {
+            return vec_new(0);
+        }
+
+        if (    match.ranges[prop].lo == INT64_MIN &&
+                match.ranges[prop].hi == INT64_MAX)
+        {
+            continue;
+        }
+
+        match.key_lo = PINDEX_key(pindex, prop, match.ranges[prop].lo);
+        match.key_hi = PINDEX_key(pindex, prop, match.ranges[prop].hi);
+        match.n = 0;
+
+        imap_walk(pindex->props[prop], (imap_cb) PINDEX_count, &match);
+
+        if (best == -1 || match.n < n)
+        {
+            best = prop;
+            n = match.n;
+        }
+    }
+
+    if (best == -1)
+    {
+        return NULL;
+    }
+
+    match.key_lo = PINDEX_key(pindex, best, match.ranges[best].lo);
+    match.key_hi = PINDEX_key(pindex, best, match.ranges[best].hi);
+    match.vec = vec_new(n);
+
+    if (match.vec != NULL)
+    {
+        imap_walk(pindex->props[best], (imap_cb) PINDEX_collect, &match);
+    }
+
+    return match.vec;
+}
+
+/*
+ * Returns the bucket key for a value. Keys are ordered like the values.
+ * Negative values are in the first bucket since cexpr compares a series
+ * start without any points (UINT64_MAX) as -1.
+ */
+static uint64_t PINDEX_key(
+        siridb_pindex_t * pindex,
+        siridb_pindex_prop_t prop,
+        int64_t value)
+{
+    uint64_t key = 0;
+
+    if (value <= 0)
+    {
+        return 0;
+    }
+
+    switch (prop)
+    {
+    case SIRIDB_PINDEX_START:
+    case SIRIDB_PINDEX_END:
+        return (uint64_t) value / pindex->day;
+    case SIRIDB_PINDEX_LENGTH:
+        for (; value; value >>= 1, key++);
+        return key;
+    default:
+        return (uint64_t) value;
+    }
+}
+
+/*
+ * Returns the property value like it is compared by siridb_series_cexpr_cb.
+ */
+static int64_t PINDEX_value(
+        siridb_series_t * series,
+        siridb_pindex_prop_t prop)
+{
+    switch (prop)
+    {
+    case SIRIDB_PINDEX_START:
+        return (int64_t) series->start;
+    case SIRIDB_PINDEX_END:
+        return (int64_t) series->end;
+    case SIRIDB_PINDEX_LENGTH:
+        return series->length;
+    default:
+        return series->tp;
+    }
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int PINDEX_add(
+        imap_t * buckets,
+        uint64_t key,
+        siridb_series_t * series)
+{
+    pindex_bucket_t * bucket = (pindex_bucket_t *) imap_get(buckets, key);
+
+    if (bucket == NULL)
+    {
+        bucket = (pindex_bucket_t *) malloc(sizeof(pindex_bucket_t));
+        if (bucket == NULL)
+        {
+            return -1;
+        }
+
+        bucket->key = key;
+        bucket->set = imap_new();
+
+        if (bucket->set == NULL || imap_add(buckets, key, bucket))
+        {
+            PINDEX_free_bucket(bucket);
+            return -1;
+        }
+    }
+
+    return (imap_add(bucket->set, series->id, series) == -1) ? -1 : 0;
+}
+
+static void PINDEX_pop(
+        imap_t * buckets,
+        uint64_t key,
+        siridb_series_t * series)
+{
+    pindex_bucket_t * bucket = (pindex_bucket_t *) imap_get(buckets, key);
+
+    if (    bucket != NULL &&
+            imap_pop(bucket->set, series->id) != NULL &&
+            !bucket->set->len)
+    {
+        imap_pop(buckets, key);
+        PINDEX_free_bucket(bucket);
+    }
+}
+
+/*
+ * Move a series to another bucket if the property has crossed a bucket
+ * boundary.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int PINDEX_move(
+        siridb_pindex_t * pindex,
+        siridb_pindex_prop_t prop,
+        siridb_series_t * series,
+        int64_t prev)
+{
+    uint64_t key = PINDEX_key(pindex, prop, PINDEX_value(series, prop));
+    uint64_t prev_key = PINDEX_key(pindex, prop, prev);
+
+    if (key == prev_key)
+    {
+        return 0;
+    }
+
+    PINDEX_pop(pindex->props[prop], prev_key, series);
+
+    return PINDEX_add(pindex->props[prop], key, series);
+}
+
+static int PINDEX_free_bucket(pindex_bucket_t * bucket)
+{
+    if (bucket->set != NULL)
+    {
+        imap_free(bucket->set, NULL);
+    }
+    free(bucket);
+    return 0;
+}
+
+/*
+ * Narrow the range of a property using a condition.
+ */
+static int PINDEX_condition(cexpr_condition_t * cond, pindex_match_t * match)
+{
+    pindex_range_t * range;
+    int64_t value = cond->int64;
+
+    switch (cond->prop)
+    {
+    case CLERI_GID_K_START:
+        range = &match->ranges[SIRIDB_PINDEX_START];
+        break;
+    case CLERI_GID_K_END:
+        range = &match->ranges[SIRIDB_PINDEX_END];
+        break;
+    case CLERI_GID_K_LENGTH:
+        range = &match->ranges[SIRIDB_PINDEX_LENGTH];
+        break;
+    case CLERI_GID_K_TYPE:
+        range = &match->ranges[SIRIDB_PINDEX_TYPE];
+        break;
+    case CLERI_GID_K_POOL:
+        range = &match->pool;
+        break;
+    default:
+        return 0;
+    }
+
+    switch (cond->operator)
+    {
+    case CEXPR_EQ:
+        if (value > range->lo)
+        {
+            range->lo = value;
+        }
+        if (value < range->hi)
+        {
+            range->hi = value;
+        }
+        break;
+    case CEXPR_GT:
+        if (value == INT64_MAX)
+        {
+            range->lo = INT64_MAX;
+            range->hi = INT64_MIN;
+        }
+        else if (value >= range->lo)
+        {
+            range->lo = value + 1;
+        }
+        break;
+    case CEXPR_GE:
+        if (value > range->lo)
+        {
+            range->lo = value;
+        }
+        break;
+    case CEXPR_LT:
+        if (value == INT64_MIN)
+        {
+            range->lo = INT64_MAX;
+            range->hi = INT64_MIN;
+        }
+        else if (value <= range->hi)
+        {
+            range->hi = value - 1;
+        }
+        break;
+    case CEXPR_LE:
+        if (value < range->hi)
+        {
+            range->hi = value;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static int PINDEX_count(pindex_bucket_t * bucket, pindex_match_t * match)
+{
+    if (bucket->key >= match->key_lo && bucket->key <= match->key_hi)
+    {
+        match->n += bucket->set->len;
+    }
+    return 0;
+}
+
+static int PINDEX_collect(pindex_bucket_t * bucket, pindex_match_t * match)
+{
+    if (bucket->key >= match->key_lo && bucket->key <= match->key_hi)
+    {
+        imap_walk(bucket->set, (imap_cb) PINDEX_check, match);
+    }
+    return 0;
+}
+
+/*
+ * Add the series to the vector when all properties are within range.
+ */
+static int PINDEX_check(siridb_series_t * series, pindex_match_t * match)
+{
+    siridb_pindex_prop_t prop;
+    int64_t value;
+
+    for (prop = 0; prop < SIRIDB_PINDEX_PROPS; prop++)
+    {
+        value = PINDEX_value(series, prop);
+        if (value < match->ranges[prop].lo || value > match->ranges[prop].hi)
+        {
+            return 0;
+        }
+    }
+
+    vec_append(match->vec, series);
+    siridb_series_incref(series);
+
+    return 0;
+}
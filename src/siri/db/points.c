@@ -15,6 +15,7 @@
 #define POINTS_MAX_QSORT 250000
 #define RAW_VALUES_THRESHOLD 7
 #define DICT_SZ 0x3fff
+#define POINTS_ZIP_CHUNK_SZ 1024    /* points per chunk in a zipped pack */
 
 static unsigned char * POINTS_zip_raw(
         siridb_points_t * points,
@@ -276,6 +277,167 @@ int siridb_points_raw_pack(siridb_points_t * points, qp_packer_t * packer)
     return rc;
 }
 
+/*
+ * Pack points like siridb_points_raw_pack() does, except that integer and
+ * float points are compressed in chunks using the same encoding as shards.
+ * Use siridb_points_unpack() to read the points.
+ *
+ * Returns 0 if successful or -1 in case of an error.
+ * (a SIGNAL is raised in case of an allocation error)
+ */
+int siridb_points_zip_pack(siridb_points_t * points, qp_packer_t * packer)
+{
+    uint_fast32_t start, end;
+    unsigned char * data;
+    uint16_t cinfo;
+    size_t size;
+    int rc;
+
+    if (points->tp == TP_STRING)
+    {
+        /* string points are always zipped */
+        return siridb_points_raw_pack(points, packer);
+    }
+
+    rc = qp_add_type(packer, QP_ARRAY_OPEN) ||
+            qp_add_int8(packer, points->tp) ||
+            qp_add_int32(packer, points->len);
+
+    for (start = 0; !rc && start < points->len; start = end)
+    {
+        end = start + POINTS_ZIP_CHUNK_SZ;
+        if (end > points->len)
+        {
+            end = points->len;
+        }
+
+        data = (points->tp == TP_INT) ?
+                siridb_points_zip_int(points, start, end, &cinfo, &size) :
+                siridb_points_zip_double(points, start, end, &cinfo, &size);
+
+        if (data == NULL)
+        {
+            ERR_ALLOC
+            return -1;
+        }
+
+        rc = qp_add_int32(packer, cinfo) || qp_add_raw(packer, data, size);
+
+        free(data);
+    }
+
+    return -(rc || qp_add_type(packer, QP_ARRAY_CLOSE));
+}
+
+/*
+ * Returns points read from an unpacker which is positioned just after the
+ * array open of points packed with either siridb_points_raw_pack() or
+ * siridb_points_zip_pack(). The array close is read as well.
+ *
+ * Returns NULL in case of invalid data or when an allocation error has
+ * occurred. (in the last case a SIGNAL is raised)
+ */
+siridb_points_t * siridb_points_unpack(qp_unpacker_t * unpacker)
+{
+    siridb_points_t * points;
+    qp_obj_t qp_tp, qp_len, qp_obj;
+    qp_types_t tp;
+    uint16_t cinfo;
+    size_t n;
+
+    if (    !qp_is_int(qp_next(unpacker, &qp_tp)) ||
+            !qp_is_int(qp_next(unpacker, &qp_len)) ||
+            qp_tp.via.int64 < TP_INT ||
+            qp_tp.via.int64 > TP_STRING ||
+            qp_len.via.int64 < 0)
+    {
+        return NULL;
+    }
+
+    points = siridb_points_new(qp_len.via.int64, qp_tp.via.int64);
+    if (points == NULL)
+    {
+        return NULL;  /* signal is raised */
+    }
+
+    tp = qp_next(unpacker, &qp_obj);
+
+    if (qp_is_raw(tp))
+    {
+        /* packed by siridb_points_raw_pack() */
+        if (points->tp == TP_STRING)
+        {
+            if (qp_len.via.int64 < POINTS_ZIP_THRESHOLD)
+            {
+                siridb_points_unzip_string_raw(
+                        points,
+                        qp_obj.via.raw,
+                        qp_len.via.int64);
+            }
+            else
+            {
+                siridb_points_unzip_string(
+                        points,
+                        qp_obj.via.raw,
+                        qp_len.via.int64,
+                        NULL, NULL, 0);
+            }
+        }
+        else if (qp_obj.len == qp_len.via.int64 * sizeof(siridb_point_t))
+        {
+            points->len = qp_len.via.int64;
+            memcpy(points->data, qp_obj.via.raw, qp_obj.len);
+        }
+        tp = qp_next(unpacker, NULL);
+    }
+    else while (points->tp != TP_STRING && qp_is_int(tp))
+    {
+        /* chunks packed by siridb_points_zip_pack() */
+        cinfo = (uint16_t) qp_obj.via.int64;
+        n = qp_len.via.int64 - points->len;
+        if (n > POINTS_ZIP_CHUNK_SZ)
+        {
+            n = POINTS_ZIP_CHUNK_SZ;
+        }
+
+        if (    !n ||
+                !qp_is_raw(qp_next(unpacker, &qp_obj)) ||
+                qp_obj.len != siridb_points_get_size_zipped(cinfo, n))
+        {
+            break;
+        }
+
+        if (points->tp == TP_INT)
+        {
+            siridb_points_unzip_int(
+                    points,
+                    (unsigned char *) qp_obj.via.raw,
+                    n,
+                    cinfo,
+                    NULL, NULL, 0);
+        }
+        else
+        {
+            siridb_points_unzip_double(
+                    points,
+                    (unsigned char *) qp_obj.via.raw,
+                    n,
+                    cinfo,
+                    NULL, NULL, 0);
+        }
+
+        tp = qp_next(unpacker, &qp_obj);
+    }
+
+    if (tp != QP_ARRAY_CLOSE || points->len != (size_t) qp_len.via.int64)
+    {
+        siridb_points_free(points);
+        return NULL;
+    }
+
+    return points;
+}
+
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  * (err_msg is set when an error has occurred)
@@ -5,11 +5,46 @@
 #include <logger/logger.h>
 #include <siri/db/pool.h>
 #include <siri/db/pools.h>
+#include <siri/err.h>
 #include <siri/grammar/grammar.h>
+#include <siri/siri.h>
 #include <stdlib.h>
 #include <string.h>
 #include <siri/db/server.h>
 
+#define POOL_MIN_LATENCY 0.001f     /* used when no latency is measured yet */
+#define POOL_REINDEX_PENALTY 4.0f   /* re-indexing servers are slower       */
+
+typedef struct
+{
+    uint8_t ref;                /* promises which hold the hedge        */
+    uint8_t pending;            /* promises without response            */
+    uint8_t done;               /* set when the answer is handled       */
+    int flags;
+    uint64_t timeout;
+    siridb_server_t * replica;  /* receives the package after the delay */
+    sirinet_pkg_t * pkg;
+    sirinet_promise_cb cb;
+    void * data;
+    uv_timer_t * timer;         /* has no reference, closed when done   */
+} pool_hedge_t;
+
+static float POOL_score(siridb_server_t * server);
+static int POOL_send_hedged(
+        siridb_server_t * server,
+        siridb_server_t * replica,
+        sirinet_pkg_t * pkg,
+        uint64_t timeout,
+        sirinet_promise_cb cb,
+        void * data,
+        int flags);
+static void POOL_hedge_send(pool_hedge_t * hedge);
+static void POOL_hedge_on_timer(uv_timer_t * handle);
+static void POOL_hedge_on_response(
+        sirinet_promise_t * promise,
+        sirinet_pkg_t * pkg,
+        int status);
+static void POOL_hedge_decref(pool_hedge_t * hedge);
 
 /*
  * Returns 1 (true) if at least one server in the pool is online, 0 (false)
@@ -93,6 +128,8 @@ int siridb_pool_cexpr_cb(
         return cexpr_int_cmp(cond->operator, wpool->servers, cond->int64);
     case CLERI_GID_K_SERIES:
         return cexpr_int_cmp(cond->operator, wpool->series, cond->int64);
+    case CLERI_GID_K_LENGTH:
+        return cexpr_int_cmp(cond->operator, wpool->length, cond->int64);
     }
     /* we must NEVER get here */
     log_critical("Unexpected pool property received: %d", cond->prop);
@@ -136,10 +173,27 @@ void siridb_pool_add_server(siridb_pool_t * pool, siridb_server_t * server)
     }
 }
 
+/*
+ * Returns the expected time for a server to respond on a new package. This is
+ * the measured latency multiplied by the number of packages the server still
+ * has to answer. A server which is re-indexing is penalized.
+ */
+static float POOL_score(siridb_server_t * server)
+{
+    float score = (server->latency > POOL_MIN_LATENCY) ?
+            server->latency : POOL_MIN_LATENCY;
+
+    score *= server->promises->len + 1;
+
+    return (server->flags & SERVER_FLAG_REINDEXING) ?
+            score * POOL_REINDEX_PENALTY : score;
+}
+
 /*
  * Returns 0 if we have send the package to one 'accessible'
  * server in the pool. The package will be send only to one server, even if
- * the pool has more servers 're-indexing'.
+ * the pool has more servers 're-indexing'. When both servers are accessible,
+ * the server with the lowest expected response time is chosen.
  *
  * This function can raise a SIGNAL when allocation errors occur but be aware
  * that 0 can still be returned in this case.
@@ -154,6 +208,10 @@ void siridb_pool_add_server(siridb_pool_t * pool, siridb_server_t * server)
  * In case flag 'FLAG_ONLY_CHECK_ONLINE' is set, we do not check 'accessible'
  * but only 'online' is enough.
  *
+ * In case flag 'FLAG_HEDGE' is set together with 'FLAG_KEEP_PKG' and hedging
+ * is enabled, the package is sent to the other server in the pool as well
+ * when the chosen server is slow to respond.
+ *
  * pkg will be destroyed when and ONLY when 0 is returned. (Except when
  * FLAG_KEEP_PKG is set)
  */
@@ -166,6 +224,8 @@ int siridb_pool_send_pkg(
         int flags)
 {
     siridb_server_t * server = NULL;
+    siridb_server_t * replica = NULL;
+    float score, best = 0.0f;
     uint16_t i;
 
     for (i = 0; i < pool->len; i++)
@@ -174,11 +234,223 @@ int siridb_pool_send_pkg(
                 siridb_server_is_online(pool->server[i]) :
                 siridb_server_is_accessible(pool->server[i]))
         {
-            server = (server == NULL) ?
-                    pool->server[i] : pool->server[rand() % 2];
+            score = POOL_score(pool->server[i]);
+            if (server == NULL || score < best)
+            {
+                replica = server;
+                server = pool->server[i];
+                best = score;
+            }
+            else
+            {
+                replica = pool->server[i];
+                if (score == best && rand() % 2)
+                {
+                    replica = server;
+                    server = pool->server[i];
+                }
+            }
         }
     }
 
-    return (server == NULL) ?
-            -1: siridb_server_send_pkg(server, pkg, timeout, cb, data, flags);
+    if (server == NULL)
+    {
+        return -1;
+    }
+
+    return (replica != NULL &&
+            (flags & FLAG_HEDGE) &&
+            (flags & FLAG_KEEP_PKG) &&
+            siri.cfg->hedge_percentile &&
+            server->latency_pct > 0.0f) ?
+            POOL_send_hedged(
+                    server,
+                    replica,
+                    pkg,
+                    timeout,
+                    cb,
+                    data,
+                    flags) :
+            siridb_server_send_pkg(server, pkg, timeout, cb, data, flags);
+}
+
+/*
+ * Send a package to a server and start a timer using the estimated response
+ * time percentile of this server. When no response is received before the
+ * timer ends, the package is sent to the replica as well. The first answer
+ * is passed to 'cb', the answer which comes later is ignored.
+ *
+ * The package must be kept until 'cb' is called. (FLAG_KEEP_PKG)
+ * The replica receives a copy of the package.
+ *
+ * Returns 0 if successful or -1 when the package could not be sent.
+ */
+static int POOL_send_hedged(
+        siridb_server_t * server,
+        siridb_server_t * replica,
+        sirinet_pkg_t * pkg,
+        uint64_t timeout,
+        sirinet_promise_cb cb,
+        void * data,
+        int flags)
+{
+    pool_hedge_t * hedge = (pool_hedge_t *) malloc(sizeof(pool_hedge_t));
+    uv_timer_t * timer = (uv_timer_t *) malloc(sizeof(uv_timer_t));
+    if (hedge == NULL || timer == NULL)
+    {
+        ERR_ALLOC
+        free(hedge);
+        free(timer);
+        return -1;
+    }
+
+    /*
+     * The hedge is ready before sending since only the promises hold a
+     * reference. The timer does not, so the hedge is released even when
+     * the timer is closed by someone else. (for example at shutdown)
+     */
+    hedge->ref = 1;
+    hedge->pending = 1;
+    hedge->done = 0;
+    hedge->flags = flags;
+    hedge->timeout = timeout;
+    hedge->replica = replica;
+    hedge->pkg = pkg;
+    hedge->cb = cb;
+    hedge->data = data;
+    hedge->timer = timer;
+    timer->data = hedge;
+
+    siridb_server_incref(replica);
+
+    uv_timer_init(siri.loop, timer);
+    uv_timer_start(
+            timer,
+            POOL_hedge_on_timer,
+            (uint64_t) (server->latency_pct * 1000.0f) + 1,
+            0);
+
+    if (siridb_server_send_pkg(
+            server,
+            pkg,
+            timeout,
+            (sirinet_promise_cb) POOL_hedge_on_response,
+            hedge,
+            flags))
+    {
+        uv_timer_stop(timer);
+        uv_close((uv_handle_t *) timer, (uv_close_cb) free);
+        siridb_server_decref(replica);
+        free(hedge);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Close the hedge timer and send the package to the replica when no answer
+ * is handled yet. This function does nothing when the timer is already
+ * closing.
+ */
+static void POOL_hedge_send(pool_hedge_t * hedge)
+{
+    siridb_server_t * replica = hedge->replica;
+    sirinet_pkg_t * pkg;
+
+    if (uv_is_closing((uv_handle_t *) hedge->timer))
+    {
+        return;
+    }
+
+    uv_timer_stop(hedge->timer);
+    uv_close((uv_handle_t *) hedge->timer, (uv_close_cb) free);
+
+    if (hedge->done || !((hedge->flags & FLAG_ONLY_CHECK_ONLINE) ?
+            siridb_server_is_online(replica) :
+            siridb_server_is_accessible(replica)))
+    {
+        return;
+    }
+
+    /*
+     * The replica gets its own copy since the original package might be
+     * destroyed when the first answer is handled while this copy is still
+     * being written.
+     */
+    pkg = sirinet_pkg_dup(hedge->pkg);
+    if (pkg == NULL)
+    {
+        return;  /* a signal is raised */
+    }
+
+    if (siridb_server_send_pkg(
+            replica,
+            pkg,
+            hedge->timeout,
+            (sirinet_promise_cb) POOL_hedge_on_response,
+            hedge,
+            hedge->flags & ~FLAG_KEEP_PKG))
+    {
+        free(pkg);
+        return;
+    }
+
+    log_debug("Hedged package (pid: %" PRIu16 ") to '%s'",
+            pkg->pid,
+            replica->name);
+
+    hedge->ref++;
+    hedge->pending++;
+}
+
+static void POOL_hedge_on_timer(uv_timer_t * handle)
+{
+    POOL_hedge_send((pool_hedge_t *) handle->data);
+}
+
+/*
+ * The first successful answer is passed to the original call-back. An error
+ * is only passed when no other promise can answer anymore.
+ */
+static void POOL_hedge_on_response(
+        sirinet_promise_t * promise,
+        sirinet_pkg_t * pkg,
+        int status)
+{
+    pool_hedge_t * hedge = (pool_hedge_t *) promise->data;
+
+    hedge->pending--;
+
+    if (!hedge->done && status != PROMISE_SUCCESS)
+    {
+        /* do not wait for the timer since this server has failed */
+        POOL_hedge_send(hedge);
+    }
+
+    if (hedge->done || (status != PROMISE_SUCCESS && hedge->pending))
+    {
+        sirinet_promise_decref(promise);
+    }
+    else
+    {
+        hedge->done = 1;
+
+        /* closes the timer, the package will not be sent again */
+        POOL_hedge_send(hedge);
+
+        promise->data = hedge->data;
+        hedge->cb(promise, pkg, status);
+    }
+
+    POOL_hedge_decref(hedge);
+}
+
+static void POOL_hedge_decref(pool_hedge_t * hedge)
+{
+    if (!--hedge->ref)
+    {
+        siridb_server_decref(hedge->replica);
+        free(hedge);
+    }
 }
@@ -0,0 +1,174 @@
+/*
+ * profile.c - Per stage query profiling.
+ *
+ * A profile is created when a query starts with the 'profile' keyword.
+ * Each server involved in processing the query records the time spent in
+ * each stage, together with the number of chunks, bytes and points which
+ * are read from shards. The result is returned like 'timeit' does.
+ */
+#include <siri/db/profile.h>
+#include <siri/db/server.h>
+#include <siri/net/promise.h>
+#include <stdlib.h>
+
+__thread siridb_profile_t * siridb_profile_io = NULL;
+
+static const char * PROFILE_stages[SIRIDB_PROFILE_STAGES] = {
+        "parse",
+        "match",
+        "lock",
+        "read",
+        "decode",
+        "aggregate",
+        "merge",
+        "pack",
+        "network"
+};
+
+/*
+ * Returns a new profile with all counters set to zero, or NULL in case of
+ * an allocation error.
+ */
+siridb_profile_t * siridb_profile_new(void)
+{
+    siridb_profile_t * profile =
+            (siridb_profile_t *) calloc(1, sizeof(siridb_profile_t));
+    if (profile != NULL)
+    {
+        profile->end_ts = UINT64_MAX;
+    }
+    return profile;
+}
+
+/*
+ * Destroy a profile. (profile is allowed to be NULL)
+ */
+void siridb_profile_free(siridb_profile_t * profile)
+{
+    if (profile != NULL)
+    {
+        free(profile->pools);
+        free(profile);
+    }
+}
+
+/*
+ * Returns the name of a stage.
+ */
+const char * siridb_profile_strstage(siridb_profile_stage_t stage)
+{
+    return PROFILE_stages[stage];
+}
+
+/*
+ * Lock the mutex and count the time we had to wait for the lock. While
+ * locked, points read from shards are counted using the profile.
+ * (profile is allowed to be NULL)
+ */
+void siridb_profile_lock(siridb_profile_t * profile, uv_mutex_t * mutex)
+{
+    struct timespec start;
+
+    if (profile == NULL)
+    {
+        uv_mutex_lock(mutex);
+        return;
+    }
+
+    timeit_start(&start);
+    uv_mutex_lock(mutex);
+    profile->stages[SIRIDB_PROFILE_LOCK] += timeit_get(&start);
+
+    siridb_profile_io = profile;
+}
+
+/*
+ * Unlock a mutex which is locked using siridb_profile_lock().
+ */
+void siridb_profile_unlock(uv_mutex_t * mutex)
+{
+    siridb_profile_io = NULL;
+    uv_mutex_unlock(mutex);
+}
+
+/*
+ * Add the stages and counters as key/value pairs to an open map.
+ *
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ */
+int siridb_profile_pack(siridb_profile_t * profile, qp_packer_t * packer)
+{
+    int rc = 0;
+    size_t i;
+
+    for (i = 0; i < SIRIDB_PROFILE_STAGES; i++)
+    {
+        rc = rc ||
+            qp_add_string(packer, PROFILE_stages[i]) ||
+            qp_add_double(packer, profile->stages[i]);
+    }
+
+    return -(rc ||
+            qp_add_raw(packer, (const unsigned char *) "chunks", 6) ||
+            qp_add_int64(packer, (int64_t) profile->chunks) ||
+            qp_add_raw(packer, (const unsigned char *) "bytes", 5) ||
+            qp_add_int64(packer, (int64_t) profile->bytes) ||
+            qp_add_raw(packer, (const unsigned char *) "points", 6) ||
+            qp_add_int64(packer, (int64_t) profile->points) ||
+            qp_add_raw(packer, (const unsigned char *) "series", 6) ||
+            qp_add_int64(packer, (int64_t) profile->series));
+}
+
+/*
+ * Count the time we have waited for other servers and keep the highest
+ * latency for each pool. Must be called when all promises are received.
+ * (profile is allowed to be NULL)
+ */
+void siridb_profile_promises(siridb_profile_t * profile, vec_t * promises)
+{
+    sirinet_promise_t * promise;
+    uint16_t pool;
+    float * tmp;
+    size_t i;
+
+    if (profile == NULL)
+    {
+        return;
+    }
+
+    profile->stages[SIRIDB_PROFILE_NETWORK] += timeit_get(&profile->network);
+
+    for (i = 0; i < promises->len; i++)
+    {
+        promise = (sirinet_promise_t *) promises->data[i];
+        if (promise == NULL)
+        {
+            continue;
+        }
+
+        pool = promise->server->pool;
+
+        if (pool >= profile->npools)
+        {
+            tmp = (float *) realloc(
+                    profile->pools,
+                    sizeof(float) * (pool + 1));
+            if (tmp == NULL)
+            {
+                /* latency for this pool will be missing, this is not
+                 * critical so we do not raise a signal */
+                continue;
+            }
+            for (; profile->npools <= pool; profile->npools++)
+            {
+                tmp[profile->npools] = -1.0f;
+            }
+            profile->pools = tmp;
+        }
+
+        if (promise->latency > profile->pools[pool])
+        {
+            profile->pools[pool] = promise->latency;
+        }
+    }
+}
@@ -11,6 +11,7 @@
 #include <siri/grammar/grammar.h>
 #include <siri/db/fifo.h>
 #include <siri/net/tcp.h>
+#include <siri/net/wqueue.h>
 #include <siri/siri.h>
 #include <siri/version.h>
 #include <stdio.h>
@@ -43,6 +44,14 @@ static void prop_buffer_size(
         siridb_t * siridb,
         qp_packer_t * packer,
         int map);
+static void prop_cache_hit_ratio(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
+static void prop_cache_size(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
 static void prop_dbname(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -103,6 +112,10 @@ static void prop_open_files(
         siridb_t * siridb,
         qp_packer_t * packer,
         int map);
+static void prop_packages_per_write(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
 static void prop_pool(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -183,6 +196,10 @@ void siridb_init_props(void)
             prop_buffer_path;
     siridb_props[CLERI_GID_K_BUFFER_SIZE - KW_OFFSET] =
             prop_buffer_size;
+    siridb_props[CLERI_GID_K_CACHE_HIT_RATIO - KW_OFFSET] =
+            prop_cache_hit_ratio;
+    siridb_props[CLERI_GID_K_CACHE_SIZE - KW_OFFSET] =
+            prop_cache_size;
     siridb_props[CLERI_GID_K_DBNAME - KW_OFFSET] =
             prop_dbname;
     siridb_props[CLERI_GID_K_DBPATH - KW_OFFSET] =
@@ -213,6 +230,8 @@ void siridb_init_props(void)
             prop_log_level;
     siridb_props[CLERI_GID_K_OPEN_FILES - KW_OFFSET] =
             prop_open_files;
+    siridb_props[CLERI_GID_K_PACKAGES_PER_WRITE - KW_OFFSET] =
+            prop_packages_per_write;
     siridb_props[CLERI_GID_K_POOL - KW_OFFSET] =
             prop_pool;
     siridb_props[CLERI_GID_K_RECEIVED_POINTS - KW_OFFSET] =
@@ -281,6 +300,24 @@ static void prop_buffer_size(
     qp_add_int32(packer, (int32_t) siridb->buffer->size);
 }
 
+static void prop_cache_hit_ratio(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("cache_hit_ratio", 15)
+    qp_add_double(packer, siridb_rcache_hit_ratio(siridb->rcache));
+}
+
+static void prop_cache_size(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("cache_size", 10)
+    qp_add_int64(packer, (int64_t) siridb->rcache->size);
+}
+
 static void prop_dbname(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -416,6 +453,15 @@ static void prop_open_files(
     qp_add_int32(packer, (int32_t) siridb_open_files(siridb));
 }
 
+static void prop_packages_per_write(
+        siridb_t * siridb __attribute__((unused)),
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("packages_per_write", 18)
+    qp_add_double(packer, sirinet_wqueue_packages_per_write());
+}
+
 static void prop_pool(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -4,9 +4,11 @@
 #include <assert.h>
 #include <logger/logger.h>
 #include <siri/db/aggregate.h>
+#include <siri/db/partial.h>
 #include <siri/db/query.h>
 #include <siri/db/shard.h>
 #include <siri/db/queries.h>
+#include <siri/db/re.h>
 #include <stddef.h>
 #include <stdlib.h>
 
@@ -15,6 +17,7 @@
 #define QUERIES_NEW(q)              \
 q->flags = 0;                       \
 q->series_map = NULL;               \
+q->series_bits = NULL;              \
 q->series_tmp = NULL;               \
 q->vec = NULL;                    \
 q->vec_index = 0;                 \
@@ -32,11 +35,13 @@ if (q->series_map != NULL)                                      \
             q->series_map,                                      \
             (imap_free_cb) &siridb__series_decref);             \
 }                                                               \
-if (q->series_tmp != NULL)                                      \
+if (q->series_tmp != NULL && q->series_tmp != q->series_bits)  \
 {                                                               \
-    imap_free(                                                  \
-            q->series_tmp,                                      \
-            (imap_free_cb) &siridb__series_decref);             \
+    bmap_free(q->series_tmp);                                   \
+}                                                               \
+if (q->series_bits != NULL)                                     \
+{                                                               \
+    bmap_free(q->series_bits);                                  \
 }                                                               \
 if (q->vec != NULL)                                           \
 {                                                               \
@@ -56,8 +61,7 @@ if (q->pmap != NULL)                                            \
 {                                                               \
     imap_free(q->pmap, NULL);                                   \
 }                                                               \
-pcre2_code_free(q->regex);                                      \
-pcre2_match_data_free(q->match_data);                           \
+siridb_re_free(q->regex, q->match_data);                        \
 free(q);                                                        \
 siridb_query_free(handle);
 
@@ -77,13 +81,16 @@ query_select_t * query_select_new(void)
     q_select->tp = QUERIES_SELECT;
     q_select->start_ts = NULL;
     q_select->end_ts = NULL;
+    q_select->tail = 0;
     q_select->presuf = NULL;
     q_select->merge_as = NULL;
     q_select->n = 0;
     q_select->nselects = 1;  /* we have at least one select function  */
     q_select->points_map = NULL;
     q_select->alist = NULL;
+    q_select->rcache_key = NULL;
     q_select->mlist = NULL;
+    q_select->partial = NULL;
     q_select->result = ct_new();
 
     if (q_select->result == NULL)
@@ -168,6 +175,8 @@ query_list_t * query_list_new(void)
     q_list->tp = QUERIES_LIST;
     q_list->props = NULL;
     q_list->limit = DEFAULT_LIST_LIMIT;
+    q_list->after = NULL;
+    q_list->rows = NULL;
 
     return q_list;
 }
@@ -237,6 +246,13 @@ void query_list_free(uv_handle_t * handle)
         vec_free(q_list->props);
     }
 
+    if (q_list->rows != NULL)
+    {
+        ct_free(q_list->rows, (ct_free_cb) qp_packer_free);
+    }
+
+    free(q_list->after);
+
     QUERIES_FREE(q_list, handle)
 }
 
@@ -264,6 +280,11 @@ void query_select_free(uv_handle_t * handle)
         }
     }
 
+    if (q_select->partial != NULL)
+    {
+        ct_free(q_select->partial, (ct_free_cb) &siridb_partial_free);
+    }
+
     free(q_select->merge_as);
 
     if (q_select->alist != NULL)
@@ -271,6 +292,8 @@ void query_select_free(uv_handle_t * handle)
         siridb_aggregate_list_free(q_select->alist);
     }
 
+    free(q_select->rcache_key);
+
     if (q_select->mlist != NULL)
     {
         siridb_aggregate_list_free(q_select->mlist);
@@ -8,6 +8,7 @@
 #include <logger/logger.h>
 #include <siri/async.h>
 #include <siri/db/nodes.h>
+#include <siri/db/profile.h>
 #include <siri/db/query.h>
 #include <siri/db/replicate.h>
 #include <siri/db/servers.h>
@@ -19,6 +20,8 @@
 #include <siri/net/pkg.h>
 #include <siri/net/clserver.h>
 #include <siri/siri.h>
+#include <siri/slowlog.h>
+#include <timeit/timeit.h>
 #include <xstr/xstr.h>
 #include <string.h>
 #include <sys/time.h>
@@ -108,6 +111,7 @@ void siridb_query_run(
     /* We should initialize the packer based on query type */
     query->packer = NULL;
     query->timeit = NULL;
+    query->profile = NULL;
 
     /* make sure all *other* pointers are set to NULL */
     query->data = NULL;
@@ -136,6 +140,9 @@ void siridb_query_free(uv_handle_t * handle)
     /* decrement active tasks */
     siridb_tasks_dec(siridb->tasks);
 
+    /* must be called before the query and profile are destroyed */
+    siri_slowlog_query(query);
+
     /* free query */
     free(query->q);
 
@@ -150,6 +157,8 @@ void siridb_query_free(uv_handle_t * handle)
         qp_packer_free(query->timeit);
     }
 
+    siridb_profile_free(query->profile);
+
     /* free node list */
     siridb_nodes_free(query->nodes);
 
@@ -191,6 +200,33 @@ void siridb_send_query_result(uv_async_t * handle)
     uv_close((uv_handle_t *) handle, siri_async_close);
 }
 
+/*
+ * Send the current packer as a CPROTO_RES_QUERY_CHUNK package and replace
+ * the packer with a new one containing an open map. This is used for
+ * streaming select results to a client.
+ *
+ * Returns 0 if successful or -1 in case of an error.
+ * (signal is raised in case of an error)
+ */
+int siridb_query_send_chunk(siridb_query_t * query)
+{
+    assert (query->packer != NULL);
+
+    sirinet_pkg_t * pkg = sirinet_packer2pkg(
+            query->packer,
+            query->pid,
+            CPROTO_RES_QUERY_CHUNK);
+
+    query->packer = sirinet_packer_new(QP_SUGGESTED_SIZE);
+
+    if (sirinet_pkg_send(query->client, pkg) || query->packer == NULL)
+    {
+        return -1;
+    }
+
+    return qp_add_type(query->packer, QP_MAP_OPEN);
+}
+
 /*
  * Signal can be raised by this function.
  */
@@ -247,13 +283,15 @@ void siridb_query_forward(
 
     /*
      * For backwards compatibility with SiriDB version < 2.0.24 we send an
-     * extra value SIRIDB_TIME_DEFAULT.
+     * extra value SIRIDB_TIME_DEFAULT. The last value contains flags which
+     * are ignored by older versions.
      */
-    qp_add_type(packer, QP_ARRAY2);
+    qp_add_type(packer, QP_ARRAY3);
 
     /* add the query to the packer */
     QUERY_to_packer(packer, query);
     qp_add_int8(packer, SIRIDB_TIME_DEFAULT);  /* Only for version < 2.0.24 */
+    qp_add_int8(packer, SIRIDB_QUERY_FLAG_PARTIAL | SIRIDB_QUERY_FLAG_ZIP);
 
 
     sirinet_pkg_t * pkg = sirinet_pkg_new(0, packer->len, 0, packer->buffer);
@@ -261,6 +299,9 @@ void siridb_query_forward(
     /* increment reference since handle will be bound to a timer */
     siri_async_incref(handle);
 
+    /* measured until the response is handled, see ON_PROMISES */
+    siridb_profile_network_start(query->profile);
+
     if (pkg != NULL)
     {
         switch (fwd)
@@ -528,6 +569,9 @@ static void QUERY_parse(uv_async_t * handle)
     int rc;
     siridb_query_t * query = (siridb_query_t *) handle->data;
     siridb_t * siridb = query->client->siridb;
+    struct timespec start;
+
+    timeit_start(&start);
 
     siridb_walker_t * walker = siridb_walker_new(
             siridb,
@@ -602,6 +646,26 @@ static void QUERY_parse(uv_async_t * handle)
         return;
     }
 
+    /*
+     * The profile statement is always the first node when used. A sample of
+     * the client queries is profiled for the slow query log.
+     */
+    if (    query->nodes->node->cl_obj->gid == CLERI_GID_PROFILE_STMT ||
+            ((query->flags & SIRIDB_QUERY_FLAG_MASTER) &&
+                    siri_slowlog_sample(&siri)))
+    {
+        query->profile = siridb_profile_new();
+
+        if (query->profile == NULL)
+        {
+            sprintf(query->err_msg, "Memory allocation error.");
+            siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+            return;
+        }
+
+        query->profile->stages[SIRIDB_PROFILE_PARSE] = timeit_get(&start);
+    }
+
     uv_async_t * forward = (uv_async_t *) malloc(sizeof(uv_async_t));
     uv_async_init(siri.loop, forward, (uv_async_cb) query->nodes->cb);
     forward->data = handle->data;
@@ -0,0 +1,586 @@
+/*
+ * rcache.c - Result cache for select queries.
+ *
+ * Dashboards usually repeat the same select queries with a sliding time
+ * window. The result cache stores the aggregated points per series, keyed
+ * by the normalized aggregate functions and the selected time range.
+ *
+ * New points invalidate only the part of a cached result from the time-stamp
+ * of the new point, so most points which are added 'now' do not invalidate
+ * anything. When a result is aggregated using a single group_by function,
+ * the complete groups which are still valid can be re-used for another time
+ * range and only the missing groups at the start and end must be calculated.
+ *
+ * Note: the cache is only used from the main thread.
+ */
+#include <assert.h>
+#include <logger/logger.h>
+#include <siri/db/aggregate.h>
+#include <siri/db/rcache.h>
+#include <siri/err.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* results larger than this part of the cache are not stored */
+#define RCACHE_MAX_ENTRY_PART 16
+
+static siridb_rcache_entry_t * RCACHE_find(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        const char * key);
+static void RCACHE_remove(
+        siridb_rcache_t * rcache,
+        siridb_rcache_entry_t * entry);
+static void RCACHE_lru_unlink(
+        siridb_rcache_t * rcache,
+        siridb_rcache_entry_t * entry);
+static void RCACHE_lru_push(
+        siridb_rcache_t * rcache,
+        siridb_rcache_entry_t * entry);
+static siridb_points_t * RCACHE_slice(
+        siridb_points_t * points,
+        uint64_t start_ts,
+        uint64_t end_ts);
+static size_t RCACHE_size(siridb_points_t * points, const char * key);
+
+/*
+ * Returns NULL in case of an error.
+ */
+siridb_rcache_t * siridb_rcache_new(size_t max_size)
+{
+    siridb_rcache_t * rcache =
+            (siridb_rcache_t *) malloc(sizeof(siridb_rcache_t));
+
+    if (rcache == NULL)
+    {
+        return NULL;
+    }
+
+    rcache->series = imap_new();
+
+    if (rcache->series == NULL)
+    {
+        free(rcache);
+        return NULL;
+    }
+
+    rcache->size = 0;
+    rcache->max_size = max_size;
+    rcache->hits = 0;
+    rcache->partial_hits = 0;
+    rcache->misses = 0;
+    rcache->lru_head = NULL;
+    rcache->lru_tail = NULL;
+
+    return rcache;
+}
+
+/*
+ * Destroy the result cache. (parsing NULL is not allowed)
+ */
+void siridb_rcache_free(siridb_rcache_t * rcache)
+{
+    siridb_rcache_clear(rcache);
+    imap_free(rcache->series, NULL);
+    free(rcache);
+}
+
+/*
+ * Returns a normalized key for the given aggregate functions or NULL in case
+ * of an allocation error. White-space outside strings and regular
+ * expressions is removed so equal queries written in another way still use
+ * the same cache entries.
+ *
+ * (do not forget to free the returned key)
+ */
+char * siridb_rcache_key(const char * str, size_t len)
+{
+    char * key = (char *) malloc(len + 1);
+    char * pt = key;
+    char quote = '\0';
+    size_t i;
+
+    if (key == NULL)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < len; i++, str++)
+    {
+        if (quote)
+        {
+            if (*str == quote)
+            {
+                quote = '\0';
+            }
+        }
+        else if (*str == '\'' || *str == '"' || *str == '`' || *str == '/')
+        {
+            quote = *str;
+        }
+        else if (*str == ' ' || *str == '\t' || *str == '\n' || *str == '\r')
+        {
+            continue;
+        }
+        *pt = *str;
+        pt++;
+    }
+
+    *pt = '\0';
+
+    return key;
+}
+
+/*
+ * Returns the group_by value when cached results for the given aggregate
+ * list can be re-used for another time range, or 0 if this is not possible.
+ *
+ * This is only possible for a single group_by function since each group is
+ * calculated using only the points within that group.
+ */
+uint64_t siridb_rcache_group_by(vec_t * alist)
+{
+    siridb_aggr_t * aggr;
+
+    if (alist->len != 1)
+    {
+        return 0;
+    }
+
+    aggr = (siridb_aggr_t *) alist->data[0];
+
+    return (aggr->limit || aggr->offset) ? 0 : aggr->group_by;
+}
+
+/*
+ * Look for a cached result.
+ *
+ * Returns 1 when (a part of) the result is found, 0 otherwise. When 1 is
+ * returned, hit->points is a copy of the re-usable points which must be
+ * freed. The points for [start_ts, hit->head_end) and
+ * [hit->tail_start, end_ts) must still be calculated.
+ */
+int siridb_rcache_get(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        const char * key,
+        uint64_t group_by,
+        uint64_t start_ts,
+        uint64_t end_ts,
+        siridb_rcache_hit_t * hit)
+{
+    siridb_rcache_entry_t * entry = RCACHE_find(rcache, series_id, key);
+    uint64_t lo, hi;
+
+    if (entry == NULL)
+    {
+        rcache->misses++;
+        return 0;
+    }
+
+    if (    entry->start_ts == start_ts &&
+            entry->end_ts == end_ts &&
+            entry->valid_ts == end_ts)
+    {
+        hit->points = siridb_points_copy(entry->points);
+        if (hit->points == NULL)
+        {
+            return 0;
+        }
+        hit->head_end = start_ts;
+        hit->tail_start = end_ts;
+
+        RCACHE_lru_unlink(rcache, entry);
+        RCACHE_lru_push(rcache, entry);
+        rcache->hits++;
+        return 1;
+    }
+
+    if (!group_by || entry->group_by != group_by)
+    {
+        rcache->misses++;
+        return 0;
+    }
+
+    /*
+     * A group with time-stamp T contains the points (T - group_by, T] so
+     * each group starts at a multiple of group_by + 1. We can re-use the
+     * complete groups which are within both the cached and requested range.
+     */
+    lo = (start_ts > entry->start_ts) ? start_ts : entry->start_ts;
+    hi = (end_ts < entry->valid_ts) ? end_ts : entry->valid_ts;
+
+    lo = (lo) ? (lo + group_by - 2) / group_by * group_by + 1 : 1;
+    hi = (hi) ? (hi - 1) / group_by * group_by + 1 : 0;
+
+    if (lo >= hi)
+    {
+        rcache->misses++;
+        return 0;
+    }
+
+    hit->points = RCACHE_slice(entry->points, lo, hi);
+    if (hit->points == NULL)
+    {
+        return 0;
+    }
+    hit->head_end = lo;
+    hit->tail_start = hi;
+
+    RCACHE_lru_unlink(rcache, entry);
+    RCACHE_lru_push(rcache, entry);
+    rcache->partial_hits++;
+    return 1;
+}
+
+/*
+ * Store a copy of the given points in the cache. Existing results for the
+ * same series and key are replaced. Errors are ignored since this just
+ * means the result is not cached.
+ */
+void siridb_rcache_set(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        const char * key,
+        uint64_t group_by,
+        uint64_t start_ts,
+        uint64_t end_ts,
+        siridb_points_t * points)
+{
+    siridb_rcache_entry_t * entry;
+    size_t size;
+
+    if (points->tp == TP_STRING)
+    {
+        return;  /* we do not cache string results */
+    }
+
+    size = RCACHE_size(points, key);
+
+    entry = RCACHE_find(rcache, series_id, key);
+    if (entry != NULL)
+    {
+        RCACHE_remove(rcache, entry);
+    }
+
+    if (size > rcache->max_size / RCACHE_MAX_ENTRY_PART)
+    {
+        return;
+    }
+
+    while (rcache->size + size > rcache->max_size)
+    {
+        RCACHE_remove(rcache, rcache->lru_tail);
+    }
+
+    entry = (siridb_rcache_entry_t *) malloc(sizeof(siridb_rcache_entry_t));
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    entry->key = strdup(key);
+    entry->points = siridb_points_copy(points);
+
+    if (entry->key == NULL || entry->points == NULL)
+    {
+        free(entry->key);
+        if (entry->points != NULL)
+        {
+            siridb_points_free(entry->points);
+        }
+        free(entry);
+        return;
+    }
+
+    entry->next = (siridb_rcache_entry_t *) imap_get(
+            rcache->series,
+            series_id);
+
+    if (imap_set(rcache->series, series_id, entry) < 0)
+    {
+        free(entry->key);
+        siridb_points_free(entry->points);
+        free(entry);
+        return;
+    }
+
+    entry->series_id = series_id;
+    entry->group_by = group_by;
+    entry->start_ts = start_ts;
+    entry->end_ts = end_ts;
+    entry->valid_ts = end_ts;
+    entry->size = size;
+
+    rcache->size += size;
+    RCACHE_lru_push(rcache, entry);
+}
+
+/*
+ * Must be called when a point is added to a series. Cached results for the
+ * series which include the time-stamp are invalidated from this time-stamp.
+ * (rcache is allowed to be NULL)
+ */
+void siridb_rcache_invalidate(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        uint64_t ts)
+{
+    siridb_rcache_entry_t * entry;
+
+    if (rcache == NULL || !rcache->series->len)
+    {
+        return;
+    }
+
+    for (   entry = (siridb_rcache_entry_t *) imap_get(
+                    rcache->series,
+                    series_id);
+            entry != NULL;
+            entry = entry->next)
+    {
+        if (ts >= entry->start_ts && ts < entry->valid_ts)
+        {
+            entry->valid_ts = ts;
+        }
+    }
+}
+
+/*
+ * Remove all cached results. This is required when points are removed,
+ * for example when shards are dropped.
+ */
+void siridb_rcache_clear(siridb_rcache_t * rcache)
+{
+    while (rcache->lru_tail != NULL)
+    {
+        RCACHE_remove(rcache, rcache->lru_tail);
+    }
+}
+
+/*
+ * Returns the concatenated points or NULL in case of an error.
+ * Both head and tail are allowed to be NULL. All points are destroyed by
+ * this function.
+ */
+siridb_points_t * siridb_rcache_concat(
+        siridb_points_t * head,
+        siridb_points_t * points,
+        siridb_points_t * tail)
+{
+    siridb_points_t * result;
+    points_tp tp = points->tp;
+    size_t n = points->len;
+
+    if (head == NULL && tail == NULL)
+    {
+        return points;
+    }
+
+    /* empty points might have the type of the not aggregated points */
+    if (head != NULL && head->len)
+    {
+        tp = head->tp;
+    }
+    else if (!points->len && tail != NULL && tail->len)
+    {
+        tp = tail->tp;
+    }
+
+    n += (head == NULL) ? 0 : head->len;
+    n += (tail == NULL) ? 0 : tail->len;
+
+    result = siridb_points_new(n, tp);
+
+    if (result != NULL)
+    {
+        if (head != NULL)
+        {
+            memcpy(result->data,
+                    head->data,
+                    sizeof(siridb_point_t) * head->len);
+            result->len = head->len;
+        }
+
+        memcpy(result->data + result->len,
+                points->data,
+                sizeof(siridb_point_t) * points->len);
+        result->len += points->len;
+
+        if (tail != NULL)
+        {
+            memcpy(result->data + result->len,
+                    tail->data,
+                    sizeof(siridb_point_t) * tail->len);
+            result->len += tail->len;
+        }
+    }
+
+    if (head != NULL)
+    {
+        siridb_points_free(head);
+    }
+
+    if (tail != NULL)
+    {
+        siridb_points_free(tail);
+    }
+
+    siridb_points_free(points);
+
+    return result;
+}
+
+/*
+ * Returns the ratio of (partial) cache hits.
+ */
+double siridb_rcache_hit_ratio(siridb_rcache_t * rcache)
+{
+    uint64_t hits = rcache->hits + rcache->partial_hits;
+    uint64_t total = hits + rcache->misses;
+    return (total) ? (double) hits / (double) total : 0.0;
+}
+
+static siridb_rcache_entry_t * RCACHE_find(
+        siridb_rcache_t * rcache,
+        uint32_t series_id,
+        const char * key)
+{
+    siridb_rcache_entry_t * entry;
+
+    for (   entry = (siridb_rcache_entry_t *) imap_get(
+                    rcache->series,
+                    series_id);
+            entry != NULL;
+            entry = entry->next)
+    {
+        if (strcmp(entry->key, key) == 0)
+        {
+            break;
+        }
+    }
+
+    return entry;
+}
+
+/*
+ * Remove an entry from the cache and destroy the entry.
+ */
+static void RCACHE_remove(
+        siridb_rcache_t * rcache,
+        siridb_rcache_entry_t * entry)
+{
+    siridb_rcache_entry_t * first = (siridb_rcache_entry_t *) imap_get(
+            rcache->series,
+            entry->series_id);
+
+    if (first == entry)
+    {
+        if (entry->next == NULL)
+        {
+            imap_pop(rcache->series, entry->series_id);
+        }
+        else
+        {
+            /* overwrite never fails */
+            imap_set(rcache->series, entry->series_id, entry->next);
+        }
+    }
+    else
+    {
+        for (; first->next != entry; first = first->next)
+        {
+            assert (first->next != NULL);
+        }
+        first->next = entry->next;
+    }
+
+    RCACHE_lru_unlink(rcache, entry);
+    rcache->size -= entry->size;
+
+    siridb_points_free(entry->points);
+    free(entry->key);
+    free(entry);
+}
+
+static void RCACHE_lru_unlink(
+        siridb_rcache_t * rcache,
+        siridb_rcache_entry_t * entry)
+{
+    if (entry->lru_prev == NULL)
+    {
+        rcache->lru_head = entry->lru_next;
+    }
+    else
+    {
+        entry->lru_prev->lru_next = entry->lru_next;
+    }
+
+    if (entry->lru_next == NULL)
+    {
+        rcache->lru_tail = entry->lru_prev;
+    }
+    else
+    {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    }
+}
+
+static void RCACHE_lru_push(
+        siridb_rcache_t * rcache,
+        siridb_rcache_entry_t * entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = rcache->lru_head;
+
+    if (rcache->lru_head == NULL)
+    {
+        rcache->lru_tail = entry;
+    }
+    else
+    {
+        rcache->lru_head->lru_prev = entry;
+    }
+
+    rcache->lru_head = entry;
+}
+
+/*
+ * Returns a copy of the points with start_ts <= ts < end_ts or NULL in case
+ * of an allocation error.
+ */
+static siridb_points_t * RCACHE_slice(
+        siridb_points_t * points,
+        uint64_t start_ts,
+        uint64_t end_ts)
+{
+    siridb_points_t * slice;
+    size_t start, end;
+
+    for (start = 0;
+         start < points->len && points->data[start].ts < start_ts;
+         start++);
+
+    for (end = start;
+         end < points->len && points->data[end].ts < end_ts;
+         end++);
+
+    slice = siridb_points_new(end - start, points->tp);
+    if (slice != NULL)
+    {
+        memcpy(slice->data,
+                points->data + start,
+                sizeof(siridb_point_t) * (end - start));
+        slice->len = end - start;
+    }
+
+    return slice;
+}
+
+static size_t RCACHE_size(siridb_points_t * points, const char * key)
+{
+    return  sizeof(siridb_rcache_entry_t) +
+            sizeof(siridb_points_t) +
+            sizeof(siridb_point_t) * points->len +
+            strlen(key) + 1;
+}
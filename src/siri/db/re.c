@@ -1,17 +1,65 @@
 /*
  * re.c - Helpers for regular expressions.
+ *
+ * Compiled expressions are JIT compiled and kept in a small cache so the
+ * same expressions, for example used by dashboards, are not compiled again
+ * on each query. A cached expression is shared by all users and therefore
+ * must be released using siridb_re_free().
  */
 #include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
 #include <siri/db/db.h>
 #include <siri/db/re.h>
+#include <string.h>
+#include <uv.h>
+
+#define RE_SPECIAL_CHARS ".[](){}*+?|^$"
+#define RE_CACHE_SIZE 64
+
+typedef struct
+{
+    pcre2_code * regex;
+    char * pattern;
+    uint32_t options;
+    uint32_t ref;       /* number of users, only unused entries are evicted */
+    uint64_t used;      /* last time used, for least recently used eviction */
+} re_cache_t;
+
+static re_cache_t RE_cache[RE_CACHE_SIZE];
+static uint64_t RE_used = 0;
+static uv_mutex_t RE_mutex;
+static uv_once_t RE_once = UV_ONCE_INIT;
+
+static void RE_init(void);
+static pcre2_code * RE_cache_get(const char * pattern, uint32_t options);
+static void RE_cache_set(
+        const char * pattern,
+        uint32_t options,
+        pcre2_code * regex);
+static int RE_find(const char * pt, const char * end, const char * needle);
+static const char * RE_skip_item(const char * pt, const char * end);
+static const char * RE_skip_escape(const char * pt, const char * end);
+static const char * RE_skip_quantifier(const char * pt, const char * end);
+
+#define RE_END_LITERAL                                          \
+    if (run)                                                    \
+    {                                                           \
+        literals[n + run] = '\0';                               \
+        n += run + 1;                                           \
+        run = 0;                                                \
+    }
 
 /*
- * Compiles both a 'pcre' regular expression and 'pcre_extra' optimization if
- * the expression could be optimized.
+ * Compiles a regular expression, or takes the expression from the cache,
+ * and creates match data for the expression. The match data is never shared
+ * so it can be used by another thread than the one compiling the expression.
  *
  * When successful, 0 is returned. In case of an error, -1 is returned and
  * the 'err_msg' is set to an appropriate error message. Both 'regex' and
- * 'regex_extra' are NULL when an error is returned.
+ * 'match_data' are NULL when an error is returned.
+ *
+ * Use siridb_re_free() to release the expression and match data.
  *
  * (SIRIDB_MAX_SIZE_ERR_MSG is honored for the error message)
  */
@@ -22,7 +70,7 @@ int siridb_re_compile(
         size_t len,
         char * err_msg)
 {
-    int options = 0;
+    uint32_t options = 0;
     int pcre_error_num;
     PCRE2_SIZE pcre_error_offset;
     char pattern[len + 1];
@@ -46,35 +94,49 @@ int siridb_re_compile(
         break;
     }
 
-    *regex = pcre2_compile(
-                (PCRE2_SPTR8) pattern,
-                PCRE2_ZERO_TERMINATED,
-                options,
-                &pcre_error_num,
-                &pcre_error_offset,
-                NULL);
+    uv_once(&RE_once, RE_init);
+    uv_mutex_lock(&RE_mutex);
+
+    *regex = RE_cache_get(pattern, options);
 
     if (*regex == NULL)
     {
-        PCRE2_UCHAR buffer[256];
-        pcre2_get_error_message(pcre_error_num, buffer, sizeof(buffer));
-        snprintf(err_msg,
-                SIRIDB_MAX_SIZE_ERR_MSG,
-                "Cannot compile regular expression '%s': %s",
-                pattern,
-                buffer);
+        *regex = pcre2_compile(
+                    (PCRE2_SPTR8) pattern,
+                    PCRE2_ZERO_TERMINATED,
+                    options,
+                    &pcre_error_num,
+                    &pcre_error_offset,
+                    NULL);
 
-        return -1;
+        if (*regex == NULL)
+        {
+            uv_mutex_unlock(&RE_mutex);
+
+            PCRE2_UCHAR buffer[256];
+            pcre2_get_error_message(pcre_error_num, buffer, sizeof(buffer));
+            snprintf(err_msg,
+                    SIRIDB_MAX_SIZE_ERR_MSG,
+                    "Cannot compile regular expression '%s': %s",
+                    pattern,
+                    buffer);
+
+            return -1;
+        }
+
+        /*
+         * JIT compilation might not be supported on this platform, in that
+         * case pcre2_match() simply uses the interpreter.
+         */
+        (void) pcre2_jit_compile(*regex, PCRE2_JIT_COMPLETE);
+
+        RE_cache_set(pattern, options, *regex);
     }
 
+    uv_mutex_unlock(&RE_mutex);
+
     *match_data = pcre2_match_data_create_from_pattern(*regex, NULL);
 
-    /*
-     * pcre_study() returns NULL for both errors and when it can not
-     * optimize the regex.  The last argument is how one checks for
-     * errors (it is NULL if everything works, and points to an error
-     * string otherwise.
-     */
     if(*match_data == NULL)
     {
         snprintf(err_msg,
@@ -82,8 +144,8 @@ int siridb_re_compile(
                 "Cannot create match data for regular expression '%s'",
                 pattern);
 
-        /* free and set regex back to NULL */
-        pcre2_code_free(*regex);
+        /* release and set regex back to NULL */
+        siridb_re_free(*regex, NULL);
         *regex = NULL;
 
         return -1;
@@ -91,3 +153,466 @@ int siridb_re_compile(
 
     return 0;
 }
+
+/*
+ * Release a regular expression and match data which are created with
+ * siridb_re_compile(). Both regex and match_data are allowed to be NULL.
+ */
+void siridb_re_free(pcre2_code * regex, pcre2_match_data * match_data)
+{
+    size_t i;
+
+    pcre2_match_data_free(match_data);
+
+    if (regex == NULL)
+    {
+        return;
+    }
+
+    uv_once(&RE_once, RE_init);
+    uv_mutex_lock(&RE_mutex);
+
+    for (i = 0; i < RE_CACHE_SIZE; i++)
+    {
+        if (RE_cache[i].regex == regex)
+        {
+            RE_cache[i].ref--;
+            break;
+        }
+    }
+
+    if (i == RE_CACHE_SIZE)
+    {
+        /* this expression was not cached */
+        pcre2_code_free(regex);
+    }
+
+    uv_mutex_unlock(&RE_mutex);
+}
+
+/*
+ * Destroy all cached expressions which are no longer used. Should be called
+ * when all databases are destroyed.
+ */
+void siridb_re_destroy(void)
+{
+    size_t i;
+
+    uv_once(&RE_once, RE_init);
+    uv_mutex_lock(&RE_mutex);
+
+    for (i = 0; i < RE_CACHE_SIZE; i++)
+    {
+        if (RE_cache[i].regex != NULL && RE_cache[i].ref == 0)
+        {
+            pcre2_code_free(RE_cache[i].regex);
+            free(RE_cache[i].pattern);
+            RE_cache[i].regex = NULL;
+            RE_cache[i].pattern = NULL;
+        }
+    }
+
+    uv_mutex_unlock(&RE_mutex);
+}
+
+/*
+ * Extract the literal prefix from a regular expression source, for example
+ * '/prod\.web\.cpu.+/' has prefix 'prod.web.cpu'. Every name matching the
+ * expression must start with this prefix. The prefix is written to 'prefix'
+ * which must have room for at least 'len' characters and the length of the
+ * prefix is returned.
+ *
+ * Zero is returned when no literal prefix can be found, for example with
+ * case insensitive expressions or when alternation ('|') is used.
+ */
+size_t siridb_re_prefix(const char * source, size_t len, char * prefix)
+{
+    const char * pt;
+    const char * end;
+    size_t n = 0;
+    char c;
+
+    /* by the grammar definition, source ends with '/' or '/i' */
+    if (len < 2 || source[len - 1] != '/')
+    {
+        return 0;
+    }
+
+    pt = source + 1;
+    end = source + len - 1;
+
+    if (memchr(pt, '|', end - pt) != NULL)
+    {
+        /* the prefix might be only valid for one of the alternatives */
+        return 0;
+    }
+
+    while (pt < end)
+    {
+        c = *pt;
+
+        if (strchr(RE_SPECIAL_CHARS, c) != NULL)
+        {
+            break;
+        }
+
+        if (c == '\\')
+        {
+            if (pt + 1 == end || isalnum((unsigned char) pt[1]))
+            {
+                /* character types like \d, \w or \Q cannot be used */
+                break;
+            }
+            c = *(++pt);
+        }
+
+        pt++;
+
+        if (pt < end && (*pt == '*' || *pt == '?' || *pt == '{'))
+        {
+            /* this character is optional */
+            break;
+        }
+
+        prefix[n++] = c;
+
+        if (pt < end && *pt == '+')
+        {
+            break;
+        }
+    }
+
+    return n;
+}
+
+/*
+ * Extract the literals which are required by a regular expression source,
+ * for example '/.*error.+timeout/' requires 'error' and 'timeout'. The
+ * literals are written to 'literals' as zero terminated strings. The buffer
+ * must have room for at least 'len' characters.
+ *
+ * Returns the total size written or zero when no literal can be found. Like
+ * with siridb_re_prefix(), case insensitive expressions or expressions with
+ * alternation ('|'), inline options or quoting have no required literals.
+ */
+size_t siridb_re_literals(const char * source, size_t len, char * literals)
+{
+    const char * pt;
+    const char * end;
+    size_t n = 0;
+    size_t run = 0;
+    char c;
+
+    if (len < 2 || source[len - 1] != '/')
+    {
+        return 0;
+    }
+
+    pt = source + 1;
+    end = source + len - 1;
+
+    if (    memchr(pt, '|', end - pt) != NULL ||
+            RE_find(pt, end, "(?") ||
+            RE_find(pt, end, "\\Q") ||
+            RE_find(pt, end, "\\c"))
+    {
+        return 0;
+    }
+
+    while (pt < end)
+    {
+        c = *pt;
+
+        if (c == '\\' && pt + 1 < end && !isalnum((unsigned char) pt[1]))
+        {
+            c = *(++pt);
+        }
+        else if (c == '\\' || strchr(RE_SPECIAL_CHARS, c) != NULL)
+        {
+            /* anything but a literal ends the current literal */
+            RE_END_LITERAL
+            pt = RE_skip_item(pt, end);
+            pt = RE_skip_quantifier(pt, end);
+            continue;
+        }
+
+        pt++;
+
+        if (pt < end && (*pt == '*' || *pt == '?' || *pt == '{'))
+        {
+            /* this character is optional */
+            RE_END_LITERAL
+            pt = RE_skip_quantifier(pt, end);
+            continue;
+        }
+
+        literals[n + run++] = c;
+
+        if (pt < end && *pt == '+')
+        {
+            RE_END_LITERAL
+            pt = RE_skip_quantifier(pt, end);
+        }
+    }
+
+    RE_END_LITERAL
+
+    return n;
+}
+
+static void RE_init(void)
+{
+    uv_mutex_init(&RE_mutex);
+}
+
+/*
+ * Returns a cached expression with a new reference or NULL when the
+ * expression is not found. (RE_mutex must be locked)
+ */
+static pcre2_code * RE_cache_get(const char * pattern, uint32_t options)
+{
+    re_cache_t * entry;
+    size_t i;
+
+    for (i = 0; i < RE_CACHE_SIZE; i++)
+    {
+        entry = RE_cache + i;
+        if (    entry->regex != NULL &&
+                entry->options == options &&
+                strcmp(entry->pattern, pattern) == 0)
+        {
+            entry->ref++;
+            entry->used = ++RE_used;
+            return entry->regex;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Add a new expression to the cache with one reference. The least recently
+ * used entry without references is replaced when the cache is full. When
+ * no entry can be replaced, the expression is simply not cached.
+ * (RE_mutex must be locked)
+ */
+static void RE_cache_set(
+        const char * pattern,
+        uint32_t options,
+        pcre2_code * regex)
+{
+    re_cache_t * entry = NULL;
+    char * tmp;
+    size_t i;
+
+    for (i = 0; i < RE_CACHE_SIZE; i++)
+    {
+        if (RE_cache[i].regex == NULL)
+        {
+            entry = RE_cache + i;
+            break;
+        }
+        if (    RE_cache[i].ref == 0 &&
+                (entry == NULL || RE_cache[i].used < entry->used))
+        {
+            entry = RE_cache + i;
+        }
+    }
+
+    if (entry == NULL || (tmp = strdup(pattern)) == NULL)
+    {
+        return;
+    }
+
+    if (entry->regex != NULL)
+    {
+        pcre2_code_free(entry->regex);
+        free(entry->pattern);
+    }
+
+    entry->regex = regex;
+    entry->pattern = tmp;
+    entry->options = options;
+    entry->ref = 1;
+    entry->used = ++RE_used;
+}
+
+/*
+ * Returns 1 when 'needle' is found between 'pt' and 'end'.
+ */
+static int RE_find(const char * pt, const char * end, const char * needle)
+{
+    size_t n = strlen(needle);
+
+    for (; pt + n <= end; pt++)
+    {
+        if (memcmp(pt, needle, n) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Skip one item which is not a literal, like a group, a character class,
+ * an escape sequence or a single special character.
+ */
+static const char * RE_skip_item(const char * pt, const char * end)
+{
+    size_t depth = 0;
+
+    switch (*pt)
+    {
+    case '\\':
+        return RE_skip_escape(pt, end);
+
+    case '[':
+        pt++;
+        /* a ']' directly after '[' or '[^' is part of the class */
+        if (pt < end && *pt == '^')
+        {
+            pt++;
+        }
+        if (pt < end && *pt == ']')
+        {
+            pt++;
+        }
+        for (; pt < end && *pt != ']'; pt++)
+        {
+            if (*pt == '\\')
+            {
+                pt++;
+            }
+        }
+        return (pt < end) ? pt + 1 : end;
+
+    case '(':
+        for (; pt < end; pt++)
+        {
+            switch (*pt)
+            {
+            case '\\':
+                pt++;
+                break;
+            case '[':
+                pt = RE_skip_item(pt, end) - 1;
+                break;
+            case '(':
+                depth++;
+                break;
+            case ')':
+                if (!--depth)
+                {
+                    return pt + 1;
+                }
+                break;
+            }
+        }
+        return end;
+
+    case '{':
+        for (; pt < end && *pt != '}'; pt++);
+        return (pt < end) ? pt + 1 : end;
+
+    default:
+        return pt + 1;
+    }
+}
+
+/*
+ * Skip an escape sequence including its arguments, for example \x41,
+ * \x{41}, \012, \o{12}, \k<name>, \g{-1} or \p{Lu}. Characters which
+ * belong to an escape must never be taken as a required literal.
+ */
+static const char * RE_skip_escape(const char * pt, const char * end)
+{
+    size_t n;
+    char c;
+
+    if (++pt >= end)
+    {
+        return end;
+    }
+
+    c = *pt++;
+
+    if (isdigit((unsigned char) c))
+    {
+        /* back reference or octal character code */
+        for (; pt < end && isdigit((unsigned char) *pt); pt++);
+        return pt;
+    }
+
+    switch (c)
+    {
+    case 'x':
+        if (pt < end && *pt == '{')
+        {
+            break;
+        }
+        for (n = 0; n < 2 && pt < end && isxdigit((unsigned char) *pt); n++)
+        {
+            pt++;
+        }
+        return pt;
+
+    case 'p':
+    case 'P':
+        if (pt < end && *pt == '{')
+        {
+            break;
+        }
+        /* single letter property like \pL */
+        return (pt < end) ? pt + 1 : end;
+
+    case 'g':
+        if (pt < end && (*pt == '-' || *pt == '+'))
+        {
+            pt++;
+        }
+        for (; pt < end && isdigit((unsigned char) *pt); pt++);
+        break;
+
+    case 'k':
+    case 'o':
+    case 'N':
+        break;
+
+    default:
+        return pt;
+    }
+
+    /* skip a name or value between {}, <> or '' */
+    if (pt < end)
+    {
+        c = (*pt == '{') ? '}' : (*pt == '<') ? '>' : (*pt == '\'') ? '\'' : 0;
+        if (c)
+        {
+            for (pt++; pt < end && *pt != c; pt++);
+            return (pt < end) ? pt + 1 : end;
+        }
+    }
+
+    return pt;
+}
+
+/*
+ * Skip a quantifier, including a lazy or possessive modifier, when found.
+ */
+static const char * RE_skip_quantifier(const char * pt, const char * end)
+{
+    if (pt < end && (*pt == '*' || *pt == '+' || *pt == '?'))
+    {
+        pt++;
+    }
+    else if (pt < end && *pt == '{')
+    {
+        pt = RE_skip_item(pt, end);
+    }
+    else
+    {
+        return pt;
+    }
+
+    return (pt < end && (*pt == '?' || *pt == '+')) ? pt + 1 : pt;
+}
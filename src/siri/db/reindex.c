@@ -36,27 +36,30 @@
 #define REINDEX_RETRY 5000          /* 5 seconds                        */
 #define REINDEX_INITWAIT 20000      /* 20 seconds                       */
 #define REINDEX_TIMEOUT 300000      /* 5 minutes                        */
+#define REINDEX_MAX_SERIES 1024     /* max series in one batch          */
+#define REINDEX_MAX_POINTS 262144   /* stop adding series to a batch    */
 
-#define NEXT_SERIES_ERR -1
-#define NEXT_SERIES_SET 0
-#define NEXT_SERIES_END 1
-
-static const long int SIZE2 = 2 * sizeof(uint32_t);
 static const size_t PCKSZ = sizeof(sirinet_pkg_t) + 5;
 
 static inline int REINDEX_fn(siridb_t * siridb, siridb_reindex_t * reindex);
 static int REINDEX_create_cb(siridb_series_t * series, FILE * fp);
 static int REINDEX_unlink(siridb_reindex_t * reindex);
-static int REINDEX_next_series_id(siridb_reindex_t * reindex);
-static void REINDEX_next(siridb_t * siridb);
+static siridb_reindex_batch_t * REINDEX_batch_new(siridb_t * siridb);
+static void REINDEX_batch_free(siridb_reindex_batch_t * batch);
+static void REINDEX_batch_work(uv_work_t * work);
+static void REINDEX_batch_work_finish(uv_work_t * work, int status);
+static void REINDEX_batch_done(siridb_reindex_batch_t * batch);
+static int REINDEX_commit(siridb_t * siridb);
 static void REINDEX_work(uv_timer_t * timer);
-static void REINDEX_commit_series(siridb_t * siridb);
+static void REINDEX_commit_series(
+        siridb_t * siridb,
+        siridb_series_t * series);
 static void REINDEX_on_insert_response(
         sirinet_promise_t * promise,
         sirinet_pkg_t * pkg,
         int status);
 
-static char reindex_progress[30];
+static char reindex_progress[64];
 
 /*
  * Returns a pointer to reindex. If 'create_new' is zero and an
@@ -76,10 +79,13 @@ siridb_reindex_t * siridb_reindex_open(siridb_t * siridb, int create_new)
     {
         reindex->fn = NULL;
         reindex->fp = NULL;
-        reindex->next_series_id = NULL;
-        reindex->pkg = NULL;
         reindex->timer = NULL;
         reindex->server = NULL;
+        reindex->head = 0;
+        reindex->tail = 0;
+        reindex->nbatches = 0;
+        reindex->moved = 0;
+        reindex->start = 0;
         if (REINDEX_fn(siridb, reindex) < 0)
         {
             ERR_ALLOC
@@ -119,7 +125,9 @@ siridb_reindex_t * siridb_reindex_open(siridb_t * siridb, int create_new)
 
                 if (reindex != NULL)
                 {
-                    reindex->size = ftello(reindex->fp);
+                    /* a resumed re-index file is opened at the start */
+                    reindex->size = fseeko(reindex->fp, 0, SEEK_END) ?
+                            -1 : ftello(reindex->fp);
                     if (reindex->size == -1)
                     {
                         ERR_FILE
@@ -127,51 +135,30 @@ siridb_reindex_t * siridb_reindex_open(siridb_t * siridb, int create_new)
                     }
                     else if (reindex->size)
                     {
-                        reindex->next_series_id =
-                                (uint32_t *) malloc(sizeof(uint32_t));
-
-                        if (reindex->next_series_id == NULL)
+                        reindex->timer =
+                                (uv_timer_t *) malloc(sizeof(uv_timer_t));
+                        if (reindex->timer == NULL)
                         {
                             ERR_ALLOC
                             siridb_reindex_free(&reindex);
                         }
-                        else if (
-                            fseeko(reindex->fp, -sizeof(uint32_t), SEEK_END) ||
-                            fread(  reindex->next_series_id,
-                                    sizeof(uint32_t),
-                                    1,
-                                    reindex->fp) != 1)
-                        {
-                            ERR_FILE
-                            siridb_reindex_free(&reindex);
-                        }
                         else
                         {
-                            reindex->timer =
-                                    (uv_timer_t *) malloc(sizeof(uv_timer_t));
-                            if (reindex->timer == NULL)
-                            {
-                                ERR_ALLOC
-                                siridb_reindex_free(&reindex);
-                            }
-                            else
+                            reindex->server = siridb->pools->pool[
+                                      siridb->pools->len -1].server[0];
+                            siridb->server->flags |= SERVER_FLAG_REINDEXING;
+                            reindex->timer->data = siridb;
+                            siri_optimize_pause();
+
+                            uv_timer_init(siri.loop, reindex->timer);
+                            if (create_new)
                             {
-                                reindex->server = siridb->pools->pool[
-                                          siridb->pools->len -1].server[0];
-                                siridb->server->flags |= SERVER_FLAG_REINDEXING;
-                                reindex->timer->data = siridb;
-                                siri_optimize_pause();
-
-                                uv_timer_init(siri.loop, reindex->timer);
-                                if (create_new)
-                                {
-                                    /*
-                                     * Sending the flags is only needed when
-                                     * the re-index was just created. Otherwise
-                                     * the flags are send when we authenticate.
-                                     */
-                                    siridb_servers_send_flags(siridb->servers);
-                                }
+                                /*
+                                 * Sending the flags is only needed when the
+                                 * re-index was just created. Otherwise the
+                                 * flags are send when we authenticate.
+                                 */
+                                siridb_servers_send_flags(siridb->servers);
                             }
                         }
                     }
@@ -183,7 +170,8 @@ siridb_reindex_t * siridb_reindex_open(siridb_t * siridb, int create_new)
 }
 
 /*
- * Returns a human readable re-index progress status
+ * Returns a human readable re-index progress status including the number of
+ * series per second which are moved to the new pool.
  */
 const char * siridb_reindex_progress(siridb_t * siridb)
 {
@@ -195,13 +183,25 @@ const char * siridb_reindex_progress(siridb_t * siridb)
     }
     else
     {
-        size_t num = siridb->reindex->size / sizeof(uint32_t);
+        siridb_reindex_t * reindex = siridb->reindex;
+        size_t num = reindex->size / sizeof(uint32_t);
         size_t total = siridb->series_map->len;
         double percent = 100 * (double) (total - num) / total;
+        uint64_t now = uv_now(siri.loop);
 
-        sprintf(reindex_progress,
-                "approximately at %0.2f%%",
-                (0 > percent) ? 0 : percent);
+        if (reindex->start && now > reindex->start)
+        {
+            sprintf(reindex_progress,
+                    "approximately at %0.2f%% (%0.1f series/s)",
+                    (0 > percent) ? 0 : percent,
+                    1000.0 * reindex->moved / (now - reindex->start));
+        }
+        else
+        {
+            sprintf(reindex_progress,
+                    "approximately at %0.2f%%",
+                    (0 > percent) ? 0 : percent);
+        }
     }
     return reindex_progress;
 }
@@ -236,9 +236,16 @@ void siridb_reindex_free(siridb_reindex_t ** reindex)
     {
         ERR_FILE
     }
+    /*
+     * Series in batches which are not committed are not in the series map
+     * anymore but remain in the re-index file, so nothing is lost.
+     */
+    for (; (*reindex)->nbatches; (*reindex)->nbatches--)
+    {
+        REINDEX_batch_free((*reindex)->batches[(*reindex)->tail]);
+        (*reindex)->tail = ((*reindex)->tail + 1) % REINDEX_WINDOW;
+    }
     free((*reindex)->fn);
-    free((*reindex)->next_series_id);
-    free((*reindex)->pkg);
     free(*reindex);
     *reindex = NULL;
 }
@@ -273,6 +280,16 @@ void siridb_reindex_status_update(siridb_t * siridb)
 {
     assert (~siridb->server->flags & SERVER_FLAG_REINDEXING);
     assert (siridb->flags & SIRIDB_FLAG_REINDEXING);
+
+    /*
+     * Inserts decoded in a work thread might use the previous lookup. This
+     * function is called again when the last decode has finished.
+     */
+    if (siridb->insert_decodes)
+    {
+        return;
+    }
+
     if (siridb_servers_available(siridb))
     {
         siridb->flags &= ~SIRIDB_FLAG_REINDEXING;
@@ -316,197 +333,406 @@ void siridb_reindex_start(uv_timer_t * timer)
 }
 
 /*
- * Type: uv_timer_cb
+ * Returns a new batch with the next series ids from the end of the re-index
+ * file. Series which should be moved are dropped from the series map so new
+ * points for these series are forwarded to the new pool. The batch is added
+ * to the re-index window.
  *
- * This function sends a packed series to the new (pool) server.
+ * Returns NULL and raises a SIGNAL in case of an error.
  */
-static void REINDEX_send(uv_timer_t * timer)
+static siridb_reindex_batch_t * REINDEX_batch_new(siridb_t * siridb)
 {
-    siridb_t * siridb = (siridb_t *) timer->data;
-    assert (siridb->reindex->pkg != NULL);
-    /* actually 'available' is sufficient since the destination server has
-     * never status 're-indexing' unless one day we support down-scaling.
-     */
-    if (siridb_server_is_accessible(siridb->reindex->server))
+    siridb_reindex_t * reindex = siridb->reindex;
+    siridb_reindex_batch_t * batch;
+    siridb_series_t * series;
+    uint32_t ids[REINDEX_MAX_SERIES];
+    long int end = reindex->size - reindex->head;
+    size_t n = end / sizeof(uint32_t);
+    size_t npoints = 0;
+
+    if (n > REINDEX_MAX_SERIES)
     {
-        siridb_server_send_pkg(
-                siridb->reindex->server,
-                siridb->reindex->pkg,
-                REINDEX_TIMEOUT,
-                (sirinet_promise_cb) REINDEX_on_insert_response,
-                siridb,
-                FLAG_KEEP_PKG);
+        n = REINDEX_MAX_SERIES;
     }
-    else
+
+    /* the last series id in the file is the next series id */
+    if (fseeko(reindex->fp, end - n * sizeof(uint32_t), SEEK_SET) ||
+        fread(ids, sizeof(uint32_t), n, reindex->fp) != n)
     {
-        log_info("Cannot send re-index package to '%s' "
-                "(try again in %d seconds)",
-                siridb->reindex->server->name,
-                REINDEX_RETRY / 1000);
-        uv_timer_start(
-                siridb->reindex->timer,
-                REINDEX_send,
-                REINDEX_RETRY,
-                0);
+        ERR_FILE
+        log_critical("Reading series ids has failed: '%s'", reindex->fn);
+        return NULL;
+    }
+
+    batch = (siridb_reindex_batch_t *) malloc(sizeof(siridb_reindex_batch_t));
+    if (batch == NULL)
+    {
+        ERR_ALLOC
+        return NULL;
+    }
+
+    batch->series = (siridb_series_t **) malloc(
+            n * sizeof(siridb_series_t *));
+    if (batch->series == NULL)
+    {
+        ERR_ALLOC
+        free(batch);
+        return NULL;
+    }
+
+    batch->siridb = siridb;
+    batch->status = REINDEX_BATCH_READING;
+    batch->nseries = 0;
+    batch->pkg = NULL;
+    batch->work.data = batch;
+
+    uv_mutex_lock(&siridb->series_mutex);
+
+    for (   batch->nids = 0;
+            batch->nids < n && npoints < REINDEX_MAX_POINTS;
+            batch->nids++)
+    {
+        series = imap_get(siridb->series_map, ids[n - 1 - batch->nids]);
+
+        if (    series == NULL ||
+                siridb_lookup_sn(
+                        siridb->pools->lookup,
+                        series->name) == siridb->server->pool ||
+                (siridb->replica != NULL &&
+                 siridb_series_server_id(series) != siridb->server->id))
+        {
+            continue;
+        }
+
+        assert (siridb_lookup_sn(
+                    siridb->pools->prev_lookup,
+                    series->name) == siridb->server->pool);
+
+        /*
+         * Prepare drop, increasing the reference counter is not needed
+         * since the series can only be decremented when dropped. since
+         * the series is not member of the siridb->series_map it will not
+         * be decremented there either.
+         */
+        siridb_series_drop_prepare(siridb, series);
+
+        batch->series[batch->nseries++] = series;
+        npoints += series->length;
     }
+
+    uv_mutex_unlock(&siridb->series_mutex);
+
+    reindex->head += batch->nids * sizeof(uint32_t);
+    reindex->batches[
+        (reindex->tail + reindex->nbatches++) % REINDEX_WINDOW] = batch;
+
+    return batch;
+}
+
+static void REINDEX_batch_free(siridb_reindex_batch_t * batch)
+{
+    free(batch->series);
+    free(batch->pkg);
+    free(batch);
 }
 
 /*
- * Return values:
- *  NEXT_SERIES_SET: Successful set the next series id and removes the previous
- *                   series id
- *  NEXT_SERIES_END: End of the file is reached, re-indexing has finished.
- *  NEXT_SERIES_ERR: An error occurred and a SIGNAL is raised
+ * Work thread: read the points for all series in the batch and pack them
+ * in one insert package for the new pool.
+ *
+ * In case of an error batch->pkg remains NULL and a SIGNAL is raised.
  */
-static int REINDEX_next_series_id(siridb_reindex_t * reindex)
+static void REINDEX_batch_work(uv_work_t * work)
 {
-    /* free re-index package */
-    free(reindex->pkg);
-    reindex->pkg = NULL;
+    siridb_reindex_batch_t * batch = (siridb_reindex_batch_t *) work->data;
+    siridb_t * siridb = batch->siridb;
+    siridb_series_t * series;
+    siridb_points_t * points;
+    qp_packer_t * packer = sirinet_packer_new(QP_SUGGESTED_SIZE);
+    uint32_t i;
+
+    if (packer == NULL)
+    {
+        return;  /* signal is raised */
+    }
 
-    int rc;
-    reindex->size -= sizeof(uint32_t);
+    qp_add_type(packer, QP_MAP_OPEN);
 
-    if (!reindex->size)
+    for (i = 0; i < batch->nseries; i++)
     {
-        rc = NEXT_SERIES_END;
+        series = batch->series[i];
+
+        /*
+         * The optimize task is paused, the lock is required since inserts
+         * might still change the shards.
+         */
+        uv_mutex_lock(&siridb->series_mutex);
+
+        points = siridb_series_get_points(series, NULL, NULL);
+
+        uv_mutex_unlock(&siridb->series_mutex);
+
+        if (points == NULL)
+        {
+            qp_packer_free(packer);
+            return;  /* signal is raised */
+        }
+
+        /* add series name including terminator char */
+        if (qp_add_raw(
+                    packer,
+                    (const unsigned char *) series->name,
+                    series->name_len + 1) ||
+            siridb_points_pack(points, packer))
+        {
+            siridb_points_free(points);
+            qp_packer_free(packer);
+            return;  /* signal is raised */
+        }
+
+        siridb_points_free(points);
     }
-    else
+
+    batch->pkg = sirinet_packer2pkg(packer, 0, BPROTO_INSERT_TESTED_SERVER);
+}
+
+static void REINDEX_batch_work_finish(uv_work_t * work, int status)
+{
+    siridb_reindex_batch_t * batch = (siridb_reindex_batch_t *) work->data;
+    siridb_t * siridb = batch->siridb;
+
+    if (status || batch->pkg == NULL)
     {
-        if (fseeko(reindex->fp, -SIZE2, SEEK_END) ||
-            fread(  reindex->next_series_id,
-                    sizeof(uint32_t),
-                    1,
-                    reindex->fp) != 1)
+        /*
+         * The series in this batch are dropped from the series map but the
+         * drop is not committed so they remain in the re-index file. Stop
+         * re-indexing on this server instead of waiting for this batch
+         * forever, the series are loaded and moved again after a restart.
+         */
+        log_critical(
+                "Reading points for re-indexing has failed, re-indexing is "
+                "stopped on '%s' and continues after a restart",
+                siridb->server->name);
+        if (siridb->reindex->timer != NULL)
         {
-            ERR_FILE
-            log_critical("Reading next series id has failed");
-            return NEXT_SERIES_ERR;
+            siridb_reindex_close(siridb->reindex);
         }
-        rc = NEXT_SERIES_SET;
     }
-
-    if (ftruncate(reindex->fd, reindex->size))
+    else
     {
-        ERR_FILE
-        log_critical("Reading next series id has failed");
-        return NEXT_SERIES_ERR;
+        batch->status = REINDEX_BATCH_READY;
+        if (siridb->reindex->timer != NULL)
+        {
+            uv_timer_start(siridb->reindex->timer, REINDEX_work, 0, 0);
+        }
     }
-    return rc;
+
+    /* can destroy siridb and siridb->reindex including the batch */
+    siridb_decref(siridb);
 }
 
 /*
- * This function can raise a SIGNAL
+ * Commit the dropped series which are moved by the batch and mark the batch
+ * as done. The re-index file is truncated by the next REINDEX_work call.
  */
-static void REINDEX_next(siridb_t * siridb)
+static void REINDEX_batch_done(siridb_reindex_batch_t * batch)
 {
-    switch (REINDEX_next_series_id(siridb->reindex))
+    siridb_t * siridb = batch->siridb;
+    uint32_t i;
+
+    for (i = 0; i < batch->nseries; i++)
+    {
+        REINDEX_commit_series(siridb, batch->series[i]);
+    }
+
+    siridb_series_flush_dropped(siridb);
+
+    free(batch->pkg);
+    batch->pkg = NULL;
+    batch->status = REINDEX_BATCH_DONE;
+
+    if (siridb->reindex->timer != NULL)
     {
-    case NEXT_SERIES_SET:
         uv_timer_start(
                 siridb->reindex->timer,
                 REINDEX_work,
                 REINDEX_SLEEP * siridb->tasks.active,
                 0);
-        break;
+    }
+}
 
-    case NEXT_SERIES_END:
-        /* update and send the flags */
-        siridb->server->flags &= ~SERVER_FLAG_REINDEXING;
-        siridb_servers_send_flags(siridb->servers);
+/*
+ * Free finished batches in order and truncate the re-index file by the
+ * series ids these batches have covered. When the file is empty, re-indexing
+ * has finished on this server.
+ *
+ * Returns 0 while re-indexing is running. A non-zero value is returned when
+ * re-indexing has finished (siridb->reindex might be destroyed) or when
+ * truncating the file has failed (a SIGNAL is raised).
+ */
+static int REINDEX_commit(siridb_t * siridb)
+{
+    siridb_reindex_t * reindex = siridb->reindex;
+    siridb_reindex_batch_t * batch;
+    long int done = 0;
 
-        log_info("Re-indexing has successfully finished on '%s'",
-                siridb->server->name);
+    while (reindex->nbatches)
+    {
+        batch = reindex->batches[reindex->tail];
+        if (batch->status != REINDEX_BATCH_DONE)
+        {
+            break;
+        }
+        done += batch->nids * sizeof(uint32_t);
+        reindex->moved += batch->nseries;
+        REINDEX_batch_free(batch);
+        reindex->tail = (reindex->tail + 1) % REINDEX_WINDOW;
+        reindex->nbatches--;
+    }
 
-        /* we can close the timer */
-        siridb_reindex_close(siridb->reindex);
+    if (!done)
+    {
+        return 0;
+    }
 
-        /* check if everyone is finished and if so destroy re-index */
-        siridb_reindex_status_update(siridb);
+    reindex->size -= done;
+    reindex->head -= done;
 
-        siri_optimize_continue();
-        break;
+    if (ftruncate(reindex->fd, reindex->size))
+    {
+        ERR_FILE
+        log_critical("Truncating re-index file has failed: '%s'", reindex->fn);
+        return -1;
+    }
 
-    case NEXT_SERIES_ERR:
-        break; /* signal is raised */
+    if (reindex->size)
+    {
+        return 0;
     }
+
+    /* update and send the flags */
+    siridb->server->flags &= ~SERVER_FLAG_REINDEXING;
+    siridb_servers_send_flags(siridb->servers);
+
+    log_info("Re-indexing has successfully finished on '%s'",
+            siridb->server->name);
+
+    /* we can close the timer */
+    siridb_reindex_close(reindex);
+
+    /* check if everyone is finished and if so destroy re-index */
+    siridb_reindex_status_update(siridb);
+
+    siri_optimize_continue();
+
+    return 1;
 }
 
+/*
+ * Type: uv_timer_cb
+ *
+ * Sends the batches which are ready to the new pool and reads new batches
+ * while the window is not full. Points are read in a work thread, one batch
+ * at a time so inserts are not blocked for too long.
+ *
+ * This function can raise a SIGNAL.
+ */
 static void REINDEX_work(uv_timer_t * timer)
 {
     siridb_t * siridb = (siridb_t *) timer->data;
     siridb_reindex_t * reindex = siridb->reindex;
+    siridb_reindex_batch_t * batch;
+    int reading = 0;
+    uint8_t i;
 
     assert (SIRI_OPTIMZE_IS_PAUSED);
     assert (reindex != NULL);
-    assert (siridb->reindex->pkg == NULL);
 
-    reindex->series = imap_get(siridb->series_map, *reindex->next_series_id);
-
-    if (    reindex->series == NULL ||
-            siridb_lookup_sn(
-                    siridb->pools->lookup,
-                    reindex->series->name) == siridb->server->pool ||
-            (siridb->replica != NULL &&
-             siridb_series_server_id(reindex->series) != siridb->server->id))
+    if (!reindex->start)
     {
-        REINDEX_next(siridb);
+        reindex->start = uv_now(siri.loop);
     }
-    else
-    {
-        /*
-         * lock is not needed since we are sure the optimize task is
-         * not running
-         */
-        assert (siridb_lookup_sn(
-                    siridb->pools->prev_lookup,
-                    reindex->series->name) == siridb->server->pool);
-        siridb_points_t * points = siridb_series_get_points(
-                reindex->series,
-                NULL,
-                NULL);
 
-        if (points != NULL)  /* signal is raised in case NULL */
+    for (i = 0; i < reindex->nbatches; i++)
+    {
+        batch = reindex->batches[(reindex->tail + i) % REINDEX_WINDOW];
+        switch (batch->status)
         {
-            /*
-             * Prepare drop, increasing the reference counter is not needed
-             * since the series can only be decremented when dropped. since
-             * the series is not member of the siridb->series_map it will not
-             * be decremented there either.
+        case REINDEX_BATCH_READING:
+            reading = 1;
+            break;
+
+        case REINDEX_BATCH_READY:
+            /* actually 'available' is sufficient since the destination
+             * server has never status 're-indexing' unless one day we
+             * support down-scaling.
              */
-
-            siridb_series_drop_prepare(siridb, reindex->series);
-
-            qp_packer_t * packer = sirinet_packer_new(QP_SUGGESTED_SIZE);
-            if (packer != NULL)
+            if (!siridb_server_is_accessible(reindex->server))
             {
-                qp_add_type(packer, QP_MAP1);
+                log_info("Cannot send re-index package to '%s' "
+                        "(try again in %d seconds)",
+                        reindex->server->name,
+                        REINDEX_RETRY / 1000);
+                uv_timer_start(timer, REINDEX_work, REINDEX_RETRY, 0);
+                return;
+            }
+            batch->status = REINDEX_BATCH_SENT;
+            siridb_server_send_pkg(
+                    reindex->server,
+                    batch->pkg,
+                    REINDEX_TIMEOUT,
+                    (sirinet_promise_cb) REINDEX_on_insert_response,
+                    batch,
+                    FLAG_KEEP_PKG);
+            break;
+
+        case REINDEX_BATCH_SENT:
+        case REINDEX_BATCH_DONE:
+            break;
+        }
+    }
 
-                /* add series name including terminator char */
-                qp_add_raw(
-                        packer,
-                        (const unsigned char *) reindex->series->name,
-                        reindex->series->name_len + 1);
+    if (    !reading &&
+            reindex->nbatches < REINDEX_WINDOW &&
+            reindex->head < reindex->size)
+    {
+        batch = REINDEX_batch_new(siridb);
+        if (batch == NULL)
+        {
+            return;  /* signal is raised */
+        }
 
-                if (siridb_points_pack(points, packer) == 0)
-                {
-                    reindex->pkg = sirinet_packer2pkg(
-                            packer,
-                            0,
-                            BPROTO_INSERT_TESTED_SERVER);
-                    uv_timer_start(
-                            reindex->timer,
-                            REINDEX_send,
-                            0,
-                            0);
-                }
-                else
-                {
-                    qp_packer_free(packer);  /* signal raised */
-                }
-            }
-            siridb_points_free(points);
+        if (batch->nseries)
+        {
+            siridb_incref(siridb);
+            uv_queue_work(
+                    siri.loop,
+                    &batch->work,
+                    REINDEX_batch_work,
+                    REINDEX_batch_work_finish);
+            reading = 1;
         }
+        else
+        {
+            /* none of the series in this batch need to be moved */
+            batch->status = REINDEX_BATCH_DONE;
+        }
+    }
+
+    if (REINDEX_commit(siridb))
+    {
+        return;  /* finished or a signal is raised */
+    }
+
+    if (    !reading &&
+            reindex->nbatches < REINDEX_WINDOW &&
+            reindex->head < reindex->size)
+    {
+        uv_timer_start(
+                timer,
+                REINDEX_work,
+                REINDEX_SLEEP * siridb->tasks.active,
+                0);
     }
 }
 
@@ -515,7 +741,9 @@ static void REINDEX_work(uv_timer_t * timer)
  *
  * This function can raise an ALLOC error but file errors are only logged.
  */
-static void REINDEX_commit_series(siridb_t * siridb)
+static void REINDEX_commit_series(
+        siridb_t * siridb,
+        siridb_series_t * series)
 {
     /*
      * Send the dropped series to the replica. The replica server might have
@@ -526,15 +754,12 @@ static void REINDEX_commit_series(siridb_t * siridb)
      */
     if (siridb->replica != NULL)
     {
-        size_t len = siridb->reindex->series->name_len + 1;
+        size_t len = series->name_len + 1;
         qp_packer_t * packer = sirinet_packer_new(PCKSZ + len);
         if (packer != NULL)
         {
             /* no need for testing, fits for sure */
-            qp_add_raw(
-                    packer,
-                    (const unsigned char *) siridb->reindex->series->name,
-                    len);
+            qp_add_raw(packer, (const unsigned char *) series->name, len);
             sirinet_pkg_t * pkg = sirinet_packer2pkg(
                     packer,
                     0,
@@ -545,11 +770,9 @@ static void REINDEX_commit_series(siridb_t * siridb)
     }
 
     /* commit the drop */
-    if (siridb_series_drop_commit(siridb, siridb->reindex->series) == 0)
-    {
-        siridb_series_flush_dropped(siridb);
-    }
+    siridb_series_drop_commit(siridb, series);
 }
+
 /*
  * Call-back function: sirinet_promise_cb
  */
@@ -558,7 +781,8 @@ static void REINDEX_on_insert_response(
         sirinet_pkg_t * pkg,
         int status)
 {
-    siridb_t * siridb = (siridb_t *) promise->data;
+    siridb_reindex_batch_t * batch = (siridb_reindex_batch_t *) promise->data;
+    siridb_t * siridb = batch->siridb;
 
     switch ((sirinet_promise_status_t) status)
     {
@@ -566,11 +790,15 @@ static void REINDEX_on_insert_response(
         /*
          * Write to socket error, data is not send so we should not commit.
          */
-        uv_timer_start(
-                siridb->reindex->timer,
-                REINDEX_send,
-                REINDEX_RETRY,
-                0);
+        batch->status = REINDEX_BATCH_READY;
+        if (siridb->reindex->timer != NULL)
+        {
+            uv_timer_start(
+                    siridb->reindex->timer,
+                    REINDEX_work,
+                    REINDEX_RETRY,
+                    0);
+        }
         break;
     case PROMISE_TIMEOUT_ERROR:
         /*
@@ -589,8 +817,7 @@ static void REINDEX_on_insert_response(
          */
         log_error("Error occurred while sending series to the replica (%d)",
                 status);
-        REINDEX_commit_series(siridb);
-        REINDEX_next(siridb);
+        REINDEX_batch_done(batch);
         break;
     case PROMISE_SUCCESS:
         if (sirinet_protocol_is_error(pkg->tp))
@@ -599,8 +826,7 @@ static void REINDEX_on_insert_response(
                     "Error occurred while processing data on the replica: "
                     "(response type: %u)", pkg->tp);
         }
-        REINDEX_commit_series(siridb);
-        REINDEX_next(siridb);
+        REINDEX_batch_done(batch);
         break;
     default:
         assert (0);
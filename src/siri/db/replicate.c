@@ -14,11 +14,32 @@
 #include <siri/net/protocol.h>
 #include <siri/siri.h>
 #include <stddef.h>
+#include <string.h>
 
 #define REPLICATE_SLEEP 10          /* 10 milliseconds * active tasks   */
 #define REPLICATE_TIMEOUT 300000    /* 5 minutes                        */
+#define REPLICATE_COALESCE_SIZE 65536   /* combine smaller inserts      */
+
+enum
+{
+    REPLICATE_SLOT_PENDING,
+    REPLICATE_SLOT_COMMIT,
+    REPLICATE_SLOT_COMMIT_ERR,
+    REPLICATE_SLOT_RETRY
+};
+
+#define REPLICATE_IS_INSERT(tp)                 \
+    ((tp) == BPROTO_INSERT_SERVER ||            \
+     (tp) == BPROTO_INSERT_TEST_SERVER ||       \
+     (tp) == BPROTO_INSERT_TESTED_SERVER)
 
 static void REPLICATE_work(uv_timer_t * handle);
+static sirinet_pkg_t * REPLICATE_next(siridb_t * siridb, uint16_t * npkgs);
+static int REPLICATE_send(
+        siridb_t * siridb,
+        sirinet_pkg_t * pkg,
+        uint16_t npkgs);
+static void REPLICATE_commit(siridb_replicate_t * replicate, siridb_t * siridb);
 static void REPLICATE_on_repl_response(
         sirinet_promise_t * promise,
         sirinet_pkg_t * pkg,
@@ -46,6 +67,21 @@ int siridb_replicate_init(siridb_t * siridb, siridb_initsync_t * initsync)
     }
 
     siridb->replicate->initsync = initsync;
+    siridb->replicate->window = siri.cfg->replicate_window;
+    siridb->replicate->head = 0;
+    siridb->replicate->inflight = 0;
+    siridb->replicate->barrier = 0;
+    siridb->replicate->rewind = 0;
+
+    siridb->replicate->slots = (siridb_replicate_slot_t *) malloc(
+            siridb->replicate->window * sizeof(siridb_replicate_slot_t));
+    if (siridb->replicate->slots == NULL)
+    {
+        ERR_ALLOC
+        free(siridb->replicate);
+        siridb->replicate = NULL;
+        return -1;
+    }
 
     siridb->replicate->timer = (uv_timer_t *) malloc(sizeof(uv_timer_t));
     if (siridb->replicate->timer == NULL)
@@ -95,6 +131,7 @@ void siridb_replicate_free(siridb_replicate_t ** replicate)
     {
         siridb_initsync_free(&(*replicate)->initsync);
     }
+    free((*replicate)->slots);
     free(*replicate);
 
     *replicate = NULL;
@@ -183,40 +220,44 @@ void siridb_replicate_continue(siridb_replicate_t * replicate)
 
 
 /*
+ * Send packages from the fifo until the window is full. Insert packages are
+ * not ordered so they may be in flight together, other packages are only
+ * sent when nothing else is in flight.
+ *
  * This function can raise a SIGNAL.
  */
 static void REPLICATE_work(uv_timer_t * handle)
 {
     siridb_t * siridb = (siridb_t *) handle->data;
+    siridb_replicate_t * replicate = siridb->replicate;
     sirinet_pkg_t * pkg;
+    uint16_t npkgs;
 
     assert (siridb->fifo != NULL);
-    assert (siridb->replicate != NULL);
+    assert (replicate != NULL);
     assert (siridb->replica != NULL);
-    assert (siridb->replicate->status != REPLICATE_IDLE);
-    assert (siridb->replicate->status != REPLICATE_PAUSED);
-    assert (siridb->replicate->status != REPLICATE_CLOSED);
-    assert (siridb->replicate->initsync == NULL);
+    assert (replicate->status != REPLICATE_IDLE);
+    assert (replicate->status != REPLICATE_PAUSED);
+    assert (replicate->status != REPLICATE_CLOSED);
+    assert (replicate->initsync == NULL);
     assert (siridb_fifo_is_open(siridb->fifo));
 
-    if (    siridb->replicate->status == REPLICATE_RUNNING &&
-            siridb_fifo_has_data(siridb->fifo) &&
+    while ( replicate->status == REPLICATE_RUNNING &&
+            replicate->inflight < replicate->window &&
+            !replicate->barrier &&
+            !replicate->rewind &&
+            siridb_fifo_has_next(siridb->fifo) &&
             (   siridb_server_is_accessible(siridb->replica) ||
                 siridb_server_is_synchronizing(siridb->replica)) &&
-            (pkg = siridb_fifo_pop(siridb->fifo)) != NULL)
+            (pkg = REPLICATE_next(siridb, &npkgs)) != NULL)
     {
-        if (siridb_server_send_pkg(
-                siridb->replica,
-                pkg,
-                REPLICATE_TIMEOUT,
-                (sirinet_promise_cb) REPLICATE_on_repl_response,
-                siridb,
-                0))
+        if (REPLICATE_send(siridb, pkg, npkgs))
         {
-            free(pkg);
+            return;  /* signal is raised */
         }
     }
-    else
+
+    if (!replicate->inflight)
     {
         if (   siridb_server_is_synchronizing(siridb->replica) &&
                         !siridb_fifo_has_data(siridb->fifo))
@@ -233,12 +274,178 @@ static void REPLICATE_work(uv_timer_t * handle)
                 free(pkg);
             }
         }
-        siridb->replicate->status =
-                (siridb->replicate->status == REPLICATE_STOPPING) ?
+        replicate->status =
+                (replicate->status == REPLICATE_STOPPING) ?
                 REPLICATE_PAUSED : REPLICATE_IDLE;
     }
 }
 
+/*
+ * Pop the next package to send. Adjacent small insert packages of the same
+ * type are combined into one package since both contain an open map with
+ * series and points.
+ *
+ * Returns NULL when nothing can be sent right now. (a SIGNAL might be raised)
+ */
+static sirinet_pkg_t * REPLICATE_next(siridb_t * siridb, uint16_t * npkgs)
+{
+    siridb_fifo_t * fifo = siridb->fifo;
+    sirinet_pkg_t * pkg, * next, * tmp;
+
+    if ((pkg = siridb_fifo_pop(fifo)) == NULL)
+    {
+        return NULL;
+    }
+
+    *npkgs = 1;
+
+    if (!REPLICATE_IS_INSERT(pkg->tp))
+    {
+        if (siridb->replicate->inflight)
+        {
+            /* wait for the inserts in flight before sending this package */
+            siridb_fifo_unpop(fifo, pkg);
+            free(pkg);
+            return NULL;
+        }
+        siridb->replicate->barrier = 1;
+        return pkg;
+    }
+
+    while ( pkg->len < REPLICATE_COALESCE_SIZE &&
+            pkg->len && pkg->data[0] == QP_MAP_OPEN &&
+            *npkgs < UINT16_MAX &&
+            siridb_fifo_has_next(fifo) &&
+            (next = siridb_fifo_pop(fifo)) != NULL)
+    {
+        if (    next->tp != pkg->tp ||
+                !next->len ||
+                next->data[0] != QP_MAP_OPEN ||
+                pkg->len + next->len > REPLICATE_COALESCE_SIZE)
+        {
+            siridb_fifo_unpop(fifo, next);
+            free(next);
+            break;
+        }
+
+        tmp = (sirinet_pkg_t *) realloc(
+                pkg,
+                sizeof(sirinet_pkg_t) + pkg->len + next->len - 1);
+        if (tmp == NULL)
+        {
+            ERR_ALLOC
+            siridb_fifo_unpop(fifo, next);
+            free(next);
+            break;
+        }
+        pkg = tmp;
+
+        /* skip the map type of the next package */
+        memcpy(pkg->data + pkg->len, next->data + 1, next->len - 1);
+        pkg->len += next->len - 1;
+        (*npkgs)++;
+
+        free(next);
+    }
+
+    return pkg;
+}
+
+/*
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ */
+static int REPLICATE_send(
+        siridb_t * siridb,
+        sirinet_pkg_t * pkg,
+        uint16_t npkgs)
+{
+    siridb_replicate_t * replicate = siridb->replicate;
+    siridb_replicate_slot_t * slot = &replicate->slots[
+            (replicate->head + replicate->inflight) % replicate->window];
+
+    slot->siridb = siridb;
+    slot->npkgs = npkgs;
+    slot->status = REPLICATE_SLOT_PENDING;
+
+    if (siridb_server_send_pkg(
+            siridb->replica,
+            pkg,
+            REPLICATE_TIMEOUT,
+            (sirinet_promise_cb) REPLICATE_on_repl_response,
+            slot,
+            0))
+    {
+        free(pkg);
+
+        /*
+         * The packages for this slot are already popped. Handle the slot as
+         * failed so the fifo is rewound once the slots before it are done.
+         */
+        slot->status = REPLICATE_SLOT_RETRY;
+        replicate->inflight++;
+        REPLICATE_commit(replicate, siridb);
+        return -1;
+    }
+
+    replicate->inflight++;
+    return 0;
+}
+
+/*
+ * Commit the fifo for finished slots, in the order the packages are popped.
+ *
+ * A slot which could not be written is sent again together with all slots
+ * after it. When a write fails the connection is closed so the slots after
+ * it have failed as well.
+ */
+static void REPLICATE_commit(siridb_replicate_t * replicate, siridb_t * siridb)
+{
+    siridb_replicate_slot_t * slot;
+    uint16_t n;
+
+    while (replicate->inflight)
+    {
+        slot = &replicate->slots[replicate->head];
+
+        if (slot->status == REPLICATE_SLOT_PENDING)
+        {
+            break;
+        }
+
+        if (slot->status == REPLICATE_SLOT_RETRY)
+        {
+            replicate->rewind = 1;
+        }
+        else if (!replicate->rewind)
+        {
+            for (n = 0; n < slot->npkgs; n++)
+            {
+                if (slot->status == REPLICATE_SLOT_COMMIT)
+                {
+                    siridb_fifo_commit(siridb->fifo);
+                }
+                else
+                {
+                    siridb_fifo_commit_err(siridb->fifo);
+                }
+            }
+        }
+
+        replicate->head = (replicate->head + 1) % replicate->window;
+        replicate->inflight--;
+    }
+
+    if (!replicate->inflight)
+    {
+        replicate->barrier = 0;
+        if (replicate->rewind)
+        {
+            siridb_fifo_rewind(siridb->fifo);
+            replicate->rewind = 0;
+        }
+    }
+}
+
 /*
  * Return a pkg without series which are scheduled for initial synchronization.
  *
@@ -269,7 +476,7 @@ sirinet_pkg_t * siridb_replicate_pkg_filter(
     qp_next(&unpacker, &qp_series_name); /* first series or end     */
     while (qp_is_raw_term(&qp_series_name))
     {
-        series = (siridb_series_t *) ct_get(
+        series = siridb_names_get(
                 siridb->series,
                 (const char *) qp_series_name.via.raw);
         if (series == NULL || (~series->flags & SIRIDB_SERIES_INIT_REPL))
@@ -307,7 +514,8 @@ static void REPLICATE_on_repl_response(
         sirinet_pkg_t * pkg,
         int status)
 {
-    siridb_t * siridb = (siridb_t *) promise->data;
+    siridb_replicate_slot_t * slot = (siridb_replicate_slot_t *) promise->data;
+    siridb_t * siridb = slot->siridb;
 
     /* open promises must be closed before siridb->replicate is destroyed */
     assert (siridb->replicate != NULL);
@@ -319,6 +527,7 @@ static void REPLICATE_on_repl_response(
         /*
          * Write to socket error, data is not send so we should not commit.
          */
+        slot->status = REPLICATE_SLOT_RETRY;
         break;
     case PROMISE_TIMEOUT_ERROR:
         /*
@@ -335,7 +544,7 @@ static void REPLICATE_on_repl_response(
          * Commit with error since this package has result in an unknown
          * package type.
          */
-        siridb_fifo_commit_err(siridb->fifo);
+        slot->status = REPLICATE_SLOT_COMMIT_ERR;
         break;
     case PROMISE_SUCCESS:
         if (sirinet_protocol_is_error(pkg->tp))
@@ -343,16 +552,19 @@ static void REPLICATE_on_repl_response(
             log_error(
                     "Error occurred while processing data on the replica: "
                     "(response type: %u)", pkg->tp);
-            siridb_fifo_commit_err(siridb->fifo);
+            slot->status = REPLICATE_SLOT_COMMIT_ERR;
         }
         else
         {
-            siridb_fifo_commit(siridb->fifo);
+            slot->status = REPLICATE_SLOT_COMMIT;
         }
         break;
     }
 
-    if (siridb->replicate->status != REPLICATE_CLOSED)
+    REPLICATE_commit(siridb->replicate, siridb);
+
+    if (    siridb->replicate->status != REPLICATE_CLOSED &&
+            !uv_is_active((uv_handle_t *) siridb->replicate->timer))
     {
         uv_timer_start(
                 siridb->replicate->timer,
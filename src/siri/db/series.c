@@ -38,6 +38,14 @@
 #define BEND series->buffer->points->data[series->buffer->points->len - 1].ts
 #define DROPPED_DUMMY 1
 
+/* the index is never allocated for less than this number of items */
+#define SERIES_IDX_MIN_SZ 4
+
+/* true when a chunk can contain points within the (optional) range */
+#define SERIES_IDX_IN_RANGE(idx, start_ts, end_ts) \
+        (((start_ts) == NULL || (idx)->end_ts >= *(start_ts)) && \
+        ((end_ts) == NULL || (idx)->start_ts < *(end_ts)))
+
 /*
  * Used for storing double and integers as string. this is not very important
  * if it will not store all characters generated so 64 is more than enough
@@ -53,12 +61,24 @@ static int SERIES_open_dropped_file(siridb_t * siridb);
 static int SERIES_update_max_id(siridb_t * siridb);
 static void SERIES_update_start(siridb_series_t *__restrict series);
 static void SERIES_update_end(siridb_series_t *__restrict series);
+static void SERIES_update_pindex(
+        siridb_t *__restrict siridb,
+        siridb_series_t *__restrict series,
+        uint64_t start,
+        uint64_t end,
+        uint32_t length);
 static void SERIES_update_overlap(siridb_series_t *__restrict series);
+static void SERIES_points_tail(
+        siridb_points_t *__restrict points,
+        size_t limit);
+static int SERIES_bmap_imap(uint32_t id, void ** args);
+static int SERIES_bmap_vec(uint32_t id, void ** args);
 static inline int SERIES_pack(siridb_series_t * series, qp_fpacker_t * fpacker);
 static void SERIES_idx_sort(
         idx_t * idx,
         uint_fast32_t start,
         uint_fast32_t end);
+static int SERIES_idx_resize(siridb_series_t * series, uint32_t n);
 
 static siridb_series_t * SERIES_new(
         siridb_t * siridb,
@@ -104,6 +124,45 @@ int siridb_series_cexpr_cb(siridb_series_t * series, cexpr_condition_t * cond)
     return -1;
 }
 
+/*
+ * Returns a new imap with the series for each id in 'bmap'. Ids of series
+ * which do not exist (anymore) are ignored. Each series in the imap has a
+ * new reference.
+ *
+ * Returns NULL in case of an allocation error.
+ */
+imap_t * siridb_series_bmap_imap(siridb_t * siridb, bmap_t * bmap)
+{
+    void * args[2] = {siridb->series_map, imap_new()};
+
+    if (args[1] != NULL && bmap_walk(bmap, (bmap_cb) SERIES_bmap_imap, args))
+    {
+        imap_free((imap_t *) args[1], (imap_free_cb) &siridb__series_decref);
+        return NULL;
+    }
+
+    return (imap_t *) args[1];
+}
+
+/*
+ * Returns a new vector with the series for each id in 'bmap'. Ids of series
+ * which do not exist (anymore) are ignored. Each series in the vector has a
+ * new reference.
+ *
+ * Returns NULL in case of an allocation error.
+ */
+vec_t * siridb_series_bmap_vec(siridb_t * siridb, bmap_t * bmap)
+{
+    void * args[2] = {siridb->series_map, vec_new(bmap->len)};
+
+    if (args[1] != NULL)
+    {
+        bmap_walk(bmap, (bmap_cb) SERIES_bmap_vec, args);
+    }
+
+    return (vec_t *) args[1];
+}
+
 /*
  * Returns 0 if successful; -1 and a SIGNAL is raised in case an error occurred.
  *
@@ -126,6 +185,9 @@ int siridb_series_add_point(
     int rc = 0;
 
     series->length++;
+    siridb->series_length++;
+
+    siridb_rcache_invalidate(siridb->rcache, series->id, *ts);
 
     /* add point in memory
      * (memory can hold 1 more point than we can hold on disk)
@@ -180,9 +242,19 @@ int siridb_series_add_pcache(
         siridb_series_t *__restrict series,
         siridb_pcache_t *__restrict pcache)
 {
+    if (pcache->len)
+    {
+        /* points in a cache are sorted so the first has the lowest ts */
+        siridb_rcache_invalidate(
+                siridb->rcache,
+                series->id,
+                pcache->data[0].ts);
+    }
+
     if (pcache->len > siridb->buffer->len || series->buffer == NULL)
     {
         series->length += pcache->len;
+        siridb->series_length += pcache->len;
 
         return siridb_shards_add_points(
                 siridb,
@@ -193,6 +265,7 @@ int siridb_series_add_pcache(
     if (pcache->len + series->buffer->len > siridb->buffer->len)
     {
         series->length += pcache->len;
+        siridb->series_length += pcache->len;
 
         siridb_points_t *__restrict points = series->buffer;
         size_t i = points->len;
@@ -304,7 +377,7 @@ siridb_series_t * siridb_series_new(
         return NULL;
     }
 
-    if (ct_add(siridb->series, series->name, series))
+    if (siridb_names_add(siridb->series, series))
     {
         log_critical("Error adding series '%s' to the internal smap.",
                 series_name);
@@ -314,6 +387,36 @@ siridb_series_t * siridb_series_new(
         return NULL;
     }
 
+    if (    siridb->trigrams != NULL &&
+            siridb_trigram_add(siridb->trigrams, series))
+    {
+        log_critical("Error adding series '%s' to the trigram index.",
+                series_name);
+        siridb_trigram_pop(siridb->trigrams, series);
+        siridb_names_pop(siridb->series, series->name);
+        imap_pop(siridb->series_map, series->id);
+        siridb__series_free(series);
+        ERR_ALLOC
+        return NULL;
+    }
+
+    if (    siridb->pindex != NULL &&
+            siridb_pindex_add(siridb->pindex, series))
+    {
+        log_critical("Error adding series '%s' to the property index.",
+                series_name);
+        siridb_pindex_pop(siridb->pindex, series);
+        if (siridb->trigrams != NULL)
+        {
+            siridb_trigram_pop(siridb->trigrams, series);
+        }
+        siridb_names_pop(siridb->series, series->name);
+        imap_pop(siridb->series_map, series->id);
+        siridb__series_free(series);
+        ERR_ALLOC
+        return NULL;
+    }
+
     /* we can ignore the result code since this is not critical and logging
      * is done by the function.
      */
@@ -352,7 +455,6 @@ void siridb__series_free(siridb_series_t *__restrict series)
     }
 
     free(series->idx);
-    free(series->name);
     free(series);
 }
 
@@ -412,19 +514,12 @@ int siridb_series_add_idx(
 {
     idx_t * idx;
     uint32_t i = series->idx_len;
-    series->idx_len++;
 
-    /* never zero */
-    idx = (idx_t *) realloc(
-            series->idx,
-            series->idx_len * sizeof(idx_t));
-    if (idx == NULL)
+    if (SERIES_idx_resize(series, i + 1))
     {
         ERR_ALLOC
-        series->idx_len--;
         return -1;
     }
-    series->idx = idx;
 
     for (; i && start_ts < series->idx[i - 1].start_ts; i--)
     {
@@ -474,7 +569,21 @@ void siridb_series_drop_prepare(siridb_t * siridb, siridb_series_t * series)
     imap_pop(siridb->series_map, series->id);
 
     /* remove series from tree */
-    ct_pop(siridb->series, series->name);
+    siridb_names_pop(siridb->series, series->name);
+
+    /* remove series from the trigram index */
+    if (siridb->trigrams != NULL)
+    {
+        siridb_trigram_pop(siridb->trigrams, series);
+    }
+
+    /* remove series from the property index */
+    if (siridb->pindex != NULL)
+    {
+        siridb_pindex_pop(siridb->pindex, series);
+    }
+
+    siridb->series_length -= series->length;
 
     series->flags |= SIRIDB_SERIES_IS_DROPPED;
 }
@@ -581,6 +690,9 @@ void siridb_series_remove_shard(
     uint_fast32_t i, offset;
     uint64_t duration = (shard->tp == SIRIDB_SHARD_TP_NUMBER) ?
                 siridb->duration_num : siridb->duration_log;
+    uint64_t prev_start = series->start;
+    uint64_t prev_end = series->end;
+    uint32_t prev_length = series->length;
 
     i = offset = 0;
 
@@ -593,6 +705,11 @@ void siridb_series_remove_shard(
             siridb_shard_decref(shard);
             offset++;
             series->length -= idx->len;
+
+            if (~series->flags & SIRIDB_SERIES_IS_DROPPED)
+            {
+                siridb->series_length -= idx->len;
+            }
         }
         else if (offset)
         {
@@ -606,6 +723,13 @@ void siridb_series_remove_shard(
         {
             series->idx_len = 0;
 
+            SERIES_update_pindex(
+                    siridb,
+                    series,
+                    prev_start,
+                    prev_end,
+                    prev_length);
+
             if (siridb_series_drop(siridb, series))
             {
                 siridb_series_flush_dropped(siridb);
@@ -613,19 +737,11 @@ void siridb_series_remove_shard(
         }
         else
         {
-            series->idx_len -= offset;
-            idx = (idx_t *) realloc(
-                        series->idx,
-                        series->idx_len * sizeof(idx_t));
-            if (idx == NULL && series->idx_len)
+            if (SERIES_idx_resize(series, series->idx_len - offset))
             {
                 log_error("Re-allocation failed while removing series from "
                         "shard index");
             }
-            else
-            {
-                series->idx = idx;
-            }
             uint64_t start = shard->id - series->mask;
             uint64_t end = start + duration;
             if (series->start >= start && series->start < end)
@@ -636,6 +752,13 @@ void siridb_series_remove_shard(
             {
                 SERIES_update_end(series);
             }
+
+            SERIES_update_pindex(
+                    siridb,
+                    series,
+                    prev_start,
+                    prev_end,
+                    prev_length);
         }
     }
 }
@@ -684,19 +807,15 @@ siridb_points_t * siridb_series_get_points(
     siridb_point_t *__restrict point;
     size_t len, size;
     uint32_t i;
-    uint32_t indexes[series->idx_len];
-    len = i = size = 0;
+    size = 0;
 
-    for (   idx = series->idx;
+    for (   idx = series->idx, i = 0;
             i < series->idx_len;
             i++, idx++)
     {
-        if (    (start_ts == NULL || idx->end_ts >= *start_ts) &&
-                (end_ts == NULL || idx->start_ts < *end_ts))
+        if (SERIES_IDX_IN_RANGE(idx, start_ts, end_ts))
         {
             size += idx->len;
-            indexes[len] = i;
-            len++;
         }
     }
 
@@ -708,9 +827,14 @@ siridb_points_t * siridb_series_get_points(
         return NULL;  /* signal is raised */
     }
 
-    for (i = 0; i < len; i++)
+    for (   idx = series->idx, i = 0;
+            i < series->idx_len;
+            i++, idx++)
     {
-        idx = series->idx + indexes[i];
+        if (!SERIES_IDX_IN_RANGE(idx, start_ts, end_ts))
+        {
+            continue;
+        }
         siridb_shard_get_points_callback(idx->shard->flags, series)(
                 points,
                 idx,
@@ -757,6 +881,133 @@ siridb_points_t * siridb_series_get_points(
     return points;
 }
 
+/*
+ * Returns the newest 'limit' points within the time range, or less when the
+ * series has less points. The index is walked from the newest chunk
+ * backwards and only the chunks which can contain one of the newest points
+ * are read.
+ *
+ * Returns NULL and raises a SIGNAL in case an error has occurred.
+ */
+siridb_points_t * siridb_series_get_tail(
+        siridb_series_t *__restrict series,
+        uint64_t *__restrict start_ts,
+        uint64_t *__restrict end_ts,
+        size_t limit)
+{
+    idx_t *__restrict idx;
+    siridb_points_t *__restrict points;
+    siridb_point_t *__restrict point;
+    size_t len, size, count;
+    uint64_t min_ts = 0;
+    uint32_t i;
+
+    if (!series->idx_len)
+    {
+        /* only buffer points, no chunks need to be selected */
+        points = siridb_series_get_points(series, start_ts, end_ts);
+        if (points != NULL)
+        {
+            SERIES_points_tail(points, limit);
+        }
+        return points;
+    }
+
+    uint8_t use[series->idx_len];
+    len = size = count = 0;
+
+    /*
+     * Walk backwards until the chunks which are completely within range
+     * contain at least 'limit' points. Each point newer than the oldest of
+     * these chunks must then be in a chunk ending at or after this chunk's
+     * start, so those are the only older chunks (overlap) we need.
+     */
+    for (i = series->idx_len; i--;)
+    {
+        idx = series->idx + i;
+        use[i] = 0;
+
+        if (    (start_ts != NULL && idx->end_ts < *start_ts) ||
+                (end_ts != NULL && idx->start_ts >= *end_ts) ||
+                (count >= limit && idx->end_ts < min_ts))
+        {
+            continue;
+        }
+
+        use[i] = 1;
+        size += idx->len;
+        len++;
+
+        if (    count < limit &&
+                (start_ts == NULL || idx->start_ts >= *start_ts) &&
+                (end_ts == NULL || idx->end_ts < *end_ts))
+        {
+            count += idx->len;
+            min_ts = idx->start_ts;
+        }
+    }
+
+    size += (series->buffer == NULL) ? 0 : series->buffer->len;
+    points = siridb_points_new(size, series->tp);
+
+    if (points == NULL)
+    {
+        return NULL;  /* signal is raised */
+    }
+
+    for (i = 0; len; i++)
+    {
+        if (!use[i])
+        {
+            continue;
+        }
+        len--;
+        idx = series->idx + i;
+        siridb_shard_get_points_callback(idx->shard->flags, series)(
+                points,
+                idx,
+                start_ts,
+                end_ts,
+                series->flags & SIRIDB_SERIES_HAS_OVERLAP);
+        /* errors can be ignored here */
+    }
+
+    if (series->buffer != NULL)
+    {
+        /* buffer points are added like siridb_series_get_points() does */
+        point = series->buffer->data;
+        len = series->buffer->len;
+
+        if (start_ts != NULL)
+        {
+            for (; len && point->ts < *start_ts; point++, len--);
+        }
+
+        if (end_ts != NULL && len)
+        {
+            siridb_point_t *__restrict p;
+
+            for (   p = point + len - 1;
+                    len && p->ts >= *end_ts;
+                    p--, len--);
+        }
+
+        for (; len; point++, len--)
+        {
+            siridb_points_add_point(points, &point->ts, &point->val);
+        }
+    }
+
+    SERIES_points_tail(points, limit);
+
+    if (points->len < size && siridb_points_resize(points, points->len))
+    {
+        log_error("Re-allocation points has failed");
+    }
+
+    return points;
+}
+
 /*
  * Can be used instead of the macro function when need as callback function.
  */
@@ -1179,29 +1430,19 @@ int siridb_series_optimize_shard(
         /* get the difference */
         diff = end - i;
 
-        /* new length is current length minus difference */
-        series->idx_len -= diff;
-
-        for (; i < series->idx_len; i++)
+        for (; i + diff < series->idx_len; i++)
         {
             series->idx[i] = series->idx[i + diff];
         }
 
-        /* shrink memory to the new size */
-        idx = (idx_t *) realloc(
-                series->idx,
-                series->idx_len * sizeof(idx_t));
-        if (idx == NULL && series->idx_len)
+        /* new length is current length minus difference */
+        if (SERIES_idx_resize(series, series->idx_len - diff))
         {
             /* this is not critical since the original allocated block still
              * works.
              */
             log_error("Shrinking memory for one series has failed!");
         }
-        else
-        {
-            series->idx = idx;
-        }
     }
     else
     {
@@ -1283,6 +1524,99 @@ static void SERIES_idx_sort(
     }
 }
 
+/*
+ * Returns the number of items allocated for an index with length 'n'.
+ *
+ * The index grows geometrically but with at most 25% unused space. Each
+ * power of two range is divided in four steps, for example 16, 20, 24, 28,
+ * 32, 40, 48 etc.
+ */
+static inline uint32_t SERIES_idx_size(uint32_t n)
+{
+    uint32_t step;
+
+    if (n <= SERIES_IDX_MIN_SZ)
+    {
+        return n ? SERIES_IDX_MIN_SZ : 0;
+    }
+
+    step = (uint32_t) 1 << (29 - __builtin_clz(n));
+
+    return (n + step - 1) & ~(step - 1);
+}
+
+/*
+ * Change the length of the index to 'n'. The allocated size is not stored
+ * but derived from the length, so the index must only be resized using
+ * this function.
+ *
+ * Returns 0 if successful or -1 if re-allocation has failed. When shrinking
+ * fails the length is still changed since the original block works fine.
+ */
+static int SERIES_idx_resize(siridb_series_t * series, uint32_t n)
+{
+    uint32_t sz = SERIES_idx_size(n);
+    idx_t * idx;
+
+    if (sz != SERIES_idx_size(series->idx_len))
+    {
+        if (!sz)
+        {
+            free(series->idx);
+            series->idx = NULL;
+        }
+        else if ((idx = (idx_t *) realloc(
+                series->idx,
+                sz * sizeof(idx_t))) != NULL)
+        {
+            series->idx = idx;
+        }
+        else if (n > series->idx_len)
+        {
+            return -1;
+        }
+        else
+        {
+            series->idx_len = n;
+            return -1;
+        }
+    }
+
+    series->idx_len = n;
+
+    return 0;
+}
+
+/*
+ * Remove the oldest points so at most 'limit' points are left.
+ */
+static void SERIES_points_tail(
+        siridb_points_t *__restrict points,
+        size_t limit)
+{
+    size_t i, n;
+
+    if (points->len <= limit)
+    {
+        return;
+    }
+
+    n = points->len - limit;
+
+    if (points->tp == TP_STRING)
+    {
+        for (i = 0; i < n; i++)
+        {
+            free(points->data[i].val.str);
+        }
+    }
+
+    memmove(points->data,
+            points->data + n,
+            limit * sizeof(siridb_point_t));
+    points->len = limit;
+}
+
 /*
  * Updates series->flags and remove SIRIDB_SERIES_HAS_OVERLAP if possible.
  * This function never sets an overlap and therefore should not be called
@@ -1315,61 +1649,58 @@ static siridb_series_t * SERIES_new(
         const char * name)
 {
     uint32_t n;
+    size_t name_len = strlen(name);
     siridb_series_t * series;
-    series = (siridb_series_t *) malloc(sizeof(siridb_series_t));
+
+    /* the name is stored in the same allocation, right after the series */
+    series = (siridb_series_t *) malloc(
+            sizeof(siridb_series_t) + name_len + 1);
     if (series == NULL)
     {
         ERR_ALLOC
     }
     else
     {
-        series->name = strdup(name);
-        if (series->name == NULL)
+        series->name = (char *) (series + 1);
+        memcpy(series->name, name, name_len + 1);
+
+        /* we use the length a lot and we have room so store this info */
+        series->name_len = name_len;
+        series->id = id;
+        series->tp = tp;
+        series->ref = 1;
+        series->length = 0;
+        series->start = -1;
+        series->end = 0;
+        series->buffer = NULL;
+        series->pool = pool;
+        series->flags = 0;
+        series->idx_len = 0;
+        series->idx = NULL;
+        series->siridb = siridb;
+
+        /* get sum series name to calculate series mask (for sharding) */
+        for (n = 0; *name; name++)
         {
-            ERR_ALLOC
-            free(series);
-            series = NULL;
+            n += *name;
         }
-        else
-        {
-            /* we use the length a lot and we have room so store this info */
-            series->name_len = strlen(series->name);
-            series->id = id;
-            series->tp = tp;
-            series->ref = 1;
-            series->length = 0;
-            series->start = -1;
-            series->end = 0;
-            series->buffer = NULL;
-            series->pool = pool;
-            series->flags = 0;
-            series->idx_len = 0;
-            series->idx = NULL;
-            series->siridb = siridb;
-
-            /* get sum series name to calculate series mask (for sharding) */
-            for (n = 0; *name; name++)
-            {
-                n += *name;
-            }
 
-            series->mask = (tp == TP_STRING) ?
-                    (uint16_t) ((n / 11) % siridb->shard_mask_log) + 600 :
-                    (uint16_t) ((n / 11) % siridb->shard_mask_num);
+        series->mask = (tp == TP_STRING) ?
+                (uint16_t) ((n / 11) % siridb->shard_mask_log) + 600 :
+                (uint16_t) ((n / 11) % siridb->shard_mask_num);
 
-            if ((_Bool) ((n / 11) % 2))
-            {
-                series->flags |= SIRIDB_SERIES_IS_SERVER_ONE;
-            }
+        if ((_Bool) ((n / 11) % 2))
+        {
+            series->flags |= SIRIDB_SERIES_IS_SERVER_ONE;
+        }
 
-            /* make sure these two are exactly the same */
-            assert (siridb_series_server_id(series) ==
-                    siridb_series_server_id_by_name(series->name));
+        /* make sure these two are exactly the same */
+        assert (siridb_series_server_id(series) ==
+                siridb_series_server_id_by_name(series->name));
 
-            if (siridb->time->precision == SIRIDB_TIME_SECONDS)
-            {
-                series->flags |= SIRIDB_SERIES_IS_32BIT_TS;
-            }
+        if (siridb->time->precision == SIRIDB_TIME_SECONDS)
+        {
+            series->flags |= SIRIDB_SERIES_IS_32BIT_TS;
         }
     }
     return series;
@@ -1562,8 +1893,8 @@ static int SERIES_load(siridb_t * siridb, imap_t * dropped)
                     (const char *) qp_series_name.via.raw);
             if (series != NULL)
             {
-                /* add series to c-tree */
-                if (ct_add(siridb->series, series->name, series) ||
+                /* add series to the name dictionary */
+                if (siridb_names_append(siridb->series, series) ||
                     imap_add(siridb->series_map, series->id, series))
                 {
                     return -1;
@@ -1584,6 +1915,13 @@ static int SERIES_load(siridb_t * siridb, imap_t * dropped)
         return -1;
     }
 
+    /* sort all loaded series at once */
+    if (siridb_names_rebuild(siridb->series))
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
     /*
      * In case of a siri_err we should not overwrite series because the
      * file then might be incomplete.
@@ -1763,4 +2101,53 @@ static void SERIES_update_end(siridb_series_t *__restrict series)
     }
 }
 
+/*
+ * Update the property index, if enabled, after the series properties are
+ * changed. The arguments are the previous property values.
+ */
+static void SERIES_update_pindex(
+        siridb_t *__restrict siridb,
+        siridb_series_t *__restrict series,
+        uint64_t start,
+        uint64_t end,
+        uint32_t length)
+{
+    if (    siridb->pindex != NULL &&
+            siridb_pindex_update(siridb->pindex, series, start, end, length))
+    {
+        log_critical("Cannot update the property index for series '%s'",
+                series->name);
+        ERR_ALLOC
+    }
+}
 
+static int SERIES_bmap_imap(uint32_t id, void ** args)
+{
+    siridb_series_t * series =
+            (siridb_series_t *) imap_get((imap_t *) args[0], id);
+
+    if (series != NULL)
+    {
+        if (imap_add((imap_t *) args[1], id, series))
+        {
+            return -1;
+        }
+        siridb_series_incref(series);
+    }
+    return 0;
+}
+
+static int SERIES_bmap_vec(uint32_t id, void ** args)
+{
+    siridb_series_t * series =
+            (siridb_series_t *) imap_get((imap_t *) args[0], id);
+    vec_t * vec = (vec_t *) args[1];
+
+    if (series != NULL)
+    {
+        /* the vector is large enough to hold all ids */
+        vec_append(vec, series);
+        siridb_series_incref(series);
+    }
+    return 0;
+}
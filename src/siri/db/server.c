@@ -12,8 +12,10 @@
 #include <siri/net/promise.h>
 #include <siri/net/stream.h>
 #include <siri/net/tcp.h>
+#include <siri/net/wqueue.h>
 #include <siri/siri.h>
 #include <siri/version.h>
+#include <timeit/timeit.h>
 #include <xstr/xstr.h>
 #include <string.h>
 
@@ -21,11 +23,12 @@
 #define SIRIDB_SERVERS_SCHEMA 1
 #define SIRIDB_SERVER_FLAGS_TIMEOUT 5000        /* 5 seconds    */
 #define SIRIDB_SERVER_PROMISES_QUEUE_SIZE 250   /* max concurrent promises  */
+#define SIRIDB_SERVER_LATENCY_WEIGHT 0.125f     /* weight for new samples   */
 #define FMT_AS_IPV6(addr) (strchr(addr, ':') != NULL)
 
 static int SERVER_update_name(siridb_server_t * server);
 static void SERVER_timeout_pkg(uv_timer_t * handle);
-static void SERVER_write_cb(uv_write_t * req, int status);
+static void SERVER_write_cb(sirinet_promise_t * promise, int status);
 static void SERVER_on_auth_response(
         sirinet_promise_t * promise,
         sirinet_pkg_t * pkg,
@@ -46,6 +49,9 @@ static int SERVER_resolve_dns(
 static void SERVER_on_data(sirinet_stream_t * client, sirinet_pkg_t * pkg);
 static void SERVER_cancel_promise(sirinet_promise_t * promise);
 static void SERVER_upd_flag_queue_full(siridb_server_t * server);
+static void SERVER_upd_latency(
+        siridb_server_t * server,
+        sirinet_promise_t * promise);
 
 /*
  * In case of an error the return value is NULL and a SIGNAL is raised.
@@ -92,6 +98,8 @@ siridb_server_t * siridb_server_new(
     server->buffer_path = NULL;
     server->buffer_size = 0;
     server->startup_time = 0;
+    server->latency = 0.0f;
+    server->latency_pct = 0.0f;
 
     /* we set the promises later because we don't need one for self */
     server->promises = NULL;
@@ -158,15 +166,6 @@ int siridb_server_send_pkg(
     promise->server = server;
     promise->data = data;
 
-    uv_write_t * req = (uv_write_t *) malloc(sizeof(uv_write_t));
-    if (req == NULL)
-    {
-        ERR_ALLOC
-        free(promise->timer);
-        free(promise);
-        return -1;
-    }
-
     while (++n)
     {
         /*
@@ -187,7 +186,6 @@ int siridb_server_send_pkg(
             /* memory allocation error */
             free(promise->timer);
             free(promise);
-            free(req);
             ERR_ALLOC
             return -1;
         }
@@ -206,7 +204,6 @@ int siridb_server_send_pkg(
         ERR_C
         free(promise->timer);
         free(promise);
-        free(req);
         return -1;
     }
 
@@ -225,21 +222,23 @@ int siridb_server_send_pkg(
             sirinet_bproto_client_str(pkg->tp),
             server->name);
 
-    req->data = promise;
-
-    /* set the correct check bit */
-    pkg->checkbit = pkg->tp ^ 255;
-
-    uv_buf_t wrbuf = uv_buf_init(
-            (char *) pkg,
-            sizeof(sirinet_pkg_t) + pkg->len);
+    /* latency is measured from here */
+    timeit_start(&promise->start);
 
-    uv_write(
-            req,
-            server->client->stream,
-            &wrbuf,
-            1,
-            SERVER_write_cb);
+    if (sirinet_wqueue_write(
+            server->client,
+            pkg,
+            (sirinet_wqueue_cb) SERVER_write_cb,
+            promise))
+    {
+        /* the write call-back is not called, a signal is raised */
+        imap_pop(server->promises, promise->pid);
+        SERVER_upd_flag_queue_full(server);
+        uv_timer_stop(promise->timer);
+        uv_close((uv_handle_t *) promise->timer, (uv_close_cb) free);
+        free(promise);
+        return -1;
+    }
 
     return 0;
 }
@@ -590,12 +589,50 @@ static void SERVER_upd_flag_queue_full(siridb_server_t * server)
 }
 
 /*
- * Write call-back.
+ * Update the moving average latency for a server with the response time of
+ * the given promise. A timed-out promise is counted with the time we have
+ * waited so a slow server is punished as well.
+ *
+ * When hedging is enabled, the configured percentile of the response time is
+ * estimated too.
  */
-static void SERVER_write_cb(uv_write_t * req, int status)
+static void SERVER_upd_latency(
+        siridb_server_t * server,
+        sirinet_promise_t * promise)
 {
-    sirinet_promise_t * promise = (sirinet_promise_t *) req->data;
+    float latency = timeit_get(&promise->start);
+
+    server->latency = (server->latency == 0.0f) ? latency :
+            server->latency + SIRIDB_SERVER_LATENCY_WEIGHT *
+            (latency - server->latency);
+
+    if (siri.cfg->hedge_percentile)
+    {
+        /*
+         * Move the estimate up when the sample is above the estimate and
+         * down otherwise. The steps are weighted by the percentile so the
+         * estimate settles where this percentile of samples is below.
+         */
+        float pct = siri.cfg->hedge_percentile / 100.0f;
+        float step = SIRIDB_SERVER_LATENCY_WEIGHT * server->latency;
+
+        server->latency_pct = (server->latency_pct == 0.0f) ? latency :
+                (latency > server->latency_pct) ?
+                server->latency_pct + step * pct :
+                server->latency_pct - step * (1.0f - pct);
+
+        if (server->latency_pct < 0.0f)
+        {
+            server->latency_pct = 0.0f;
+        }
+    }
+}
 
+/*
+ * Write call-back.
+ */
+static void SERVER_write_cb(sirinet_promise_t * promise, int status)
+{
     if (status)
     {
         log_error(
@@ -622,8 +659,6 @@ static void SERVER_write_cb(uv_write_t * req, int status)
 
     free(promise->pkg); /* NULL when FLAG_KEEP_PKG is set */
     sirinet_promise_decref(promise);
-
-    free(req);
 }
 
 /*
@@ -646,6 +681,7 @@ static void SERVER_timeout_pkg(uv_timer_t * handle)
     else
     {
         SERVER_upd_flag_queue_full(promise->server);
+        SERVER_upd_latency(promise->server, promise);
         log_warning("Timeout on package (PID %" PRIu16 ") for server '%s'",
                 promise->pid,
                 promise->server->name);
@@ -759,6 +795,7 @@ static void SERVER_on_data(sirinet_stream_t * client, sirinet_pkg_t * pkg)
     else
     {
         SERVER_upd_flag_queue_full(promise->server);
+        SERVER_upd_latency(promise->server, promise);
         uv_timer_stop(promise->timer);
         uv_close((uv_handle_t *) promise->timer, (uv_close_cb) free);
         promise->cb(promise, pkg, PROMISE_SUCCESS);
@@ -13,6 +13,7 @@
 #include <siri/db/shard.h>
 #include <siri/db/shards.h>
 #include <siri/db/points.h>
+#include <siri/db/profile.h>
 #include <siri/optimize.h>
 #include <siri/err.h>
 #include <siri/file/pointer.h>
@@ -615,6 +616,9 @@ int siridb_shard_get_points_num32(
         uint64_t * end_ts,
         uint8_t has_overlap)
 {
+    siridb_profile_t * profile = siridb_profile_io;
+    struct timespec start;
+    size_t n = points->len;
     uint32_t * temp,* pt;
     size_t len = points->len + idx->len;
 
@@ -636,6 +640,8 @@ int siridb_shard_get_points_num32(
         return -1;
     }
 
+    siridb_profile_start(profile, &start);
+
     if (fseeko(idx->shard->fp->fp, idx->pos, SEEK_SET) ||
         fread(
             temp,
@@ -660,6 +666,8 @@ int siridb_shard_get_points_num32(
         return -1;
     }
 
+    siridb_profile_read(profile, 12 * idx->len, &start);
+
     /* set pointer to start */
     pt = temp;
 
@@ -698,6 +706,8 @@ int siridb_shard_get_points_num32(
         }
     }
 
+    siridb_profile_decode(profile, points->len - n, &start);
+
     free(temp);
     return 0;
 }
@@ -712,6 +722,9 @@ int siridb_shard_get_points_num64(
         uint64_t * end_ts,
         uint8_t has_overlap)
 {
+    siridb_profile_t * profile = siridb_profile_io;
+    struct timespec start;
+    size_t n = points->len;
     uint64_t * temp, * pt;
     size_t len = points->len + idx->len;
 
@@ -733,6 +746,8 @@ int siridb_shard_get_points_num64(
         return -1;
     }
 
+    siridb_profile_start(profile, &start);
+
     if (fseeko(idx->shard->fp->fp, idx->pos, SEEK_SET) ||
         fread(
             temp,
@@ -757,6 +772,8 @@ int siridb_shard_get_points_num64(
         return -1;
     }
 
+    siridb_profile_read(profile, 16 * idx->len, &start);
+
     /* set pointer to start */
     pt = temp;
 
@@ -793,6 +810,8 @@ int siridb_shard_get_points_num64(
         }
     }
 
+    siridb_profile_decode(profile, points->len - n, &start);
+
     free(temp);
     return 0;
 }
@@ -808,6 +827,9 @@ int siridb_shard_get_points_num_compressed(
         uint64_t * end_ts,
         uint8_t has_overlap)
 {
+    siridb_profile_t * profile = siridb_profile_io;
+    struct timespec start;
+    size_t n = points->len;
     unsigned char * bits;
     size_t size = siridb_points_get_size_zipped(idx->cinfo, idx->len);
 
@@ -829,6 +851,8 @@ int siridb_shard_get_points_num_compressed(
         return -1;
     }
 
+    siridb_profile_start(profile, &start);
+
     if (fseeko(idx->shard->fp->fp, idx->pos, SEEK_SET) ||
         fread(bits, size, 1, idx->shard->fp->fp) != 1)
     {
@@ -849,6 +873,8 @@ int siridb_shard_get_points_num_compressed(
         return -1;
     }
 
+    siridb_profile_read(profile, size, &start);
+
     switch (points->tp)
     {
     case TP_INT:
@@ -874,6 +900,8 @@ int siridb_shard_get_points_num_compressed(
     case TP_STRING: assert(0);
     }
 
+    siridb_profile_decode(profile, points->len - n, &start);
+
     free(bits);
     return 0;
 }
@@ -885,6 +913,9 @@ int siridb_shard_get_points_log_compressed(
         uint64_t * end_ts,
         uint8_t has_overlap)
 {
+    siridb_profile_t * profile = siridb_profile_io;
+    struct timespec start;
+    size_t n = points->len;
     int rc;
 
     if (idx->len < POINTS_ZIP_THRESHOLD)
@@ -914,6 +945,8 @@ int siridb_shard_get_points_log_compressed(
         return -1;
     }
 
+    siridb_profile_start(profile, &start);
+
     if (    fseeko(idx->shard->fp->fp, idx->pos, SEEK_SET) ||
             fread(  bits,
                     sizeof(uint8_t),
@@ -937,6 +970,8 @@ int siridb_shard_get_points_log_compressed(
         return -1;
     }
 
+    siridb_profile_read(profile, size, &start);
+
     rc = siridb_points_unzip_string(
             points,
             bits,
@@ -945,6 +980,8 @@ int siridb_shard_get_points_log_compressed(
             end_ts,
             has_overlap && (idx->shard->flags & SIRIDB_SHARD_HAS_OVERLAP));
 
+    siridb_profile_decode(profile, points->len - n, &start);
+
     free(bits);
 
     return rc;
@@ -960,6 +997,9 @@ int siridb_shard_get_points_log32(
         uint64_t * end_ts,
         uint8_t has_overlap)
 {
+    siridb_profile_t * profile = siridb_profile_io;
+    struct timespec start;
+    size_t n = points->len;
     uint32_t * tdata, * tpt;
     char * cdata, * cpt;
     size_t len = points->len + idx->len;
@@ -986,6 +1026,8 @@ int siridb_shard_get_points_log32(
         return -1;
     }
 
+    siridb_profile_start(profile, &start);
+
     if (    fseeko(idx->shard->fp->fp, idx->pos, SEEK_SET) ||
             fread(  tdata,
                     sizeof(uint32_t),
@@ -1014,6 +1056,8 @@ int siridb_shard_get_points_log32(
         return -1;
     }
 
+    siridb_profile_read(profile, sizeof(uint32_t) * idx->len + dsize, &start);
+
     /* set pointer to start */
     tpt = tdata;
     cpt = cdata;
@@ -1062,6 +1106,8 @@ int siridb_shard_get_points_log32(
         }
     }
 
+    siridb_profile_decode(profile, points->len - n, &start);
+
     free(tdata);
     free(cdata);
     return 0;
@@ -1077,6 +1123,9 @@ int siridb_shard_get_points_log64(
         uint64_t * end_ts,
         uint8_t has_overlap)
 {
+    siridb_profile_t * profile = siridb_profile_io;
+    struct timespec start;
+    size_t n = points->len;
     uint64_t * tdata, * tpt;
     char * cdata, * cpt;
     size_t len = points->len + idx->len;
@@ -1103,6 +1152,8 @@ int siridb_shard_get_points_log64(
         return -1;
     }
 
+    siridb_profile_start(profile, &start);
+
     if (    fseeko(idx->shard->fp->fp, idx->pos, SEEK_SET) ||
             fread(  tdata,
                     sizeof(uint64_t),
@@ -1131,6 +1182,8 @@ int siridb_shard_get_points_log64(
         return -1;
     }
 
+    siridb_profile_read(profile, sizeof(uint64_t) * idx->len + dsize, &start);
+
     /* set pointer to start */
     tpt = tdata;
     cpt = cdata;
@@ -1178,6 +1231,8 @@ int siridb_shard_get_points_log64(
         }
     }
 
+    siridb_profile_decode(profile, points->len - n, &start);
+
     free(tdata);
     free(cdata);
     return 0;
@@ -1419,6 +1474,9 @@ void siridb_shard_drop(siridb_shard_t * shard, siridb_t * siridb)
     siridb_shard_t * pop_shard;
     int optimizing = 0;
 
+    /* cached select results might contain points from this shard */
+    siridb_rcache_clear(siridb->rcache);
+
     uv_mutex_lock(&siridb->series_mutex);
     uv_mutex_lock(&siridb->shards_mutex);
 
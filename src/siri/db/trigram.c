@@ -0,0 +1,224 @@
+/*
+ * trigram.c - Trigram index on series names.
+ *
+ * Each trigram (three successive characters) in a series name points to
+ * the set of series having that trigram in their name. For a regular
+ * expression with required literals, only series containing all trigrams
+ * of these literals are candidates. The candidates still must be tested
+ * against the expression.
+ *
+ * The index does not hold references to the series, series must be removed
+ * from the index before they are destroyed.
+ */
+#include <siri/db/trigram.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIGRAM_KEY(s) \
+        ((uint64_t) (uint8_t) (s)[0] << 16 | \
+        (uint64_t) (uint8_t) (s)[1] << 8 | \
+        (uint64_t) (uint8_t) (s)[2])
+
+typedef struct
+{
+    vec_t * vec;
+    imap_t ** sets;
+    size_t n;
+} trigram_check_t;
+
+static int TRIGRAM_free_set(imap_t * set);
+static int TRIGRAM_check(siridb_series_t * series, void * args);
+
+/*
+ * Returns NULL in case of an error.
+ */
+siridb_trigram_t * siridb_trigram_new(void)
+{
+    siridb_trigram_t * trigram =
+            (siridb_trigram_t *) malloc(sizeof(siridb_trigram_t));
+
+    if (trigram == NULL)
+    {
+        return NULL;
+    }
+
+    trigram->grams = imap_new();
+
+    if (trigram->grams == NULL)
+    {
+        free(trigram);
+        return NULL;
+    }
+
+    return trigram;
+}
+
+/*
+ * Destroy the trigram index. (parsing NULL is not allowed)
+ */
+void siridb_trigram_free(siridb_trigram_t * trigram)
+{
+    imap_free(trigram->grams, (imap_free_cb) TRIGRAM_free_set);
+    free(trigram);
+}
+
+/*
+ * Add a series to the index.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error. In case of
+ * an error the series might be partially indexed and should be removed
+ * using siridb_trigram_pop().
+ */
+int siridb_trigram_add(siridb_trigram_t * trigram, siridb_series_t * series)
+{
+    imap_t * set;
+    uint64_t key;
+    size_t i;
+
+    for (i = 0; i + 3 <= series->name_len; i++)
+    {
+        key = TRIGRAM_KEY(series->name + i);
+        set = (imap_t *) imap_get(trigram->grams, key);
+
+        if (set == NULL)
+        {
+            set = imap_new();
+            if (set == NULL)
+            {
+                return -1;
+            }
+            if (imap_add(trigram->grams, key, set))
+            {
+                imap_free(set, NULL);
+                return -1;
+            }
+        }
+
+        /* -2 is returned when the trigram exists more than once */
+        if (imap_add(set, series->id, series) == -1)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Remove a series from the index.
+ */
+void siridb_trigram_pop(siridb_trigram_t * trigram, siridb_series_t * series)
+{
+    imap_t * set;
+    uint64_t key;
+    size_t i;
+
+    for (i = 0; i + 3 <= series->name_len; i++)
+    {
+        key = TRIGRAM_KEY(series->name + i);
+        set = (imap_t *) imap_get(trigram->grams, key);
+
+        if (set != NULL && imap_pop(set, series->id) != NULL && !set->len)
+        {
+            imap_pop(trigram->grams, key);
+            imap_free(set, NULL);
+        }
+    }
+}
+
+/*
+ * Returns a vector with the series which contain all given literals. The
+ * literals are zero terminated strings with a total size of 'len'. Literals
+ * shorter than three characters are ignored.
+ *
+ * Each series in the vector has a new reference.
+ *
+ * NULL is returned in case of an allocation error or when no literal has at
+ * least three characters, in which case all series must be tested.
+ */
+vec_t * siridb_trigram_match(
+        siridb_trigram_t * trigram,
+        const char * literals,
+        size_t len)
+{
+    trigram_check_t check;
+    imap_t * smallest = NULL;
+    imap_t * set;
+    const char * pt;
+    const char * end = literals + len;
+    size_t n = 0;
+    size_t i;
+
+    for (pt = literals; pt < end; pt += strlen(pt) + 1)
+    {
+        i = strlen(pt);
+        n += (i >= 3) ? i - 2 : 0;
+    }
+
+    if (!n)
+    {
+        return NULL;
+    }
+
+    imap_t * sets[n];
+
+    for (n = 0, pt = literals; pt < end; pt += strlen(pt) + 1)
+    {
+        for (i = 0; pt[i] && pt[i + 1] && pt[i + 2]; i++)
+        {
+            set = (imap_t *) imap_get(trigram->grams, TRIGRAM_KEY(pt + i));
+
+            if (set == NULL)
+            {
+                /* no series contains this trigram */
+                return vec_new(0);
+            }
+
+            if (smallest == NULL || set->len < smallest->len)
+            {
+                smallest = set;
+            }
+
+            sets[n++] = set;
+        }
+    }
+
+    check.vec = vec_new(smallest->len);
+    check.sets = sets;
+    check.n = n;
+
+    if (check.vec != NULL)
+    {
+        imap_walk(smallest, (imap_cb) TRIGRAM_check, &check);
+    }
+
+    return check.vec;
+}
+
+static int TRIGRAM_free_set(imap_t * set)
+{
+    imap_free(set, NULL);
+    return 0;
+}
+
+/*
+ * Add the series to the vector when the series exists in all sets.
+ */
+static int TRIGRAM_check(siridb_series_t * series, void * args)
+{
+    trigram_check_t * check = (trigram_check_t *) args;
+    size_t i;
+
+    for (i = 0; i < check->n; i++)
+    {
+        if (imap_get(check->sets[i], series->id) == NULL)
+        {
+            return 0;
+        }
+    }
+
+    vec_append(check->vec, series);
+    siridb_series_incref(series);
+
+    return 0;
+}
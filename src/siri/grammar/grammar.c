@@ -41,6 +41,8 @@ cleri_grammar_t * compile_grammar(void)
     cleri_t * k_backup_mode = cleri_keyword(CLERI_GID_K_BACKUP_MODE, "backup_mode", CLERI_CASE_SENSITIVE);
     cleri_t * k_before = cleri_keyword(CLERI_GID_K_BEFORE, "before", CLERI_CASE_SENSITIVE);
     cleri_t * k_buffer_size = cleri_keyword(CLERI_GID_K_BUFFER_SIZE, "buffer_size", CLERI_CASE_SENSITIVE);
+    cleri_t * k_cache_hit_ratio = cleri_keyword(CLERI_GID_K_CACHE_HIT_RATIO, "cache_hit_ratio", CLERI_CASE_SENSITIVE);
+    cleri_t * k_cache_size = cleri_keyword(CLERI_GID_K_CACHE_SIZE, "cache_size", CLERI_CASE_SENSITIVE);
     cleri_t * k_buffer_path = cleri_keyword(CLERI_GID_K_BUFFER_PATH, "buffer_path", CLERI_CASE_SENSITIVE);
     cleri_t * k_between = cleri_keyword(CLERI_GID_K_BETWEEN, "between", CLERI_CASE_SENSITIVE);
     cleri_t * k_count = cleri_keyword(CLERI_GID_K_COUNT, "count", CLERI_CASE_SENSITIVE);
@@ -51,6 +53,7 @@ cleri_grammar_t * compile_grammar(void)
     cleri_t * k_dbpath = cleri_keyword(CLERI_GID_K_DBPATH, "dbpath", CLERI_CASE_SENSITIVE);
     cleri_t * k_debug = cleri_keyword(CLERI_GID_K_DEBUG, "debug", CLERI_CASE_SENSITIVE);
     cleri_t * k_derivative = cleri_keyword(CLERI_GID_K_DERIVATIVE, "derivative", CLERI_CASE_SENSITIVE);
+    cleri_t * k_desc = cleri_keyword(CLERI_GID_K_DESC, "desc", CLERI_CASE_SENSITIVE);
     cleri_t * k_difference = cleri_keyword(CLERI_GID_K_DIFFERENCE, "difference", CLERI_CASE_SENSITIVE);
     cleri_t * k_drop = cleri_keyword(CLERI_GID_K_DROP, "drop", CLERI_CASE_SENSITIVE);
     cleri_t * k_drop_threshold = cleri_keyword(CLERI_GID_K_DROP_THRESHOLD, "drop_threshold", CLERI_CASE_SENSITIVE);
@@ -123,12 +126,15 @@ cleri_grammar_t * compile_grammar(void)
     cleri_t * k_online = cleri_keyword(CLERI_GID_K_ONLINE, "online", CLERI_CASE_SENSITIVE);
     cleri_t * k_open_files = cleri_keyword(CLERI_GID_K_OPEN_FILES, "open_files", CLERI_CASE_SENSITIVE);
     cleri_t * k_or = cleri_keyword(CLERI_GID_K_OR, "or", CLERI_CASE_SENSITIVE);
+    cleri_t * k_order = cleri_keyword(CLERI_GID_K_ORDER, "order", CLERI_CASE_SENSITIVE);
+    cleri_t * k_packages_per_write = cleri_keyword(CLERI_GID_K_PACKAGES_PER_WRITE, "packages_per_write", CLERI_CASE_SENSITIVE);
     cleri_t * k_password = cleri_keyword(CLERI_GID_K_PASSWORD, "password", CLERI_CASE_SENSITIVE);
     cleri_t * k_points = cleri_keyword(CLERI_GID_K_POINTS, "points", CLERI_CASE_SENSITIVE);
     cleri_t * k_pool = cleri_keyword(CLERI_GID_K_POOL, "pool", CLERI_CASE_SENSITIVE);
     cleri_t * k_pools = cleri_keyword(CLERI_GID_K_POOLS, "pools", CLERI_CASE_SENSITIVE);
     cleri_t * k_port = cleri_keyword(CLERI_GID_K_PORT, "port", CLERI_CASE_SENSITIVE);
     cleri_t * k_prefix = cleri_keyword(CLERI_GID_K_PREFIX, "prefix", CLERI_CASE_SENSITIVE);
+    cleri_t * k_profile = cleri_keyword(CLERI_GID_K_PROFILE, "profile", CLERI_CASE_SENSITIVE);
     cleri_t * k_pvariance = cleri_keyword(CLERI_GID_K_PVARIANCE, "pvariance", CLERI_CASE_SENSITIVE);
     cleri_t * k_read = cleri_keyword(CLERI_GID_K_READ, "read", CLERI_CASE_SENSITIVE);
     cleri_t * k_received_points = cleri_keyword(CLERI_GID_K_RECEIVED_POINTS, "received_points", CLERI_CASE_SENSITIVE);
@@ -350,10 +356,11 @@ cleri_grammar_t * compile_grammar(void)
     cleri_t * pool_props = cleri_choice(
         CLERI_GID_POOL_PROPS,
         CLERI_FIRST_MATCH,
-        3,
+        4,
         k_pool,
         k_servers,
-        k_series
+        k_series,
+        k_length
     );
     cleri_t * pool_columns = cleri_list(CLERI_GID_POOL_COLUMNS, pool_props, cleri_token(CLERI_NONE, ","), 1, 0, 0);
     cleri_t * bool_operator = cleri_tokens(CLERI_GID_BOOL_OPERATOR, "== !=");
@@ -784,6 +791,14 @@ cleri_grammar_t * compile_grammar(void)
         k_limit,
         int_expr
     );
+    cleri_t * order_expr = cleri_sequence(
+        CLERI_GID_ORDER_EXPR,
+        4,
+        k_order,
+        k_desc,
+        k_limit,
+        int_expr
+    );
     cleri_t * before_expr = cleri_sequence(
         CLERI_GID_BEFORE_EXPR,
         2,
@@ -817,6 +832,12 @@ cleri_grammar_t * compile_grammar(void)
         k_suffix,
         string
     );
+    cleri_t * series_after = cleri_sequence(
+        CLERI_GID_SERIES_AFTER,
+        2,
+        k_after,
+        string
+    );
     cleri_t * f_all = cleri_choice(
         CLERI_GID_F_ALL,
         CLERI_FIRST_MATCH,
@@ -1320,11 +1341,12 @@ cleri_grammar_t * compile_grammar(void)
     );
     cleri_t * list_series = cleri_sequence(
         CLERI_GID_LIST_SERIES,
-        4,
+        5,
         k_series,
         cleri_optional(CLERI_NONE, series_columns),
         cleri_optional(CLERI_NONE, series_match),
-        cleri_optional(CLERI_NONE, where_series)
+        cleri_optional(CLERI_NONE, where_series),
+        cleri_optional(CLERI_NONE, series_after)
     );
     cleri_t * list_servers = cleri_sequence(
         CLERI_GID_LIST_SERVERS,
@@ -1461,7 +1483,7 @@ cleri_grammar_t * compile_grammar(void)
     );
     cleri_t * select_stmt = cleri_sequence(
         CLERI_GID_SELECT_STMT,
-        7,
+        8,
         k_select,
         select_aggregates,
         k_from,
@@ -1475,6 +1497,7 @@ cleri_grammar_t * compile_grammar(void)
             between_expr,
             before_expr
         )),
+        cleri_optional(CLERI_NONE, order_expr),
         cleri_optional(CLERI_NONE, merge_as)
     );
     cleri_t * show_stmt = cleri_sequence(
@@ -1484,11 +1507,13 @@ cleri_grammar_t * compile_grammar(void)
         cleri_list(CLERI_NONE, cleri_choice(
             CLERI_NONE,
             CLERI_FIRST_MATCH,
-            34,
+            37,
             k_active_handles,
             k_active_tasks,
             k_buffer_path,
             k_buffer_size,
+            k_cache_hit_ratio,
+            k_cache_size,
             k_dbname,
             k_dbpath,
             k_drop_threshold,
@@ -1504,6 +1529,7 @@ cleri_grammar_t * compile_grammar(void)
             k_max_open_files,
             k_mem_usage,
             k_open_files,
+            k_packages_per_write,
             k_pool,
             k_received_points,
             k_reindex_progress,
@@ -1522,11 +1548,18 @@ cleri_grammar_t * compile_grammar(void)
         ), cleri_token(CLERI_NONE, ","), 0, 0, 0)
     );
     cleri_t * timeit_stmt = cleri_dup(CLERI_GID_TIMEIT_STMT, k_timeit);
+    cleri_t * profile_stmt = cleri_dup(CLERI_GID_PROFILE_STMT, k_profile);
     cleri_t * help_stmt = cleri_ref();
     cleri_t * START = cleri_sequence(
         CLERI_GID_START,
         3,
-        cleri_optional(CLERI_NONE, timeit_stmt),
+        cleri_optional(CLERI_NONE, cleri_choice(
+            CLERI_NONE,
+            CLERI_FIRST_MATCH,
+            2,
+            timeit_stmt,
+            profile_stmt
+        )),
         cleri_optional(CLERI_NONE, cleri_choice(
             CLERI_NONE,
             CLERI_FIRST_MATCH,
@@ -1647,6 +1680,7 @@ cleri_grammar_t * compile_grammar(void)
         ))
     );
     cleri_t * help_noaccess = cleri_keyword(CLERI_GID_HELP_NOACCESS, "noaccess", CLERI_CASE_SENSITIVE);
+    cleri_t * help_profile = cleri_keyword(CLERI_GID_HELP_PROFILE, "profile", CLERI_CASE_SENSITIVE);
     cleri_t * help_revoke = cleri_keyword(CLERI_GID_HELP_REVOKE, "revoke", CLERI_CASE_SENSITIVE);
     cleri_t * help_select = cleri_keyword(CLERI_GID_HELP_SELECT, "select", CLERI_CASE_SENSITIVE);
     cleri_t * help_show = cleri_keyword(CLERI_GID_HELP_SHOW, "show", CLERI_CASE_SENSITIVE);
@@ -1659,7 +1693,7 @@ cleri_grammar_t * compile_grammar(void)
         cleri_optional(CLERI_NONE, cleri_choice(
             CLERI_NONE,
             CLERI_MOST_GREEDY,
-            14,
+            15,
             help_access,
             help_alter,
             help_count,
@@ -1669,6 +1703,7 @@ cleri_grammar_t * compile_grammar(void)
             help_grant,
             help_list,
             help_noaccess,
+            help_profile,
             help_revoke,
             help_select,
             help_show,
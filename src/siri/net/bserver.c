@@ -468,6 +468,8 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg, int flags)
     qp_unpacker_init(&unpacker, pkg->data, pkg->len);
 
     qp_obj_t qp_query;
+    qp_obj_t qp_flags;
+    int query_flags = 0;
 
     if (flags & SIRIDB_QUERY_FLAG_UPDATE_REPLICA)
     {
@@ -482,13 +484,21 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg, int flags)
     if (    qp_is_array(qp_next(&unpacker, NULL)) &&
             qp_next(&unpacker, &qp_query) == QP_RAW)
     {
+        /* older SiriDB versions do not send query flags */
+        if (    qp_is_int(qp_next(&unpacker, NULL)) &&
+                qp_is_int(qp_next(&unpacker, &qp_flags)))
+        {
+            query_flags = qp_flags.via.int64 & (
+                    SIRIDB_QUERY_FLAG_PARTIAL | SIRIDB_QUERY_FLAG_ZIP);
+        }
+
         siridb_query_run(
                 pkg->pid,
                 client,
                 (const char *) qp_query.via.raw,
                 qp_query.len,
                 0.0,
-                0);
+                query_flags);
     }
     else
     {
@@ -633,7 +643,7 @@ static void on_drop_series(sirinet_stream_t * client, sirinet_pkg_t * pkg)
         if (qp_is_raw_term(&qp_series_name))
         {
             siridb_series_t * series;
-            series = ct_get(
+            series = siridb_names_get(
                     siridb->series,
                     (const char *) qp_series_name.via.raw);
             if (series != NULL)
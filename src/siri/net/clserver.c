@@ -478,8 +478,10 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg)
     qp_unpacker_t unpacker;
     qp_obj_t qp_query;
     qp_obj_t qp_time_precision;
+    qp_obj_t qp_flags;
     float factor;
     siridb_timep_t tp = SIRIDB_TIME_DEFAULT;
+    int query_flags = SIRIDB_QUERY_FLAG_MASTER;
 
     qp_unpacker_init(&unpacker, pkg->data, pkg->len);
 
@@ -497,13 +499,20 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg)
         factor = (tp == SIRIDB_TIME_DEFAULT) ? 0.0 :
                 pow(1000.0, tp - siridb->time->precision);
 
+        /* query flags are optional */
+        if (    qp_next(&unpacker, &qp_flags) == QP_INT64 &&
+                (qp_flags.via.int64 & CPROTO_QUERY_FLAG_STREAM))
+        {
+            query_flags |= SIRIDB_QUERY_FLAG_STREAM;
+        }
+
         siridb_query_run(
                 pkg->pid,
                 client,
                 (const char *) qp_query.via.raw,
                 qp_query.len,
                 factor,
-                SIRIDB_QUERY_FLAG_MASTER);
+                query_flags);
     }
     else
     {
@@ -555,65 +564,14 @@ static void on_insert(sirinet_stream_t * client, sirinet_pkg_t * pkg)
         return;
     }
 
-    qp_unpacker_t unpacker;
-    qp_unpacker_init(&unpacker, pkg->data, pkg->len);
-
     siridb_insert_t * insert = siridb_insert_new(
             siridb,
             pkg->pid,
             client);
 
-    if (insert != NULL)
+    if (insert != NULL && siridb_insert_assign(insert, pkg))
     {
-        ssize_t rc = siridb_insert_assign_pools(
-                siridb,
-                &unpacker,
-                insert->packer);
-
-        switch ((siridb_insert_err_t) rc)
-        {
-        case ERR_EXPECTING_ARRAY:
-        case ERR_EXPECTING_SERIES_NAME:
-        case ERR_EXPECTING_MAP_OR_ARRAY:
-        case ERR_EXPECTING_INTEGER_TS:
-        case ERR_TIMESTAMP_OUT_OF_RANGE:
-        case ERR_UNSUPPORTED_VALUE:
-        case ERR_EXPECTING_AT_LEAST_ONE_POINT:
-        case ERR_EXPECTING_NAME_AND_POINTS:
-        case ERR_INCOMPATIBLE_SERVER_VERSION:
-        case ERR_MEM_ALLOC:
-            {
-                /* something went wrong, get correct err message */
-                const char * err_msg = siridb_insert_err_msg(rc);
-
-                log_error("Insert error: '%s' at position %lu",
-                        err_msg, unpacker.pt - pkg->data);
-
-                /* create and send package */
-                sirinet_pkg_t * package = sirinet_pkg_err(
-                        pkg->pid,
-                        strlen(err_msg),
-                        CPROTO_ERR_INSERT,
-                        err_msg);
-
-                if (package != NULL)
-                {
-                    /* ignore result code, signal can be raised */
-                    sirinet_pkg_send(client, package);
-                }
-            }
-
-            /* error, free insert */
-            siridb_insert_free(insert);
-            break;
-
-        default:
-            if (siridb_insert_points_to_pools(insert, (size_t) rc))
-            {
-                siridb_insert_free(insert);  /* signal is raised */
-            }
-            break;
-        }
+        siridb_insert_free(insert);  /* signal is raised */
     }
 }
 
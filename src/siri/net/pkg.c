@@ -6,18 +6,11 @@
 #include <siri/err.h>
 #include <siri/net/pkg.h>
 #include <siri/net/clserver.h>
+#include <siri/net/wqueue.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct pkg_send_s
-{
-    sirinet_pkg_t * pkg;
-    sirinet_stream_t * client;
-} pkg_send_t;
-
-static void PKG_write_cb(uv_write_t * req, int status);
-
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  * (do not forget to run free(...) on the result. )
@@ -135,41 +128,11 @@ sirinet_pkg_t * sirinet_pkg_err(
  */
 int sirinet_pkg_send(sirinet_stream_t * client, sirinet_pkg_t * pkg)
 {
-    uv_write_t * req = (uv_write_t *) malloc(sizeof(uv_write_t));
-
-    if (req == NULL)
-    {
-        ERR_ALLOC
-        free(pkg);
-        return -1;
-    }
-
-    pkg_send_t * data = (pkg_send_t *) malloc(sizeof(pkg_send_t));
-
-    if (data == NULL)
+    if (sirinet_wqueue_write(client, pkg, NULL, NULL))
     {
-        ERR_ALLOC
         free(pkg);
-        free(req);
         return -1;
     }
-
-    /* increment client reference counter */
-    sirinet_stream_incref(client);
-
-    data->client = client;
-    data->pkg = pkg;
-    req->data = data;
-
-    /* set the correct check bit */
-    pkg->checkbit = pkg->tp ^ 255;
-
-    uv_buf_t wrbuf = uv_buf_init(
-            (char *) pkg,
-            sizeof(sirinet_pkg_t) + pkg->len);
-
-    uv_write(req, client->stream, &wrbuf, 1, PKG_write_cb);
-
     return 0;
 }
 
@@ -191,19 +154,3 @@ sirinet_pkg_t * sirinet_pkg_dup(sirinet_pkg_t * pkg)
     }
     return dup;
 }
-
-static void PKG_write_cb(uv_write_t * req, int status)
-{
-    if (status)
-    {
-        log_error("Socket write error: %s", uv_strerror(status));
-    }
-
-    pkg_send_t * data = (pkg_send_t *) req->data;
-
-    sirinet_stream_decref(data->client);
-
-    free(data->pkg);
-    free(data);
-    free(req);
-}
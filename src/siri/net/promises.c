@@ -6,6 +6,7 @@
 #include <siri/err.h>
 #include <siri/net/promise.h>
 #include <siri/net/promises.h>
+#include <timeit/timeit.h>
 
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
@@ -75,6 +76,8 @@ void sirinet_promises_on_response(
 {
     sirinet_promises_t * promises = (sirinet_promises_t *) promise->data;
 
+    promise->latency = timeit_get(&promise->start);
+
     if (status)
     {
         /* we already have a log entry so this can be a debug log */
@@ -40,6 +40,7 @@ const char * sirinet_cproto_server_str(cproto_server_t n)
     case CPROTO_RES_AUTH_SUCCESS: return "CPROTO_RES_AUTH_SUCCESS";
     case CPROTO_RES_ACK: return "CPROTO_RES_ACK";
     case CPROTO_RES_FILE: return "CPROTO_RES_FILE";
+    case CPROTO_RES_QUERY_CHUNK: return "CPROTO_RES_QUERY_CHUNK";
 
     case CPROTO_ACK_SERVICE: return "CPROTO_ACK_SERVICE";
     case CPROTO_ACK_SERVICE_DATA: return "CPROTO_ACK_SERVICE_DATA";
@@ -9,21 +9,32 @@
 #include <siri/net/stream.h>
 #include <siri/net/pipe.h>
 #include <siri/net/tcp.h>
+#include <siri/net/wqueue.h>
 #include <siri/siri.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define MAX_ALLOWED_PKG_SIZE 20971520      /* 20 MB  */
 
+/*
+ * Read buffers of this size are shared between connections. A stream only
+ * holds a buffer while a package is partially received, so idle connections
+ * do not keep a buffer.
+ */
+#define STREAM_BUF_SZ 65536                 /* 64 KB  */
+#define STREAM_POOL_SZ 64
+
 #define QUIT_STREAM                     \
-    free(client->buf);                  \
-    client->buf = NULL;                 \
-    client->len = 0;                    \
-    client->size = 0;                   \
+    STREAM_release_buf(client);         \
     client->on_data = NULL;             \
     sirinet_stream_decref(client);      \
     return;
 
+static char * stream_pool[STREAM_POOL_SZ];
+static size_t stream_pool_len = 0;
+
+static void STREAM_release_buf(sirinet_stream_t * client);
+
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  *
@@ -44,10 +55,12 @@ sirinet_stream_t * sirinet_stream_new(sirinet_stream_tp_t tp, on_data_cb_t cb)
     client->on_data = cb;
     client->buf = NULL;
     client->len = 0;
-    client->size = -1; /* this will force allocating on first request */
+    client->pos = 0;
+    client->size = 0;
     client->origin = NULL;
     client->siridb = NULL;
     client->ref = 1;
+    client->wqueue = NULL;
 
     switch(tp)
     {
@@ -103,23 +116,25 @@ char * sirinet_stream_name(sirinet_stream_t * client)
  */
 void sirinet_stream_alloc_buffer(
         uv_handle_t * handle,
-        size_t suggested_size,
+        size_t suggested_size __attribute__((unused)),
         uv_buf_t * buf)
 {
     sirinet_stream_t * client = (sirinet_stream_t *) handle->data;
 
-    if (!client->len && client->size > RESET_BUF_SIZE)
+    if (client->buf == NULL)
     {
-        free(client->buf);
-        client->buf = (char *) malloc(suggested_size);
+        client->buf = (stream_pool_len) ?
+                stream_pool[--stream_pool_len] :
+                (char *) malloc(STREAM_BUF_SZ);
         if (client->buf == NULL)
         {
             ERR_ALLOC
             buf->len = 0;
             return;
         }
-        client->size = suggested_size;
+        client->size = STREAM_BUF_SZ;
         client->len = 0;
+        client->pos = 0;
     }
     buf->base = client->buf + client->len;
     buf->len = client->size - client->len;
@@ -127,11 +142,16 @@ void sirinet_stream_alloc_buffer(
 
 /*
  * This function can raise a SIGNAL.
+ *
+ * All complete packages in the buffer are handled in a single loop and are
+ * passed to on_data() without copying. Only the remainder of a partially
+ * received package is moved to the start of the buffer, at most once for
+ * each read.
  */
 void sirinet_stream_on_data(
         uv_stream_t * uvclient,
         ssize_t nread,
-        const uv_buf_t * buf)
+        const uv_buf_t * buf __attribute__((unused)))
 {
     sirinet_stream_t * client = uvclient->data;
     sirinet_pkg_t * pkg;
@@ -168,34 +188,58 @@ void sirinet_stream_on_data(
 
     client->len += nread;
 
-    if (client->len < sizeof(sirinet_pkg_t))
+    while (client->len - client->pos >= sizeof(sirinet_pkg_t))
+    {
+        pkg = (sirinet_pkg_t *) (client->buf + client->pos);
+        check = pkg->tp ^ 255;
+        if (check != pkg->checkbit ||
+                ((      client->tp == STREAM_TCP_CLIENT ||
+                        client->tp == STREAM_PIPE_CLIENT) &&
+                        pkg->len > MAX_ALLOWED_PKG_SIZE))
+        {
+            char * name = sirinet_stream_name(client);
+            if (name != NULL)
+            {
+                log_error(
+                    "Got an illegal package or size too large from '%s', "
+                    "closing connection "
+                    "(pid: %" PRIu16 ", len: %" PRIu32 ", tp: %" PRIu8 ")",
+                    name, pkg->pid, pkg->len, pkg->tp);
+                free(name);
+            }
+            QUIT_STREAM
+        }
+
+        total_sz = sizeof(sirinet_pkg_t) + pkg->len;
+        if (client->len - client->pos < total_sz)
+        {
+            break;
+        }
+
+        client->pos += total_sz;
+
+        /* call on-data function */
+        (*client->on_data)(client, pkg);
+    }
+
+    if (client->pos == client->len)
     {
+        /* everything is handled, the buffer is no longer required */
+        STREAM_release_buf(client);
         return;
     }
 
-    pkg = (sirinet_pkg_t *) client->buf;
-    check = pkg->tp ^ 255;
-    if (check != pkg->checkbit ||
-            ((      client->tp == STREAM_TCP_CLIENT ||
-                    client->tp == STREAM_PIPE_CLIENT) &&
-                    pkg->len > MAX_ALLOWED_PKG_SIZE))
+    if (client->pos)
     {
-        char * name = sirinet_stream_name(client);
-        if (name != NULL)
-        {
-            log_error(
-                "Got an illegal package or size too large from '%s', "
-                "closing connection "
-                "(pid: %" PRIu16 ", len: %" PRIu32 ", tp: %" PRIu8 ")",
-                name, pkg->pid, pkg->len, pkg->tp);
-            free(name);
-        }
-        QUIT_STREAM
+        client->len -= client->pos;
+        memmove(client->buf, client->buf + client->pos, client->len);
+        client->pos = 0;
     }
 
-    total_sz = sizeof(sirinet_pkg_t) + pkg->len;
-    if (client->len < total_sz)
+    if (client->len >= sizeof(sirinet_pkg_t))
     {
+        pkg = (sirinet_pkg_t *) client->buf;
+        total_sz = sizeof(sirinet_pkg_t) + pkg->len;
         if (client->size < total_sz)
         {
             char * tmp = realloc(client->buf, total_sz);
@@ -210,19 +254,17 @@ void sirinet_stream_on_data(
             client->buf = tmp;
             client->size = total_sz;
         }
-        return;
     }
+}
 
-    /* call on-data function */
-    (*client->on_data)(client, pkg);
-
-    client->len -= total_sz;
-
-    if (client->len > 0)
+/*
+ * Free buffers which are kept in the pool.
+ */
+void sirinet_stream_pool_destroy(void)
+{
+    while (stream_pool_len)
     {
-        /* move data and call sirinet_stream_on_data() function again */
-        memmove(client->buf, client->buf + total_sz, client->len);
-        sirinet_stream_on_data(uvclient, 0, buf);
+        free(stream_pool[--stream_pool_len]);
     }
 }
 
@@ -272,11 +314,38 @@ void sirinet__stream_free(uv_stream_t * uvclient)
         siri.client = NULL;
         break;
     }
-    free(client->buf);
+    if (client->wqueue != NULL)
+    {
+        sirinet_wqueue_free(client->wqueue);
+    }
+    STREAM_release_buf(client);
     free(client);
     free(uvclient);
 }
 
+/*
+ * Return the stream buffer to the pool, or free the buffer when the pool is
+ * full or when the buffer has grown for a large package.
+ */
+static void STREAM_release_buf(sirinet_stream_t * client)
+{
+    if (client->buf != NULL)
+    {
+        if (client->size == STREAM_BUF_SZ && stream_pool_len < STREAM_POOL_SZ)
+        {
+            stream_pool[stream_pool_len++] = client->buf;
+        }
+        else
+        {
+            free(client->buf);
+        }
+        client->buf = NULL;
+    }
+    client->len = 0;
+    client->pos = 0;
+    client->size = 0;
+}
+
 
 
 
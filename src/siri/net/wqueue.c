@@ -0,0 +1,314 @@
+/*
+ * wqueue.c - Write queue for coalescing packages on a stream.
+ *
+ * A stream has at most one write in progress. Packages which are sent while
+ * a write is in progress are queued and written together, using a single
+ * write call with two buffers for each package, as soon as the current write
+ * has finished.
+ */
+#include <logger/logger.h>
+#include <siri/err.h>
+#include <siri/net/wqueue.h>
+#include <siri/siri.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WQUEUE_INITIAL_SIZE 8
+
+static uint64_t wqueue_packages = 0;    /* packages written             */
+static uint64_t wqueue_writes = 0;      /* write calls on streams       */
+
+static sirinet_witems_t * WQUEUE_items_new(void);
+static int WQUEUE_append(
+        sirinet_witems_t * witems,
+        sirinet_pkg_t * pkg,
+        sirinet_wqueue_cb cb,
+        void * data);
+static void WQUEUE_flush(sirinet_wqueue_t * wqueue);
+static void WQUEUE_write_cb(uv_write_t * req, int status);
+static void WQUEUE_error_cb(uv_timer_t * timer);
+
+/*
+ * Returns NULL and raises a SIGNAL in case an error has occurred.
+ */
+sirinet_wqueue_t * sirinet_wqueue_new(sirinet_stream_t * client)
+{
+    sirinet_wqueue_t * wqueue =
+            (sirinet_wqueue_t *) malloc(sizeof(sirinet_wqueue_t));
+    if (wqueue == NULL)
+    {
+        ERR_ALLOC
+        return NULL;
+    }
+
+    wqueue->client = client;
+    wqueue->writing = WQUEUE_items_new();
+    wqueue->pending = WQUEUE_items_new();
+    wqueue->bufs = NULL;
+    wqueue->nbufs = 0;
+    wqueue->pending_size = 0;
+    wqueue->err = 0;
+    wqueue->req.data = wqueue;
+
+    if (wqueue->writing == NULL || wqueue->pending == NULL)
+    {
+        sirinet_wqueue_free(wqueue);
+        ERR_ALLOC
+        return NULL;
+    }
+
+    return wqueue;
+}
+
+/*
+ * Destroy a write queue. This function should only be called when no write
+ * is in progress which is true when the stream is destroyed since each write
+ * holds a reference to the stream.
+ */
+void sirinet_wqueue_free(sirinet_wqueue_t * wqueue)
+{
+    if (wqueue->writing != NULL)
+    {
+        free(wqueue->writing->items);
+        free(wqueue->writing);
+    }
+    if (wqueue->pending != NULL)
+    {
+        free(wqueue->pending->items);
+        free(wqueue->pending);
+    }
+    free(wqueue->bufs);
+    free(wqueue);
+}
+
+/*
+ * Queue a package for writing to a stream. The write starts immediately when
+ * no other write is in progress for this stream.
+ *
+ * Returns 0 if successful or -1 in case of an error, in which case 'cb' is
+ * not called. (a SIGNAL is raised in case of an error)
+ */
+int sirinet_wqueue_write(
+        sirinet_stream_t * client,
+        sirinet_pkg_t * pkg,
+        sirinet_wqueue_cb cb,
+        void * data)
+{
+    if (client->wqueue == NULL &&
+        (client->wqueue = sirinet_wqueue_new(client)) == NULL)
+    {
+        return -1;  /* signal is raised */
+    }
+
+    /* set the correct check bit */
+    pkg->checkbit = pkg->tp ^ 255;
+
+    if (WQUEUE_append(client->wqueue->pending, pkg, cb, data))
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
+    client->wqueue->pending_size += sizeof(sirinet_pkg_t) + pkg->len;
+
+    if (!client->wqueue->writing->len)
+    {
+        WQUEUE_flush(client->wqueue);
+    }
+
+    return 0;
+}
+
+/*
+ * Returns the number of bytes which are not yet written to the stream. This
+ * includes both the write in progress and the packages which are queued for
+ * the next write.
+ */
+size_t sirinet_wqueue_pending_size(sirinet_stream_t * client)
+{
+    return client->stream->write_queue_size +
+            ((client->wqueue == NULL) ? 0 : client->wqueue->pending_size);
+}
+
+/*
+ * Returns the average number of packages for each write call since the
+ * start of SiriDB, or 0 when nothing is written yet.
+ */
+double sirinet_wqueue_packages_per_write(void)
+{
+    return (wqueue_writes) ?
+            (double) wqueue_packages / (double) wqueue_writes : 0.0;
+}
+
+static sirinet_witems_t * WQUEUE_items_new(void)
+{
+    sirinet_witems_t * witems =
+            (sirinet_witems_t *) malloc(sizeof(sirinet_witems_t));
+    if (witems != NULL)
+    {
+        witems->len = 0;
+        witems->size = 0;
+        witems->items = NULL;
+    }
+    return witems;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int WQUEUE_append(
+        sirinet_witems_t * witems,
+        sirinet_pkg_t * pkg,
+        sirinet_wqueue_cb cb,
+        void * data)
+{
+    sirinet_witem_t * witem;
+
+    if (witems->len == witems->size)
+    {
+        size_t size = witems->size ? witems->size * 2 : WQUEUE_INITIAL_SIZE;
+        sirinet_witem_t * tmp = (sirinet_witem_t *) realloc(
+                witems->items,
+                size * sizeof(sirinet_witem_t));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        witems->items = tmp;
+        witems->size = size;
+    }
+
+    witem = witems->items + witems->len++;
+
+    memcpy(witem->header, pkg, sizeof(sirinet_pkg_t));
+    witem->pkg = pkg;
+    witem->cb = cb;
+    witem->data = data;
+
+    return 0;
+}
+
+/*
+ * Write all pending items. The pending items become the items which are
+ * being written, so new items can be queued while writing.
+ */
+static void WQUEUE_flush(sirinet_wqueue_t * wqueue)
+{
+    sirinet_witems_t * witems = wqueue->pending;
+    sirinet_witem_t * witem;
+    size_t i, nbufs = witems->len * 2;
+    int rc;
+
+    if (nbufs > wqueue->nbufs)
+    {
+        uv_buf_t * tmp = (uv_buf_t *) realloc(
+                wqueue->bufs,
+                nbufs * sizeof(uv_buf_t));
+        if (tmp == NULL)
+        {
+            ERR_ALLOC
+            rc = UV_ENOBUFS;
+            goto failed;
+        }
+        wqueue->bufs = tmp;
+        wqueue->nbufs = nbufs;
+    }
+
+    for (i = 0; i < witems->len; i++)
+    {
+        witem = witems->items + i;
+        wqueue->bufs[i * 2] = uv_buf_init(
+                (char *) witem->header,
+                sizeof(sirinet_pkg_t));
+        wqueue->bufs[i * 2 + 1] = uv_buf_init(
+                (char *) witem->pkg->data,
+                witem->pkg->len);
+    }
+
+    wqueue_packages += witems->len;
+    wqueue_writes++;
+
+    rc = uv_write(
+            &wqueue->req,
+            wqueue->client->stream,
+            wqueue->bufs,
+            nbufs,
+            WQUEUE_write_cb);
+
+failed:
+    wqueue->pending = wqueue->writing;
+    wqueue->writing = witems;
+    wqueue->pending_size = 0;
+
+    /* the stream must exist until the write has finished */
+    sirinet_stream_incref(wqueue->client);
+
+    if (rc)
+    {
+        /*
+         * The call-back is not called by libuv. Callers do not expect
+         * call-backs before the write function has returned, so the items
+         * are finished with the error status on the next loop iteration.
+         * (the items stay in the write, new items are kept pending)
+         */
+        uv_timer_t * timer = (uv_timer_t *) malloc(sizeof(uv_timer_t));
+
+        log_error("Cannot write to stream: %s", uv_strerror(rc));
+
+        if (timer == NULL)
+        {
+            ERR_ALLOC
+            return;
+        }
+
+        wqueue->err = rc;
+        timer->data = wqueue;
+        uv_timer_init(siri.loop, timer);
+        uv_timer_start(timer, WQUEUE_error_cb, 0, 0);
+    }
+}
+
+static void WQUEUE_error_cb(uv_timer_t * timer)
+{
+    sirinet_wqueue_t * wqueue = (sirinet_wqueue_t *) timer->data;
+
+    uv_close((uv_handle_t *) timer, (uv_close_cb) free);
+
+    WQUEUE_write_cb(&wqueue->req, wqueue->err);
+}
+
+static void WQUEUE_write_cb(uv_write_t * req, int status)
+{
+    sirinet_wqueue_t * wqueue = (sirinet_wqueue_t *) req->data;
+    sirinet_stream_t * client = wqueue->client;
+    sirinet_witems_t * witems = wqueue->writing;
+    sirinet_witem_t * witem;
+    size_t i;
+
+    if (status)
+    {
+        log_error("Socket write error: %s", uv_strerror(status));
+    }
+
+    for (i = 0; i < witems->len; i++)
+    {
+        witem = witems->items + i;
+        if (witem->cb == NULL)
+        {
+            free(witem->pkg);
+        }
+        else
+        {
+            witem->cb(witem->data, status);
+        }
+    }
+
+    witems->len = 0;
+
+    if (wqueue->pending->len)
+    {
+        WQUEUE_flush(wqueue);
+    }
+
+    sirinet_stream_decref(client);
+}
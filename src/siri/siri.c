@@ -27,6 +27,7 @@
 #include <siri/db/groups.h>
 #include <siri/db/pools.h>
 #include <siri/db/props.h>
+#include <siri/db/re.h>
 #include <siri/db/series.h>
 #include <siri/db/server.h>
 #include <siri/db/servers.h>
@@ -39,6 +40,7 @@
 #include <siri/net/pipe.h>
 #include <siri/net/stream.h>
 #include <siri/siri.h>
+#include <siri/slowlog.h>
 #include <siri/version.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -82,6 +84,7 @@ siri_t siri = {
         .optimize=NULL,
         .heartbeat=NULL,
         .buffersync=NULL,
+        .slowlog=NULL,
         .cfg=NULL,
         .args=NULL,
         .status=SIRI_STATUS_LOADING,
@@ -191,6 +194,9 @@ int siri_start(void)
     /* initialize buffer-sync task (bind siri.buffersync) */
     siri_buffersync_init(&siri);
 
+    /* initialize slow query log (bind siri.slowlog) */
+    siri_slowlog_init(&siri);
+
     /* initialize backup (bind siri.backup) */
     if (siri_backup_init(&siri))
     {
@@ -226,12 +232,18 @@ void siri_free(void)
         }
     }
 
+    /* close the slow query log, pending writes are finished */
+    siri_slowlog_destroy(&siri);
+
     /* first free the File Handler. (this will close all open shard files) */
     siri_fh_free(siri.fh);
 
     /* this will free each SiriDB database and the list */
     llist_free_cb(siri.siridb_list, (llist_cb) siridb_decref_cb, NULL);
 
+    /* free cached regular expressions */
+    siridb_re_destroy();
+
     /* free siridb grammar */
     cleri_grammar_free(siri.grammar);
 
@@ -244,6 +256,9 @@ void siri_free(void)
     /* free config */
     siri_cfg_destroy(&siri);
 
+    /* free pooled stream read buffers */
+    sirinet_stream_pool_destroy();
+
     /* free event loop */
     free(siri.loop);
 }
@@ -0,0 +1,278 @@
+/*
+ * slowlog.c - Log queries which exceed the slow query threshold.
+ *
+ * A sample of the queries received from clients is profiled. When such
+ * a query takes longer than the threshold, an entry with the query, user,
+ * selected time range, counters, latency per pool and the profile is
+ * written as one JSON line to the slow query log. Writing is done
+ * asynchronously using the event loop.
+ */
+#include <fcntl.h>
+#include <logger/logger.h>
+#include <siri/db/profile.h>
+#include <siri/db/user.h>
+#include <siri/slowlog.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SLOWLOG_FILENAME "slow_query.log"
+
+static siri_slowlog_t slowlog;
+
+static void SLOWLOG_write_cb(uv_fs_t * req);
+static void SLOWLOG_print_str(FILE * fp, const char * str);
+static void SLOWLOG_print_ts(FILE * fp, uint64_t ts, uint64_t none);
+
+/*
+ * Open the slow query log when a threshold is configured. In case the file
+ * cannot be opened the slow query log stays disabled.
+ */
+void siri_slowlog_init(siri_t * siri)
+{
+    uv_fs_t req;
+    int rc;
+
+    siri->slowlog = NULL;
+
+    if (siri->cfg->slow_query_threshold == 0)
+    {
+        return;
+    }
+
+    char fn[strlen(siri->cfg->default_db_path) + strlen(SLOWLOG_FILENAME) + 1];
+    sprintf(fn, "%s%s", siri->cfg->default_db_path, SLOWLOG_FILENAME);
+
+    rc = uv_fs_open(
+            siri->loop,
+            &req,
+            fn,
+            O_WRONLY | O_APPEND | O_CREAT,
+            0600,
+            NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (rc < 0)
+    {
+        log_error("Cannot open slow query log '%s' (%s)",
+                fn,
+                uv_strerror(rc));
+        return;
+    }
+
+    slowlog.fd = rc;
+    slowlog.threshold = siri->cfg->slow_query_threshold;
+    slowlog.sample_rate = siri->cfg->slow_query_sample_rate;
+
+    siri->slowlog = &slowlog;
+
+    log_info("Log queries slower than %" PRIu32 "ms to '%s'",
+            slowlog.threshold,
+            fn);
+}
+
+/*
+ * Close the slow query log. Must be called after the event loop has stopped
+ * so all pending writes are finished.
+ */
+void siri_slowlog_destroy(siri_t * siri)
+{
+    if (siri->slowlog != NULL)
+    {
+        close(slowlog.fd);
+        siri->slowlog = NULL;
+    }
+}
+
+/*
+ * Returns 1 when a query should be profiled for the slow query log.
+ */
+int siri_slowlog_sample(siri_t * siri)
+{
+    return siri->slowlog != NULL && (
+            slowlog.sample_rate >= 100 ||
+            (uint32_t) (rand() % 100) < slowlog.sample_rate);
+}
+
+/*
+ * Write an entry to the slow query log if the query is profiled and has
+ * exceeded the threshold. This function must be called before the profile
+ * is destroyed.
+ *
+ * Errors are logged but do not raise a signal since the slow query log is
+ * not critical.
+ */
+void siri_slowlog_query(siridb_query_t * query)
+{
+    siridb_profile_t * profile = query->profile;
+    struct timespec now;
+    uv_fs_t * req;
+    uv_buf_t wrbuf;
+    char * buf;
+    size_t size;
+    FILE * fp;
+    double duration;
+    const char * sep = "";
+    size_t i;
+
+    if (    siri.slowlog == NULL ||
+            profile == NULL ||
+            (~query->flags & SIRIDB_QUERY_FLAG_MASTER))
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    duration = (double) (now.tv_sec - query->start.tv_sec) +
+            (double) (now.tv_nsec - query->start.tv_nsec) / 1000000000.0;
+
+    if (duration * 1000.0 < (double) slowlog.threshold)
+    {
+        return;
+    }
+
+    if ((fp = open_memstream(&buf, &size)) == NULL)
+    {
+        log_error("Cannot create slow query log entry");
+        return;
+    }
+
+    fprintf(fp, "{\"time\": %ld, \"database\": ", (long) query->start.tv_sec);
+    SLOWLOG_print_str(fp, query->client->siridb->dbname);
+    fprintf(fp, ", \"user\": ");
+    SLOWLOG_print_str(fp, ((siridb_user_t *) query->client->origin)->name);
+    fprintf(fp, ", \"duration\": %.4f, \"query\": ", duration);
+    SLOWLOG_print_str(fp, query->q);
+    fprintf(fp, ", \"start\": ");
+    SLOWLOG_print_ts(fp, profile->start_ts, 0);
+    fprintf(fp, ", \"end\": ");
+    SLOWLOG_print_ts(fp, profile->end_ts, UINT64_MAX);
+    fprintf(fp,
+            ", \"series\": %" PRIu64
+            ", \"points\": %" PRIu64
+            ", \"chunks\": %" PRIu64
+            ", \"bytes\": %" PRIu64
+            ", \"pools\": {",
+            profile->series,
+            profile->points,
+            profile->chunks,
+            profile->bytes);
+
+    for (i = 0; i < profile->npools; i++)
+    {
+        if (profile->pools[i] < 0.0f)
+        {
+            /* this pool was not involved in the query */
+            continue;
+        }
+        fprintf(fp, "%s\"%zu\": %.4f", sep, i, profile->pools[i]);
+        sep = ", ";
+    }
+
+    fprintf(fp, "}, \"profile\": {");
+
+    for (i = 0; i < SIRIDB_PROFILE_STAGES; i++)
+    {
+        fprintf(fp, "%s\"%s\": %.4f",
+                i ? ", " : "",
+                siridb_profile_strstage((siridb_profile_stage_t) i),
+                profile->stages[i]);
+    }
+
+    fprintf(fp, "}}\n");
+
+    if (fclose(fp) != 0)
+    {
+        log_error("Cannot create slow query log entry");
+        free(buf);
+        return;
+    }
+
+    req = (uv_fs_t *) malloc(sizeof(uv_fs_t));
+    if (req == NULL)
+    {
+        log_error("Cannot create slow query log entry");
+        free(buf);
+        return;
+    }
+
+    req->data = buf;
+    wrbuf = uv_buf_init(buf, size);
+
+    if (uv_fs_write(siri.loop, req, slowlog.fd, &wrbuf, 1, -1,
+            SLOWLOG_write_cb))
+    {
+        log_error("Cannot write to the slow query log");
+        free(buf);
+        free(req);
+    }
+}
+
+static void SLOWLOG_write_cb(uv_fs_t * req)
+{
+    if (req->result < 0)
+    {
+        log_error("Cannot write to the slow query log (%s)",
+                uv_strerror((int) req->result));
+    }
+    free(req->data);
+    uv_fs_req_cleanup(req);
+    free(req);
+}
+
+/*
+ * Print a JSON string.
+ */
+static void SLOWLOG_print_str(FILE * fp, const char * str)
+{
+    fputc('"', fp);
+    for (; *str; str++)
+    {
+        switch (*str)
+        {
+        case '"':
+            fputs("\\\"", fp);
+            break;
+        case '\\':
+            fputs("\\\\", fp);
+            break;
+        case '\n':
+            fputs("\\n", fp);
+            break;
+        case '\r':
+            fputs("\\r", fp);
+            break;
+        case '\t':
+            fputs("\\t", fp);
+            break;
+        default:
+            if ((unsigned char) *str < 0x20)
+            {
+                fprintf(fp, "\\u%04x", (unsigned char) *str);
+            }
+            else
+            {
+                fputc(*str, fp);
+            }
+        }
+    }
+    fputc('"', fp);
+}
+
+/*
+ * Print a time stamp or null when the time stamp equals none.
+ */
+static void SLOWLOG_print_ts(FILE * fp, uint64_t ts, uint64_t none)
+{
+    if (ts == none)
+    {
+        fputs("null", fp);
+    }
+    else
+    {
+        fprintf(fp, "%" PRIu64, ts);
+    }
+}
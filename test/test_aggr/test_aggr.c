@@ -2,6 +2,7 @@
 #include "../test.h"
 #include <siri/db/points.h>
 #include <siri/db/aggregate.h>
+#include <siri/db/partial.h>
 
 
 #define SIRIDB_MAX_SIZE_ERR_MSG 1024
@@ -368,6 +369,93 @@ static int test_variance(void)
     return test_end();
 }
 
+static int test_partial(void)
+{
+    test_start("aggr (partial)");
+
+    uint32_t gids[8] = {
+        CLERI_GID_F_COUNT,
+        CLERI_GID_F_SUM,
+        CLERI_GID_F_MIN,
+        CLERI_GID_F_MAX,
+        CLERI_GID_F_MEAN,
+        CLERI_GID_F_VARIANCE,
+        CLERI_GID_F_PVARIANCE,
+        CLERI_GID_F_STDDEV
+    };
+    uint64_t group_by[3] = {0, 5, 6};
+    siridb_points_t * aggrp, * combined, * points = prepare_points();
+    siridb_points_t * even = siridb_points_new(5, TP_INT);
+    siridb_points_t * odd = siridb_points_new(5, TP_INT);
+    vec_t * partials;
+    unsigned int i, g, j;
+
+    /* split the points like they would be spread over two pools */
+    for (i = 0; i < points->len; i++)
+    {
+        siridb_points_add_point(
+                (i % 2) ? odd : even,
+                &(points->data + i)->ts,
+                &(points->data + i)->val);
+    }
+
+    aggr.limit = 0;
+    aggr.offset = 0;
+
+    for (i = 0; i < 8; i++)
+    {
+        for (g = 0; g < 3; g++)
+        {
+            aggr.gid = gids[i];
+            aggr.group_by = group_by[g];
+
+            _assert (siridb_partial_size(&aggr) > 0);
+
+            partials = vec_new(VEC_DEFAULT_SIZE);
+            _assert (siridb_partial_append(
+                    &partials, even, &aggr, err_msg) == 0);
+            _assert (siridb_partial_append(
+                    &partials, odd, &aggr, err_msg) == 0);
+
+            combined = siridb_partial_combine(partials, &aggr, err_msg);
+            aggrp = siridb_aggregate_run(points, &aggr, err_msg);
+
+            _assert (combined != NULL && aggrp != NULL);
+            _assert (combined->len == aggrp->len);
+            _assert (combined->tp == aggrp->tp);
+
+            for (j = 0; j < aggrp->len; j++)
+            {
+                _assert ((combined->data + j)->ts == (aggrp->data + j)->ts);
+                _assert ((aggrp->tp == TP_INT) ?
+                        (combined->data + j)->val.int64 ==
+                                (aggrp->data + j)->val.int64 :
+                        fabs((combined->data + j)->val.real -
+                                (aggrp->data + j)->val.real) < 1e-9);
+            }
+
+            siridb_points_free(combined);
+            siridb_points_free(aggrp);
+            siridb_partial_free(partials);
+        }
+    }
+
+    /* limit() cannot be used with partial aggregation */
+    aggr.gid = CLERI_GID_F_MEAN;
+    aggr.limit = 2;
+    _assert (siridb_partial_size(&aggr) == 0);
+
+    aggr.gid = CLERI_GID_F_MEDIAN;
+    aggr.limit = 0;
+    _assert (siridb_partial_size(&aggr) == 0);
+
+    siridb_points_free(even);
+    siridb_points_free(odd);
+    siridb_points_free(points);
+
+    return test_end();
+}
+
 int main()
 {
     return (
@@ -384,6 +472,7 @@ int main()
         test_stddev() ||
         test_sum() ||
         test_variance() ||
+        test_partial() ||
         0
     );
 }
@@ -0,0 +1,140 @@
+#include "../test.h"
+#include <bmap/bmap.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ids are tested in three containers where the second one is dense */
+#define MAX_ID (3 << 16)
+
+static uint8_t a[MAX_ID];
+static uint8_t b[MAX_ID];
+
+static bmap_t * fill(uint8_t * set, unsigned int seed)
+{
+    bmap_t * bmap = bmap_new();
+    uint32_t id;
+
+    srand(seed);
+    memset(set, 0, MAX_ID);
+
+    for (id = 0; id < MAX_ID; id++)
+    {
+        /* dense in the second container, sparse in the others */
+        if (rand() % ((id >> 16) == 1 ? 2 : 50) == 0)
+        {
+            set[id] = 1;
+            _assert (bmap_add(bmap, id) == 1);
+        }
+    }
+    return bmap;
+}
+
+static int check_cb(uint32_t id, uint8_t * set)
+{
+    return set[id] != 1 || !(set[id] = 2) ? -1 : 0;
+}
+
+static int equal(bmap_t * bmap, uint8_t * set)
+{
+    size_t n = 0;
+    uint32_t id;
+
+    if (bmap_walk(bmap, (bmap_cb) check_cb, set))
+    {
+        return 0;
+    }
+    for (id = 0; id < MAX_ID; id++)
+    {
+        if (set[id] == 1)
+        {
+            return 0;
+        }
+        n += set[id] == 2;
+        set[id] = set[id] == 2;
+    }
+    return n == bmap->len;
+}
+
+int main()
+{
+    test_start("bmap");
+
+    bmap_t * bmap_a, * bmap_b;
+    uint32_t id;
+
+    /* test add, has and pop */
+    {
+        bmap_a = bmap_new();
+        _assert (bmap_add(bmap_a, 5) == 1);
+        _assert (bmap_add(bmap_a, 5) == 0);
+        _assert (bmap_add(bmap_a, 70000) == 1);
+        _assert (bmap_has(bmap_a, 5) == 1);
+        _assert (bmap_has(bmap_a, 6) == 0);
+        _assert (bmap_a->len == 2 && bmap_a->n == 2);
+        _assert (bmap_pop(bmap_a, 70000) == 1);
+        _assert (bmap_pop(bmap_a, 70000) == 0);
+        _assert (bmap_a->len == 1 && bmap_a->n == 1);
+        bmap_clear(bmap_a);
+        _assert (bmap_a->len == 0 && bmap_a->n == 0);
+        bmap_free(bmap_a);
+    }
+
+    /* test union */
+    {
+        bmap_a = fill(a, 1);
+        bmap_b = fill(b, 2);
+        _assert (equal(bmap_a, a));
+        _assert (bmap_union(bmap_a, bmap_b) == 0);
+        for (id = 0; id < MAX_ID; id++)
+        {
+            a[id] |= b[id];
+        }
+        _assert (equal(bmap_a, a));
+        bmap_free(bmap_a);
+        bmap_free(bmap_b);
+    }
+
+    /* test intersection */
+    {
+        bmap_a = fill(a, 3);
+        bmap_b = fill(b, 4);
+        _assert (bmap_intersection(bmap_a, bmap_b) == 0);
+        for (id = 0; id < MAX_ID; id++)
+        {
+            a[id] &= b[id];
+        }
+        _assert (equal(bmap_a, a));
+        bmap_free(bmap_a);
+        bmap_free(bmap_b);
+    }
+
+    /* test difference */
+    {
+        bmap_a = fill(a, 5);
+        bmap_b = fill(b, 6);
+        _assert (bmap_difference(bmap_a, bmap_b) == 0);
+        for (id = 0; id < MAX_ID; id++)
+        {
+            a[id] &= !b[id];
+        }
+        _assert (equal(bmap_a, a));
+        bmap_free(bmap_a);
+        bmap_free(bmap_b);
+    }
+
+    /* test symmetric difference */
+    {
+        bmap_a = fill(a, 7);
+        bmap_b = fill(b, 8);
+        _assert (bmap_symmetric_difference(bmap_a, bmap_b) == 0);
+        for (id = 0; id < MAX_ID; id++)
+        {
+            a[id] ^= b[id];
+        }
+        _assert (equal(bmap_a, a));
+        bmap_free(bmap_a);
+        bmap_free(bmap_b);
+    }
+
+    return test_end();
+}
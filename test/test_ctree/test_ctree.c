@@ -19,6 +19,27 @@ static char * entries[] = {
     "entry-last",
 };
 
+static int count_cb(void * data __attribute__((unused)), void * args)
+{
+    return args == NULL;
+}
+
+static int collect_cb(void * data, void * args)
+{
+    char *** pt = (char ***) args;
+    *(*pt)++ = (char *) data;
+    return 1;
+}
+
+static size_t after(ct_t * ct, const char * key, size_t n, char ** found)
+{
+    size_t m = n;
+    char ** pt = found;
+    ct_valuesn_after(ct, key, &m, collect_cb, &pt);
+    _assert ((size_t) (pt - found) == n - m);
+    return n - m;
+}
+
 int main()
 {
     test_start("ctree");
@@ -75,6 +96,64 @@ int main()
         }
     }
 
+    /* test values with prefix */
+    {
+        _assert (ct_values_prefix(ctree, "entry", 5, count_cb, NULL) == 4);
+        _assert (ct_values_prefix(ctree, "entry 1", 7, count_cb, NULL) == 3);
+        _assert (ct_values_prefix(ctree, "entry-", 6, count_cb, NULL) == 1);
+        _assert (ct_values_prefix(ctree, "entry 13", 8, count_cb, NULL) == 0);
+        _assert (ct_values_prefix(ctree, "F", 1, count_cb, NULL) == 3);
+        _assert (ct_values_prefix(ctree, "Fi", 2, count_cb, NULL) == 2);
+        _assert (ct_values_prefix(
+                ctree, "Fifth entry!", 12, count_cb, NULL) == 0);
+        _assert (ct_values_prefix(ctree, "x", 1, count_cb, NULL) == 0);
+        _assert (ct_values_prefix(ctree, "", 0, count_cb, NULL) == 14);
+    }
+
+    /* test ordered values after a key */
+    {
+        char * found[14];
+        _assert (after(ctree, "", 14, found) == 14);
+        _assert (found[0] == entries[8]);       /* 8 */
+        _assert (found[13] == entries[13]);     /* entry-last */
+        _assert (after(ctree, "", 0, found) == 0);
+        _assert (after(ctree, "Fifth entry", 2, found) == 2);
+        _assert (found[0] == entries[1]);       /* First entry */
+        _assert (found[1] == entries[4]);       /* Fourth entry */
+        _assert (after(ctree, "F", 1, found) == 1);
+        _assert (found[0] == entries[5]);       /* Fifth entry */
+        _assert (after(ctree, "Sf", 2, found) == 2);
+        _assert (found[0] == entries[6]);       /* Sixth entry */
+        _assert (found[1] == entries[3]);       /* Third entry */
+        _assert (after(ctree, "Sf", 14, found) == 7);
+        _assert (after(ctree, "entry 1", 14, found) == 4);
+        _assert (found[0] == entries[10]);      /* entry 10 */
+        _assert (after(ctree, "entry 12", 14, found) == 1);
+        _assert (found[0] == entries[13]);      /* entry-last */
+        _assert (after(ctree, "Zz", 1, found) == 1);
+        _assert (found[0] == entries[10]);      /* entry 10 */
+        _assert (after(ctree, "entry-last", 14, found) == 0);
+        _assert (after(ctree, "x", 14, found) == 0);
+    }
+
+    /* test values for prefixes of a key */
+    {
+        _assert (ct_prefixes(ctree, "entry 11", count_cb, NULL) == 1);
+        _assert (ct_prefixes(ctree, "entry 111", count_cb, NULL) == 1);
+        _assert (ct_prefixes(ctree, "entry", count_cb, NULL) == 0);
+        _assert (ct_prefixes(ctree, "8", count_cb, NULL) == 1);
+        _assert (ct_prefixes(ctree, "80", count_cb, NULL) == 1);
+        _assert (ct_prefixes(ctree, "x", count_cb, NULL) == 0);
+        _assert (ct_prefixes(ctree, "", count_cb, NULL) == 0);
+
+        _assert (ct_add(ctree, "entry", entries[0]) == CT_OK);
+        _assert (ct_add(ctree, "entry 1", entries[0]) == CT_OK);
+        _assert (ct_prefixes(ctree, "entry 11", count_cb, NULL) == 3);
+        _assert (ct_prefixes(ctree, "entry-last", count_cb, NULL) == 2);
+        _assert (ct_pop(ctree, "entry") == entries[0]);
+        _assert (ct_pop(ctree, "entry 1") == entries[0]);
+    }
+
     /* test pop value */
     {
         unsigned int i;
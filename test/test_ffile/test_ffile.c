@@ -0,0 +1,191 @@
+#include "../test.h"
+#include <siri/db/ffile.h>
+#include <unistd.h>
+
+
+static sirinet_pkg_t * make_pkg(uint8_t tp, uint32_t len)
+{
+    sirinet_pkg_t * pkg = malloc(sizeof(sirinet_pkg_t) + len);
+    pkg->len = len;
+    pkg->pid = 0;
+    pkg->tp = tp;
+    pkg->checkbit = tp ^ 255;
+    memset(pkg->data, tp, len);
+    return pkg;
+}
+
+static int pop_tp(siridb_ffile_t * ffile)
+{
+    int tp;
+    sirinet_pkg_t * pkg = siridb_ffile_pop(ffile);
+    if (pkg == NULL)
+    {
+        return -1;
+    }
+    tp = pkg->tp;
+    free(pkg);
+    return tp;
+}
+
+static int test_pop_ahead(void)
+{
+    test_start("ffile (pop ahead)");
+
+    char path[] = "/tmp/siridb_test_ffile_XXXXXX";
+    siridb_ffile_t * ffile;
+    sirinet_pkg_t * pkg;
+    uint8_t tp;
+
+    _assert (mkdtemp(path) != NULL);
+    strcat(path, "/");
+
+    ffile = siridb_ffile_new(0, path, NULL);
+    _assert (ffile != NULL);
+    _assert (!ffile->pop_size);
+
+    for (tp = 1; tp <= 3; tp++)
+    {
+        pkg = make_pkg(tp, tp * 10);
+        _assert (siridb_ffile_append(ffile, pkg) == FFILE_SUCCESS);
+        free(pkg);
+    }
+
+    /* pop more than one package before committing */
+    _assert (siridb_ffile_pop_at_head(ffile));
+    _assert (pop_tp(ffile) == 1);
+    _assert (!siridb_ffile_pop_at_head(ffile));
+
+    pkg = siridb_ffile_pop(ffile);
+    _assert (pkg != NULL && pkg->tp == 2 && pkg->len == 20);
+
+    /* undo the last pop */
+    siridb_ffile_unpop(ffile, pkg);
+    free(pkg);
+    _assert (pop_tp(ffile) == 2);
+    _assert (pop_tp(ffile) == 3);
+    _assert (!ffile->pop_size);
+
+    /* a new package can be popped right after it is appended */
+    pkg = make_pkg(4, 5);
+    _assert (siridb_ffile_append(ffile, pkg) == FFILE_SUCCESS);
+    free(pkg);
+    _assert (pop_tp(ffile) == 4);
+
+    /* commits are in the order of popping */
+    _assert (siridb_ffile_pop_commit(ffile) == 0);
+    _assert (siridb_ffile_pkg_size(ffile->next_size) ==
+            sizeof(sirinet_pkg_t) + 20);
+
+    /* pop again from the first package which is not committed */
+    siridb_ffile_pop_rewind(ffile);
+    _assert (pop_tp(ffile) == 2);
+
+    _assert (siridb_ffile_pop_commit(ffile) == 0);
+    _assert (siridb_ffile_pop_commit(ffile) == 0);
+    _assert (siridb_ffile_pop_commit(ffile) == 0);
+    _assert (!ffile->next_size);
+    _assert (siridb_ffile_pop_at_head(ffile));
+    _assert (!ffile->pop_size);
+
+    siridb_ffile_unlink(ffile);
+    _assert (rmdir(path) == 0);
+
+    return test_end();
+}
+
+static int test_full_file(void)
+{
+    test_start("ffile (full file)");
+
+    char path[] = "/tmp/siridb_test_ffile_XXXXXX";
+    char * fn;
+    siridb_ffile_t * ffile;
+    sirinet_pkg_t * pkg;
+    FILE * fp;
+    uint32_t sz;
+    uint8_t tp;
+
+    _assert (mkdtemp(path) != NULL);
+    strcat(path, "/");
+
+    ffile = siridb_ffile_new(0, path, NULL);
+    _assert (ffile != NULL);
+
+    for (tp = 1; tp <= 3; tp++)
+    {
+        pkg = make_pkg(tp, 100);
+        _assert (siridb_ffile_append(ffile, pkg) == FFILE_SUCCESS);
+        free(pkg);
+    }
+    fn = strdup(ffile->fn);
+    siridb_ffile_free(ffile);
+
+    /* an existing file is full and is read using a memory map */
+    ffile = siridb_ffile_new(0, path, NULL);
+    _assert (ffile != NULL && ffile->fp == NULL && !ffile->free_space);
+    siridb_ffile_open(ffile, "r+");
+    _assert (pop_tp(ffile) == 1);
+    _assert (ffile->map != NULL);
+    _assert (siridb_ffile_pop_commit(ffile) == 0);
+
+    /* committed packages are truncated at once, not only when closed */
+    fp = fopen(fn, "r");
+    _assert (fp != NULL);
+    fseek(fp, 0, SEEK_END);
+    _assert (ftell(fp) == ffile->size);
+    fclose(fp);
+
+    _assert (pop_tp(ffile) == 2);
+    siridb_ffile_free(ffile);
+
+    /* a committed package is not popped again after re-opening the file */
+    ffile = siridb_ffile_new(0, path, NULL);
+    siridb_ffile_open(ffile, "r+");
+    _assert (pop_tp(ffile) == 2);
+    siridb_ffile_free(ffile);
+
+    /* a corrupt package is detected by the checksum */
+    fp = fopen(fn, "r+");
+    _assert (fp != NULL);
+    fseek(fp, -(long int) (2 * sizeof(uint32_t) + 1), SEEK_END);
+    fputc('x', fp);
+    fclose(fp);
+
+    ffile = siridb_ffile_new(0, path, NULL);
+    siridb_ffile_open(ffile, "r+");
+    _assert (siridb_ffile_pop(ffile) == NULL);
+    siridb_ffile_unlink(ffile);
+
+    /* packages without a checksum can still be read */
+    fp = fopen(fn, "w");
+    _assert (fp != NULL);
+    sz = 0;
+    fwrite(&sz, sizeof(uint32_t), 1, fp);
+    pkg = make_pkg(7, 10);
+    sz = pkg->len + sizeof(sirinet_pkg_t);
+    fwrite(pkg, sz, 1, fp);
+    fwrite(&sz, sizeof(uint32_t), 1, fp);
+    free(pkg);
+    fclose(fp);
+
+    ffile = siridb_ffile_new(0, path, NULL);
+    siridb_ffile_open(ffile, "r+");
+    _assert (pop_tp(ffile) == 7);
+    _assert (siridb_ffile_pop_commit(ffile) == 0);
+    _assert (!ffile->next_size);
+    siridb_ffile_unlink(ffile);
+
+    free(fn);
+    _assert (rmdir(path) == 0);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_pop_ahead() ||
+        test_full_file() ||
+        0
+    );
+}
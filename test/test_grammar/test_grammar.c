@@ -29,6 +29,8 @@ int main()
     assert_valid(grammar, "select * from *");
     assert_valid(grammar, "select * from 'series'");
     assert_valid(grammar, "select * from * after now-1d");
+    assert_valid(grammar, "select * from 'series' order desc limit 100");
+    assert_invalid(grammar, "select * from 'series' order limit 100");
     assert_valid(grammar, "list series");
     assert_valid(grammar,
         "select mean(1h + 1m) from \"series-001\", \"series-002\", "
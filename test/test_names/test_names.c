@@ -0,0 +1,172 @@
+#include "../test.h"
+#include <siri/db/names.h>
+
+#define NUM_MANY 20000
+
+static const unsigned int num_entries = 6;
+static char * entries[] = {
+    "prod.web01.error",
+    "prod.web02.errors",
+    "prod.db01.timeout",
+    "test.web01.error.timeout",
+    "ab",
+    "a",
+};
+
+typedef struct
+{
+    const char * last;
+    size_t count;
+    int ordered;
+} walk_t;
+
+static siridb_series_t series[6];
+static siridb_series_t many[NUM_MANY];
+static char many_names[NUM_MANY][16];
+
+static int walk_cb(siridb_series_t * series, walk_t * walk)
+{
+    if (walk->last != NULL && strcmp(walk->last, series->name) >= 0)
+    {
+        walk->ordered = 0;
+    }
+    walk->last = series->name;
+    walk->count++;
+    return 1;
+}
+
+static size_t prefix(siridb_names_t * names, const char * p)
+{
+    walk_t walk = {NULL, 0, 1};
+    siridb_names_values_prefix(
+            names,
+            p,
+            strlen(p),
+            (ct_val_cb) walk_cb,
+            &walk);
+    return walk.ordered ? walk.count : (size_t) -1;
+}
+
+static size_t valuesn(siridb_names_t * names, const char * after, size_t n)
+{
+    walk_t walk = {NULL, 0, 1};
+    if (after == NULL)
+    {
+        siridb_names_valuesn(names, &n, (ct_val_cb) walk_cb, &walk);
+    }
+    else
+    {
+        walk.last = after;
+        siridb_names_valuesn_after(
+                names,
+                after,
+                &n,
+                (ct_val_cb) walk_cb,
+                &walk);
+    }
+    return walk.ordered ? walk.count : (size_t) -1;
+}
+
+int main()
+{
+    test_start("names");
+
+    siridb_names_t * names = siridb_names_new();
+    unsigned int i;
+
+    /* test adding series */
+    {
+        for (i = 0; i < num_entries; i++)
+        {
+            series[i].id = i + 1;
+            series[i].name = entries[i];
+            series[i].name_len = strlen(entries[i]);
+            _assert (siridb_names_add(names, series + i) == CT_OK);
+        }
+        _assert (siridb_names_add(names, series + 1) == CT_EXISTS);
+        _assert (names->len == num_entries);
+    }
+
+    /* test lookups in the delta */
+    {
+        _assert (siridb_names_get(names, "ab") == series + 4);
+        _assert (siridb_names_get(names, "abc") == NULL);
+        _assert (siridb_names_getn(names, "abc", 2) == series + 4);
+        _assert (siridb_names_getn(names, "abc", 1) == series + 5);
+        _assert (prefix(names, "prod.") == 3);
+        _assert (prefix(names, "a") == 2);
+        _assert (valuesn(names, NULL, 100) == num_entries);
+        _assert (valuesn(names, NULL, 4) == 4);
+        _assert (valuesn(names, "prod.web01.error", 100) == 2);
+    }
+
+    /* test lookups after a rebuild */
+    {
+        _assert (siridb_names_rebuild(names) == 0);
+        _assert (names->size == num_entries);
+        _assert (names->delta->len == 0);
+        _assert (siridb_names_get(names, "prod.db01.timeout") == series + 2);
+        _assert (prefix(names, "prod.") == 3);
+        _assert (prefix(names, "") == num_entries);
+        _assert (valuesn(names, "prod.web01.error", 100) == 2);
+        _assert (valuesn(names, "zzz", 100) == 0);
+    }
+
+    /* test removing series from the sorted array and the delta */
+    {
+        _assert (siridb_names_pop(names, "prod.web01.error") == series + 0);
+        _assert (siridb_names_pop(names, "prod.web01.error") == NULL);
+        _assert (siridb_names_get(names, "prod.web01.error") == NULL);
+        _assert (names->ndropped == 1);
+        _assert (prefix(names, "prod.") == 2);
+
+        /* add again, now the series is in the delta */
+        _assert (siridb_names_add(names, series + 0) == CT_OK);
+        _assert (prefix(names, "prod.") == 3);
+        _assert (valuesn(names, "prod.db01.timeout", 100) == 3);
+        _assert (siridb_names_pop(names, "prod.web01.error") == series + 0);
+        _assert (names->delta->len == 0);
+
+        _assert (siridb_names_rebuild(names) == 0);
+        _assert (names->size == num_entries - 1);
+        _assert (names->ndropped == 0);
+        _assert (valuesn(names, NULL, 100) == num_entries - 1);
+    }
+
+    siridb_names_free(names, NULL);
+    names = siridb_names_new();
+
+    /* test automatic rebuilds and growing the hash table */
+    {
+        for (i = 0; i < NUM_MANY; i++)
+        {
+            sprintf(many_names[i], "series-%05u", (i * 7919) % NUM_MANY);
+            many[i].id = i + 1;
+            many[i].name = many_names[i];
+            many[i].name_len = strlen(many_names[i]);
+            _assert (siridb_names_add(names, many + i) == CT_OK);
+        }
+        _assert (names->len == NUM_MANY);
+        _assert (names->size > 0);
+        _assert (names->size + names->delta->len == NUM_MANY);
+        _assert (valuesn(names, NULL, NUM_MANY) == NUM_MANY);
+        _assert (prefix(names, "series-1") == 10000);
+
+        for (i = 0; i < NUM_MANY; i += 2)
+        {
+            _assert (siridb_names_pop(names, many_names[i]) == many + i);
+        }
+        _assert (names->len == NUM_MANY / 2);
+        _assert (valuesn(names, NULL, NUM_MANY) == NUM_MANY / 2);
+        _assert (valuesn(names, "series-10000", NUM_MANY) == 5000);
+
+        for (i = 1; i < NUM_MANY; i += 2)
+        {
+            _assert (siridb_names_get(names, many_names[i]) == many + i);
+        }
+    }
+
+    siridb_names_free(names, NULL);
+
+    return test_end();
+}
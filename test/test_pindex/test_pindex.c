@@ -0,0 +1,103 @@
+#include "../test.h"
+#include <siri/db/pindex.h>
+#include <siri/grammar/grammar.h>
+
+/* as defined in cexpr.c */
+#define VIA_NULL 0
+#define VIA_COND 2
+
+static siridb_series_t series[3];
+
+static size_t match(
+        siridb_pindex_t * pindex,
+        cexpr_condition_t * a,
+        cexpr_condition_t * b,
+        cexpr_operator_t operator,
+        uint16_t pool)
+{
+    cexpr_t cexpr = {
+            .operator=operator,
+            .tp_a=VIA_COND,
+            .tp_b=(b == NULL) ? VIA_NULL : VIA_COND,
+            .via_a.cond=a,
+            .via_b.cond=b
+    };
+    vec_t * vec = siridb_pindex_match(pindex, &cexpr, pool);
+    size_t len;
+
+    if (vec == NULL)
+    {
+        return (size_t) -1;
+    }
+    len = vec->len;
+    vec_free(vec);
+    return len;
+}
+
+int main()
+{
+    test_start("pindex");
+
+    /* use 10 as one day so buckets are easy to follow */
+    siridb_pindex_t * pindex = siridb_pindex_new(10);
+    cexpr_condition_t end_lt = {CLERI_GID_K_END, CEXPR_LT, 100, NULL};
+    cexpr_condition_t length_gt = {CLERI_GID_K_LENGTH, CEXPR_GT, 1000, NULL};
+    cexpr_condition_t type_eq = {CLERI_GID_K_TYPE, CEXPR_EQ, TP_STRING, NULL};
+    cexpr_condition_t pool_eq = {CLERI_GID_K_POOL, CEXPR_EQ, 1, NULL};
+    cexpr_condition_t name_eq = {CLERI_GID_K_NAME, CEXPR_EQ, 0, "a"};
+    unsigned int i;
+
+    series[0] = (siridb_series_t) {
+        .id=1, .start=5, .end=95, .length=3, .tp=TP_INT};
+    series[1] = (siridb_series_t) {
+        .id=2, .start=50, .end=500, .length=2000, .tp=TP_DOUBLE};
+    series[2] = (siridb_series_t) {
+        .id=3, .start=1000, .end=1010, .length=1, .tp=TP_STRING};
+
+    /* test adding series */
+    {
+        for (i = 0; i < 3; i++)
+        {
+            _assert (siridb_pindex_add(pindex, series + i) == 0);
+        }
+    }
+
+    /* test matching conditions */
+    {
+        _assert (match(pindex, &end_lt, NULL, CEXPR_AND, 0) == 1);
+        _assert (match(pindex, &length_gt, NULL, CEXPR_AND, 0) == 1);
+        _assert (match(pindex, &type_eq, NULL, CEXPR_AND, 0) == 1);
+        _assert (match(pindex, &end_lt, &length_gt, CEXPR_AND, 0) == 0);
+        _assert (match(pindex, &name_eq, &length_gt, CEXPR_AND, 0) == 1);
+        _assert (match(pindex, &pool_eq, NULL, CEXPR_AND, 0) == 0);
+        _assert (match(pindex, &pool_eq, NULL, CEXPR_AND, 1) == (size_t) -1);
+        _assert (match(pindex, &name_eq, NULL, CEXPR_AND, 0) == (size_t) -1);
+        _assert (match(
+                pindex, &end_lt, &length_gt, CEXPR_OR, 0) == (size_t) -1);
+    }
+
+    /* test updating series */
+    {
+        series[0].end = 600;
+        series[0].length = 5000;
+        _assert (siridb_pindex_update(pindex, series + 0, 5, 95, 3) == 0);
+        _assert (match(pindex, &end_lt, NULL, CEXPR_AND, 0) == 0);
+        _assert (match(pindex, &length_gt, NULL, CEXPR_AND, 0) == 2);
+    }
+
+    /* test removing series */
+    {
+        for (i = 0; i < 3; i++)
+        {
+            siridb_pindex_pop(pindex, series + i);
+        }
+        for (i = 0; i < SIRIDB_PINDEX_PROPS; i++)
+        {
+            _assert (pindex->props[i]->len == 0);
+        }
+    }
+
+    siridb_pindex_free(pindex);
+
+    return test_end();
+}
@@ -0,0 +1,116 @@
+#include "../test.h"
+#include <siri/db/points.h>
+#include <qpack/qpack.h>
+
+
+static siridb_points_t * prepare_points(size_t n, points_tp tp)
+{
+    siridb_points_t * points = siridb_points_new(n, tp);
+    uint64_t ts;
+    qp_via_t val;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        ts = 1500000000 + i * 10 + (i % 3);
+        if (tp == TP_INT)
+        {
+            val.int64 = (int64_t) (i % 7) - 3;
+        }
+        else
+        {
+            val.real = (double) i / 4.0;
+        }
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static int equal_points(siridb_points_t * a, siridb_points_t * b)
+{
+    size_t i;
+
+    if (a->tp != b->tp || a->len != b->len)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < a->len; i++)
+    {
+        if (    a->data[i].ts != b->data[i].ts ||
+                a->data[i].val.uint64 != b->data[i].val.uint64)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static siridb_points_t * pack_unpack(
+        siridb_points_t * points,
+        int (*pack)(siridb_points_t *, qp_packer_t *),
+        size_t * size)
+{
+    siridb_points_t * unpacked = NULL;
+    qp_packer_t * packer = qp_packer_new(1024);
+    qp_unpacker_t unpacker;
+
+    if (pack(points, packer) == 0)
+    {
+        *size = packer->len;
+        qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+        if (qp_is_array(qp_next(&unpacker, NULL)))
+        {
+            unpacked = siridb_points_unpack(&unpacker);
+        }
+    }
+
+    qp_packer_free(packer);
+    return unpacked;
+}
+
+static int test_zip_pack(void)
+{
+    test_start("points (zip pack)");
+
+    size_t raw_size, zip_size;
+    size_t sizes[5] = {0, 1, 4, 1024, 2500};
+    siridb_points_t * points, * unpacked;
+    size_t i;
+
+    for (i = 0; i < 5; i++)
+    {
+        points = prepare_points(sizes[i], TP_INT);
+
+        unpacked = pack_unpack(points, siridb_points_raw_pack, &raw_size);
+        _assert (unpacked != NULL && equal_points(points, unpacked));
+        siridb_points_free(unpacked);
+
+        unpacked = pack_unpack(points, siridb_points_zip_pack, &zip_size);
+        _assert (unpacked != NULL && equal_points(points, unpacked));
+        _assert (sizes[i] < POINTS_ZIP_THRESHOLD || zip_size < raw_size);
+        siridb_points_free(unpacked);
+
+        siridb_points_free(points);
+
+        points = prepare_points(sizes[i], TP_DOUBLE);
+
+        unpacked = pack_unpack(points, siridb_points_zip_pack, &zip_size);
+        _assert (unpacked != NULL && equal_points(points, unpacked));
+        siridb_points_free(unpacked);
+
+        siridb_points_free(points);
+    }
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_zip_pack() ||
+        0
+    );
+}
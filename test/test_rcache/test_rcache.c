@@ -0,0 +1,208 @@
+#include "../test.h"
+#include <siri/db/points.h>
+#include <siri/db/rcache.h>
+
+
+static siridb_points_t * prepare_points(uint64_t first, uint64_t step)
+{
+    siridb_points_t * points = siridb_points_new(10, TP_INT);
+    qp_via_t val;
+    uint64_t ts;
+    unsigned int i;
+
+    for (i = 0; i < 10; i++)
+    {
+        ts = first + i * step;
+        val.int64 = i;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static int test_key(void)
+{
+    test_start("rcache (key)");
+
+    char * key;
+
+    key = siridb_rcache_key("mean (1h)  =>  sum( 1d )", 24);
+    _assert (strcmp(key, "mean(1h)=>sum(1d)") == 0);
+    free(key);
+
+    key = siridb_rcache_key("filter(== 'a b') => filter(~ / x /)", 35);
+    _assert (strcmp(key, "filter(=='a b')=>filter(~/ x /)") == 0);
+    free(key);
+
+    return test_end();
+}
+
+static int test_full_hit(void)
+{
+    test_start("rcache (full hit)");
+
+    siridb_rcache_t * rcache = siridb_rcache_new(SIRIDB_RCACHE_MAX_SIZE);
+    siridb_points_t * points = prepare_points(10, 10);
+    siridb_rcache_hit_t hit;
+
+    siridb_rcache_set(rcache, 1, "sum(10)", 10, 1, 101, points);
+    _assert (rcache->size > 0);
+
+    _assert (siridb_rcache_get(rcache, 2, "sum(10)", 10, 1, 101, &hit) == 0);
+    _assert (siridb_rcache_get(rcache, 1, "max(10)", 10, 1, 101, &hit) == 0);
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 1, 101, &hit) == 1);
+    _assert (hit.points->len == 10);
+    _assert (hit.head_end == 1 && hit.tail_start == 101);
+    siridb_points_free(hit.points);
+
+    _assert (rcache->hits == 1 && rcache->misses == 2);
+    _assert (siridb_rcache_hit_ratio(rcache) > 0.3);
+
+    siridb_points_free(points);
+    siridb_rcache_free(rcache);
+
+    return test_end();
+}
+
+static int test_partial_hit(void)
+{
+    test_start("rcache (partial hit)");
+
+    siridb_rcache_t * rcache = siridb_rcache_new(SIRIDB_RCACHE_MAX_SIZE);
+    siridb_points_t * points = prepare_points(10, 10);
+    siridb_rcache_hit_t hit;
+
+    /* groups 10, 20, .. 100 for the range [1, 101) */
+    siridb_rcache_set(rcache, 1, "sum(10)", 10, 1, 101, points);
+
+    /* sliding window, groups 30 .. 100 can be re-used */
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 21, 121, &hit) == 1);
+    _assert (hit.head_end == 21 && hit.tail_start == 101);
+    _assert (hit.points->len == 8);
+    _assert (hit.points->data[0].ts == 30);
+    _assert (hit.points->data[7].ts == 100);
+    siridb_points_free(hit.points);
+
+    /* a start within a group requires the first group to be calculated */
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 25, 121, &hit) == 1);
+    _assert (hit.head_end == 31);
+    _assert (hit.points->data[0].ts == 40);
+    siridb_points_free(hit.points);
+
+    /* another group_by cannot be re-used */
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 5, 21, 121, &hit) == 0);
+
+    _assert (rcache->partial_hits == 2 && rcache->misses == 1);
+
+    siridb_points_free(points);
+    siridb_rcache_free(rcache);
+
+    return test_end();
+}
+
+static int test_invalidate(void)
+{
+    test_start("rcache (invalidate)");
+
+    siridb_rcache_t * rcache = siridb_rcache_new(SIRIDB_RCACHE_MAX_SIZE);
+    siridb_points_t * points = prepare_points(10, 10);
+    siridb_rcache_hit_t hit;
+
+    siridb_rcache_set(rcache, 1, "sum(10)", 10, 1, 101, points);
+
+    /* points outside the cached range do not invalidate anything */
+    siridb_rcache_invalidate(rcache, 1, 150);
+    siridb_rcache_invalidate(rcache, 2, 50);
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 1, 101, &hit) == 1);
+    _assert (hit.points->len == 10);
+    siridb_points_free(hit.points);
+
+    /* only the groups before the new point can be re-used */
+    siridb_rcache_invalidate(rcache, 1, 55);
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 1, 101, &hit) == 1);
+    _assert (hit.head_end == 1 && hit.tail_start == 51);
+    _assert (hit.points->len == 5);
+    siridb_points_free(hit.points);
+
+    /* no group_by means the result cannot be used anymore */
+    siridb_rcache_set(rcache, 1, "count()", 0, 1, 101, points);
+    siridb_rcache_invalidate(rcache, 1, 99);
+    _assert (siridb_rcache_get(rcache, 1, "count()", 0, 1, 101, &hit) == 0);
+
+    siridb_rcache_clear(rcache);
+    _assert (rcache->size == 0);
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 1, 101, &hit) == 0);
+
+    siridb_points_free(points);
+    siridb_rcache_free(rcache);
+
+    return test_end();
+}
+
+static int test_evict(void)
+{
+    test_start("rcache (evict)");
+
+    siridb_rcache_t * rcache = siridb_rcache_new(SIRIDB_RCACHE_MAX_SIZE);
+    siridb_points_t * points = prepare_points(10, 10);
+    siridb_rcache_hit_t hit;
+    uint32_t id;
+    size_t size;
+
+    siridb_rcache_set(rcache, 1, "sum(10)", 10, 1, 101, points);
+    size = rcache->size;
+    rcache->max_size = size * 16;
+
+    for (id = 2; id <= 16; id++)
+    {
+        siridb_rcache_set(rcache, id, "sum(10)", 10, 1, 101, points);
+    }
+    _assert (rcache->size == 16 * size);
+
+    /* touch series 1 so series 2 is the least recently used */
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 1, 101, &hit) == 1);
+    siridb_points_free(hit.points);
+
+    siridb_rcache_set(rcache, 17, "sum(10)", 10, 1, 101, points);
+
+    _assert (rcache->size == 16 * size);
+    _assert (siridb_rcache_get(rcache, 2, "sum(10)", 10, 1, 101, &hit) == 0);
+    _assert (siridb_rcache_get(rcache, 1, "sum(10)", 10, 1, 101, &hit) == 1);
+    siridb_points_free(hit.points);
+
+    siridb_points_free(points);
+    siridb_rcache_free(rcache);
+
+    return test_end();
+}
+
+static int test_concat(void)
+{
+    test_start("rcache (concat)");
+
+    siridb_points_t * points = siridb_rcache_concat(
+            prepare_points(1, 1),
+            prepare_points(11, 1),
+            prepare_points(21, 1));
+
+    _assert (points != NULL);
+    _assert (points->len == 30);
+    _assert (points->data[0].ts == 1 && points->data[29].ts == 30);
+
+    siridb_points_free(points);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_key() ||
+        test_full_hit() ||
+        test_partial_hit() ||
+        test_invalidate() ||
+        test_evict() ||
+        test_concat() ||
+        0
+    );
+}
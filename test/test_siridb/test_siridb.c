@@ -1,6 +1,13 @@
 #include "../test.h"
 #include <locale.h>
+#include <siri/db/query.h>
 #include <siri/db/series.h>
+#include <siri/db/user.h>
+#include <siri/net/wqueue.h>
+#include <siri/siri.h>
+#include <siri/slowlog.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 
 static int test_series_ensure_type(void)
@@ -111,10 +118,234 @@ static int test_series_ensure_type(void)
     return test_end();
 };
 
+static int test_series_get_tail_buffer(void)
+{
+    test_start("siridb (series_get_tail_buffer)");
+
+    siridb_series_t series;
+    siridb_points_t * points;
+    qp_via_t val;
+    uint64_t ts, start_ts = 2, end_ts = 4;
+
+    memset(&series, 0, sizeof(siridb_series_t));
+    series.tp = TP_INT;
+
+    /* a series without chunks and without buffer */
+    {
+        points = siridb_series_get_tail(&series, NULL, NULL, 2);
+        _assert (points != NULL && points->len == 0);
+        siridb_points_free(points);
+    }
+
+    series.buffer = siridb_points_new(5, TP_INT);
+    _assert (series.buffer != NULL);
+
+    for (ts = 0; ts < 5; ts++)
+    {
+        val.int64 = (int64_t) ts * 10;
+        siridb_points_add_point(series.buffer, &ts, &val);
+    }
+
+    /* a series with points in the buffer only */
+    {
+        points = siridb_series_get_tail(&series, NULL, NULL, 2);
+        _assert (points != NULL && points->len == 2);
+        _assert (points->data[0].ts == 3 && points->data[1].ts == 4);
+        siridb_points_free(points);
+
+        points = siridb_series_get_tail(&series, &start_ts, &end_ts, 1);
+        _assert (points != NULL && points->len == 1);
+        _assert (points->data[0].ts == 3 && points->data[0].val.int64 == 30);
+        siridb_points_free(points);
+    }
+
+    siridb_points_free(series.buffer);
+
+    return test_end();
+}
+
+static int test_query_free_slowlog(void)
+{
+    test_start("siridb (query_free_slowlog)");
+
+    const char * q = "select * from 'series-001'";
+    char path[] = "/tmp/siridb_slowlog_XXXXXX";
+    char fn[sizeof(path) + 16];
+    char line[512];
+    uv_loop_t * loop = siri.loop;
+    siri_cfg_t * cfg = siri.cfg;
+    siri_cfg_t test_cfg;
+    siridb_t siridb;
+    siridb_user_t user;
+    sirinet_stream_t client;
+    siridb_query_t * query;
+    uv_handle_t * handle;
+    FILE * fp;
+
+    _assert (mkdtemp(path) != NULL);
+
+    memset(&test_cfg, 0, sizeof(siri_cfg_t));
+    snprintf(test_cfg.default_db_path, XPATH_MAX, "%s/", path);
+    test_cfg.slow_query_threshold = 1;
+    test_cfg.slow_query_sample_rate = 100;
+
+    siri.loop = uv_default_loop();
+    siri.cfg = &test_cfg;
+    siri_slowlog_init(&siri);
+    _assert (siri.slowlog != NULL);
+
+    memset(&siridb, 0, sizeof(siridb_t));
+    siridb.dbname = "dbtest";
+    siridb.tasks.active = 1;
+
+    user.name = "iris";
+
+    memset(&client, 0, sizeof(sirinet_stream_t));
+    client.ref = 2;  /* the query must not destroy the client */
+    client.siridb = &siridb;
+    client.origin = &user;
+
+    query = (siridb_query_t *) calloc(1, sizeof(siridb_query_t));
+    _assert (query != NULL);
+    query->flags = SIRIDB_QUERY_FLAG_MASTER;
+    query->client = &client;
+    query->q = strdup(q);
+    query->profile = siridb_profile_new();
+    _assert (query->q != NULL && query->profile != NULL);
+
+    /* make the query exceed the threshold */
+    clock_gettime(CLOCK_REALTIME, &query->start);
+    query->start.tv_sec--;
+
+    handle = (uv_handle_t *) malloc(sizeof(uv_async_t));
+    _assert (handle != NULL);
+    handle->data = query;
+
+    /* the query is logged while it is destroyed */
+    siridb_query_free(handle);
+    uv_run(siri.loop, UV_RUN_DEFAULT);
+
+    _assert (client.ref == 1);
+    _assert (siridb.tasks.active == 0);
+
+    siri_slowlog_destroy(&siri);
+    siri.loop = loop;
+    siri.cfg = cfg;
+
+    snprintf(fn, sizeof(fn), "%s/slow_query.log", path);
+    fp = fopen(fn, "r");
+    _assert (fp != NULL);
+    _assert (fgets(line, sizeof(line), fp) != NULL);
+    fclose(fp);
+
+    _assert (strstr(
+            line,
+            "\"query\": \"select * from 'series-001'\"") != NULL);
+    _assert (strstr(line, "\"user\": \"iris\"") != NULL);
+
+    unlink(fn);
+    rmdir(path);
+
+    return test_end();
+}
+
+static int test_wqueue_pending_size(void)
+{
+    test_start("siridb (wqueue_pending_size)");
+
+    const size_t size = sizeof(sirinet_pkg_t) + 1024;
+    unsigned char data[1024];
+    uv_loop_t * loop = uv_default_loop();
+    sirinet_stream_t * client;
+    int i, fds[2];
+
+    memset(data, 0, sizeof(data));
+
+    _assert (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    client = sirinet_stream_new(STREAM_PIPE_CLIENT, NULL);
+    _assert (client != NULL);
+    _assert (uv_pipe_init(loop, (uv_pipe_t *) client->stream, 0) == 0);
+    _assert (uv_pipe_open((uv_pipe_t *) client->stream, fds[0]) == 0);
+
+    _assert (sirinet_wqueue_pending_size(client) == 0);
+
+    /* the first package is written, the others wait for the next write */
+    for (i = 0; i < 3; i++)
+    {
+        _assert (sirinet_pkg_send(
+                client,
+                sirinet_pkg_new(0, sizeof(data), 0, data)) == 0);
+    }
+
+    _assert (client->wqueue->pending->len == 2);
+    _assert (sirinet_wqueue_pending_size(client) >= 2 * size);
+
+    /* the socket buffer is large enough for all packages */
+    while (client->wqueue->writing->len)
+    {
+        uv_run(loop, UV_RUN_NOWAIT);
+    }
+
+    _assert (sirinet_wqueue_pending_size(client) == 0);
+
+    sirinet_stream_decref(client);
+    uv_run(loop, UV_RUN_DEFAULT);
+    close(fds[1]);
+
+    return test_end();
+}
+
+static void wqueue_status_cb(int * status, int rc)
+{
+    *status = rc;
+}
+
+static int test_wqueue_write_error(void)
+{
+    test_start("siridb (wqueue_write_error)");
+
+    uv_loop_t * loop = siri.loop;
+    sirinet_stream_t * client;
+    sirinet_pkg_t * pkg = sirinet_pkg_new(0, 0, 0, NULL);
+    int status = 1;
+
+    siri.loop = uv_default_loop();
+
+    /* a pipe which is not opened cannot be written to */
+    client = sirinet_stream_new(STREAM_PIPE_CLIENT, NULL);
+    _assert (client != NULL);
+    _assert (uv_pipe_init(siri.loop, (uv_pipe_t *) client->stream, 0) == 0);
+
+    _assert (pkg != NULL);
+    _assert (sirinet_wqueue_write(
+            client,
+            pkg,
+            (sirinet_wqueue_cb) wqueue_status_cb,
+            &status) == 0);
+
+    /* the call-back must not be called before the write has returned */
+    _assert (status == 1);
+
+    uv_run(siri.loop, UV_RUN_NOWAIT);
+    _assert (status == UV_EBADF);
+    free(pkg);  /* the call-back is responsible for the package */
+
+    sirinet_stream_decref(client);
+    uv_run(siri.loop, UV_RUN_DEFAULT);
+    siri.loop = loop;
+
+    return test_end();
+}
+
 int main()
 {
     return (
         test_series_ensure_type() ||
+        test_series_get_tail_buffer() ||
+        test_query_free_slowlog() ||
+        test_wqueue_pending_size() ||
+        test_wqueue_write_error() ||
         0
     );
 };
\ No newline at end of file
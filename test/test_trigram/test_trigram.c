@@ -0,0 +1,99 @@
+#include "../test.h"
+#include <siri/db/re.h>
+#include <siri/db/trigram.h>
+
+static const unsigned int num_entries = 5;
+static char * entries[] = {
+    "prod.web01.error",
+    "prod.web02.errors",
+    "prod.db01.timeout",
+    "test.web01.error.timeout",
+    "ab",
+};
+
+static siridb_series_t series[5];
+
+static size_t match(
+        siridb_trigram_t * trigram,
+        const char * literals,
+        size_t n)
+{
+    vec_t * vec = siridb_trigram_match(trigram, literals, n);
+    size_t len;
+
+    if (vec == NULL)
+    {
+        return (size_t) -1;
+    }
+    len = vec->len;
+    vec_free(vec);
+    return len;
+}
+
+static int literals(const char * source, const char * expect, size_t n)
+{
+    char buf[64];
+    return (
+        siridb_re_literals(source, strlen(source), buf) == n &&
+        memcmp(buf, expect, n) == 0);
+}
+
+int main()
+{
+    test_start("trigram");
+
+    siridb_trigram_t * trigram = siridb_trigram_new();
+    unsigned int i;
+
+    /* test adding series */
+    {
+        for (i = 0; i < num_entries; i++)
+        {
+            series[i].id = i + 1;
+            series[i].name = entries[i];
+            series[i].name_len = strlen(entries[i]);
+            _assert (siridb_trigram_add(trigram, series + i) == 0);
+        }
+    }
+
+    /* test matching literals */
+    {
+        _assert (match(trigram, "error", 6) == 3);
+        _assert (match(trigram, "errors", 7) == 1);
+        _assert (match(trigram, "web01\0error", 12) == 2);
+        _assert (match(trigram, "error\0timeout", 14) == 1);
+        _assert (match(trigram, "missing", 8) == 0);
+        _assert (match(trigram, "ab", 3) == (size_t) -1);
+    }
+
+    /* test required literals with escape sequences */
+    {
+        _assert (literals("/error.*timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\x41timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\x{41}timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\012timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\o{12}timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\k<name>timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\k'name'timeout/", "error\0timeout", 14));
+        _assert (literals("/(web)\\g{-1}error/", "error", 6));
+        _assert (literals("/error\\p{Lu}timeout/", "error\0timeout", 14));
+        _assert (literals("/error\\pLtimeout/", "error\0timeout", 14));
+        _assert (literals("/\\d+error\\.log/", "error.log", 10));
+    }
+
+    /* test removing series */
+    {
+        siridb_trigram_pop(trigram, series + 0);
+        _assert (match(trigram, "error", 6) == 2);
+
+        for (i = 1; i < num_entries; i++)
+        {
+            siridb_trigram_pop(trigram, series + i);
+        }
+        _assert (trigram->grams->len == 0);
+    }
+
+    siridb_trigram_free(trigram);
+
+    return test_end();
+}